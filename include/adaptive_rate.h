@@ -0,0 +1,70 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// Controle adaptativo do período de amostragem/publicação a partir da dinâmica do sinal.
+// Mantém uma média e uma variância exponenciais da umidade (constante de tempo tauMs,
+// independente do período atual). Se a inclinação da média ou o desvio padrão passam dos
+// limites (ex.: irrigação começou), volta direto ao período mínimo; com o sinal estável,
+// dobra o período a cada leitura até o máximo.
+struct AdaptiveRateConfig {
+  uint32_t minPeriodMs;
+  uint32_t maxPeriodMs;
+  float slopeThreshold;   // %/min na média filtrada
+  float stddevThreshold;  // % de desvio padrão
+  uint32_t tauMs;         // Constante de tempo dos filtros exponenciais
+};
+
+class AdaptiveRate {
+ public:
+  explicit AdaptiveRate(const AdaptiveRateConfig& config) : _cfg(config), _period(config.minPeriodMs) {}
+
+  // Atualiza com uma nova leitura (elapsedMs desde a anterior) e retorna o novo período
+  uint32_t update(float humidity, uint32_t elapsedMs) {
+    if (!_primed || elapsedMs == 0) {
+      _mean = humidity;
+      _variance = 0;
+      _slope = 0;
+      _primed = true;
+      return _period;
+    }
+    float alpha = (float)elapsedMs / (float)(_cfg.tauMs + elapsedMs);
+    float delta = humidity - _mean;
+    float previous = _mean;
+    _mean += alpha * delta;
+    _variance = (1.0f - alpha) * (_variance + alpha * delta * delta);
+    _slope = (_mean - previous) * 60000.0f / (float)elapsedMs;
+
+    if (fabsf(_slope) > _cfg.slopeThreshold || stddev() > _cfg.stddevThreshold) {
+      _period = _cfg.minPeriodMs;
+    } else if (_period < _cfg.maxPeriodMs) {
+      _period = _period > _cfg.maxPeriodMs / 2 ? _cfg.maxPeriodMs : _period * 2;
+    }
+    return _period;
+  }
+
+  // Novos limites valem a partir da próxima leitura; o período atual é ajustado a eles
+  void setLimits(uint32_t minPeriodMs, uint32_t maxPeriodMs) {
+    if (minPeriodMs == 0 || maxPeriodMs < minPeriodMs) return;
+    _cfg.minPeriodMs = minPeriodMs;
+    _cfg.maxPeriodMs = maxPeriodMs;
+    if (_period < minPeriodMs) _period = minPeriodMs;
+    if (_period > maxPeriodMs) _period = maxPeriodMs;
+  }
+
+  uint32_t period() const { return _period; }
+  uint32_t minPeriod() const { return _cfg.minPeriodMs; }
+  uint32_t maxPeriod() const { return _cfg.maxPeriodMs; }
+  float mean() const { return _mean; }
+  float slope() const { return _slope; }
+  float stddev() const { return sqrtf(_variance); }
+
+ private:
+  AdaptiveRateConfig _cfg;
+  uint32_t _period;
+  bool _primed = false;
+  float _mean = 0;
+  float _variance = 0;
+  float _slope = 0;
+};
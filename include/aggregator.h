@@ -0,0 +1,182 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Estatísticas de janela em memória O(1), sem alocação: média/variância de Welford,
+// mínimo/máximo e quantis pelo algoritmo P² (Jain & Chlamtac), que mantém só 5
+// marcadores por quantil. Cada add() custa algumas dezenas de operações em ponto
+// flutuante, o que permite alimentar o agregador na taxa do ADC.
+
+class P2Quantile {
+ public:
+  void reset(float p) {
+    _p = p;
+    _count = 0;
+  }
+
+  void add(float x) {
+    if (_count < 5) {
+      _q[_count++] = x;
+      if (_count == 5) start();
+      return;
+    }
+
+    int k;
+    if (x < _q[0]) {
+      _q[0] = x;
+      k = 0;
+    } else if (x >= _q[4]) {
+      _q[4] = x;
+      k = 3;
+    } else {
+      k = 0;
+      while (k < 3 && x >= _q[k + 1]) k++;
+    }
+    for (int i = k + 1; i < 5; i++) _n[i]++;
+    for (int i = 0; i < 5; i++) _desired[i] += _step[i];
+
+    // Ajusta os marcadores internos que se afastaram da posição desejada
+    for (int i = 1; i < 4; i++) {
+      float d = _desired[i] - _n[i];
+      if ((d >= 1 && _n[i + 1] - _n[i] > 1) || (d <= -1 && _n[i - 1] - _n[i] < -1)) {
+        int s = d > 0 ? 1 : -1;
+        float candidate = parabolic(i, s);
+        if (_q[i - 1] < candidate && candidate < _q[i + 1]) {
+          _q[i] = candidate;
+        } else {
+          _q[i] += s * (_q[i + s] - _q[i]) / (float)(_n[i + s] - _n[i]);
+        }
+        _n[i] += s;
+      }
+    }
+    _count++;
+  }
+
+  float value() const {
+    if (_count >= 5) return _q[2];
+    if (_count == 0) return NAN;
+    // Poucas amostras: quantil exato das que existem
+    float sorted[5];
+    for (uint32_t i = 0; i < _count; i++) sorted[i] = _q[i];
+    sortSmall(sorted, _count);
+    return sorted[(uint32_t)(_p * (_count - 1) + 0.5f)];
+  }
+
+ private:
+  void start() {
+    sortSmall(_q, 5);
+    for (int i = 0; i < 5; i++) _n[i] = i;
+    _desired[0] = 0;
+    _desired[1] = 2 * _p;
+    _desired[2] = 4 * _p;
+    _desired[3] = 2 + 2 * _p;
+    _desired[4] = 4;
+    _step[0] = 0;
+    _step[1] = _p / 2;
+    _step[2] = _p;
+    _step[3] = (1 + _p) / 2;
+    _step[4] = 1;
+  }
+
+  float parabolic(int i, int s) const {
+    float a = (float)(_n[i] - _n[i - 1] + s) * (_q[i + 1] - _q[i]) / (float)(_n[i + 1] - _n[i]);
+    float b = (float)(_n[i + 1] - _n[i] - s) * (_q[i] - _q[i - 1]) / (float)(_n[i] - _n[i - 1]);
+    return _q[i] + (float)s / (float)(_n[i + 1] - _n[i - 1]) * (a + b);
+  }
+
+  static void sortSmall(float* v, uint32_t n) {
+    for (uint32_t i = 1; i < n; i++) {
+      float x = v[i];
+      uint32_t j = i;
+      while (j > 0 && v[j - 1] > x) {
+        v[j] = v[j - 1];
+        j--;
+      }
+      v[j] = x;
+    }
+  }
+
+  float _p = 0.5f;
+  uint32_t _count = 0;
+  float _q[5];
+  int32_t _n[5];
+  float _desired[5];
+  float _step[5];
+};
+
+#define AGG_QUANTILES 3
+// Quantis calculados em cada janela: p05, p50 (mediana) e p95
+static const float aggQuantiles[AGG_QUANTILES] = { 0.05f, 0.50f, 0.95f };
+
+struct WindowSummary {
+  unsigned long startedAt;  // millis() do início da janela
+  uint32_t windowMs;
+  uint32_t count;
+  float min;
+  float max;
+  float mean;
+  float stddev;
+  float quantiles[AGG_QUANTILES];
+};
+
+// Janela "tumbling": acumula até close(), que devolve o resumo e começa outra janela
+class WindowAggregator {
+ public:
+  explicit WindowAggregator(uint32_t windowMs) : _windowMs(windowMs) { reset(0); }
+
+  void add(float x) {
+    _count++;
+    float delta = x - _mean;
+    _mean += delta / (float)_count;
+    _m2 += delta * (x - _mean);
+    if (x < _min) _min = x;
+    if (x > _max) _max = x;
+    for (int i = 0; i < AGG_QUANTILES; i++) _quantiles[i].add(x);
+  }
+
+  // Fecha a janela atual; retorna false (sem resumo) se ela não recebeu amostras
+  bool close(unsigned long now, WindowSummary& out) {
+    bool hasData = _count > 0;
+    if (hasData) {
+      out.startedAt = _startedAt;
+      out.windowMs = _windowMs;
+      out.count = _count;
+      out.min = _min;
+      out.max = _max;
+      out.mean = _mean;
+      out.stddev = _count > 1 ? sqrtf(_m2 / (float)(_count - 1)) : 0.0f;
+      for (int i = 0; i < AGG_QUANTILES; i++) out.quantiles[i] = _quantiles[i].value();
+    }
+    reset(now);
+    return hasData;
+  }
+
+  // Descarta o que houver e começa a janela em now (no boot, junto com o agendamento do
+  // primeiro fechamento)
+  void restart(unsigned long now) { reset(now); }
+
+  uint32_t windowMs() const { return _windowMs; }
+  uint32_t count() const { return _count; }
+
+ private:
+  void reset(unsigned long now) {
+    _startedAt = now;
+    _count = 0;
+    _mean = 0;
+    _m2 = 0;
+    _min = INFINITY;
+    _max = -INFINITY;
+    for (int i = 0; i < AGG_QUANTILES; i++) _quantiles[i].reset(aggQuantiles[i]);
+  }
+
+  uint32_t _windowMs;
+  unsigned long _startedAt;
+  uint32_t _count;
+  float _mean;
+  float _m2;
+  float _min;
+  float _max;
+  P2Quantile _quantiles[AGG_QUANTILES];
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+
+// Alarmes de limiar avaliados a cada amostra do ADC. Só as transições (disparo e
+// normalização) geram eventos:
+//  - fio solto e fundo de escala olham o pino antes do filtro (um pico curto sumiria nele)
+//    e só mudam de estado depois de debounceSamples amostras seguidas do outro lado do
+//    limite, para um valor oscilando no limite não virar uma rajada de eventos;
+//  - seco e encharcado olham a saída do filtro: a validade e a umidade vêm do mesmo sinal.
+//    Qualquer amostra inválida (no pino ou no filtro) suspende esses alarmes até passarem
+//    settleSamples amostras válidas seguidas, o tempo de o filtro esquecer o pico; a
+//    histerese de umidade evita a oscilação em torno do limite.
+enum AlarmType {
+  ALARM_DRY,           // Solo seco demais
+  ALARM_SATURATED,     // Solo encharcado
+  ALARM_DISCONNECTED,  // Saída do sensor perto de 0 V: fio solto ou sensor sem alimentação
+  ALARM_ADC_RAIL,      // ADC no fundo de escala: leitura saturada, valor não confiável
+  ALARM_COUNT
+};
+
+struct AlarmThresholds {
+  float dryBelow;          // % de umidade
+  float saturatedAbove;    // % de umidade
+  float hysteresis;        // % de umidade para normalizar os alarmes de umidade
+  int disconnectedBelow;   // valor bruto do ADC
+  int railAbove;           // valor bruto do ADC
+  uint8_t debounceSamples; // amostras seguidas para disparar ou normalizar fio solto e fundo de escala
+  uint16_t settleSamples;  // amostras válidas seguidas antes de voltar a avaliar seco e encharcado
+};
+
+struct AlarmEvent {
+  uint8_t type;     // AlarmType
+  bool active;      // true = disparou, false = normalizou
+  float humidity;
+  int raw;
+};
+
+inline const char* alarmName(uint8_t type) {
+  switch (type) {
+    case ALARM_DRY: return "dry";
+    case ALARM_SATURATED: return "saturated";
+    case ALARM_DISCONNECTED: return "disconnected";
+    case ALARM_ADC_RAIL: return "adc_rail";
+    default: return "unknown";
+  }
+}
+
+class AlarmMonitor {
+ public:
+  // No boot o filtro também precisa assentar antes dos alarmes de umidade
+  explicit AlarmMonitor(const AlarmThresholds& thresholds) : _t(thresholds), _settle(thresholds.settleSamples) {}
+
+  // Avalia uma amostra (pin: valor do pino; filtered: saída do filtro, de onde vem a
+  // umidade) e chama emit(const AlarmEvent&) para cada alarme que mudou de estado
+  template <typename Emit>
+  void update(int pin, int filtered, float humidity, Emit emit) {
+    debounce(ALARM_DISCONNECTED, pin < _t.disconnectedBelow, pin, humidity, emit);
+    debounce(ALARM_ADC_RAIL, pin > _t.railAbove, pin, humidity, emit);
+
+    // Com leitura inválida a umidade calculada não significa nada (0 V vira 100%,
+    // fundo de escala vira 0%): os alarmes de umidade mantêm o estado anterior.
+    bool valid = !outOfRange(pin) && !outOfRange(filtered) && !_active[ALARM_DISCONNECTED] && !_active[ALARM_ADC_RAIL];
+    if (!valid) {
+      _settle = _t.settleSamples;
+      return;
+    }
+    if (_settle > 0) {
+      _settle--;
+      return;
+    }
+    bool dry = _active[ALARM_DRY] ? humidity < _t.dryBelow + _t.hysteresis : humidity < _t.dryBelow;
+    bool wet = _active[ALARM_SATURATED] ? humidity > _t.saturatedAbove - _t.hysteresis
+                                        : humidity > _t.saturatedAbove;
+    set(ALARM_DRY, dry, filtered, humidity, emit);
+    set(ALARM_SATURATED, wet, filtered, humidity, emit);
+  }
+
+  bool active(AlarmType type) const { return _active[type]; }
+
+ private:
+  bool outOfRange(int raw) const { return raw < _t.disconnectedBelow || raw > _t.railAbove; }
+
+  // Muda de estado só depois de debounceSamples amostras seguidas pedindo a mudança
+  template <typename Emit>
+  void debounce(AlarmType type, bool active, int raw, float humidity, Emit& emit) {
+    if (active == _active[type]) {
+      _streak[type] = 0;
+      return;
+    }
+    if (++_streak[type] < _t.debounceSamples) return;
+    _streak[type] = 0;
+    set(type, active, raw, humidity, emit);
+  }
+
+  template <typename Emit>
+  void set(AlarmType type, bool active, int raw, float humidity, Emit& emit) {
+    if (_active[type] == active) return;
+    _active[type] = active;
+    AlarmEvent event = { (uint8_t)type, active, humidity, raw };
+    emit(event);
+  }
+
+  AlarmThresholds _t;
+  bool _active[ALARM_COUNT] = {};
+  uint8_t _streak[ALARM_COUNT] = {};  // Amostras seguidas contra o estado atual (debounce)
+  uint16_t _settle;                   // Amostras válidas que ainda faltam para avaliar a umidade
+};
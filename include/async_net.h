@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "broker_pool.h"
+
+// Rede sem bloquear o loop(), para o pool de brokers (broker_pool.h):
+//  - netResolve() consulta o DNS na task do lwIP (dns_gethostbyname com callback) e é
+//    chamada de novo pelo job até a resposta; uma consulta por vez, como no pool;
+//  - TcpProbe abre um socket não bloqueante e confere o handshake com select() sem espera,
+//    sem dado nenhum depois: só mede o RTT e diz se o broker está alcançável.
+// No simulador as duas vêm de sim/net.cpp, no relógio virtual.
+
+ResolveStatus netResolve(const char* host, uint8_t address[4]);
+
+class TcpProbe {
+ public:
+  ~TcpProbe() { stop(); }
+
+  // false se não deu nem para mandar o SYN (IP inválido, sem socket, sem rota)
+  bool start(const char* ip, uint16_t port);
+  // > 0 conectado, 0 em andamento, < 0 recusado ou desfeito
+  int poll();
+  void stop();
+
+ private:
+  int _fd = -1;  // No simulador, o id do handshake
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+// Troca de imagem via partição de boot (tabela partitions_split.csv):
+//  - factory: imagem de provisionamento (portal de configuração)
+//  - ota_0:   imagem de sensoriamento, sem WebServer/DNSServer/portal
+// As funções só apontam o próximo boot; quem chama decide quando reiniciar.
+// Retornam false se a partição não existir ou não contiver um app válido.
+bool switchToSensingImage();
+bool switchToFactoryImage();
+
+// Imprime uma linha legível por máquina com o tempo de boot até o fim do setup():
+//   BOOT image=<nome> setup_ms=<ms> free_heap=<bytes>
+void reportBootTime(const char* image);
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mqtt_client.h"
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Lista de brokers MQTT com cache de DNS, medição de latência e failover, usada pelo
+// MqttTransport (mqtt_transport.h). Nada aqui bloqueia o loop(): poll(), chamado pelo job
+// "brokers", dá um passo do DNS e um do probe a cada vez.
+//  - o endereço de cada broker é resolvido fora do loop() (o resolvedor devolve
+//    RESOLVE_PENDING até a resposta) e guardado por BROKER_DNS_TTL_MS (o resolvedor do
+//    Arduino não informa o TTL do registro); o cliente MQTT recebe o IP em texto, que o
+//    WiFiClient usa sem consultar o DNS. Se o DNS falhar com o cache vencido, o endereço
+//    antigo continua valendo e a consulta volta em BROKER_DNS_RETRY_MS (RFC 8767);
+//  - o probe é um handshake TCP sem bloquear, um broker por vez: mede o RTT (EWMA de 1/4,
+//    como o SRTT do TCP) e diz se o broker está alcançável. Só um broker que respondeu ao
+//    probe recebe a conexão MQTT, então um broker fora do ar nunca prende o connect();
+//  - uma falha (de conexão ou de probe) põe o broker em backoff exponencial, que espaça os
+//    probes; sem conexão nenhuma o backoff fica em BROKER_BACKOFF_DOWN_MS, então o primeiro
+//    broker que volta responde ao probe em segundos e é usado na hora;
+//  - ready() dá o próximo broker a tentar: o de menor RTT entre os alcançáveis e fora do
+//    backoff. Quando a conexão atual cai, todos são medidos de novo antes da próxima.
+//
+// O probe é um parâmetro de template (TcpProbe de async_net.h ou qualquer classe com
+// start(ip, porta)/poll()/stop(), poll() > 0 conectado, 0 em andamento, < 0 falhou).
+
+#define BROKER_POOL_MAX 4
+#define BROKER_HOST_MAX 64
+#ifndef BROKER_DNS_TTL_MS
+#define BROKER_DNS_TTL_MS 300000       // Validade do endereço resolvido
+#endif
+#define BROKER_DNS_RETRY_MS 10000      // Nova consulta depois de uma falha do DNS
+#define BROKER_PROBE_TIMEOUT_MS 1000   // Handshake TCP mais lento que isso conta como falha
+#define BROKER_PROBE_INTERVAL_MS 600000  // Nova medição de um broker alcançável (10 min)
+#define BROKER_BACKOFF_MS 500          // Espera até o próximo probe depois da primeira falha seguida (dobra a cada nova)
+#define BROKER_BACKOFF_MAX_MS 300000   // Com a conexão de pé em outro broker
+#define BROKER_BACKOFF_DOWN_MS 2000    // Sem conexão: limite do backoff, a volta de um broker é vista em até ~2 s
+
+// Resolução de nomes sem bloquear: chamada de novo com o mesmo host até sair do
+// RESOLVE_PENDING (uma consulta por vez)
+enum ResolveStatus {
+  RESOLVE_OK,
+  RESOLVE_PENDING,
+  RESOLVE_FAILED,
+};
+
+typedef ResolveStatus (*BrokerResolveFn)(const char* host, uint8_t address[4]);
+
+struct BrokerStats {
+  uint32_t rttMs = 0;          // Handshake TCP suavizado (0 = nunca medido)
+  uint32_t lastRttMs = 0;
+  uint32_t probes = 0;
+  uint32_t probeFailures = 0;
+  uint32_t connects = 0;       // Conexões MQTT estabelecidas
+  uint32_t failures = 0;       // Conexões que falharam ou caíram
+  uint32_t resolves = 0;       // Consultas ao DNS (cache vazio ou vencido)
+  uint32_t dnsFailures = 0;
+  uint32_t dnsStale = 0;       // DNS falhou e o endereço vencido continuou valendo
+};
+
+struct BrokerEntry {
+  char host[BROKER_HOST_MAX];
+  uint16_t port;
+  char address[16];            // IP em texto; vazio enquanto não resolvido
+  unsigned long resolveAt;     // Próxima consulta ao DNS
+  uint8_t consecutiveFailures;
+  unsigned long retryAt;       // Em backoff até este instante
+  bool reachable;              // Respondeu ao último probe e não falhou desde então
+  unsigned long probeAt;       // Próxima medição, se alcançável
+  uint8_t protocol;            // Versão do MQTT aceita pelo broker (MQTT_V5 até ele recusar)
+  BrokerStats stats;
+};
+
+template <typename Probe>
+class BrokerPool {
+ public:
+  BrokerPool(Probe& probe, MqttMillisFn millisFn, BrokerResolveFn resolve)
+      : _probe(probe), _millis(millisFn), _resolve(resolve) {}
+
+  void clear() {
+    _probe.stop();
+    _count = 0;
+    _current = -1;
+    _resolving = -1;
+    _probing = -1;
+  }
+
+  bool add(const char* host, size_t length, uint16_t port) {
+    if (_count >= BROKER_POOL_MAX || length == 0 || length >= BROKER_HOST_MAX) return false;
+    BrokerEntry& entry = _entries[_count++];
+    memcpy(entry.host, host, length);
+    entry.host[length] = '\0';
+    entry.port = port;
+    entry.address[0] = '\0';
+    entry.resolveAt = _millis();
+    entry.consecutiveFailures = 0;
+    entry.retryAt = _millis();
+    entry.reachable = false;
+    entry.probeAt = 0;
+    entry.protocol = MQTT_V5;
+    entry.stats = BrokerStats();
+    return true;
+  }
+
+  // "host[:porta],host[:porta]" (vírgulas ou espaços); retorna quantos entraram
+  size_t parse(const char* list, size_t length, uint16_t defaultPort) {
+    clear();
+    size_t pos = 0;
+    while (pos < length) {
+      while (pos < length && (list[pos] == ',' || list[pos] == ' ')) pos++;
+      size_t start = pos;
+      while (pos < length && list[pos] != ',' && list[pos] != ' ') pos++;
+      if (pos == start) break;
+      size_t hostLength = pos - start;
+      uint16_t port = defaultPort;
+      const char* colon = (const char*)memchr(list + start, ':', hostLength);
+      if (colon) {
+        hostLength = colon - (list + start);
+        port = (uint16_t)atoi(colon + 1);
+        if (port == 0) continue;
+      }
+      add(list + start, hostLength, port);
+    }
+    return _count;
+  }
+
+  size_t count() const { return _count; }
+  const BrokerEntry& at(size_t i) const { return _entries[i]; }
+  int current() const { return _current; }
+  uint32_t failovers() const { return _failovers; }
+  uint32_t lastFailoverMs() const { return _lastFailoverMs; }
+
+  bool healthy(size_t i) const { return (long)(_millis() - _entries[i].retryAt) >= 0; }
+
+  // IP em texto do cache; nullptr se nunca resolveu (a consulta é feita por poll())
+  const char* address(size_t i) const { return _entries[i].address[0] != '\0' ? _entries[i].address : nullptr; }
+
+  // Próximo broker a tentar: alcançável, fora do backoff e resolvido, o de menor RTT; -1 se
+  // nenhum (poll() segue medindo)
+  int ready() const {
+    int best = -1;
+    for (size_t i = 0; i < _count; i++) {
+      const BrokerEntry& entry = _entries[i];
+      if (!entry.reachable || !healthy(i) || entry.address[0] == '\0') continue;
+      if (best < 0 || entry.stats.rttMs < _entries[best].stats.rttMs) best = (int)i;
+    }
+    return best;
+  }
+
+  // Handshake do probe a caminho: vale chamar poll() de novo logo, para medir o RTT
+  bool probing() const { return _probing >= 0; }
+
+  // Um passo do DNS e um do probe; true quando um broker acabou de responder ao probe e
+  // ready() pode ter mudado
+  bool poll() {
+    resolveStep();
+    return probeStep();
+  }
+
+  void connected(size_t i) {
+    BrokerEntry& entry = _entries[i];
+    entry.stats.connects++;
+    entry.consecutiveFailures = 0;
+    entry.retryAt = _millis();
+    if (_lostAt != 0) {
+      _lastFailoverMs = _millis() - _lostAt;
+      _lostAt = 0;
+    }
+    _current = (int)i;
+  }
+
+  void failed(size_t i) { fail(_entries[i]); }
+
+  // Versão do MQTT com que o broker aceitou (ou recusou) a última conexão
+  void setProtocol(size_t i, uint8_t version) { _entries[i].protocol = version; }
+
+  // A conexão com o broker atual caiu: ele vai para o backoff e os outros são medidos de novo
+  // antes de receber a conexão (a queda pode ter sido do caminho, não só do broker)
+  void lost() {
+    if (_current < 0) return;
+    int current = _current;
+    _current = -1;
+    fail(_entries[current]);
+    unsigned long limit = _millis() + BROKER_BACKOFF_DOWN_MS;
+    for (size_t i = 0; i < _count; i++) {
+      _entries[i].reachable = false;
+      if ((long)(_entries[i].retryAt - limit) > 0) _entries[i].retryAt = limit;
+    }
+    _failovers++;
+    _lostAt = _millis();
+    if (_lostAt == 0) _lostAt = 1;
+  }
+
+ private:
+  // Consulta o DNS do primeiro broker com o cache vazio ou vencido, uma consulta por vez
+  void resolveStep() {
+    unsigned long now = _millis();
+    if (_resolving < 0) {
+      for (size_t i = 0; i < _count && _resolving < 0; i++) {
+        if ((long)(now - _entries[i].resolveAt) >= 0) _resolving = (int)i;
+      }
+      if (_resolving < 0) return;
+      _entries[_resolving].stats.resolves++;
+    }
+    BrokerEntry& entry = _entries[_resolving];
+    uint8_t ip[4];
+    ResolveStatus status = _resolve(entry.host, ip);
+    if (status == RESOLVE_PENDING) return;
+    _resolving = -1;
+    if (status == RESOLVE_FAILED) {
+      entry.stats.dnsFailures++;
+      if (entry.address[0] != '\0') entry.stats.dnsStale++;
+      entry.resolveAt = now + BROKER_DNS_RETRY_MS;
+      return;
+    }
+    char address[sizeof(entry.address)];
+    snprintf(address, sizeof(address), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    if (strcmp(address, entry.address) != 0) {
+      strcpy(entry.address, address);
+      entry.reachable = false;  // Endereço novo: precisa de probe antes da conexão
+    }
+    entry.resolveAt = now + BROKER_DNS_TTL_MS;
+  }
+
+  // Confere o probe em andamento ou começa o do próximo broker devido: os não alcançáveis
+  // assim que saem do backoff, os alcançáveis a cada BROKER_PROBE_INTERVAL_MS
+  bool probeStep() {
+    unsigned long now = _millis();
+    if (_probing >= 0) {
+      BrokerEntry& entry = _entries[_probing];
+      int result = _probe.poll();
+      uint32_t rtt = now - _probeStartedAt;
+      if (result == 0 && rtt < BROKER_PROBE_TIMEOUT_MS) return false;
+      _probe.stop();
+      int index = _probing;
+      _probing = -1;
+      if (result <= 0) {
+        probeFailed(index);
+        return false;
+      }
+      // O backoff não zera aqui: um broker que aceita o TCP e recusa o CONNECT continua espaçado
+      entry.stats.lastRttMs = rtt;
+      entry.stats.rttMs = entry.stats.rttMs == 0 ? (rtt ? rtt : 1) : (3 * entry.stats.rttMs + rtt + 2) / 4;
+      entry.reachable = true;
+      entry.probeAt = now + BROKER_PROBE_INTERVAL_MS;
+      return true;
+    }
+    for (size_t k = 0; k < _count; k++) {
+      size_t i = (_nextProbe + k) % _count;
+      BrokerEntry& entry = _entries[i];
+      if (entry.address[0] == '\0') continue;
+      bool due = entry.reachable ? (long)(now - entry.probeAt) >= 0 : healthy(i);
+      if (!due) continue;
+      _nextProbe = (i + 1) % _count;
+      entry.stats.probes++;
+      if (!_probe.start(entry.address, entry.port)) {
+        probeFailed(i);
+        return false;
+      }
+      _probing = (int)i;
+      _probeStartedAt = now;
+      return false;
+    }
+    return false;
+  }
+
+  void probeFailed(size_t i) {
+    BrokerEntry& entry = _entries[i];
+    entry.stats.probeFailures++;
+    if ((int)i == _current) {
+      entry.probeAt = _millis() + BROKER_PROBE_INTERVAL_MS;  // O atual segue conectado: só a próxima queda conta
+      return;
+    }
+    fail(entry);
+  }
+
+  void fail(BrokerEntry& entry) {
+    entry.stats.failures++;
+    entry.reachable = false;
+    uint32_t limit = _current < 0 ? BROKER_BACKOFF_DOWN_MS : BROKER_BACKOFF_MAX_MS;
+    uint32_t backoff = BROKER_BACKOFF_MS;
+    for (uint8_t k = 0; k < entry.consecutiveFailures && backoff < limit; k++) backoff *= 2;
+    if (backoff > limit) backoff = limit;
+    if (entry.consecutiveFailures < 255) entry.consecutiveFailures++;
+    entry.retryAt = _millis() + backoff;
+  }
+
+  Probe& _probe;
+  MqttMillisFn _millis;
+  BrokerResolveFn _resolve;
+  BrokerEntry _entries[BROKER_POOL_MAX];
+  size_t _count = 0;
+  int _current = -1;
+  int _resolving = -1;           // Consulta ao DNS em andamento
+  int _probing = -1;             // Probe em andamento
+  unsigned long _probeStartedAt = 0;
+  size_t _nextProbe = 0;         // Rodízio: um broker sempre devido não monopoliza o probe
+  uint32_t _failovers = 0;
+  uint32_t _lastFailoverMs = 0;  // Da queda à conexão com outro broker
+  unsigned long _lostAt = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+// Conversão da leitura bruta do ADC para umidade (%). Funções puras, sem dependência
+// do Arduino, para poderem ser medidas e usadas também em builds nativos (host).
+
+// Mesmo comportamento do map() do Arduino (aritmética inteira, truncando)
+inline long mapRange(long x, long inMin, long inMax, long outMin, long outMax) {
+  if (inMax == inMin) return outMin;
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// A ordem de seco e molhado é invertida no mapeamento porque um valor
+// analógico mais ALTO (seco) corresponde a 0% de umidade.
+inline float humidityFromRaw(int rawValue, int dryValue, int wetValue) {
+  long humidityPercent = mapRange(rawValue, dryValue, wetValue, 0, 100);
+  // Garante que o valor final esteja sempre dentro do intervalo de 0 a 100
+  if (humidityPercent < 0) humidityPercent = 0;
+  if (humidityPercent > 100) humidityPercent = 100;
+  return (float)humidityPercent;
+}
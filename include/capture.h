@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Captura do ADC em alta taxa pela serial, para caracterizar ruído e ajustar filtros. As
+// amostras brutas saem em quadros binários, cada um em COBS (Consistent Overhead Byte
+// Stuffing) e terminado por um byte 0x00: o receptor se ressincroniza no próximo 0x00
+// depois de qualquer byte perdido ou de texto de log misturado, e o CRC descarta o resto.
+//
+// Quadro antes do COBS (little endian):
+//   0  uint8 versão   (CAPTURE_FRAME_VERSION)
+//   1  uint8 count    amostras no quadro; 0 marca o fim da captura
+//   2  uint16 período µs entre amostras
+//   4  uint32 seq     número do quadro; um buraco é um quadro perdido (serial cheia)
+//   8  uint32 t0      esp_timer (µs, 32 bits baixos) da primeira amostra
+//   12 uint16 raw[count]  leituras do ADC (12 bits)
+//   .. uint16 crc     CRC-16/CCITT-FALSE (crc.h) dos bytes anteriores
+//
+// O receptor do host, que grava a captura em arquivo, está em scripts/capture_recv.py.
+
+#define CAPTURE_FRAME_VERSION 1
+#define CAPTURE_HEADER_SIZE 12
+#define CAPTURE_SAMPLES_PER_FRAME 32
+#define CAPTURE_FRAME_MAX (CAPTURE_HEADER_SIZE + 2 * CAPTURE_SAMPLES_PER_FRAME + 2)
+// COBS acrescenta um byte a cada 254 e o primeiro; mais o delimitador
+#define CAPTURE_ENCODED_MAX (CAPTURE_FRAME_MAX + CAPTURE_FRAME_MAX / 254 + 2)
+#define CAPTURE_BAUD 921600            // ~92 kB/s: ~36 mil amostras/s no formato acima
+#define CAPTURE_TX_BUFFER 8192         // Fila de transmissão do driver da UART durante a captura
+#define CAPTURE_RATE_MAX_HZ 10000      // analogRead() leva ~10-20 µs no ESP32
+#define CAPTURE_DURATION_MAX_S 600
+
+// Codifica em COBS sem o delimitador final; out precisa de length + length / 254 + 1 bytes.
+// Retorna o tamanho codificado.
+size_t cobsEncode(const uint8_t* data, size_t length, uint8_t* out);
+
+// Decodifica um quadro COBS (sem o delimitador); retorna o tamanho ou 0 se é inválido
+size_t cobsDecode(const uint8_t* data, size_t length, uint8_t* out);
+
+struct CaptureStats {
+  uint32_t frames = 0;
+  uint32_t samples = 0;
+  uint32_t droppedFrames = 0;  // Quadros descartados com a fila da serial cheia
+  uint32_t lateSamples = 0;    // Amostras lidas depois do prazo seguinte (taxa alta demais)
+  uint32_t maxLateUs = 0;
+  uint64_t wireBytes = 0;
+};
+
+// Monta os quadros: add() até ready(), então encode() grava o quadro codificado (com o
+// delimitador) e começa o próximo
+class CaptureFramer {
+ public:
+  void begin(uint32_t periodUs);
+
+  // Retorna true quando o quadro ficou cheio
+  bool add(uint16_t raw, uint32_t sampledUs);
+  bool ready() const { return _count == CAPTURE_SAMPLES_PER_FRAME; }
+  uint8_t count() const { return _count; }
+
+  // Quadro atual (cheio ou não; vazio é o marcador de fim) em out[CAPTURE_ENCODED_MAX]
+  size_t encode(uint8_t* out);
+
+ private:
+  uint8_t _frame[CAPTURE_FRAME_MAX];
+  uint8_t _count = 0;
+  uint16_t _periodUs = 0;
+  uint32_t _seq = 0;
+};
+
+// Só no ESP32. Captura bloqueante do pino analógico: troca a Serial para CAPTURE_BAUD com uma fila de
+// transmissão grande (o driver da UART do ESP-IDF a esvazia por interrupção enquanto o
+// loop amostra), amostra a rateHz por durationMs (0: enquanto keepGoing() for verdadeiro)
+// e volta a Serial para restoreBaud. A rede não é atendida durante a captura.
+CaptureStats runCapture(uint8_t pin, uint32_t rateHz, uint32_t durationMs, bool (*keepGoing)(),
+                        unsigned long restoreBaud);
@@ -0,0 +1,10 @@
+#pragma once
+
+// Horário atual em milissegundos desde a época Unix, ou 0 se o relógio ainda não foi
+// sincronizado (NTP). Em builds nativos (host) usa o relógio do sistema.
+unsigned long long getUnixTimestampMillis();
+
+// Fonte de horário mais precisa que o NTP do sistema (time_sync.h), consultada antes dele;
+// deve retornar 0 enquanto não estiver sincronizada
+typedef unsigned long long (*WallClockSource)();
+void setWallClockSource(WallClockSource source);
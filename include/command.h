@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Comandos aceitos no tópico sensors/<id>/command. Formato texto: uma palavra-chave
+// seguida de argumentos numéricos separados por espaço, ex.: "RATE 1000 300000", ou de
+// um argumento de texto livre (o resto da linha), ex.: "BROKERS a.local:1883,b.local".
+enum CommandType {
+  CMD_EMPTY,      // Payload vazio (ou só espaços)
+  CMD_INVALID,    // Texto não reconhecido ou argumentos errados
+  CMD_RESET,      // "RESET": apaga a configuração e reinicia
+  CMD_RATE,       // "RATE <min_ms> <max_ms>": limites do período adaptativo de amostragem
+  CMD_RAW,        // "RAW <0|1>": publica ou não as leituras brutas além dos resumos de janela
+  CMD_BATCH,      // "BATCH <n>": leituras em blocos comprimidos de até n amostras (0 = JSON)
+  CMD_HISTORY,    // "HISTORY <de_ms> <ate_ms> [fator]": reenvia o histórico da flash, com média de
+                  // "fator" leituras por amostra
+  CMD_INFLIGHT,   // "INFLIGHT <n>": mensagens QoS 1 em voo sem esperar o PUBACK
+  CMD_TRANSPORT,  // "TRANSPORT <0|1>": MQTT sobre TCP ou MQTT-SN sobre UDP (reinicia)
+  CMD_BROKERS,    // "BROKERS [host[:porta],...]": lista de brokers MQTT (vazia volta ao padrão)
+  CMD_TIME,       // "TIME <t1> <t2> <t3>": resposta do servidor de horário (time_sync.h), em µs
+  CMD_CAPTURE,    // "CAPTURE <hz> [segundos]": captura binária do ADC pela serial (capture.h)
+  CMD_FILTER,     // "FILTER <p1> [p2]": parâmetros do filtro das amostras do ADC (filter.h)
+};
+
+#define COMMAND_MAX_ARGS 4
+
+struct Command {
+  CommandType type;
+  uint8_t argCount;
+  double args[COMMAND_MAX_ARGS];
+  const uint8_t* text;  // Argumento de texto: aponta para dentro do payload (não terminado)
+  size_t textLength;
+};
+
+// Interpreta o payload recebido sem alocar e sem modificá-lo (o buffer do cliente MQTT
+// não tem espaço garantido para um terminador nulo). Ignora espaços nas pontas e
+// maiúsculas/minúsculas na palavra-chave.
+Command parseCommand(const uint8_t* payload, size_t length);
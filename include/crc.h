@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRCs em software, bit a bit: sem tabelas em RAM/flash e iguais no ESP32 e no host.
+// Usados em blocos pequenos (registros e cabeçalhos), onde a velocidade não importa.
+
+// CRC-16/CCITT-FALSE (polinômio 0x1021, valor inicial 0xFFFF)
+inline uint16_t crc16(const void* data, size_t length, uint16_t crc = 0xFFFF) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (length--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+// CRC-32 IEEE 802.3 (o mesmo de zlib.crc32 em Python)
+inline uint32_t crc32(const void* data, size_t length, uint32_t crc = 0) {
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  while (length--) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <stdint.h>
+
+// Filtro das amostras do ADC antes da conversão para umidade. A política (EMA, Kalman 1-D
+// ou Hampel) é escolhida na build por parâmetro de template; todas trabalham em ponto fixo
+// (contagens do ADC << FILTER_FRAC_BITS), sem float nem alocação no caminho de cada amostra.
+// Os dois parâmetros de cada política chegam como float (comando "FILTER <p1> [p2]", NVS)
+// e são convertidos uma vez em setParams():
+//   EMA     p1 = alfa (0 < alfa <= 1)                   p2 sem uso
+//   Kalman  p1 = q, ruído do processo (contagens²/amostra)  p2 = r, ruído da medida (contagens²)
+//   Hampel  p1 = janela (ímpar, 3..FILTER_HAMPEL_MAX)   p2 = k, limite em desvios (MAD escalado)
+
+#define FILTER_FRAC_BITS 8
+#define FILTER_ONE (1L << FILTER_FRAC_BITS)
+#define FILTER_HAMPEL_MAX 15
+#define FILTER_VARIANCE_MAX 65535.0f  // Limite de q e r do Kalman (contagens²)
+
+struct FilterStats {
+  uint32_t samples;
+  uint32_t rejected;  // Amostras trocadas pela mediana (Hampel)
+  int32_t input;      // Última amostra, em contagens
+  int32_t estimateQ;  // Última saída
+  int32_t spreadQ;    // Incerteza: desvio da estimativa (Kalman), MAD escalado (Hampel) ou
+                      // média dos resíduos absolutos (EMA)
+};
+
+// Raiz inteira (só para as métricas)
+inline uint32_t filterIsqrt(uint64_t x) {
+  uint64_t root = 0;
+  for (uint64_t bit = 1ULL << 62; bit != 0; bit >>= 2) {
+    if (x >= root + bit) {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+  }
+  return (uint32_t)root;
+}
+
+// Produto em Q16 com arredondamento (o deslocamento puro puxaria a estimativa para baixo)
+inline int32_t filterMulQ16(int32_t value, int32_t gainQ16) {
+  return (int32_t)(((int64_t)value * gainQ16 + (1L << 15)) >> 16);
+}
+
+// Média móvel exponencial: y += alfa * (x - y)
+class EmaPolicy {
+ public:
+  static const char* name() { return "ema"; }
+
+  EmaPolicy() { setParams(0.2f, 0); }
+
+  bool setParams(float alpha, float) {
+    if (!(alpha > 0 && alpha <= 1)) return false;
+    _alphaQ16 = (int32_t)(alpha * 65536.0f + 0.5f);
+    _params[0] = alpha;
+    return true;
+  }
+  float param(int i) const { return i == 0 ? _params[0] : 0; }
+
+  int32_t update(int32_t xQ, bool& rejected) {
+    rejected = false;
+    if (!_primed) {
+      _primed = true;
+      _y = xQ;
+      return _y;
+    }
+    int32_t residual = xQ - _y;
+    _y += filterMulQ16(residual, _alphaQ16);
+    _spread += filterMulQ16((residual < 0 ? -residual : residual) - _spread, _alphaQ16);
+    return _y;
+  }
+  int32_t spreadQ() const { return _spread; }
+
+ private:
+  int32_t _alphaQ16;
+  float _params[1];
+  bool _primed = false;
+  int32_t _y = 0;
+  int32_t _spread = 0;
+};
+
+// Kalman escalar com modelo de passeio aleatório: a umidade do solo muda devagar (q pequeno)
+// e o ruído do ADC é branco (r). Variância e ruídos em contagens² << FILTER_FRAC_BITS.
+class KalmanPolicy {
+ public:
+  static const char* name() { return "kalman"; }
+
+  KalmanPolicy() { setParams(1.0f, 225.0f); }
+
+  bool setParams(float q, float r) {
+    if (!(q > 0 && q <= FILTER_VARIANCE_MAX && r >= 1 && r <= FILTER_VARIANCE_MAX)) return false;
+    _qQ = (int32_t)(q * FILTER_ONE + 0.5f);
+    if (_qQ == 0) _qQ = 1;  // q = 0 congelaria a estimativa
+    _rQ = (int32_t)(r * FILTER_ONE + 0.5f);
+    _params[0] = q;
+    _params[1] = r;
+    return true;
+  }
+  float param(int i) const { return _params[i]; }
+
+  int32_t update(int32_t zQ, bool& rejected) {
+    rejected = false;
+    if (!_primed) {
+      _primed = true;
+      _x = zQ;
+      _p = _rQ;
+      return _x;
+    }
+    _p += _qQ;
+    int32_t gainQ16 = (int32_t)(((int64_t)_p << 16) / (_p + _rQ));
+    _x += filterMulQ16(zQ - _x, gainQ16);
+    _p = filterMulQ16(_p, 65536 - gainQ16);
+    if (_p < 1) _p = 1;
+    return _x;
+  }
+  // sqrt(P) em contagens, de volta para Q8: sqrt(p << 8) = sqrt(P) << 8
+  int32_t spreadQ() const { return (int32_t)filterIsqrt((uint64_t)_p << FILTER_FRAC_BITS); }
+
+ private:
+  int32_t _qQ;
+  int32_t _rQ;
+  float _params[2];
+  bool _primed = false;
+  int32_t _x = 0;
+  int32_t _p = 0;
+};
+
+// Hampel causal: a amostra nova é comparada com a mediana da janela (ela incluída) e, se
+// passa de k desvios (MAD * 1,4826), sai a mediana no lugar. Sem atraso para o sinal
+// limpo; um degrau verdadeiro passa depois de meia janela. Enquanto a janela enche, vale a
+// mediana do que já chegou (as 2 primeiras amostras passam direto).
+#define FILTER_MAD_SCALE_Q8 380       // 1,4826 em Q8: MAD -> desvio padrão de um ruído normal
+#define FILTER_MAD_MIN 1              // MAD mínimo (contagens): o ADC quantizado dá MAD 0 em sinal parado
+
+class HampelPolicy {
+ public:
+  static const char* name() { return "hampel"; }
+
+  HampelPolicy() { setParams(7, 3.0f); }
+
+  bool setParams(float window, float k) {
+    int n = (int)window;
+    if (n != window || n < 3 || n > FILTER_HAMPEL_MAX || n % 2 == 0 || !(k >= 0.5f && k <= 100)) return false;
+    if (n != _size) {
+      _size = (uint8_t)n;
+      _count = 0;
+      _next = 0;
+    }
+    _kQ8 = (int32_t)(k * FILTER_ONE + 0.5f);
+    _params[0] = (float)n;
+    _params[1] = k;
+    return true;
+  }
+  float param(int i) const { return _params[i]; }
+
+  int32_t update(int32_t xQ, bool& rejected) {
+    rejected = false;
+    _window[_next] = xQ;
+    _next = (uint8_t)((_next + 1) % _size);
+    if (_count < _size) _count++;
+    if (_count < 3) return xQ;
+
+    int32_t sorted[FILTER_HAMPEL_MAX] = {};
+    int32_t median = medianOf(_window, sorted);
+    int32_t deviations[FILTER_HAMPEL_MAX];
+    for (uint8_t i = 0; i < _count; i++) {
+      int32_t d = _window[i] - median;
+      deviations[i] = d < 0 ? -d : d;
+    }
+    int32_t mad = medianOf(deviations, sorted);
+    if (mad < FILTER_MAD_MIN * FILTER_ONE) mad = FILTER_MAD_MIN * FILTER_ONE;
+    _spread = (int32_t)(((int64_t)mad * FILTER_MAD_SCALE_Q8) >> FILTER_FRAC_BITS);
+
+    int32_t distance = xQ > median ? xQ - median : median - xQ;
+    if ((int64_t)distance << FILTER_FRAC_BITS > (int64_t)_spread * _kQ8) {
+      rejected = true;
+      return median;
+    }
+    return xQ;
+  }
+  int32_t spreadQ() const { return _spread; }
+
+ private:
+  // Ordenação por inserção numa cópia: janelas de até 15 amostras (as _count primeiras
+  // posições, que são as ocupadas enquanto a janela enche)
+  int32_t medianOf(const int32_t* values, int32_t* scratch) const {
+    for (uint8_t i = 0; i < _count; i++) {
+      int32_t v = values[i];
+      int j = i;
+      for (; j > 0 && scratch[j - 1] > v; j--) scratch[j] = scratch[j - 1];
+      scratch[j] = v;
+    }
+    return scratch[_count / 2];
+  }
+
+  uint8_t _size = 0;
+  uint8_t _count = 0;
+  uint8_t _next = 0;
+  int32_t _kQ8 = 0;
+  float _params[2];
+  int32_t _window[FILTER_HAMPEL_MAX];
+  int32_t _spread = 0;
+};
+
+// Estágio de filtro com a política escolhida: recebe e devolve contagens do ADC
+template <typename Policy>
+class SensorFilter {
+ public:
+  const char* name() const { return Policy::name(); }
+  bool setParams(float p1, float p2) { return _policy.setParams(p1, p2); }
+  float param(int i) const { return _policy.param(i); }
+  const Policy& policy() const { return _policy; }
+
+  int update(int raw) {
+    bool rejected;
+    int32_t yQ = _policy.update((int32_t)raw << FILTER_FRAC_BITS, rejected);
+    _stats.samples++;
+    if (rejected) _stats.rejected++;
+    _stats.input = raw;
+    _stats.estimateQ = yQ;
+    return (int)((yQ + FILTER_ONE / 2) >> FILTER_FRAC_BITS);
+  }
+
+  const FilterStats& stats() {
+    _stats.spreadQ = _policy.spreadQ();
+    return _stats;
+  }
+
+ private:
+  Policy _policy;
+  FilterStats _stats = {};
+};
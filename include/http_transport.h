@@ -0,0 +1,210 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "transport.h"
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Transporte HTTP/1.1 em lote (interface de transport.h): send() acrescenta a mensagem ao
+// lote e flush() manda o lote inteiro num único POST, numa conexão keep-alive reaproveitada
+// entre os envios (sem handshake TCP por lote).
+//
+// Corpo (Content-Type HTTP_CONTENT_TYPE), um registro por mensagem, binário inclusive:
+//   <tópico> <bytes do payload>\n<payload>\n
+//
+// Resposta 2xx confirma o lote inteiro; o corpo da resposta, se houver, traz comandos
+// para o dispositivo (um por linha), entregues ao callback com o tópico de comando. Como
+// o servidor só fala quando é chamado, os comandos chegam no próximo flush(). 4xx recusa
+// o lote (descartado, como um PUBACK com erro); 5xx ou falha de rede mantêm o lote para o
+// próximo flush(). O lote é a cópia que garante a entrega: send() só falha quando o
+// lote está cheio e não pôde ser enviado.
+//
+// O socket é um parâmetro de template (WiFiClient no ESP32 ou qualquer classe com
+// connect/connected/write/available/read/stop).
+
+#ifndef HTTP_BATCH_BYTES
+#define HTTP_BATCH_BYTES 4096          // Lote pendente; cheio, send() envia antes de acrescentar
+#endif
+#define HTTP_HEADER_MAX 192            // Cabeçalho da requisição, montado logo antes do lote
+#define HTTP_RESPONSE_TIMEOUT_MS 5000
+#define HTTP_LINE_MAX 256              // Linha de status, cabeçalho ou comando da resposta
+#define HTTP_CONTENT_TYPE "application/x-agroflow-batch"
+
+template <typename Socket>
+class HttpBatchTransport {
+ public:
+  HttpBatchTransport(Socket& socket, MqttMillisFn millisFn, const char* host, uint16_t port, const char* path)
+      : _socket(socket), _millis(millisFn), _host(host), _port(port), _path(path) {}
+
+  void begin(const TransportConfig& config) { _config = config; }
+
+  bool connect() {
+    if (!_socket.connect(_host, _port)) {
+      _state = MQTT_STATE_CONNECT_FAILED;
+      return false;
+    }
+    _state = MQTT_STATE_CONNECTED;
+    _stats.connects++;
+    return true;
+  }
+
+  bool connecting() const { return false; }
+  bool connected() {
+    if (_state == MQTT_STATE_CONNECTED && !_socket.connected()) _state = MQTT_STATE_CONNECTION_LOST;
+    return _state == MQTT_STATE_CONNECTED;
+  }
+
+  void loop() {}
+  bool ready() const { return true; }
+
+  bool send(const char* topic, ByteSpan payload, int8_t qos) {
+    char head[MQTT_TOPIC_MAX + 16];
+    int headLength = snprintf(head, sizeof(head), "%s %u\n", topic, (unsigned)payload.size);
+    if (headLength <= 0 || (size_t)headLength >= sizeof(head)) {
+      _stats.rejected++;
+      return false;
+    }
+    size_t length = (size_t)headLength + payload.size + 1;
+    if (length > HTTP_BATCH_BYTES) {
+      _stats.rejected++;
+      return false;
+    }
+    if (_length + length > HTTP_BATCH_BYTES && !flush()) return false;
+    uint8_t* record = _batch + HTTP_HEADER_MAX + _length;
+    memcpy(record, head, headLength);
+    memcpy(record + headLength, payload.data, payload.size);
+    record[length - 1] = '\n';
+    _length += length;
+    _records++;
+    if (qos > 0) {
+      _confirmed++;
+      _stats.published++;
+    } else {
+      _stats.qos0++;
+    }
+    return true;
+  }
+
+  bool flush() {
+    if (_records == 0) return true;
+    if (!connected() && !connect()) return false;
+    // Cabeçalho e lote num único write: em dois, o segundo segmento pequeno esperaria o ACK
+    // atrasado do primeiro (Nagle)
+    char header[HTTP_HEADER_MAX];
+    int n = snprintf(header, sizeof(header),
+                     "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: " HTTP_CONTENT_TYPE
+                     "\r\nX-Device-Id: %s\r\nContent-Length: %u\r\n\r\n",
+                     _path, _host, _config.clientId ? _config.clientId : "", (unsigned)_length);
+    if (n <= 0 || (size_t)n >= sizeof(header)) return false;
+    uint8_t* request = _batch + HTTP_HEADER_MAX - n;
+    memcpy(request, header, n);
+    unsigned long start = _millis();
+    if (_socket.write(request, n + _length) != n + _length) {
+      lose();
+      return false;
+    }
+    int status = readResponse();
+    if (status < 0 || status >= 500) {
+      lose();
+      return false;
+    }
+    if (status >= 300) {
+      _stats.refused += _confirmed;
+    } else {
+      uint32_t latency = _millis() - start;  // Ida e volta do POST
+      _stats.acked += _confirmed;
+      _stats.lastAckMs = latency;
+      if (latency > _stats.maxAckMs) _stats.maxAckMs = latency;
+      _stats.totalAckMs += (uint64_t)latency * _confirmed;
+    }
+    _length = 0;
+    _records = 0;
+    _confirmed = 0;
+    return true;
+  }
+
+  void setWindow(uint8_t) {}
+  uint8_t window() const { return 0; }
+  size_t inflight() const { return _records; }  // Mensagens no lote ainda sem resposta 2xx
+  int state() const { return _state; }
+  const char* protocol() const { return "http"; }
+  const MqttStats& stats() const { return _stats; }
+
+ private:
+  void lose() {
+    _socket.stop();
+    _state = MQTT_STATE_CONNECTION_LOST;
+  }
+
+  int readByte(unsigned long deadline) {
+    while (!_socket.available()) {
+      if (!_socket.connected() || (long)(_millis() - deadline) >= 0) return -1;
+#ifdef ARDUINO
+      yield();
+#endif
+    }
+    return _socket.read();
+  }
+
+  // Linha sem o \r\n final (cortada em capacity - 1); false em timeout ou fechamento
+  bool readLine(char* line, size_t capacity, unsigned long deadline, long* budget = nullptr) {
+    size_t n = 0;
+    for (;;) {
+      if (budget && *budget <= 0) break;
+      int c = readByte(deadline);
+      if (c < 0) return false;
+      if (budget) (*budget)--;
+      if (c == '\n') break;
+      if (c != '\r' && n + 1 < capacity) line[n++] = (char)c;
+    }
+    line[n] = '\0';
+    return true;
+  }
+
+  // Status da resposta, ou -1. Sem Content-Length (ou com "Connection: close") não há como
+  // achar o fim da resposta numa conexão reaproveitada: a conexão é fechada depois.
+  int readResponse() {
+    unsigned long deadline = _millis() + HTTP_RESPONSE_TIMEOUT_MS;
+    char line[HTTP_LINE_MAX];
+    if (!readLine(line, sizeof(line), deadline) || strncmp(line, "HTTP/1.", 7) != 0) return -1;
+    int status = atoi(line + 9);
+    long contentLength = -1;
+    bool keepAlive = true;
+    while (readLine(line, sizeof(line), deadline)) {
+      if (line[0] == '\0') {
+        if (contentLength < 0) keepAlive = false;
+        long budget = contentLength < 0 ? 0 : contentLength;
+        while (budget > 0 && readLine(line, sizeof(line), deadline, &budget)) {
+          if (line[0] && status < 300 && _config.callback) {
+            _config.callback((char*)_config.commandTopic, (uint8_t*)line, strlen(line));
+          }
+        }
+        if (!keepAlive || budget > 0) lose();
+        return status;
+      }
+      if (strncasecmp(line, "Content-Length:", 15) == 0) contentLength = atol(line + 15);
+      if (strncasecmp(line, "Connection:", 11) == 0 && strstr(line + 11, "close")) keepAlive = false;
+    }
+    return -1;
+  }
+
+  Socket& _socket;
+  MqttMillisFn _millis;
+  const char* _host;
+  uint16_t _port;
+  const char* _path;
+  TransportConfig _config = {};
+  int _state = MQTT_STATE_DISCONNECTED;
+  MqttStats _stats;
+
+  uint8_t _batch[HTTP_HEADER_MAX + HTTP_BATCH_BYTES];  // Lote a partir de HTTP_HEADER_MAX
+  size_t _length = 0;
+  size_t _records = 0;
+  size_t _confirmed = 0;  // Registros com QoS 1 no lote
+};
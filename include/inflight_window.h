@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Janela de mensagens QoS 1 aguardando confirmação, compartilhada pelos clientes MQTT
+// (mqtt_client.h) e MQTT-SN (mqttsn_client.h). Cada mensagem ocupa um trecho contíguo de
+// uma arena circular e um descritor; os dois são liberados em ordem, conforme as
+// confirmações chegam (uma confirmação fora de ordem espera as anteriores).
+// O conteúdo do trecho e o significado de tag/flags ficam a cargo do cliente.
+
+struct InflightEntry {
+  uint16_t offset;  // Início do trecho na arena
+  uint16_t length;
+  uint16_t packetId;
+  uint16_t tag;     // Livre para o cliente (ex.: tamanho do tópico, índice do tópico)
+  uint8_t flags;    // Livre para o cliente (ex.: retain)
+  uint8_t retries;
+  bool acked;
+  unsigned long sentAt;
+};
+
+template <size_t MaxEntries, size_t ArenaSize>
+class InflightWindow {
+ public:
+  size_t size() const { return _count; }
+  bool empty() const { return _count == 0; }
+  bool full() const { return _count >= MaxEntries; }
+
+  // i = 0 é a mais antiga
+  InflightEntry& at(size_t i) { return _entries[(_first + i) % MaxEntries]; }
+  uint8_t* data(const InflightEntry& entry) { return _arena + entry.offset; }
+
+  // Reserva length bytes contíguos para a próxima mensagem; nullptr se não houver espaço.
+  // A reserva só vale depois de commit().
+  uint8_t* reserve(size_t length) {
+    if (full()) return nullptr;
+    int offset = allocate(length);
+    if (offset < 0) return nullptr;
+    _reserved = (size_t)offset;
+    return _arena + offset;
+  }
+
+  InflightEntry& commit(size_t length, uint16_t packetId, unsigned long now) {
+    InflightEntry& entry = _entries[(_first + _count) % MaxEntries];
+    entry.offset = (uint16_t)_reserved;
+    entry.length = (uint16_t)length;
+    entry.packetId = packetId;
+    entry.tag = 0;
+    entry.flags = 0;
+    entry.retries = 0;
+    entry.acked = false;
+    entry.sentAt = now;
+    _count++;
+    _head = _reserved + length;
+    return entry;
+  }
+
+  // Descritor ainda não confirmado com este packet id, ou nullptr
+  InflightEntry* find(uint16_t packetId) {
+    for (size_t i = 0; i < _count; i++) {
+      InflightEntry& entry = at(i);
+      if (entry.packetId == packetId && !entry.acked) return &entry;
+    }
+    return nullptr;
+  }
+
+  bool contains(uint16_t packetId) const {
+    for (size_t i = 0; i < _count; i++) {
+      if (_entries[(_first + i) % MaxEntries].packetId == packetId) return true;
+    }
+    return false;
+  }
+
+  // Libera as confirmadas do início da janela
+  void release() {
+    while (_count > 0 && _entries[_first].acked) {
+      _first = (_first + 1) % MaxEntries;
+      _count--;
+    }
+    if (_count == 0) _head = 0;
+  }
+
+ private:
+  int allocate(size_t length) {
+    if (length > ArenaSize) return -1;
+    if (_count == 0) return 0;
+    size_t tail = _entries[_first].offset;
+    if (_head > tail) {
+      if (_head + length <= ArenaSize) return (int)_head;
+      return length <= tail ? 0 : -1;  // Volta ao início
+    }
+    return _head + length <= tail ? (int)_head : -1;
+  }
+
+  InflightEntry _entries[MaxEntries];
+  size_t _first = 0;
+  size_t _count = 0;
+  uint8_t _arena[ArenaSize];
+  size_t _head = 0;      // Próximo byte livre depois da mensagem mais recente
+  size_t _reserved = 0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Escritor de JSON em fluxo: acumula a saída num buffer fixo e a entrega em pedaços ao
+// "sink" (qualquer chamável com a assinatura void(const char* data, size_t len)).
+// O uso de memória é constante, independente do tamanho do documento gerado.
+template <typename Sink, size_t N = 128>
+class JsonStreamWriter {
+ public:
+  explicit JsonStreamWriter(Sink sink) : _sink(sink) {}
+
+  void raw(char c) {
+    if (_len == N) flush();
+    _buf[_len++] = c;
+  }
+
+  void raw(const char* s) {
+    while (*s) raw(*s++);
+  }
+
+  // Escreve uma string JSON entre aspas, escapando aspas, barras e caracteres de controle.
+  // Bytes UTF-8 (>= 0x80) passam sem alteração.
+  void string(const char* s, size_t maxLen = SIZE_MAX) {
+    static const char hex[] = "0123456789abcdef";
+    raw('"');
+    for (size_t i = 0; i < maxLen && s[i]; i++) {
+      uint8_t c = (uint8_t)s[i];
+      switch (c) {
+        case '"':  raw("\\\""); break;
+        case '\\': raw("\\\\"); break;
+        case '\n': raw("\\n"); break;
+        case '\r': raw("\\r"); break;
+        case '\t': raw("\\t"); break;
+        case '\b': raw("\\b"); break;
+        case '\f': raw("\\f"); break;
+        default:
+          if (c < 0x20) {
+            raw("\\u00");
+            raw(hex[c >> 4]);
+            raw(hex[c & 0x0F]);
+          } else {
+            raw((char)c);
+          }
+      }
+    }
+    raw('"');
+  }
+
+  void number(long v) {
+    char tmp[12];
+    snprintf(tmp, sizeof(tmp), "%ld", v);
+    raw(tmp);
+  }
+
+  // Chave de objeto já com os dois-pontos: "chave":
+  void key(const char* k) {
+    string(k);
+    raw(':');
+  }
+
+  void flush() {
+    if (_len == 0) return;
+    _sink(_buf, _len);
+    _len = 0;
+  }
+
+ private:
+  Sink _sink;
+  char _buf[N];
+  size_t _len = 0;
+};
@@ -0,0 +1,495 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "inflight_window.h"
+#include "mqtt_packet.h"
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Cliente MQTT enxuto, com QoS 1 em janela: até window() mensagens ficam em voo ao
+// mesmo tempo, sem esperar o PUBACK de cada uma. As mensagens QoS 1 (tópico e payload) são
+// copiadas para uma arena circular e só saem dela com o PUBACK; numa reconexão todas as
+// pendentes são reenviadas, na ordem, com os mesmos packet ids (DUP marcado se o broker
+// manteve a sessão). QoS 0 é escrito direto do buffer do chamador, sem cópia.
+//
+// Fala MQTT 5 e cai para o 3.1.1 quando o broker recusa a versão no CONNACK (0x01 ou
+// 0x84); a versão escolhida fica no cliente até setProtocol() (o MqttTransport guarda uma
+// por broker, broker_pool.h). Conexão fechada sem CONNACK não conta: é queda, não versão.
+// No 5:
+//  - cada tópico ganha um alias na primeira publicação da conexão e as seguintes mandam só
+//    os 2 bytes do alias no lugar do nome;
+//  - a sessão dura setSessionExpiry() segundos depois da queda, então comandos QoS 1
+//    enviados com o dispositivo fora do ar são entregues na volta (com cleanSession false);
+//  - a janela é limitada pelo Receive Maximum do broker.
+// O cabeçalho do PUBLISH é montado a cada envio, porque os aliases valem só por conexão.
+//
+// O socket é um parâmetro de template (WiFiClient no ESP32 ou qualquer classe com
+// connect/connected/write/available/read/stop), então o mesmo código roda no host.
+// A interface pública segue a do PubSubClient, que este cliente substitui; connect()
+// espera o CONNACK como o dele, e beginConnect() é a versão sem espera (o CONNACK é tratado
+// por loop()), para quem não pode parar o loop() do firmware.
+
+#ifndef MQTT_INFLIGHT_MAX
+#define MQTT_INFLIGHT_MAX 16          // Limite da janela (mensagens QoS 1 sem PUBACK)
+#endif
+#ifndef MQTT_INFLIGHT_ARENA
+#define MQTT_INFLIGHT_ARENA 6144      // Bytes para guardar os PUBLISH em voo
+#endif
+#ifndef MQTT_RX_BUFFER
+#define MQTT_RX_BUFFER 512            // Maior pacote recebido (comandos); maiores são descartados
+#endif
+#ifndef MQTT_TOPIC_ALIAS_MAX
+#define MQTT_TOPIC_ALIAS_MAX 8        // Aliases de tópico por conexão (limitado também pelo broker)
+#endif
+#define MQTT_TOPIC_MAX 128            // Maior tópico publicado
+#define MQTT_ALIAS_TOPIC_MAX 48       // Maior tópico que recebe alias (guardado por cópia)
+#define MQTT_RECEIVE_MAXIMUM 8        // PUBLISH QoS 1 que o broker pode nos mandar sem PUBACK
+#define MQTT_CONNECT_TIMEOUT_MS 5000  // Do CONNECT ao CONNACK
+#define MQTT_ACK_TIMEOUT_MS 30000     // Sem PUBACK por este tempo: conexão é dada como perdida
+
+enum MqttState {
+  MQTT_STATE_CONNECTING = -6,  // CONNECT enviado, esperando o CONNACK
+  MQTT_STATE_ASLEEP = -5,  // MQTT-SN: cliente dormindo, o gateway guarda as mensagens
+  MQTT_STATE_CONNECTION_TIMEOUT = -4,
+  MQTT_STATE_CONNECTION_LOST = -3,
+  MQTT_STATE_CONNECT_FAILED = -2,
+  MQTT_STATE_DISCONNECTED = -1,
+  MQTT_STATE_CONNECTED = 0,
+  // 1 a 5: código de recusa do CONNACK
+};
+
+struct MqttStats {
+  uint32_t published = 0;      // QoS 1 aceitos na janela
+  uint32_t acked = 0;
+  uint32_t retransmitted = 0;  // Reenvios depois de reconectar
+  uint32_t rejected = 0;       // Recusados por janela ou arena cheia (ou maiores que o limite do broker)
+  uint32_t refused = 0;        // PUBACK com código de erro do MQTT 5 (a mensagem não é reenviada)
+  uint32_t qos0 = 0;
+  uint32_t connects = 0;
+  uint32_t fallbacks = 0;      // Conexões refeitas em 3.1.1 porque o broker recusou o MQTT 5
+  uint32_t aliased = 0;        // PUBLISH enviados só com o alias do tópico
+  uint32_t aliasBytesSaved = 0;
+  uint32_t lastAckMs = 0;      // Tempo do PUBLISH ao PUBACK
+  uint32_t maxAckMs = 0;
+  uint64_t totalAckMs = 0;
+
+  uint32_t meanAckMs() const { return acked ? (uint32_t)(totalAckMs / acked) : 0; }
+};
+
+typedef unsigned long (*MqttMillisFn)();
+
+template <typename Socket>
+class MqttClient {
+ public:
+  typedef void (*Callback)(char* topic, uint8_t* payload, unsigned int length);
+
+  MqttClient(Socket& socket, MqttMillisFn millisFn) : _socket(socket), _millis(millisFn) {}
+
+  void setServer(const char* host, uint16_t port) {
+    _host = host;
+    _port = port;
+  }
+  void setCallback(Callback callback) { _callback = callback; }
+  void setKeepAlive(uint16_t seconds) { _keepAliveS = seconds; }
+  void setWindow(uint8_t window) {
+    _window = window < 1 ? 1 : (window > MQTT_INFLIGHT_MAX ? MQTT_INFLIGHT_MAX : window);
+  }
+  // MQTT_V5 (padrão, com queda para o 3.1.1) ou MQTT_V311
+  void setProtocol(uint8_t version) { _protocol = version == MQTT_V5 ? MQTT_V5 : MQTT_V311; }
+  // Só MQTT 5; no 3.1.1 uma sessão não limpa dura até a próxima conexão com cleanSession
+  void setSessionExpiry(uint32_t seconds) { _sessionExpiryS = seconds; }
+
+  // Janela efetiva: a configurada, limitada pelo Receive Maximum do broker
+  uint8_t window() const { return _window < _serverReceiveMax ? _window : (uint8_t)_serverReceiveMax; }
+  size_t inflight() const { return _inflight.size(); }
+  bool windowFull() const { return _inflight.size() >= window(); }
+  int state() const { return _state; }
+  uint8_t protocol() const { return _protocol; }
+  uint32_t sessionExpiry() const { return _sessionExpiryS; }
+  const MqttStats& stats() const { return _stats; }
+
+  // Abre o TCP e envia o CONNECT sem esperar o CONNACK: loop() trata a resposta e
+  // connecting() fica true até ela chegar (ou até MQTT_CONNECT_TIMEOUT_MS). Com cleanSession
+  // false o broker mantém a sessão: inscrições e comandos QoS 1 pendentes. Os ponteiros
+  // precisam valer até o fim da tentativa (a queda para o 3.1.1 manda o CONNECT de novo).
+  bool beginConnect(const char* clientId, bool cleanSession = true, const char* username = nullptr,
+                    const char* password = nullptr) {
+    _clientId = clientId;
+    _cleanSession = cleanSession;
+    _username = username;
+    _password = password;
+    return sendConnect();
+  }
+  bool connecting() const { return _state == MQTT_STATE_CONNECTING; }
+
+  // Conecta e espera o CONNACK (bloqueia até MQTT_CONNECT_TIMEOUT_MS, como o PubSubClient)
+  bool connect(const char* clientId, bool cleanSession = true, const char* username = nullptr,
+               const char* password = nullptr) {
+    if (!beginConnect(clientId, cleanSession, username, password)) return false;
+    while (connecting()) {
+      loop();
+#ifdef ARDUINO
+      yield();
+#endif
+    }
+    return _state == MQTT_STATE_CONNECTED;
+  }
+
+  bool connected() {
+    if (_state != MQTT_STATE_CONNECTED) return false;
+    if (!_socket.connected()) lose();
+    return _state == MQTT_STATE_CONNECTED;
+  }
+
+  void disconnect() {
+    if (_state == MQTT_STATE_CONNECTED) {
+      uint8_t packet[2];
+      _socket.write(packet, mqttWriteEmpty(packet, MQTT_DISCONNECT));
+    }
+    _socket.stop();
+    _state = MQTT_STATE_DISCONNECTED;
+  }
+
+  bool subscribe(const char* topic, uint8_t qos = 1) {
+    if (!connected()) return false;
+    uint8_t packet[160];
+    size_t n = mqttWriteSubscribe(packet, sizeof(packet), _protocol, nextPacketId(), topic, qos > 1 ? 1 : qos);
+    return n > 0 && send(packet, n);
+  }
+
+  // QoS 1: false se a janela ou a arena estiverem cheias (a mensagem continua com o chamador)
+  bool publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos = 0, bool retain = false) {
+    if (!connected()) return false;
+    size_t topicLength = strlen(topic);
+    if (topicLength > MQTT_TOPIC_MAX ||
+        (_maxPacketSize && mqttPublishSize(_protocol, topic, length, qos ? 1 : 0, 0) > _maxPacketSize)) {
+      _stats.rejected++;
+      return false;
+    }
+    if (qos == 0) {
+      if (!sendPublish(topic, payload, length, 0, retain, 0, false)) return false;
+      _stats.qos0++;
+      return true;
+    }
+
+    // Na arena: tópico (com terminador) seguido do payload; tag = tamanho do tópico
+    size_t size = topicLength + 1 + length;
+    uint8_t* data = windowFull() ? nullptr : _inflight.reserve(size);
+    if (data == nullptr) {
+      _stats.rejected++;
+      return false;
+    }
+    memcpy(data, topic, topicLength + 1);
+    memcpy(data + topicLength + 1, payload, length);
+    InflightEntry& entry = _inflight.commit(size, nextPacketId(), _millis());
+    entry.tag = (uint16_t)topicLength;
+    entry.flags = retain ? 1 : 0;
+    _stats.published++;
+    sendEntry(entry, false);  // Se falhar, a mensagem já está na janela e sai na reconexão
+    return true;
+  }
+
+  bool publish(const char* topic, const char* payload, size_t length, uint8_t qos = 0, bool retain = false) {
+    return publish(topic, (const uint8_t*)payload, length, qos, retain);
+  }
+
+  // Recebe pacotes (o CONNACK, durante a conexão), entrega comandos ao callback, mantém o
+  // keepalive e detecta PUBACK atrasado
+  bool loop() {
+    if (connecting() && !awaitConnack()) return false;
+    if (!connected()) return false;
+    while (_socket.available() > 0 && receive()) {
+      process();
+      if (_state != MQTT_STATE_CONNECTED) return false;
+    }
+
+    unsigned long now = _millis();
+    uint32_t keepAliveMs = (uint32_t)_keepAliveS * 1000;
+    if (!_inflight.empty() && now - _inflight.at(0).sentAt > MQTT_ACK_TIMEOUT_MS) {
+      lose();
+      return false;
+    }
+    if (keepAliveMs > 0 && now - _lastInbound > keepAliveMs + keepAliveMs / 2) {
+      lose();
+      return false;
+    }
+    // PINGREQ quando o broker fica calado (só há tráfego de saída QoS 0) ou quando nós ficamos
+    if (keepAliveMs > 0 && (now - _lastOutbound >= keepAliveMs ||
+                            (now - _lastInbound >= keepAliveMs && _lastPingAt < _lastInbound))) {
+      uint8_t packet[2];
+      send(packet, mqttWriteEmpty(packet, MQTT_PINGREQ));
+      _lastPingAt = now;
+    }
+    return _state == MQTT_STATE_CONNECTED;
+  }
+
+ private:
+  bool sendConnect() {
+    if (_socket.connected()) _socket.stop();
+    _rxLen = 0;
+    _rxSkip = 0;
+    if (!_socket.connect(_host, _port)) {
+      _state = MQTT_STATE_CONNECT_FAILED;
+      return false;
+    }
+
+    MqttConnectOptions options = { _protocol, _clientId, _keepAliveS, _cleanSession, _username, _password,
+                                   _sessionExpiryS, MQTT_RECEIVE_MAXIMUM };
+    size_t n = mqttWriteConnect(_rx, sizeof(_rx), options);
+    if (n == 0 || _socket.write(_rx, n) != n) {
+      _socket.stop();
+      _state = MQTT_STATE_CONNECT_FAILED;
+      return false;
+    }
+    _state = MQTT_STATE_CONNECTING;  // receive() vê o fechamento sem CONNACK como perda de conexão
+    _connectSentAt = _millis();
+    return true;
+  }
+
+  // Confere se o CONNACK chegou; true quando a conexão ficou pronta
+  bool awaitConnack() {
+    if (!receive()) return false;
+    uint8_t first;
+    uint32_t remaining;
+    int header = mqttReadFixedHeader(_rx, _rxLen, first, remaining);
+    if (header <= 0 || _rxLen < header + remaining) {
+      if (_millis() - _connectSentAt < MQTT_CONNECT_TIMEOUT_MS) return false;
+      _socket.stop();
+      _state = MQTT_STATE_CONNECTION_TIMEOUT;
+      return false;
+    }
+    MqttConnack connack;
+    bool sawConnack = (first >> 4) == MQTT_CONNACK;
+    if (!sawConnack || !mqttParseConnack(_rx + header, remaining, _protocol, connack) || connack.reason != 0) {
+      _state = sawConnack && connack.reason != 0 ? (int)connack.reason : (int)MQTT_STATE_CONNECT_FAILED;
+      _socket.stop();
+      // Broker só 3.1.1: recusa a versão no CONNACK; a nova tentativa segue em loop()
+      bool badVersion = _state == MQTT_CONNACK_BAD_VERSION_V311 || _state == MQTT_CONNACK_BAD_VERSION_V5;
+      if (_protocol == MQTT_V5 && badVersion) {
+        _protocol = MQTT_V311;
+        _stats.fallbacks++;
+        sendConnect();
+      }
+      return false;
+    }
+    consume(header + remaining);
+    _state = MQTT_STATE_CONNECTED;
+    _stats.connects++;
+    _lastInbound = _lastOutbound = _millis();
+    _lastPingAt = 0;
+    _serverReceiveMax = connack.receiveMaximum ? connack.receiveMaximum : 65535;
+    _maxPacketSize = connack.maximumPacketSize;
+    if (connack.sessionExpiryGiven) _sessionExpiryS = connack.sessionExpiryS;
+    _aliasLimit = connack.topicAliasMaximum < MQTT_TOPIC_ALIAS_MAX ? connack.topicAliasMaximum
+                                                                   : MQTT_TOPIC_ALIAS_MAX;
+    _aliasCount = 0;
+    retransmit(connack.sessionPresent);
+    return _state == MQTT_STATE_CONNECTED;
+  }
+
+  void lose() {
+    _socket.stop();
+    _state = MQTT_STATE_CONNECTION_LOST;
+  }
+
+  bool send(const uint8_t* data, size_t length) {
+    if (length == 0) return true;
+    if (_socket.write(data, length) != length) {
+      lose();
+      return false;
+    }
+    _lastOutbound = _millis();
+    return true;
+  }
+
+  // Lê o que houver no socket para o buffer de recepção (ou descarta um pacote grande demais)
+  bool receive() {
+    if (!_socket.connected()) {
+      lose();
+      return false;
+    }
+    if (_socket.available() <= 0) return true;
+    if (_rxSkip > 0) {
+      uint8_t scratch[64];
+      int n = _socket.read(scratch, _rxSkip < sizeof(scratch) ? _rxSkip : sizeof(scratch));
+      if (n > 0) _rxSkip -= n;
+      return true;
+    }
+    int n = _socket.read(_rx + _rxLen, sizeof(_rx) - _rxLen);
+    if (n > 0) {
+      _rxLen += n;
+      _lastInbound = _millis();
+    }
+    return true;
+  }
+
+  void consume(size_t length) {
+    memmove(_rx, _rx + length, _rxLen - length);
+    _rxLen -= length;
+  }
+
+  void process() {
+    while (_rxSkip == 0) {
+      uint8_t first;
+      uint32_t remaining;
+      int header = mqttReadFixedHeader(_rx, _rxLen, first, remaining);
+      if (header < 0) {
+        lose();
+        return;
+      }
+      if (header == 0) return;
+      size_t total = header + remaining;
+      if (total > sizeof(_rx)) {
+        _rxSkip = total - _rxLen;
+        _rxLen = 0;
+        return;
+      }
+      if (_rxLen < total) return;
+      handle(first, _rx + header, remaining);
+      consume(total);
+    }
+  }
+
+  // Tópico do PUBLISH: alias já estabelecido (nome omitido), alias novo (nome + alias) ou
+  // nenhum (3.1.1, broker sem aliases ou tabela cheia)
+  uint16_t topicAlias(const char* topic, bool& omitTopic) {
+    omitTopic = false;
+    if (_protocol != MQTT_V5) return 0;
+    for (uint8_t i = 0; i < _aliasCount; i++) {
+      if (strcmp(_aliases[i], topic) == 0) {
+        omitTopic = true;
+        return i + 1;
+      }
+    }
+    if (_aliasCount >= _aliasLimit || strlen(topic) >= MQTT_ALIAS_TOPIC_MAX) return 0;
+    strcpy(_aliases[_aliasCount], topic);
+    return ++_aliasCount;
+  }
+
+  bool sendPublish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain,
+                   uint16_t packetId, bool dup) {
+    bool omitTopic;
+    uint16_t alias = topicAlias(topic, omitTopic);
+    uint8_t header[MQTT_FIXED_HEADER_MAX + 2 + MQTT_TOPIC_MAX + 2 + 4];
+    size_t n = mqttWritePublishHeader(header, sizeof(header), _protocol, omitTopic ? "" : topic, length, qos,
+                                      retain, packetId, alias);
+    if (n == 0) return false;
+    if (dup) header[0] |= MQTT_PUBLISH_DUP;
+    if (omitTopic) {
+      _stats.aliased++;
+      _stats.aliasBytesSaved += strlen(topic);
+    }
+    return send(header, n) && send(payload, length);
+  }
+
+  bool sendEntry(const InflightEntry& entry, bool dup) {
+    const uint8_t* data = _inflight.data(entry);
+    return sendPublish((const char*)data, data + entry.tag + 1, entry.length - entry.tag - 1, 1, entry.flags & 1,
+                       entry.packetId, dup);
+  }
+
+  void handle(uint8_t first, uint8_t* body, uint32_t length) {
+    switch (first >> 4) {
+      case MQTT_PUBACK:
+        // MQTT 5: código de motivo opcional; erro (>= 0x80) libera a mensagem sem reenvio
+        if (length >= 3 && body[2] >= 0x80) _stats.refused++;
+        if (length >= 2) acknowledge((uint16_t)(body[0] << 8 | body[1]));
+        break;
+      case MQTT_DISCONNECT:  // MQTT 5: o broker avisa antes de fechar
+        lose();
+        break;
+      case MQTT_PUBLISH: {
+        if (length < 2) break;
+        uint8_t qos = (first >> 1) & 0x03;
+        uint16_t topicLength = (uint16_t)(body[0] << 8 | body[1]);
+        size_t pos = 2 + topicLength + (qos ? 2 : 0);
+        if (pos > length) break;
+        uint16_t packetId = qos ? (uint16_t)(body[2 + topicLength] << 8 | body[3 + topicLength]) : 0;
+        if (_protocol == MQTT_V5) {
+          uint32_t properties;
+          int n = mqttReadVarInt(body + pos, length - pos, properties);
+          if (n <= 0 || pos + n + properties > length) break;
+          pos += n + properties;  // Não anunciamos Topic Alias Maximum: o broker sempre manda o nome
+        }
+        // Recua o tópico um byte para caber o terminador nulo sem copiar o payload
+        memmove(body + 1, body + 2, topicLength);
+        body[1 + topicLength] = '\0';
+        if (_callback) _callback((char*)body + 1, body + pos, length - pos);
+        if (qos > 0 && _state == MQTT_STATE_CONNECTED) {
+          uint8_t ack[4];
+          send(ack, mqttWriteAck(ack, MQTT_PUBACK, packetId));
+        }
+        break;
+      }
+      default:
+        break;  // SUBACK e PINGRESP só renovam _lastInbound
+    }
+  }
+
+  void acknowledge(uint16_t packetId) {
+    InflightEntry* entry = _inflight.find(packetId);
+    if (entry != nullptr) {
+      entry->acked = true;
+      uint32_t latency = _millis() - entry->sentAt;
+      _stats.acked++;
+      _stats.lastAckMs = latency;
+      if (latency > _stats.maxAckMs) _stats.maxAckMs = latency;
+      _stats.totalAckMs += latency;
+    }
+    _inflight.release();
+  }
+
+  // Sessão nova: para o broker são mensagens novas, sem DUP
+  void retransmit(bool sessionPresent) {
+    for (size_t i = 0; i < _inflight.size() && _state == MQTT_STATE_CONNECTED; i++) {
+      InflightEntry& entry = _inflight.at(i);
+      if (entry.acked) continue;
+      entry.sentAt = _millis();
+      _stats.retransmitted++;
+      sendEntry(entry, sessionPresent);
+    }
+  }
+
+  uint16_t nextPacketId() {
+    do {
+      if (++_nextPacketId == 0) _nextPacketId = 1;
+    } while (_inflight.contains(_nextPacketId));
+    return _nextPacketId;
+  }
+
+  Socket& _socket;
+  MqttMillisFn _millis;
+  const char* _host = nullptr;
+  uint16_t _port = 1883;
+  Callback _callback = nullptr;
+  uint16_t _keepAliveS = 15;
+  uint8_t _window = 8;
+  uint8_t _protocol = MQTT_V5;
+  uint32_t _sessionExpiryS = 0;
+  uint16_t _serverReceiveMax = 65535;
+  uint32_t _maxPacketSize = 0;
+  int _state = MQTT_STATE_DISCONNECTED;
+  const char* _clientId = nullptr;  // Da tentativa de conexão em andamento
+  bool _cleanSession = true;
+  const char* _username = nullptr;
+  const char* _password = nullptr;
+  unsigned long _connectSentAt = 0;
+  unsigned long _lastInbound = 0;
+  unsigned long _lastOutbound = 0;
+  unsigned long _lastPingAt = 0;
+  uint16_t _nextPacketId = 0;
+
+  uint8_t _rx[MQTT_RX_BUFFER];
+  size_t _rxLen = 0;
+  size_t _rxSkip = 0;
+
+  InflightWindow<MQTT_INFLIGHT_MAX, MQTT_INFLIGHT_ARENA> _inflight;
+
+  char _aliases[MQTT_TOPIC_ALIAS_MAX][MQTT_ALIAS_TOPIC_MAX];  // Alias i + 1 -> tópico, nesta conexão
+  uint8_t _aliasCount = 0;
+  uint16_t _aliasLimit = 0;
+  MqttStats _stats;
+};
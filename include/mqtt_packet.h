@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Codificação dos pacotes MQTT 3.1.1 e 5 usados pelo cliente (mqtt_client.h). Funções puras,
+// sem E/S: escrevem em um buffer e retornam o número de bytes, ou 0 se não couber. O
+// parâmetro version é o nível de protocolo (4 = 3.1.1, 5 = MQTT 5); no 5 os pacotes levam
+// o bloco de propriedades, que aqui fica vazio exceto onde indicado.
+
+enum MqttPacketType {
+  MQTT_CONNECT = 1,
+  MQTT_CONNACK = 2,
+  MQTT_PUBLISH = 3,
+  MQTT_PUBACK = 4,
+  MQTT_SUBSCRIBE = 8,
+  MQTT_SUBACK = 9,
+  MQTT_PINGREQ = 12,
+  MQTT_PINGRESP = 13,
+  MQTT_DISCONNECT = 14,
+};
+
+#define MQTT_FIXED_HEADER_MAX 5  // Tipo + até 4 bytes de comprimento restante
+#define MQTT_PUBLISH_DUP 0x08    // Bit DUP no primeiro byte do PUBLISH
+#define MQTT_V311 4
+#define MQTT_V5 5
+
+// Propriedades do MQTT 5 usadas pelo cliente
+#define MQTT_PROP_SESSION_EXPIRY 0x11
+#define MQTT_PROP_RECEIVE_MAXIMUM 0x21
+#define MQTT_PROP_TOPIC_ALIAS_MAXIMUM 0x22
+#define MQTT_PROP_TOPIC_ALIAS 0x23
+#define MQTT_PROP_MAXIMUM_PACKET_SIZE 0x27
+
+// Recusa do CONNACK por versão de protocolo (3.1.1 e 5): o cliente cai para o 3.1.1
+#define MQTT_CONNACK_BAD_VERSION_V311 0x01
+#define MQTT_CONNACK_BAD_VERSION_V5 0x84
+
+struct MqttConnectOptions {
+  uint8_t version;
+  const char* clientId;
+  uint16_t keepAliveS;
+  bool cleanSession;        // Clean Start no MQTT 5
+  const char* username;     // nullptr se não usado
+  const char* password;
+  uint32_t sessionExpiryS;  // Só MQTT 5: por quanto tempo o broker guarda a sessão (0 = até desconectar)
+  uint16_t receiveMaximum;  // Só MQTT 5: PUBLISH QoS 1 que o broker pode nos mandar sem PUBACK (0 = 65535)
+};
+
+// CONNACK interpretado. Os limites do broker só existem no MQTT 5; no 3.1.1 ficam os padrões.
+struct MqttConnack {
+  bool sessionPresent;
+  uint8_t reason;              // 0 = aceito
+  uint16_t receiveMaximum;     // PUBLISH QoS 1 em voo que o broker aceita (padrão 65535)
+  uint16_t topicAliasMaximum;  // Aliases de tópico que o broker aceita (padrão 0)
+  uint32_t maximumPacketSize;  // 0 = sem limite
+  uint32_t sessionExpiryS;     // Valor imposto pelo broker, se informado
+  bool sessionExpiryGiven;
+};
+
+// Comprimento restante (1 a 4 bytes, 7 bits por byte)
+size_t mqttWriteRemainingLength(uint8_t* out, uint32_t length);
+
+// Lê o cabeçalho fixo. Retorna o tamanho do cabeçalho, 0 se ainda faltam bytes ou -1 se
+// o comprimento for inválido.
+int mqttReadFixedHeader(const uint8_t* in, size_t available, uint8_t& first, uint32_t& remaining);
+
+// Inteiro de comprimento variável (mesma codificação do comprimento restante). Retorna os
+// bytes lidos, 0 se ainda faltam bytes ou -1 se for inválido.
+int mqttReadVarInt(const uint8_t* in, size_t available, uint32_t& value);
+
+size_t mqttWriteConnect(uint8_t* out, size_t capacity, const MqttConnectOptions& options);
+
+// Lê o corpo do CONNACK (sem o cabeçalho fixo); false se estiver malformado
+bool mqttParseConnack(const uint8_t* body, size_t length, uint8_t version, MqttConnack& out);
+
+// Tamanho total de um PUBLISH (cabeçalhos + payload). topic vazio com topicAlias != 0 usa
+// um alias já estabelecido na conexão.
+size_t mqttPublishSize(uint8_t version, const char* topic, size_t payloadLength, uint8_t qos, uint16_t topicAlias);
+
+// Cabeçalho do PUBLISH (cabeçalho fixo, tópico, packet id e, no MQTT 5, as propriedades);
+// o payload vai logo depois, escrito pelo chamador direto do buffer de origem
+size_t mqttWritePublishHeader(uint8_t* out, size_t capacity, uint8_t version, const char* topic,
+                              size_t payloadLength, uint8_t qos, bool retain, uint16_t packetId,
+                              uint16_t topicAlias);
+
+size_t mqttWriteSubscribe(uint8_t* out, size_t capacity, uint8_t version, uint16_t packetId, const char* topic,
+                          uint8_t qos);
+
+// PUBACK e outros pacotes de 4 bytes com só o packet id (no MQTT 5 a forma curta significa sucesso)
+size_t mqttWriteAck(uint8_t* out, MqttPacketType type, uint16_t packetId);
+
+// PINGREQ e DISCONNECT (2 bytes)
+size_t mqttWriteEmpty(uint8_t* out, MqttPacketType type);
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "broker_pool.h"
+#include "mqtt_client.h"
+#include "mqttsn_client.h"
+#include "transport.h"
+
+// Transportes MQTT (mqtt_client.h) e MQTT-SN (mqttsn_client.h) na interface de
+// transport.h. Os dois publicam assim que send() é chamado, então flush() não tem o que
+// fazer; a confirmação é a janela QoS 1 de cada cliente.
+//
+// Com setBrokers() o MqttTransport conecta ao melhor broker da lista (broker_pool.h) e,
+// se a conexão cai ou falha, passa para o próximo que responder ao probe; sem ela usa o
+// host do construtor. A versão do MQTT é a de cada broker: um broker só 3.1.1 não tira o
+// MQTT 5 dos outros. O pool mede os brokers com um probe TCP próprio (async_net.h), que
+// não precisa ser do tipo da conexão: com TLS (tls_client.h) o probe continua sendo só o
+// handshake TCP.
+
+template <typename Socket, typename Probe>
+class MqttTransport {
+ public:
+  MqttTransport(Socket& socket, MqttMillisFn millisFn, const char* host, uint16_t port)
+      : _socket(socket), _client(socket, millisFn) {
+    _client.setServer(host, port);
+  }
+
+  MqttClient<Socket>& client() { return _client; }
+  void setBrokers(BrokerPool<Probe>* brokers) { _brokers = brokers; }
+
+  void begin(const TransportConfig& config) {
+    _config = config;
+    _client.setSessionExpiry(config.sessionExpiryS);
+    _client.setCallback(config.callback);
+  }
+
+  // Um passo da conexão, sem esperar o CONNACK: começa a tentativa com o broker de
+  // ready() (um por chamada; se ele falha, o próximo fica para a chamada seguinte) ou
+  // confere a que está em andamento. Com a sessão persistente, a sessão de um broker não
+  // vale no outro: as mensagens em voo são reenviadas ao novo broker como se fossem novas.
+  bool connect() {
+    if (!_pending && !start()) return false;
+    _pending = true;
+    _client.loop();
+    if (_client.connecting()) return false;
+    _pending = false;
+    return finish();
+  }
+  bool connecting() const { return _pending; }
+  bool connected() { return !_pending && _client.connected(); }
+  void loop() {
+    _client.loop();
+    // A queda entra no pool já, não só na próxima tentativa: os outros começam a ser medidos
+    if (!_pending && _brokers != nullptr && _brokers->current() >= 0 && !_client.connected()) _brokers->lost();
+  }
+  bool ready() const { return !_client.windowFull(); }
+  bool send(const char* topic, ByteSpan payload, int8_t qos) {
+    return _client.publish(topic, payload.data, payload.size, qos < 0 ? 0 : (uint8_t)qos);
+  }
+  bool flush() { return true; }
+
+  void setWindow(uint8_t window) { _client.setWindow(window); }
+  uint8_t window() const { return _client.window(); }
+  size_t inflight() const { return _client.inflight(); }
+  int state() const { return _client.state(); }
+  const char* protocol() const { return _client.protocol() == MQTT_V5 ? "mqtt5" : "mqtt3.1.1"; }
+  const MqttStats& stats() const { return _client.stats(); }
+
+ private:
+  // Sessão persistente: comandos enviados enquanto estávamos fora chegam logo após conectar
+  bool start() {
+    if (_brokers == nullptr || _brokers->count() == 0) return _client.beginConnect(_config.clientId, false);
+    _brokers->lost();  // Sem efeito se não havia conexão
+    _attempt = _brokers->ready();
+    if (_attempt < 0) return false;
+    setServerName(_socket, _brokers->at(_attempt).host);
+    _client.setServer(_brokers->address(_attempt), _brokers->at(_attempt).port);
+    _client.setProtocol(_brokers->at(_attempt).protocol);
+    if (_client.beginConnect(_config.clientId, false)) return true;
+    _brokers->failed(_attempt);
+    return false;
+  }
+
+  bool finish() {
+    bool ok = _client.connected();
+    if (_brokers != nullptr && _attempt >= 0) {
+      _brokers->setProtocol(_attempt, _client.protocol());
+      if (ok) {
+        _brokers->connected(_attempt);
+      } else {
+        _brokers->failed(_attempt);
+      }
+      _attempt = -1;
+    }
+    if (ok) _client.subscribe(_config.commandTopic, 1);
+    return ok;
+  }
+
+  Socket& _socket;
+  MqttClient<Socket> _client;
+  TransportConfig _config = {};
+  BrokerPool<Probe>* _brokers = nullptr;
+  int _attempt = -1;     // Broker da tentativa em andamento
+  bool _pending = false;  // CONNECT enviado, sessão ainda não pronta
+};
+
+template <typename Udp>
+class MqttSnTransport {
+ public:
+  MqttSnTransport(Udp& udp, MqttMillisFn millisFn, const char* host, uint16_t port) : _client(udp, millisFn) {
+    _client.setGateway(host, port);
+  }
+
+  MqttSnClient<Udp>& client() { return _client; }
+
+  void begin(const TransportConfig& config) {
+    _config = config;
+    _client.setCallback(config.callback);
+    for (size_t i = 0; i < config.predefinedCount; i++) {
+      _client.predefineTopic(config.predefined[i].name, config.predefined[i].id);
+    }
+  }
+
+  // Um passo da conexão, como no MqttTransport: o CONNECT sai na primeira chamada e as
+  // seguintes conferem o CONNACK (os reenvios são do cliente); a inscrição sai sem esperar
+  bool connect() {
+    if (!_pending && !_client.beginConnect(_config.clientId, false)) return false;
+    _pending = true;
+    _client.loop();
+    if (_client.connecting()) return false;
+    _pending = false;
+    if (!_client.connected()) return false;
+    _client.subscribe(_config.commandTopic, 1);
+    return true;
+  }
+  bool connecting() const { return _pending; }
+  bool connected() { return !_pending && _client.connected(); }
+  void loop() { _client.loop(); }
+  bool ready() const { return !_client.windowFull(); }
+  bool send(const char* topic, ByteSpan payload, int8_t qos) {
+    return _client.publish(topic, payload.data, payload.size, qos);
+  }
+  bool flush() { return true; }
+
+  void setWindow(uint8_t window) { _client.setWindow(window); }
+  uint8_t window() const { return _client.window(); }
+  size_t inflight() const { return _client.inflight(); }
+  int state() const { return _client.state(); }
+  const char* protocol() const { return "mqtt-sn"; }
+  const MqttStats& stats() const { return _client.stats(); }
+
+ private:
+  MqttSnClient<Udp> _client;
+  TransportConfig _config = {};
+  bool _pending = false;  // CONNECT enviado, sessão ainda não pronta
+};
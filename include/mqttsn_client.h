@@ -0,0 +1,588 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "inflight_window.h"
+#include "mqtt_client.h"
+#include "mqttsn_packet.h"
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Cliente MQTT-SN 1.2 sobre UDP: sem handshake TCP nem keepalive de TCP, cada mensagem é
+// um datagrama com 7 bytes de cabeçalho no lugar do tópico por extenso. Mesma interface
+// do MqttClient (mqtt_client.h), para o firmware escolher o transporte no boot.
+//
+//  - Tópicos predefinidos (predefineTopic) usam o id combinado com o gateway e aceitam
+//    QoS -1: o datagrama sai sem conexão nem confirmação (métricas, por exemplo).
+//  - Os demais tópicos são registrados (REGISTER) na primeira publicação da sessão; a
+//    mensagem QoS 1 espera na janela e sai quando chega o REGACK.
+//  - Nada espera resposta dentro da chamada: CONNECT, REGISTER e SUBSCRIBE são pedidos,
+//    um por vez como manda o MQTT-SN, que loop() reenvia a cada MQTTSN_RETRY_MS e confere
+//    nas chamadas seguintes. connect(), sleep() e checkIn() são as versões que esperam.
+//  - QoS 1 usa a mesma janela do cliente TCP (inflight_window.h), mas, como UDP perde
+//    datagramas, a mensagem sem PUBACK é reenviada com DUP a cada MQTTSN_RETRY_MS; depois
+//    de MQTTSN_RETRY_MAX tentativas a conexão é dada como perdida e tudo sai de novo na
+//    reconexão.
+//  - Cliente dormindo: sleep(s) avisa o gateway, que passa a guardar as mensagens;
+//    checkIn() acorda por um instante e recebe o que ficou guardado (PINGREQ com o id
+//    do cliente até o PINGRESP); connect() volta ao modo ativo.
+//
+// O socket é um parâmetro de template (WiFiUDP no ESP32 ou qualquer classe com
+// begin/beginPacket/write/endPacket/parsePacket/read).
+
+#ifndef MQTTSN_INFLIGHT_MAX
+#define MQTTSN_INFLIGHT_MAX 8
+#endif
+#ifndef MQTTSN_INFLIGHT_ARENA
+#define MQTTSN_INFLIGHT_ARENA 4096     // Só os payloads: o tópico fica na tabela de tópicos
+#endif
+#ifndef MQTTSN_TOPICS_MAX
+#define MQTTSN_TOPICS_MAX 8            // Tópicos publicados ou inscritos (predefinidos inclusive)
+#endif
+#define MQTTSN_TOPIC_NAME_MAX 64
+#define MQTTSN_RX_BUFFER 512           // Maior datagrama recebido (comandos); o resto é descartado
+#ifndef MQTTSN_RETRY_MS
+#define MQTTSN_RETRY_MS 3000           // Tretry: espera por uma resposta antes de reenviar
+#endif
+#define MQTTSN_RETRY_MAX 4             // Nretry: reenvios antes de desistir
+#define MQTTSN_REQUEST_MAX 80          // Pedido guardado para os reenvios (CONNECT com o client id)
+#define MQTTSN_NEED_REGISTER 1         // Topic::need: falta o REGISTER
+#define MQTTSN_NEED_SUBSCRIBE 2        // Topic::need: falta o SUBSCRIBE
+#define MQTTSN_LOCAL_PORT 10000
+
+template <typename Udp>
+class MqttSnClient {
+ public:
+  typedef void (*Callback)(char* topic, uint8_t* payload, unsigned int length);
+
+  MqttSnClient(Udp& udp, MqttMillisFn millisFn) : _udp(udp), _millis(millisFn) {}
+
+  void setGateway(const char* host, uint16_t port) {
+    _host = host;
+    _port = port;
+  }
+  void setCallback(Callback callback) { _callback = callback; }
+  void setKeepAlive(uint16_t seconds) { _keepAliveS = seconds; }
+  void setWindow(uint8_t window) {
+    _window = window < 1 ? 1 : (window > MQTTSN_INFLIGHT_MAX ? MQTTSN_INFLIGHT_MAX : window);
+  }
+
+  // Tópico com id fixo configurado também no gateway; false se a tabela estiver cheia
+  bool predefineTopic(const char* topic, uint16_t topicId) {
+    int index = addTopic(topic);
+    if (index < 0) return false;
+    _topics[index].id = topicId;
+    _topics[index].type = MQTTSN_TOPIC_PREDEFINED;
+    _topics[index].known = true;
+    return true;
+  }
+
+  uint8_t window() const { return _window; }
+  size_t inflight() const { return _inflight.size(); }
+  bool windowFull() const { return _inflight.size() >= _window; }
+  int state() const { return _state; }
+  bool connected() const { return _state == MQTT_STATE_CONNECTED; }
+  const MqttStats& stats() const { return _stats; }
+
+  // Envia o CONNECT sem esperar o CONNACK: loop() reenvia e trata a resposta, e
+  // connecting() fica true até ela chegar (ou até (MQTTSN_RETRY_MAX + 1) * MQTTSN_RETRY_MS).
+  // clientId precisa continuar válido depois da chamada: é usado de novo nos reenvios e em
+  // checkIn(). Com cleanSession false o gateway mantém inscrições e registros de tópico.
+  bool beginConnect(const char* clientId, bool cleanSession = true) {
+    if (!_udpStarted) {
+      _udp.begin(MQTTSN_LOCAL_PORT);
+      _udpStarted = true;
+    }
+    _clientId = clientId;
+    _cleanSession = cleanSession;
+    size_t n = mqttSnWriteConnect(_request, sizeof(_request), clientId, _keepAliveS, cleanSession);
+    if (n == 0) {
+      _state = MQTT_STATE_CONNECT_FAILED;
+      return false;
+    }
+    _state = MQTT_STATE_CONNECTING;
+    startRequest(n, MQTTSN_CONNACK, 0);  // Substitui o pedido da conexão anterior, se havia
+    return true;
+  }
+  bool connecting() const { return _state == MQTT_STATE_CONNECTING; }
+
+  // Conecta e espera o CONNACK, com reenvios (bloqueia até (MQTTSN_RETRY_MAX + 1) *
+  // MQTTSN_RETRY_MS)
+  bool connect(const char* clientId, bool cleanSession = true) {
+    if (!beginConnect(clientId, cleanSession)) return false;
+    while (connecting()) {
+      loop();
+#ifdef ARDUINO
+      delay(1);
+#endif
+    }
+    return connected();
+  }
+
+  void disconnect() {
+    if (connected()) {
+      uint8_t packet[4];
+      send(packet, mqttSnWriteDisconnect(packet, 0));
+    }
+    _state = MQTT_STATE_DISCONNECTED;
+    _awaitType = 0;
+  }
+
+  // Avisa o gateway que vamos dormir por durationS segundos e espera a confirmação; as
+  // mensagens para este cliente ficam guardadas até checkIn() ou connect()
+  bool sleep(uint16_t durationS) {
+    if (!connected()) return false;
+    size_t n = mqttSnWriteDisconnect(_request, durationS);
+    _state = request(n, MQTTSN_DISCONNECT) ? MQTT_STATE_ASLEEP : MQTT_STATE_DISCONNECTED;
+    return _state == MQTT_STATE_ASLEEP;
+  }
+
+  // Acorda por um instante: o gateway entrega o que guardou (callback) e responde PINGRESP
+  bool checkIn() {
+    if (_state != MQTT_STATE_ASLEEP || _clientId == nullptr) return false;
+    size_t n = mqttSnWritePingreq(_request, sizeof(_request), _clientId);
+    return n > 0 && request(n, MQTTSN_PINGRESP);
+  }
+
+  // Pede a inscrição sem esperar o SUBACK (sai quando não há outro pedido em andamento);
+  // false sem conexão ou com a tabela de tópicos cheia
+  bool subscribe(const char* topic, uint8_t qos = 1) {
+    if (!connected()) return false;
+    int index = addTopic(topic);
+    if (index < 0) return false;
+    _topics[index].need |= MQTTSN_NEED_SUBSCRIBE;
+    _topics[index].subscribeQos = qos > 1 ? 1 : qos;
+    nextRequest();
+    return true;
+  }
+
+  // qos -1 só com tópico predefinido e não exige conexão. QoS 1: false se a janela ou a
+  // arena estiverem cheias (a mensagem continua com o chamador). QoS 0 num tópico ainda
+  // sem id nesta sessão: false, e o REGISTER sai para a próxima.
+  bool publish(const char* topic, const uint8_t* payload, size_t length, int8_t qos = 0, bool retain = false) {
+    int index = addTopic(topic);
+    if (index < 0 || (qos < 0 && _topics[index].type != MQTTSN_TOPIC_PREDEFINED)) {
+      _stats.rejected++;
+      return false;
+    }
+    if (qos < 0) {
+      if (!_udpStarted) {
+        _udp.begin(MQTTSN_LOCAL_PORT);
+        _udpStarted = true;
+      }
+      if (!sendPublish(index, payload, length, -1, retain, 0, false)) return false;
+      _stats.qos0++;
+      return true;
+    }
+    if (!connected()) return false;
+    if (qos == 0) {
+      if (!sendPublish(index, payload, length, 0, retain, 0, false)) return false;
+      _stats.qos0++;
+      return true;
+    }
+
+    uint8_t* data = windowFull() ? nullptr : _inflight.reserve(length);
+    if (data == nullptr) {
+      _stats.rejected++;
+      return false;
+    }
+    memcpy(data, payload, length);
+    InflightEntry& entry = _inflight.commit(length, nextMsgId(), _millis());
+    entry.tag = (uint16_t)index;
+    entry.flags = retain ? 1 : 0;
+    _stats.published++;
+    sendEntry(entry, false);  // Se falhar, sai no próximo reenvio
+    return true;
+  }
+
+  bool publish(const char* topic, const char* payload, size_t length, int8_t qos = 0, bool retain = false) {
+    return publish(topic, (const uint8_t*)payload, length, qos, retain);
+  }
+
+  // Recebe datagramas, entrega comandos ao callback, reenvia o pedido em andamento e QoS 1
+  // sem PUBACK e mantém o keepalive. Uma passada, sem esperar nada.
+  bool loop() {
+    if (!connected() && !connecting()) return false;
+    while (poll()) {
+    }
+    unsigned long now = _millis();
+    retryRequest(now);
+    if (!connected()) return false;
+    nextRequest();
+
+    for (size_t i = 0; i < _inflight.size() && connected(); i++) {
+      InflightEntry& entry = _inflight.at(i);
+      if (entry.acked || now - entry.sentAt < MQTTSN_RETRY_MS) continue;
+      if (entry.retries >= MQTTSN_RETRY_MAX) {
+        lose();
+        return false;
+      }
+      entry.retries++;
+      entry.sentAt = now;
+      _stats.retransmitted++;
+      sendEntry(entry, true);
+    }
+
+    uint32_t keepAliveMs = (uint32_t)_keepAliveS * 1000;
+    if (keepAliveMs > 0 && now - _lastInbound > keepAliveMs + keepAliveMs / 2) {
+      lose();
+      return false;
+    }
+    if (keepAliveMs > 0 && (now - _lastOutbound >= keepAliveMs ||
+                            (now - _lastInbound >= keepAliveMs && _lastPingAt < _lastInbound))) {
+      uint8_t packet[2];
+      send(packet, mqttSnWritePingreq(packet, sizeof(packet), nullptr));
+      _lastPingAt = now;
+    }
+    return connected();
+  }
+
+ private:
+  struct Topic {
+    char name[MQTTSN_TOPIC_NAME_MAX];
+    uint16_t id;
+    uint8_t type;  // MQTTSN_TOPIC_NORMAL ou MQTTSN_TOPIC_PREDEFINED
+    bool known;    // Id válido nesta sessão
+    uint8_t need;  // MQTTSN_NEED_*: pedidos que faltam para este tópico
+    uint8_t subscribeQos;
+  };
+
+  void lose() {
+    _state = MQTT_STATE_CONNECTION_LOST;
+    _awaitType = 0;  // Fica para a reconexão (need continua marcado)
+  }
+
+  // Um datagrama: cabeçalho e, opcionalmente, o payload direto do buffer de origem
+  bool send(const uint8_t* header, size_t headerLength, const uint8_t* payload = nullptr, size_t length = 0) {
+    if (headerLength == 0 || !_udp.beginPacket(_host, _port)) return false;
+    _udp.write(header, headerLength);
+    if (length) _udp.write(payload, length);
+    if (!_udp.endPacket()) return false;
+    _lastOutbound = _millis();
+    return true;
+  }
+
+  int findTopic(const char* name) const {
+    for (uint8_t i = 0; i < _topicCount; i++) {
+      if (strcmp(_topics[i].name, name) == 0) return i;
+    }
+    return -1;
+  }
+
+  int findTopicId(uint16_t id, uint8_t type) const {
+    for (uint8_t i = 0; i < _topicCount; i++) {
+      if (_topics[i].known && _topics[i].id == id && _topics[i].type == type) return i;
+    }
+    return -1;
+  }
+
+  int addTopic(const char* name) {
+    int index = findTopic(name);
+    if (index >= 0) return index;
+    if (_topicCount >= MQTTSN_TOPICS_MAX || strlen(name) >= MQTTSN_TOPIC_NAME_MAX) return -1;
+    Topic& topic = _topics[_topicCount];
+    strcpy(topic.name, name);
+    topic.id = 0;
+    topic.type = MQTTSN_TOPIC_NORMAL;
+    topic.known = false;
+    topic.need = 0;
+    topic.subscribeQos = 0;
+    return _topicCount++;
+  }
+
+  // true se o tópico já tem id nesta sessão; senão pede o REGISTER e a mensagem fica para
+  // o REGACK (QoS 1) ou para o chamador (QoS 0)
+  bool ensureTopic(int index) {
+    Topic& topic = _topics[index];
+    if (topic.known) return true;
+    if (!connected()) return false;
+    topic.need |= MQTTSN_NEED_REGISTER;
+    nextRequest();
+    return false;
+  }
+
+  bool sendPublish(int index, const uint8_t* payload, size_t length, int8_t qos, bool retain, uint16_t msgId,
+                   bool dup) {
+    if (!ensureTopic(index)) return false;
+    const Topic& topic = _topics[index];
+    uint8_t flags = mqttSnQosFlags(qos) | topic.type | (retain ? MQTTSN_FLAG_RETAIN : 0) | (dup ? MQTTSN_FLAG_DUP : 0);
+    uint8_t header[MQTTSN_PUBLISH_HEADER_MAX];
+    size_t n = mqttSnWritePublishHeader(header, sizeof(header), flags, topic.id, msgId, length);
+    return n > 0 && send(header, n, payload, length);
+  }
+
+  bool sendEntry(const InflightEntry& entry, bool dup) {
+    return sendPublish(entry.tag, _inflight.data(entry), entry.length, 1, entry.flags & 1, entry.packetId, dup);
+  }
+
+  // Envia o pedido montado em _request e marca a resposta esperada (com o mesmo msg id,
+  // quando há); os reenvios e a resposta ficam para loop()
+  void startRequest(size_t length, uint8_t replyType, uint16_t msgId, int topic = -1) {
+    _requestLength = length;
+    _requestTopic = topic;
+    _requestRetries = 0;
+    _requestSentAt = _millis();
+    _awaitType = replyType;
+    _awaitMsgId = msgId;
+    _awaitDone = false;
+    send(_request, length);  // Se falhar, sai no próximo reenvio
+  }
+
+  // Reenvia o pedido sem resposta a cada MQTTSN_RETRY_MS; depois de MQTTSN_RETRY_MAX
+  // reenvios desiste: sem CONNACK a tentativa termina, sem REGACK/SUBACK a conexão é dada
+  // como perdida (o gateway não responde)
+  void retryRequest(unsigned long now) {
+    if (_awaitType == 0 || now - _requestSentAt < MQTTSN_RETRY_MS) return;
+    if (_requestRetries < MQTTSN_RETRY_MAX) {
+      _requestRetries++;
+      _requestSentAt = now;
+      send(_request, _requestLength);
+      return;
+    }
+    uint8_t type = _awaitType;
+    _awaitType = 0;
+    if (type == MQTTSN_CONNACK) {
+      _state = MQTT_STATE_CONNECTION_TIMEOUT;
+    } else if (type == MQTTSN_REGACK || type == MQTTSN_SUBACK) {
+      lose();
+    }
+  }
+
+  // Pedido que espera a resposta, para sleep() e checkIn(); o que chega no meio (PUBACK,
+  // comandos) é tratado normalmente
+  bool request(size_t length, uint8_t replyType) {
+    startRequest(length, replyType, 0);
+    while (_awaitType != 0) {
+      if (!poll()) {
+        retryRequest(_millis());
+#ifdef ARDUINO
+        delay(1);
+#endif
+      }
+    }
+    return _awaitDone;
+  }
+
+  // Próximo pedido de tópico, se nenhum está em andamento: as inscrições primeiro (é por
+  // elas que chegam os comandos), depois os registros
+  void nextRequest() {
+    if (_awaitType != 0 || !connected()) return;
+    int index = -1;
+    for (uint8_t i = 0; i < _topicCount && index < 0; i++) {
+      if (_topics[i].need & MQTTSN_NEED_SUBSCRIBE) index = i;
+    }
+    for (uint8_t i = 0; i < _topicCount && index < 0; i++) {
+      if (_topics[i].known) _topics[i].need &= ~MQTTSN_NEED_REGISTER;
+      if (_topics[i].need & MQTTSN_NEED_REGISTER) index = i;
+    }
+    if (index < 0) return;
+    Topic& topic = _topics[index];
+    uint16_t msgId = nextMsgId();
+    if (topic.need & MQTTSN_NEED_SUBSCRIBE) {
+      size_t n = mqttSnWriteSubscribe(_request, sizeof(_request), mqttSnQosFlags(topic.subscribeQos), msgId,
+                                      topic.name);
+      startRequest(n, MQTTSN_SUBACK, msgId, index);
+    } else {
+      startRequest(mqttSnWriteRegister(_request, sizeof(_request), msgId, topic.name), MQTTSN_REGACK, msgId, index);
+    }
+  }
+
+  void connackReceived(uint8_t returnCode) {
+    if (returnCode != MQTTSN_RC_ACCEPTED) {
+      _state = returnCode;
+      return;
+    }
+    _state = MQTT_STATE_CONNECTED;
+    _stats.connects++;
+    _lastInbound = _lastOutbound = _millis();
+    _lastPingAt = 0;
+    if (_cleanSession) {
+      for (uint8_t i = 0; i < _topicCount; i++) {
+        if (_topics[i].type == MQTTSN_TOPIC_NORMAL) _topics[i].known = false;
+      }
+    }
+    // Pendências da conexão anterior, na ordem (DUP: o gateway pode já ter recebido)
+    for (size_t i = 0; i < _inflight.size() && connected(); i++) {
+      InflightEntry& entry = _inflight.at(i);
+      if (entry.acked) continue;
+      entry.sentAt = _millis();
+      entry.retries = 0;
+      _stats.retransmitted++;
+      sendEntry(entry, true);
+    }
+  }
+
+  // REGACK ou SUBACK do pedido em andamento; com o id novo, as mensagens QoS 1 que
+  // esperavam o registro saem já
+  void topicAckReceived(uint8_t type, uint16_t topicId, uint8_t returnCode) {
+    Topic& topic = _topics[_requestTopic];
+    topic.need &= ~(type == MQTTSN_REGACK ? MQTTSN_NEED_REGISTER : MQTTSN_NEED_SUBSCRIBE);
+    if (returnCode == MQTTSN_RC_ACCEPTED) {
+      topic.id = topicId;
+      topic.known = true;
+    }
+    unsigned long now = _millis();
+    for (size_t i = 0; i < _inflight.size() && topic.known && type == MQTTSN_REGACK; i++) {
+      InflightEntry& entry = _inflight.at(i);
+      if (entry.acked || entry.tag != (uint16_t)_requestTopic) continue;
+      entry.sentAt = now;
+      sendEntry(entry, false);
+    }
+    nextRequest();
+  }
+
+  // Lê e trata um datagrama; false se não havia nenhum
+  bool poll() {
+    int size = _udp.parsePacket();
+    if (size <= 0) return false;
+    int n = _udp.read(_rx, sizeof(_rx));
+    uint16_t length;
+    uint8_t type;
+    size_t header = n > 0 ? mqttSnReadHeader(_rx, (size_t)n, length, type) : 0;
+    if (header == 0) return true;  // Truncado ou inválido: descarta
+    _lastInbound = _millis();
+    handle(type, _rx + header, length - header);
+    return true;
+  }
+
+  void handle(uint8_t type, uint8_t* body, size_t length) {
+    uint16_t topicId = length >= 2 ? (uint16_t)(body[0] << 8 | body[1]) : 0;
+    switch (type) {
+      case MQTTSN_CONNACK:
+        if (length >= 1) awaited(type, 0, 0, body[0]);
+        break;
+      case MQTTSN_REGACK:  // topic id, msg id, código
+        if (length >= 5) awaited(type, (uint16_t)(body[2] << 8 | body[3]), topicId, body[4]);
+        break;
+      case MQTTSN_SUBACK:  // flags, topic id, msg id, código
+        if (length >= 6) {
+          awaited(type, (uint16_t)(body[3] << 8 | body[4]), (uint16_t)(body[1] << 8 | body[2]), body[5]);
+        }
+        break;
+      case MQTTSN_PINGRESP:
+        awaited(type, 0, 0, MQTTSN_RC_ACCEPTED);
+        break;
+      case MQTTSN_DISCONNECT:
+        if (_awaitType == MQTTSN_DISCONNECT) {
+          awaited(type, 0, 0, MQTTSN_RC_ACCEPTED);
+        } else {
+          lose();
+        }
+        break;
+      case MQTTSN_PUBACK:
+        if (length >= 5) acknowledge((uint16_t)(body[2] << 8 | body[3]), body[4]);
+        break;
+      case MQTTSN_REGISTER: {  // Tópico novo vindo do gateway (inscrição com curinga)
+        if (length < 4) break;
+        uint16_t msgId = (uint16_t)(body[2] << 8 | body[3]);
+        char name[MQTTSN_TOPIC_NAME_MAX];
+        size_t nameLength = length - 4 < sizeof(name) - 1 ? length - 4 : sizeof(name) - 1;
+        memcpy(name, body + 4, nameLength);
+        name[nameLength] = '\0';
+        int index = addTopic(name);
+        if (index >= 0) {
+          _topics[index].id = topicId;
+          _topics[index].known = true;
+        }
+        uint8_t ack[7];
+        send(ack, mqttSnWriteAck(ack, MQTTSN_REGACK, topicId, msgId,
+                                 index >= 0 ? MQTTSN_RC_ACCEPTED : MQTTSN_RC_CONGESTION));
+        break;
+      }
+      case MQTTSN_PUBLISH: {  // flags, topic id, msg id, dados
+        if (length < 5) break;
+        uint8_t flags = body[0];
+        uint16_t id = (uint16_t)(body[1] << 8 | body[2]);
+        uint16_t msgId = (uint16_t)(body[3] << 8 | body[4]);
+        int index = findTopicId(id, flags & MQTTSN_TOPIC_TYPE_MASK);
+        if (index >= 0 && _callback) _callback(_topics[index].name, body + 5, length - 5);
+        if (mqttSnQos(flags) == 1) {
+          uint8_t ack[7];
+          send(ack, mqttSnWriteAck(ack, MQTTSN_PUBACK, id, msgId,
+                                   index >= 0 ? MQTTSN_RC_ACCEPTED : MQTTSN_RC_INVALID_TOPIC));
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  void awaited(uint8_t type, uint16_t msgId, uint16_t topicId, uint8_t returnCode) {
+    if (_awaitType != type || _awaitMsgId != msgId) return;
+    _awaitType = 0;
+    _awaitDone = true;
+    if (type == MQTTSN_CONNACK) {
+      connackReceived(returnCode);
+    } else if (type == MQTTSN_REGACK || type == MQTTSN_SUBACK) {
+      topicAckReceived(type, topicId, returnCode);
+    }
+  }
+
+  void acknowledge(uint16_t msgId, uint8_t returnCode) {
+    InflightEntry* entry = _inflight.find(msgId);
+    if (entry == nullptr) return;
+    switch (returnCode) {
+      case MQTTSN_RC_ACCEPTED: {
+        uint32_t latency = _millis() - entry->sentAt;
+        _stats.acked++;
+        _stats.lastAckMs = latency;
+        if (latency > _stats.maxAckMs) _stats.maxAckMs = latency;
+        _stats.totalAckMs += latency;
+        entry->acked = true;
+        break;
+      }
+      case MQTTSN_RC_INVALID_TOPIC:  // Gateway perdeu o registro: registra de novo no reenvio
+        _topics[entry->tag].known = false;
+        break;
+      case MQTTSN_RC_CONGESTION:  // Tenta de novo só depois de um Tretry inteiro
+        entry->sentAt = _millis();
+        break;
+      default:
+        _stats.refused++;
+        entry->acked = true;
+        break;
+    }
+    _inflight.release();
+  }
+
+  uint16_t nextMsgId() {
+    do {
+      if (++_nextMsgId == 0) _nextMsgId = 1;
+    } while (_inflight.contains(_nextMsgId));
+    return _nextMsgId;
+  }
+
+  Udp& _udp;
+  MqttMillisFn _millis;
+  const char* _host = nullptr;
+  uint16_t _port = 10000;
+  const char* _clientId = nullptr;
+  bool _cleanSession = true;
+  bool _udpStarted = false;
+  Callback _callback = nullptr;
+  uint16_t _keepAliveS = 60;
+  uint8_t _window = 4;
+  int _state = MQTT_STATE_DISCONNECTED;
+  unsigned long _lastInbound = 0;
+  unsigned long _lastOutbound = 0;
+  unsigned long _lastPingAt = 0;
+  uint16_t _nextMsgId = 0;
+
+  uint8_t _request[MQTTSN_REQUEST_MAX];  // Pedido em andamento, para os reenvios
+  size_t _requestLength = 0;
+  int _requestTopic = -1;  // Tópico do REGISTER/SUBSCRIBE
+  uint8_t _requestRetries = 0;
+  unsigned long _requestSentAt = 0;
+  uint8_t _awaitType = 0;  // Resposta esperada pelo pedido em andamento (0 = nenhum)
+  uint16_t _awaitMsgId = 0;
+  bool _awaitDone = false;
+
+  uint8_t _rx[MQTTSN_RX_BUFFER];
+  Topic _topics[MQTTSN_TOPICS_MAX];
+  uint8_t _topicCount = 0;
+  InflightWindow<MQTTSN_INFLIGHT_MAX, MQTTSN_INFLIGHT_ARENA> _inflight;
+  MqttStats _stats;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Codificação das mensagens MQTT-SN 1.2 usadas pelo cliente UDP (mqttsn_client.h). Mesmo
+// estilo de mqtt_packet.h: funções puras que escrevem em um buffer e retornam o número de
+// bytes, ou 0 se não couber.
+//
+// Cabeçalho: comprimento total (1 byte, ou 0x01 + 2 bytes a partir de 256) e tipo.
+
+enum MqttSnMsgType {
+  MQTTSN_CONNECT = 0x04,
+  MQTTSN_CONNACK = 0x05,
+  MQTTSN_REGISTER = 0x0A,
+  MQTTSN_REGACK = 0x0B,
+  MQTTSN_PUBLISH = 0x0C,
+  MQTTSN_PUBACK = 0x0D,
+  MQTTSN_SUBSCRIBE = 0x12,
+  MQTTSN_SUBACK = 0x13,
+  MQTTSN_PINGREQ = 0x16,
+  MQTTSN_PINGRESP = 0x17,
+  MQTTSN_DISCONNECT = 0x18,
+};
+
+// Byte de flags
+#define MQTTSN_FLAG_DUP 0x80
+#define MQTTSN_FLAG_RETAIN 0x10
+#define MQTTSN_FLAG_CLEAN_SESSION 0x04
+#define MQTTSN_TOPIC_NORMAL 0x00      // Id obtido com REGISTER (ou SUBSCRIBE)
+#define MQTTSN_TOPIC_PREDEFINED 0x01  // Id combinado com o gateway de antemão
+#define MQTTSN_TOPIC_TYPE_MASK 0x03
+
+// Códigos de retorno
+#define MQTTSN_RC_ACCEPTED 0x00
+#define MQTTSN_RC_CONGESTION 0x01
+#define MQTTSN_RC_INVALID_TOPIC 0x02
+#define MQTTSN_RC_NOT_SUPPORTED 0x03
+
+#define MQTTSN_PUBLISH_HEADER_MAX 9  // Comprimento longo (3) + tipo + flags + topic id + msg id
+
+// Flags de QoS: -1 (sem conexão, só tópicos predefinidos), 0 ou 1
+uint8_t mqttSnQosFlags(int8_t qos);
+int8_t mqttSnQos(uint8_t flags);
+
+// Lê o cabeçalho. Retorna o tamanho do cabeçalho (2 ou 4) ou 0 se a mensagem for inválida
+// (datagrama menor que o comprimento declarado).
+size_t mqttSnReadHeader(const uint8_t* in, size_t available, uint16_t& length, uint8_t& type);
+
+size_t mqttSnWriteConnect(uint8_t* out, size_t capacity, const char* clientId, uint16_t keepAliveS,
+                          bool cleanSession);
+
+size_t mqttSnWriteRegister(uint8_t* out, size_t capacity, uint16_t msgId, const char* topic);
+
+// Cabeçalho do PUBLISH; o payload vai logo depois, escrito pelo chamador
+size_t mqttSnWritePublishHeader(uint8_t* out, size_t capacity, uint8_t flags, uint16_t topicId, uint16_t msgId,
+                                size_t payloadLength);
+
+size_t mqttSnWriteSubscribe(uint8_t* out, size_t capacity, uint8_t flags, uint16_t msgId, const char* topic);
+
+// PUBACK e REGACK (7 bytes)
+size_t mqttSnWriteAck(uint8_t* out, MqttSnMsgType type, uint16_t topicId, uint16_t msgId, uint8_t returnCode);
+
+// PINGREQ; com clientId é o aviso de um cliente dormindo de que acordou para buscar mensagens
+size_t mqttSnWritePingreq(uint8_t* out, size_t capacity, const char* clientId);
+
+// DISCONNECT; durationS > 0 pede para dormir por esse tempo (o gateway guarda as mensagens)
+size_t mqttSnWriteDisconnect(uint8_t* out, uint16_t durationS);
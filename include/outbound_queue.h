@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ring_buffer.h"
+#include "sequence.h"
+
+// Métricas de uma faixa de saída. A latência vai da entrada na fila até a publicação.
+struct LaneStats {
+  uint32_t enqueued = 0;
+  uint32_t sent = 0;
+  uint32_t dropped = 0;       // Descartados por falta de espaço (os mais antigos saem)
+  uint32_t lastLatencyMs = 0;
+  uint32_t maxLatencyMs = 0;
+  uint64_t totalLatencyMs = 0;
+
+  uint32_t meanLatencyMs() const { return sent ? (uint32_t)(totalLatencyMs / sent) : 0; }
+};
+
+// Uma faixa (lane) da fila de saída: capacidade fixa, sem alocação, com métricas próprias.
+// A prioridade entre faixas é decidida por quem consome (alarmes sempre antes da telemetria).
+// Cada item guarda o número de sequência recebido na entrada: um reenvio repete o número e
+// um descarte por falta de espaço aparece como buraco para o backend.
+template <typename T, size_t N>
+class OutboundLane {
+ public:
+  void push(const T& item, unsigned long now, SeqNo seq) {
+    _stats.enqueued++;
+    if (!_slots.push(Slot{ item, now, seq })) _stats.dropped++;
+  }
+
+  bool empty() const { return _slots.empty(); }
+  bool full() const { return _slots.full(); }
+  size_t size() const { return _slots.size(); }
+  static constexpr size_t capacity() { return N; }
+  T& front() { return _slots.front().item; }
+  const T& at(size_t i) const { return _slots.at(i).item; }  // i = 0 é o mais antigo
+  unsigned long frontQueuedAt() { return _slots.front().queuedAt; }
+  SeqNo frontSeq() { return _slots.front().seq; }
+  SeqNo seqAt(size_t i) const { return _slots.at(i).seq; }
+
+  // Remove o primeiro item depois de publicado, contabilizando a latência
+  void markSent(unsigned long now) {
+    if (_slots.empty()) return;
+    uint32_t latency = now - _slots.front().queuedAt;
+    _stats.sent++;
+    _stats.lastLatencyMs = latency;
+    if (latency > _stats.maxLatencyMs) _stats.maxLatencyMs = latency;
+    _stats.totalLatencyMs += latency;
+    _slots.pop();
+  }
+
+  const LaneStats& stats() const { return _stats; }
+
+ private:
+  struct Slot {
+    T item;
+    unsigned long queuedAt;
+    SeqNo seq;
+  };
+  RingBuffer<Slot, N> _slots;
+  LaneStats _stats;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stddef.h>
+#include <ArduinoJson.h>
+#include "alarms.h"
+#include "mqtt_client.h"
+#include "broker_pool.h"
+#include "tls_client.h"
+#include "seal.h"
+#include "time_sync.h"
+#include "filter.h"
+#include "aggregator.h"
+#include "outbound_queue.h"
+#include "sequence.h"
+#include "scheduler.h"
+#include "ts_store.h"
+
+// Todas as mensagens levam "epoch" e "seq" (ver sequence.h), numerados por fluxo:
+// leituras, alarmes, resumos e métricas têm contadores independentes.
+
+// Serializa uma leitura no formato JSON publicado em MQTT_PUB_TOPIC:
+//   {"id":"<id>","epoch":..,"seq":..,"humidity":<float>,"timestamp":<epoch ms>,
+//    "period_ms":<período efetivo>}
+// period_ms é o período de amostragem em vigor quando a leitura foi feita (adaptativo).
+// Retorna o número de bytes escritos (sem o terminador), ou 0 se não couber.
+size_t serializeReading(char* out, size_t capacity, const char* id, SeqNo seq, float humidity,
+                        unsigned long long timestamp, uint32_t periodMs);
+
+// Evento de alarme publicado no tópico sensors/<id>/alarm:
+//   {"id":"<id>","epoch":..,"seq":..,"alarm":"dry","state":"raised"|"cleared","humidity":..,
+//    "raw":..,"timestamp":..}
+size_t serializeAlarm(char* out, size_t capacity, const char* id, SeqNo seq, const AlarmEvent& event,
+                      unsigned long long timestamp);
+
+// Resumo de uma janela publicado no tópico sensors/<id>/summary:
+//   {"id":"<id>","epoch":..,"seq":..,"window_s":60,"start":<epoch ms>,"count":..,"min":..,
+//    "max":..,"mean":..,"stddev":..,"p05":..,"p50":..,"p95":..}
+size_t serializeSummary(char* out, size_t capacity, const char* id, SeqNo seq,
+                        const WindowSummary& summary, unsigned long long startTimestamp);
+
+// Acrescenta parent[name] = {"depth":..,"enqueued":..,"sent":..,"dropped":..,
+//   "lat_last_ms":..,"lat_mean_ms":..,"lat_max_ms":..} às métricas do dispositivo
+void writeLaneMetrics(JsonObject parent, const char* name, const LaneStats& stats, size_t depth);
+
+// Acrescenta parent[name] = {"period_ms":..,"runs":..,"overruns":..,"missed":..,
+//   "jitter_last_us":..,"jitter_mean_us":..,"jitter_max_us":..,"dur_max_us":..}
+void writeJobMetrics(JsonObject parent, const char* name, const JobStats& stats, uint32_t periodMs);
+
+// Acrescenta parent[name] = {"pages":..,"used_pages":..,"appended":..,"erases":..,
+//   "crc_errors":..,"write_errors":..,"oldest":<epoch ms>} às métricas do dispositivo
+void writeStoreMetrics(JsonObject parent, const char* name, const TsStoreStats& stats,
+                       unsigned long long oldestTimestamp);
+
+// Acrescenta parent[name] = {"protocol":<"mqtt5"|"mqtt3.1.1"|"mqtt-sn"|"http"|"udp">,"inflight":..,"window":..,
+//   "published":..,"acked":..,"retransmitted":..,"rejected":..,"refused":..,"qos0":..,"connects":..,
+//   "fallbacks":..,"aliased":..,"alias_bytes_saved":..,"ack_last_ms":..,"ack_mean_ms":..,"ack_max_ms":..}
+// (transporte da telemetria, transport.h: janela QoS 1, aliases de tópico e latência da
+// confirmação; no HTTP inflight é o lote pendente e a latência é a do POST)
+void writeUplinkMetrics(JsonObject parent, const char* name, const MqttStats& stats, const char* protocol,
+                        size_t inflight, uint8_t window);
+
+// Acrescenta a parent {"host":..,"port":..,"address":<IP em cache>,"current":..,"healthy":..,
+//   "rtt_ms":..,"rtt_last_ms":..,"probes":..,"probe_failures":..,"connects":..,"failures":..,
+//   "resolves":..,"dns_failures":..,"dns_stale":..} (um broker da lista, broker_pool.h)
+void writeBrokerMetrics(JsonArray parent, const BrokerEntry& entry, bool current, bool healthy);
+
+// Acrescenta parent[name] = {"suite":<suíte da conexão atual>,"cached":<sessões na RTC>,
+//   "restored":..,"full":..,"resumed":..,"rejected":..,"failures":..,"oversized":..,
+//   "last_ms":..,"last_bytes":..,"last_resumed":..,"full_ms_avg":..,"resumed_ms_avg":..,
+//   "full_bytes_avg":..,"resumed_bytes_avg":..,"full_mj_avg":..,"resumed_mj_avg":..}
+// (handshakes do TlsClient, tls_client.h; energia estimada com TLS_ACTIVE_MW)
+void writeTlsMetrics(JsonObject parent, const char* name, const TlsStats& stats, const char* suite,
+                     size_t cachedSessions);
+
+// Acrescenta parent[name] = {"key_id":..,"sealed":..,"failures":..,"bytes":..,"cycles_per_byte":..,
+//   "mb_per_s":..,"last_bytes":..,"last_cycles":..} (envelopes AES-GCM, seal.h; a vazão é
+// a da cifragem em si, pelos ciclos gastos com a CPU a cpuMhz)
+void writeSealMetrics(JsonObject parent, const char* name, const SealStats& stats, uint8_t keyId,
+                      uint32_t cpuMhz);
+
+// Acrescenta parent[name] = {"synced":..,"err_us":..,"bound_us":..,"skew_ppm":..,"correction_us":..,
+//   "rtt_us":..,"rtt_min_us":..,"fit":..,"filtered":..,"requests":..,"responses":..,"stale":..,
+//   "steps":..} (sincronização com o servidor de horário, time_sync.h: err_us é o erro padrão
+// estimado do offset, bound_us o limite pela assimetria, metade do menor RTT da janela)
+void writeTimeSyncMetrics(JsonObject parent, const char* name, const TimeSyncStats& stats, bool synced);
+
+// Acrescenta parent[name] = {"policy":<"ema"|"kalman"|"hampel">,"p1":..,"p2":..,"samples":..,
+//   "rejected":..,"input":..,"estimate":..,"spread":..} (estágio de filtro das amostras do
+// ADC, filter.h; input, estimate e spread em contagens do ADC)
+void writeFilterMetrics(JsonObject parent, const char* name, const char* policy, const FilterStats& stats,
+                        float p1, float p2);
@@ -0,0 +1,15 @@
+#pragma once
+
+// Portal de configuração (Access Point + portal cativo). Não bloqueia: depois de
+// startConfigurationPortal(), o loop() deve chamar servicePortal() enquanto portalActive.
+extern bool portalActive;
+
+void startConfigurationPortal();
+void stopConfigurationPortal();
+
+// Retorna true quando as credenciais foram validadas e salvas e o portal foi encerrado
+bool servicePortal();
+
+// true enquanto o portal testa (ou acabou de validar) credenciais novas: a reconexão com
+// as credenciais guardadas espera
+bool portalConnecting();
@@ -0,0 +1,86 @@
+// Gerado automaticamente por scripts/embed_portal.py -- NAO EDITE.
+// Edite os arquivos em web/ e recompile.
+#pragma once
+
+#include <Arduino.h>
+
+// web/index.html: 2522 bytes -> 1188 bytes (gzip)
+#define INDEX_HTML_GZ_ETAG "\"453bebd26d33c127\""
+const size_t index_html_gz_len = 1188;
+const uint8_t index_html_gz[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0x56, 0xff, 0x6e, 0xdb, 0x36,
+  0x10, 0xfe, 0xbf, 0x4f, 0x71, 0x53, 0xb6, 0xd9, 0x06, 0x2c, 0x59, 0x71, 0xe2, 0x36, 0x8b, 0x65,
+  0x03, 0x6d, 0x9a, 0xa0, 0x05, 0xd6, 0xb5, 0x68, 0x3a, 0x0c, 0xc3, 0x30, 0xac, 0xb4, 0x48, 0x59,
+  0x6c, 0x28, 0x52, 0x23, 0x29, 0xff, 0x58, 0x90, 0x77, 0xd9, 0xbb, 0xec, 0xc5, 0x76, 0x24, 0x65,
+  0xd9, 0xf9, 0x81, 0x62, 0x4b, 0x00, 0x41, 0x22, 0xef, 0xbe, 0xfb, 0xee, 0xbb, 0x3b, 0xd2, 0xd9,
+  0x37, 0xaf, 0xdf, 0x5f, 0x7c, 0xfa, 0xf5, 0xc3, 0x25, 0xbc, 0xf9, 0xf4, 0xee, 0xc7, 0x79, 0x56,
+  0xda, 0x4a, 0xe0, 0x93, 0x11, 0x3a, 0x7f, 0x06, 0x90, 0x59, 0x6e, 0x05, 0x9b, 0x5f, 0x28, 0x59,
+  0xf0, 0x65, 0xa3, 0x89, 0x86, 0x6b, 0x26, 0x8d, 0xd2, 0xf0, 0x72, 0xa9, 0xd5, 0x95, 0x50, 0xeb,
+  0x6c, 0x14, 0x2c, 0x9c, 0x6d, 0xc5, 0x2c, 0x01, 0x49, 0x2a, 0x36, 0x8b, 0x56, 0x9c, 0xad, 0x6b,
+  0xa5, 0x6d, 0x04, 0xb9, 0x92, 0x96, 0x49, 0x3b, 0x8b, 0xd6, 0x9c, 0xda, 0x72, 0x46, 0xd9, 0x8a,
+  0xe7, 0x2c, 0xf6, 0x1f, 0x43, 0xe0, 0x92, 0x5b, 0x4e, 0x44, 0x6c, 0x72, 0x22, 0xd8, 0xec, 0x38,
+  0xf2, 0x30, 0xc6, 0x6e, 0x03, 0x20, 0xc0, 0x42, 0xd1, 0x2d, 0xdc, 0x42, 0x81, 0x18, 0x71, 0x41,
+  0x2a, 0x2e, 0xb6, 0xe7, 0x10, 0x93, 0xba, 0x16, 0x2c, 0x36, 0x5b, 0x63, 0x59, 0x35, 0x84, 0x57,
+  0x82, 0xcb, 0x9b, 0x77, 0x24, 0xbf, 0xf6, 0xdf, 0x57, 0x68, 0x39, 0x84, 0xde, 0x35, 0x5b, 0x2a,
+  0x06, 0x3f, 0xbf, 0xed, 0x0d, 0xe1, 0xa3, 0x5a, 0x28, 0xab, 0x86, 0xf0, 0x86, 0x89, 0x15, 0xb3,
+  0x3c, 0x27, 0x43, 0x78, 0xa9, 0x31, 0xe6, 0x10, 0x0c, 0x91, 0x26, 0x36, 0x4c, 0xf3, 0x62, 0x0a,
+  0x94, 0x9b, 0x5a, 0x10, 0x44, 0x2f, 0x04, 0xdb, 0x4c, 0xe1, 0x4b, 0x63, 0x2c, 0x2f, 0xb6, 0x71,
+  0x4b, 0xfe, 0x1c, 0x72, 0x7c, 0x32, 0x3d, 0x05, 0x22, 0xf8, 0x52, 0xc6, 0x1c, 0x23, 0x99, 0xfd,
+  0x62, 0xc5, 0x65, 0x5c, 0x32, 0xbe, 0x2c, 0xd1, 0xf0, 0x38, 0x4d, 0x57, 0xe5, 0x14, 0x16, 0x24,
+  0xbf, 0x41, 0x85, 0x1a, 0x49, 0x11, 0x43, 0x28, 0x7d, 0x0e, 0x47, 0x45, 0x5a, 0x8c, 0x8b, 0x09,
+  0x5a, 0x13, 0xbd, 0xe4, 0xf2, 0x1c, 0xd2, 0x29, 0xdc, 0xf9, 0x24, 0x13, 0x17, 0x85, 0x70, 0xc9,
+  0x34, 0xa6, 0xfa, 0xd8, 0x71, 0x5d, 0x62, 0xb8, 0x29, 0xd4, 0x84, 0x52, 0x2e, 0x97, 0xe7, 0x30,
+  0xd6, 0xac, 0xc2, 0x00, 0x4a, 0x53, 0xa6, 0x63, 0x4d, 0x28, 0x6f, 0x90, 0xca, 0x59, 0xbd, 0x71,
+  0x6b, 0x9b, 0xd8, 0x94, 0x84, 0xaa, 0x35, 0xa2, 0xc3, 0x69, 0xbd, 0x81, 0xe3, 0x31, 0x3e, 0xf4,
+  0x72, 0x41, 0xfa, 0xe9, 0xd0, 0xff, 0x27, 0xc7, 0x83, 0x29, 0x78, 0xf1, 0x3d, 0xd5, 0xef, 0x1c,
+  0x9d, 0x4d, 0xdc, 0x2e, 0x9c, 0xa6, 0xa9, 0x83, 0x09, 0xac, 0xca, 0x31, 0xb2, 0xd9, 0x71, 0x3f,
+  0x26, 0xe3, 0x74, 0x9c, 0x4f, 0xc1, 0xb2, 0x8d, 0x8d, 0xbd, 0x06, 0xfb, 0xec, 0x83, 0xb9, 0x20,
+  0x0b, 0x26, 0xd0, 0xa3, 0x13, 0x72, 0x21, 0x54, 0x7e, 0xb3, 0xcb, 0x36, 0xc6, 0x1a, 0x58, 0x55,
+  0x21, 0xad, 0x64, 0xe2, 0xe9, 0xfb, 0x8a, 0xae, 0x5b, 0xcd, 0x9e, 0xa7, 0xa8, 0xc5, 0x2e, 0xd4,
+  0x29, 0x99, 0x4c, 0x9e, 0x9f, 0xed, 0x60, 0xb9, 0xac, 0x1b, 0x2c, 0xa8, 0x61, 0x82, 0xe5, 0x16,
+  0xe1, 0xef, 0x51, 0xef, 0x24, 0x49, 0x93, 0x17, 0x01, 0xf6, 0x41, 0xb4, 0xe3, 0x03, 0xa9, 0xf0,
+  0x0b, 0xb5, 0x30, 0x4a, 0x70, 0x0a, 0x47, 0xf9, 0x82, 0x4e, 0x58, 0xfa, 0x48, 0xc5, 0xd3, 0x4e,
+  0x45, 0xfe, 0x97, 0x07, 0x6e, 0xf7, 0x71, 0x69, 0x47, 0x68, 0xd1, 0x20, 0xb4, 0x7c, 0xc8, 0xe4,
+  0x89, 0x72, 0x8f, 0xd9, 0x0b, 0x7a, 0x32, 0xee, 0xf2, 0x7a, 0x58, 0xc5, 0x34, 0x39, 0x9b, 0xdc,
+  0x63, 0x27, 0x95, 0x64, 0x4f, 0x13, 0xca, 0x1b, 0x6d, 0x1c, 0x44, 0xad, 0x78, 0x50, 0xdc, 0x8b,
+  0x87, 0x14, 0xd9, 0x2e, 0xc3, 0xb6, 0x8f, 0xd6, 0xbc, 0xe0, 0x6e, 0x94, 0xe4, 0x61, 0x1d, 0x42,
+  0x43, 0x3f, 0xd9, 0xb7, 0x4b, 0x52, 0xef, 0x2b, 0x12, 0x30, 0x8e, 0x4c, 0xcd, 0x65, 0xe8, 0xc4,
+  0xaf, 0x86, 0x3d, 0x70, 0xca, 0x46, 0xdd, 0xc0, 0x66, 0x26, 0xd7, 0xbc, 0xb6, 0x61, 0x76, 0x8b,
+  0x46, 0xe6, 0x96, 0xa3, 0x56, 0x8e, 0xd1, 0x4f, 0xcc, 0xae, 0x95, 0xbe, 0x31, 0xfd, 0x01, 0xdc,
+  0xfa, 0x5d, 0x70, 0x07, 0x83, 0xb1, 0xbb, 0xca, 0xce, 0x80, 0xaa, 0xbc, 0xa9, 0x90, 0x58, 0xb2,
+  0x64, 0xf6, 0x52, 0x30, 0xf7, 0xfa, 0x6a, 0xfb, 0x96, 0xf6, 0x7b, 0xc6, 0x70, 0xda, 0x1b, 0x4c,
+  0xef, 0x7b, 0xb5, 0x2c, 0xbf, 0xe6, 0x16, 0x4c, 0xf6, 0x9e, 0x21, 0x52, 0xe2, 0x57, 0xdd, 0x51,
+  0x87, 0xce, 0xbd, 0x4c, 0xd5, 0x8e, 0xe2, 0xfc, 0x83, 0x46, 0x18, 0x4d, 0x24, 0x55, 0xa0, 0x19,
+  0x65, 0x26, 0x49, 0x92, 0x6c, 0xd4, 0xee, 0xf5, 0x76, 0x00, 0x05, 0xb3, 0x79, 0xd9, 0xef, 0x8d,
+  0x5c, 0x3e, 0xbd, 0x41, 0x62, 0x4b, 0x26, 0xfb, 0x48, 0x61, 0x0e, 0x3a, 0xf9, 0x62, 0x94, 0xec,
+  0x0f, 0xda, 0x35, 0xc9, 0xac, 0x71, 0xcb, 0xbb, 0x44, 0xbf, 0x1a, 0x1a, 0x56, 0x44, 0x34, 0x78,
+  0x60, 0x46, 0xf3, 0x6b, 0x67, 0x84, 0x2b, 0x0c, 0x9a, 0x8a, 0x78, 0x1a, 0x8f, 0x29, 0x00, 0x38,
+  0xf0, 0xa4, 0x50, 0xfa, 0x92, 0x20, 0x17, 0x79, 0x3f, 0xcc, 0x4e, 0x1d, 0xf4, 0x3a, 0x54, 0x26,
+  0xd7, 0x8c, 0x58, 0xd6, 0x8a, 0xd3, 0xef, 0x05, 0xcc, 0xbd, 0x2e, 0xee, 0x0f, 0xd7, 0x12, 0x4f,
+  0x04, 0xfd, 0x64, 0xe2, 0x14, 0x7f, 0xb8, 0xeb, 0x26, 0xff, 0x22, 0x9c, 0x86, 0x68, 0xf3, 0xf9,
+  0xdb, 0xdb, 0x60, 0x76, 0x07, 0x7d, 0xf7, 0xaa, 0xf1, 0xfd, 0x8e, 0xbe, 0xaa, 0x06, 0x9f, 0x0f,
+  0xfd, 0xda, 0xb4, 0xf1, 0xbc, 0x66, 0x92, 0x5e, 0x94, 0x5c, 0xd0, 0x3e, 0x42, 0x1d, 0x04, 0xbe,
+  0xeb, 0xde, 0xef, 0x06, 0x49, 0x4e, 0x9c, 0xbc, 0xec, 0x3f, 0x2b, 0x37, 0xbf, 0xd4, 0x5a, 0x01,
+  0x51, 0x38, 0x92, 0x58, 0x11, 0x1d, 0x0a, 0xf7, 0x58, 0xb2, 0x5d, 0x8c, 0xd0, 0xdf, 0x6b, 0x8e,
+  0x35, 0x5e, 0x27, 0x4a, 0x0a, 0x45, 0x28, 0x82, 0x1d, 0xf6, 0xe6, 0x34, 0x34, 0x73, 0xdb, 0xc2,
+  0xd9, 0xc8, 0xdf, 0x81, 0x99, 0xbb, 0x82, 0x7c, 0x6f, 0x53, 0xbe, 0x82, 0x5c, 0x10, 0x63, 0x66,
+  0x51, 0x77, 0x60, 0x47, 0xa1, 0xd5, 0xb3, 0x72, 0xec, 0xae, 0x48, 0x64, 0xba, 0xbf, 0x20, 0xff,
+  0xf9, 0x1b, 0x3e, 0xfa, 0x1a, 0xe2, 0x5e, 0x30, 0xc2, 0xaa, 0x55, 0x40, 0xfc, 0x4c, 0xcc, 0xa2,
+  0x91, 0x21, 0x2b, 0x16, 0x01, 0x5e, 0x99, 0xa5, 0xa2, 0xb3, 0xe8, 0xc3, 0xfb, 0xeb, 0x4f, 0x2d,
+  0x18, 0x5a, 0x86, 0xc3, 0x14, 0xed, 0x67, 0x91, 0x13, 0x39, 0x9a, 0x3b, 0x24, 0xf8, 0x85, 0xc7,
+  0x57, 0xfc, 0x3c, 0x1b, 0xf9, 0xdd, 0xce, 0xf6, 0x80, 0x56, 0x37, 0xff, 0x1d, 0x92, 0x1b, 0xc9,
+  0x30, 0x60, 0x9c, 0xb6, 0x58, 0xed, 0x05, 0x1d, 0xde, 0x35, 0xfb, 0xb3, 0xe1, 0x28, 0xdc, 0x1c,
+  0xf3, 0xf6, 0x76, 0x87, 0x8e, 0x35, 0x1e, 0x24, 0xde, 0x2d, 0x4c, 0x52, 0x04, 0x4a, 0xe6, 0x82,
+  0xe7, 0x37, 0xb8, 0x72, 0x6f, 0xa2, 0xa3, 0xf9, 0xf7, 0x47, 0x67, 0xcf, 0x4f, 0x26, 0x53, 0x04,
+  0x41, 0x9f, 0x8e, 0xd9, 0x08, 0xa9, 0x3d, 0x95, 0x52, 0x8d, 0x64, 0xd1, 0x95, 0xba, 0x96, 0x97,
+  0x25, 0x01, 0x4a, 0xbc, 0x52, 0x8f, 0x32, 0xf3, 0x67, 0x3f, 0xd8, 0x6d, 0xcd, 0x0e, 0x7c, 0x3c,
+  0xa3, 0xfd, 0x57, 0x48, 0x66, 0x8f, 0xf8, 0x94, 0x82, 0x8c, 0x88, 0x3f, 0x6e, 0xd8, 0x36, 0x9a,
+  0x5f, 0x94, 0xa8, 0x39, 0xa0, 0x92, 0x39, 0x2f, 0x34, 0x81, 0xfe, 0xc9, 0x18, 0x4a, 0xb6, 0x19,
+  0x62, 0x7f, 0xbb, 0xb9, 0x23, 0x62, 0xf0, 0x3f, 0x28, 0x74, 0xa8, 0x3b, 0x3d, 0xbb, 0xef, 0x9a,
+  0x58, 0x3c, 0x2e, 0xb1, 0xc4, 0xbf, 0xa5, 0xf1, 0x0f, 0x24, 0x2e, 0x5e, 0xc6, 0x57, 0xbf, 0xdf,
+  0x9e, 0x8c, 0xef, 0x22, 0x20, 0x8d, 0x55, 0xb9, 0xaa, 0xf0, 0xd7, 0x8b, 0x45, 0x0f, 0x55, 0x14,
+  0x7b, 0xbe, 0xed, 0xb5, 0x12, 0x22, 0x99, 0x66, 0x51, 0x71, 0x8b, 0xf2, 0x10, 0xb1, 0xc2, 0x86,
+  0x62, 0xb0, 0xeb, 0xad, 0x6c, 0x14, 0xec, 0xda, 0x86, 0x1a, 0xb9, 0x8e, 0xf2, 0xbd, 0x19, 0xa4,
+  0xc6, 0x6d, 0xd7, 0xac, 0xd8, 0x72, 0xee, 0x37, 0xdc, 0xb3, 0x7f, 0x01, 0x75, 0xf7, 0xb5, 0x50,
+  0xda, 0x09, 0x00, 0x00,
+};
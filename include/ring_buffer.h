@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+
+// Fila circular de capacidade fixa, sem alocação dinâmica.
+// Quando cheia, push() descarta o item mais antigo para abrir espaço ao novo.
+template <typename T, size_t N>
+class RingBuffer {
+ public:
+  // Retorna false se um item antigo precisou ser descartado
+  bool push(const T& item) {
+    bool dropped = full();
+    if (dropped) pop();
+    _items[(_head + _count) % N] = item;
+    _count++;
+    return !dropped;
+  }
+
+  T& front() { return _items[_head]; }
+  const T& at(size_t i) const { return _items[(_head + i) % N]; }
+
+  void pop() {
+    if (_count == 0) return;
+    _head = (_head + 1) % N;
+    _count--;
+  }
+
+  void clear() { _head = 0; _count = 0; }
+  bool empty() const { return _count == 0; }
+  bool full() const { return _count == N; }
+  size_t size() const { return _count; }
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  T _items[N];
+  size_t _head = 0;
+  size_t _count = 0;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+
+// Uma rede encontrada no scan. O SSID pode não ter terminador nulo (registro do driver),
+// por isso vem acompanhado do tamanho máximo.
+struct ScanEntry {
+  const char* ssid;
+  size_t ssidMaxLen;
+  int rssi;
+};
+
+// Escreve a lista de redes como [{"ssid":"...","rssi":-60},...] num JsonStreamWriter.
+// getEntry(i, entry) preenche a entrada i e retorna false se ela não existir.
+// Redes ocultas (SSID vazio) são omitidas sem quebrar a regra das vírgulas.
+template <typename Writer, typename GetEntry>
+void writeScanJson(Writer& out, int count, GetEntry getEntry) {
+  out.raw('[');
+  bool first = true;
+  for (int i = 0; i < count; ++i) {
+    ScanEntry entry;
+    if (!getEntry(i, entry) || entry.ssid[0] == '\0') continue;
+    if (!first) out.raw(',');
+    first = false;
+    out.raw('{');
+    out.key("ssid");
+    out.string(entry.ssid, entry.ssidMaxLen);
+    out.raw(',');
+    out.key("rssi");
+    out.number(entry.rssi);
+    out.raw('}');
+  }
+  out.raw(']');
+  out.flush();
+}
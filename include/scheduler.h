@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Escalonador cooperativo por prazos, chamado a cada volta do loop(). Os prazos seguem uma
+// grade fixa (prazo anterior + período), então o atraso de uma execução não se acumula.
+// O relógio é injetado (microssegundos, 64 bits) para que o mesmo código rode no host.
+
+#define SCHEDULER_MAX_JOBS 16
+
+// O que fazer quando um job perde um ou mais prazos
+enum CatchUpPolicy {
+  CATCHUP_SKIP,   // Executa uma vez e pula os prazos perdidos, voltando para a grade
+  CATCHUP_BURST,  // Executa uma vez por prazo perdido (até maxBurst por volta do loop)
+};
+
+struct JobStats {
+  uint32_t runs = 0;
+  uint32_t overruns = 0;         // Execuções que duraram mais que o período
+  uint32_t missed = 0;           // Prazos pulados (CATCHUP_SKIP) ou descartados além do maxBurst
+  uint32_t lastJitterUs = 0;     // Atraso do início em relação ao prazo
+  uint32_t maxJitterUs = 0;
+  uint64_t totalJitterUs = 0;
+  uint32_t lastDurationUs = 0;
+  uint32_t maxDurationUs = 0;
+
+  uint32_t meanJitterUs() const { return runs ? (uint32_t)(totalJitterUs / runs) : 0; }
+};
+
+typedef void (*JobFn)();
+typedef uint64_t (*ClockFn)();
+
+class Scheduler {
+ public:
+  explicit Scheduler(ClockFn clock) : _clock(clock) {}
+
+  // Registra um job; retorna o id, ou -1 se não houver espaço. alignToWall indica que os
+  // prazos devem cair em múltiplos do período no horário Unix depois de alignToWallClock().
+  int add(const char* name, uint32_t periodMs, JobFn fn, CatchUpPolicy policy = CATCHUP_SKIP,
+          bool alignToWall = false, uint8_t maxBurst = 4);
+
+  // Executa os jobs vencidos e retorna quantos microssegundos faltam para o próximo prazo
+  uint64_t runDue();
+
+  // Antecipa o próximo prazo do job para agora (ex.: publicar um alarme sem esperar). Chamado
+  // pelo próprio job, vale para a próxima volta do loop() no lugar do prazo da grade.
+  void runNow(int id);
+  // Põe o próximo prazo do job daqui a delayMs (ex.: o primeiro fechamento de uma janela
+  // de agregação, que não deve rodar no add()); chamado pelo próprio job, também vale
+  void runIn(int id, uint32_t delayMs);
+  void setPeriod(int id, uint32_t periodMs);
+  uint32_t period(int id) const { return (uint32_t)(_jobs[id].periodUs / 1000); }
+
+  // Realinha os jobs marcados com alignToWall ao horário Unix (epoch em ms)
+  void alignToWallClock(unsigned long long epochMs);
+
+  size_t count() const { return _count; }
+  const char* name(int id) const { return _jobs[id].name; }
+  const JobStats& stats(int id) const { return _jobs[id].stats; }
+
+ private:
+  struct Job {
+    const char* name;
+    uint64_t periodUs;
+    uint64_t nextUs;
+    JobFn fn;
+    CatchUpPolicy policy;
+    bool alignToWall;
+    uint8_t maxBurst;
+    bool moved;                  // runNow/runIn durante a execução: o prazo pedido fica
+    JobStats stats;
+  };
+
+  void runJob(Job& job, uint64_t deadline);
+
+  ClockFn _clock;
+  Job _jobs[SCHEDULER_MAX_JOBS];
+  size_t _count = 0;
+  int _running = -1;             // Job em execução
+};
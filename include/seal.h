@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Envelope cifrado e autenticado (AES-128-GCM) para os blocos publicados pelo dispositivo,
+// fim a fim: o broker, compartilhado, só vê o envelope. A chave é do dispositivo (NVS,
+// gravada pelo portal); no ESP32 o GCM é o do mbedtls do ESP-IDF, que usa o acelerador
+// AES; no host, uma implementação em software com tabelas (mesmo formato, para testes e
+// para o benchmark).
+//
+// Formato (little endian):
+//   0  'A' 'S'        magic (o bloco aberto começa com 'A' 'F', ts_codec.h)
+//   2  uint8 versão   (SEAL_VERSION)
+//   3  uint8 chave    id da chave do dispositivo (troca de chave sem ambiguidade)
+//   4  uint32 epoch   nonce de 96 bits: época de boot (sequence.h) e contador do boot,
+//   8  uint64 count   que nunca se repetem com a mesma chave
+//   16 cifrado        mesmo tamanho do bloco aberto
+//   .. tag[16]
+// Dados associados (autenticados, não cifrados): os 16 bytes do cabeçalho seguidos do
+// tópico, então um envelope copiado para outro tópico ou dispositivo não abre.
+//
+// A cifragem é feita no lugar: quem chama deixa SEAL_HEADER_SIZE bytes livres antes do
+// bloco e SEAL_TAG_SIZE depois, e o envelope sai no mesmo buffer, sem cópia.
+//
+// O decodificador de referência para o backend está em scripts/seal_open.py.
+
+#define SEAL_KEY_SIZE 16
+#define SEAL_HEADER_SIZE 16
+#define SEAL_TAG_SIZE 16
+#define SEAL_OVERHEAD (SEAL_HEADER_SIZE + SEAL_TAG_SIZE)
+#define SEAL_VERSION 1
+#define SEAL_TOPIC_MAX 128             // Maior tópico aceito nos dados associados
+
+struct SealStats {
+  uint32_t sealed = 0;
+  uint32_t failures = 0;
+  uint64_t bytes = 0;                  // Bytes cifrados (sem cabeçalho nem tag)
+  uint64_t cycles = 0;                 // Ciclos de CPU gastos em seal(), 0 sem contador
+  uint32_t lastBytes = 0;
+  uint32_t lastCycles = 0;
+
+  float cyclesPerByte() const { return bytes ? (float)cycles / bytes : 0; }
+};
+
+struct SealContext;
+
+class PayloadSealer {
+ public:
+  ~PayloadSealer() { end(); }
+
+  // Sem chave (ou com epoch 0, época não gravada) o sealer fica desligado
+  bool begin(const uint8_t key[SEAL_KEY_SIZE], uint8_t keyId, uint32_t epoch);
+  void end();
+  bool enabled() const { return _context != nullptr; }
+  uint8_t keyId() const { return _keyId; }
+
+  // buffer: [SEAL_HEADER_SIZE livres][length bytes do bloco][SEAL_TAG_SIZE livres].
+  // Retorna o tamanho do envelope (length + SEAL_OVERHEAD) ou 0 em caso de erro.
+  size_t seal(const char* topic, uint8_t* buffer, size_t length);
+
+  const SealStats& stats() const { return _stats; }
+
+ private:
+  SealContext* _context = nullptr;
+  uint8_t _keyId = 0;
+  uint32_t _epoch = 0;
+  uint64_t _counter = 0;
+  SealStats _stats;
+};
+
+// Abre um envelope no lugar (testes no host e benchmark): retorna o tamanho do bloco, que
+// fica em envelope + SEAL_HEADER_SIZE, ou -1 se o envelope é inválido ou não autentica
+int sealOpen(const uint8_t key[SEAL_KEY_SIZE], const char* topic, uint8_t* envelope, size_t length);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+// Número de sequência de uma mensagem: (época de boot, contador). A época é incrementada e
+// salva na NVS a cada boot; o contador recomeça em 0. O par cresce estritamente ao longo de
+// toda a vida do dispositivo sem gravar na flash a cada mensagem, e permite ao backend
+// distinguir mensagens perdidas (buracos) de repetidas (reenvios) por fluxo.
+struct SeqNo {
+  uint32_t epoch;
+  uint32_t seq;
+};
+
+inline bool operator==(const SeqNo& a, const SeqNo& b) { return a.epoch == b.epoch && a.seq == b.seq; }
+inline bool operator!=(const SeqNo& a, const SeqNo& b) { return !(a == b); }
+
+// b vem imediatamente depois de a no mesmo fluxo, com passo "stride"
+inline bool seqFollows(const SeqNo& a, const SeqNo& b, uint32_t stride = 1) {
+  return a.epoch == b.epoch && b.seq == a.seq + stride;
+}
+
+// Contador de um fluxo de mensagens (leituras, alarmes, resumos, métricas)
+class SequenceCounter {
+ public:
+  void begin(uint32_t epoch) {
+    _epoch = epoch;
+    _next = 0;
+  }
+  SeqNo next() { return SeqNo{ _epoch, _next++ }; }
+  uint32_t epoch() const { return _epoch; }
+
+ private:
+  uint32_t _epoch = 0;
+  uint32_t _next = 0;
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// Sincronização de relógio da frota por trocas de ida e volta através do broker, no
+// estilo do NTP, com um servidor de horário do backend como referência comum
+// (scripts/time_server.py):
+//   dispositivo -> sensors/<id>/time     "<t1>"                 (t1: relógio local, µs)
+//   servidor    -> sensors/<id>/command  "TIME <t1> <t2> <t3>"  (t2/t3: chegada e saída
+//                                                              no servidor, µs Unix)
+// Com t4 (chegada da resposta, relógio local): atraso = (t4 - t1) - (t3 - t2) e offset =
+// ((t2 - t1) + (t3 - t4)) / 2. O erro do offset de uma troca é no máximo atraso/2 (a
+// assimetria entre ida e volta), e o broker acrescenta fila nos dois sentidos, então:
+//  - filtro por RTT: das últimas TIME_SYNC_WINDOW trocas, só entram na estimativa as de
+//    atraso perto do mínimo da janela (as que não pegaram fila);
+//  - a deriva do cristal (skew, em ppm) é a inclinação da regressão linear do offset
+//    contra o relógio local sobre essas trocas, e o offset atual é a reta no instante atual;
+//  - o relógio disciplinado segue a reta sem saltos: correções de até TIME_SYNC_STEP_US
+//    são absorvidas variando a frequência (no máximo TIME_SYNC_SLEW_MAX_PPM), então o
+//    horário nunca anda para trás; só a primeira sincronização e erros maiores saltam.
+// O erro estimado é o erro padrão da reta no instante atual (resíduos da regressão), e o
+// limite, metade do menor atraso da janela. Header-only e sem dependências do Arduino:
+// o relógio local é passado em cada chamada (esp_timer_get_time() no firmware).
+
+#define TIME_SYNC_WINDOW 16            // Trocas guardadas para a regressão
+#define TIME_SYNC_MIN_FIT 4            // Trocas filtradas para estimar a deriva
+#define TIME_SYNC_MIN_SPAN_US 60000000 // Intervalo mínimo entre a primeira e a última troca da reta
+#define TIME_SYNC_RTT_SLACK_US 2000    // Atraso aceito acima do mínimo (ou 1/4 do mínimo, o maior)
+#define TIME_SYNC_MAX_PPM 500          // Deriva acima disso é regressão ruim, não cristal
+#define TIME_SYNC_STEP_US 50000        // Correções maiores saltam em vez de deslizar
+#define TIME_SYNC_SLEW_US 30000000     // Prazo para absorver uma correção deslizando
+#define TIME_SYNC_SLEW_MAX_PPM 500
+#define TIME_SYNC_TIMEOUT_US 10000000  // Resposta que chega depois disso é descartada
+
+struct TimeSyncStats {
+  uint32_t requests = 0;
+  uint32_t responses = 0;
+  uint32_t stale = 0;       // Resposta sem pedido correspondente (atrasada, repetida, de outro boot)
+  uint32_t filtered = 0;    // Trocas da janela fora do filtro de RTT na última estimativa
+  uint32_t steps = 0;       // Correções por salto (a primeira inclusive)
+  uint32_t lastDelayUs = 0;
+  uint32_t minDelayUs = 0;  // Menor atraso da janela
+  int32_t lastCorrectionUs = 0;  // Diferença entre a reta e o relógio disciplinado na última estimativa
+  float skewPpm = 0;        // Deriva do relógio local em relação ao servidor
+  float errorUs = 0;        // Erro padrão estimado do offset atual
+  uint8_t fitSamples = 0;   // Trocas usadas na última regressão
+};
+
+class TimeSync {
+ public:
+  // Novo pedido; retorna o t1 a publicar. Um pedido anterior sem resposta é abandonado.
+  uint64_t request(uint64_t localUs) {
+    _pendingUs = localUs;
+    _stats.requests++;
+    return localUs;
+  }
+
+  // Resposta "TIME t1 t2 t3" chegando em localUs; false se não corresponde ao pedido atual
+  bool onResponse(uint64_t t1, int64_t t2, int64_t t3, uint64_t localUs) {
+    if (t1 == 0 || t1 != _pendingUs || localUs < t1 || localUs - t1 > TIME_SYNC_TIMEOUT_US || t3 < t2) {
+      _stats.stale++;
+      return false;
+    }
+    _pendingUs = 0;
+    _stats.responses++;
+    int64_t delay = (int64_t)(localUs - t1) - (t3 - t2);
+    if (delay < 0) delay = 0;  // Servidor mais lento que o próprio relógio local; raro
+    Sample& s = _samples[_next];
+    s.localUs = t1 + (localUs - t1) / 2;
+    s.offsetUs = ((t2 - (int64_t)t1) + (t3 - (int64_t)localUs)) / 2;
+    s.delayUs = (uint32_t)delay;
+    _next = (_next + 1) % TIME_SYNC_WINDOW;
+    if (_count < TIME_SYNC_WINDOW) _count++;
+    _stats.lastDelayUs = s.delayUs;
+    fit(localUs);
+    return true;
+  }
+
+  bool synced() const { return _synced; }
+  bool pending() const { return _pendingUs != 0; }
+  uint8_t samples() const { return _count; }
+
+  // Horário disciplinado (µs Unix) no instante local; 0 antes da primeira troca
+  int64_t nowUs(uint64_t localUs) const {
+    if (!_synced) return 0;
+    int64_t elapsed = (int64_t)(localUs - _anchorUs);
+    double rate = _freqPpm;
+    if (localUs > _slewUntilUs) {
+      // Deslize já terminou: a parte até _slewUntilUs corre com a taxa extra
+      int64_t slewed = (int64_t)(_slewUntilUs - _anchorUs);
+      return _phaseUs + elapsed + (int64_t)(elapsed * rate * 1e-6 + slewed * _slewPpm * 1e-6);
+    }
+    return _phaseUs + elapsed + (int64_t)(elapsed * (rate + _slewPpm) * 1e-6);
+  }
+
+  const TimeSyncStats& stats() const { return _stats; }
+
+ private:
+  struct Sample {
+    uint64_t localUs;  // Meio da troca, no relógio local
+    int64_t offsetUs;  // Servidor - local
+    uint32_t delayUs;
+  };
+
+  // Reestima offset e deriva com as trocas filtradas e ajusta o relógio disciplinado
+  void fit(uint64_t localUs) {
+    uint32_t minDelay = UINT32_MAX;
+    for (uint8_t i = 0; i < _count; i++) {
+      if (_samples[i].delayUs < minDelay) minDelay = _samples[i].delayUs;
+    }
+    uint32_t slack = minDelay / 4 > TIME_SYNC_RTT_SLACK_US ? minDelay / 4 : TIME_SYNC_RTT_SLACK_US;
+    uint32_t limit = minDelay + slack;
+
+    // Regressão em torno do instante atual (x em s, y em µs), para não perder precisão em
+    // double com os valores absolutos: a inclinação já sai em µs/s = ppm
+    int64_t yRef = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+      if (_samples[i].delayUs == minDelay) yRef = _samples[i].offsetUs;
+    }
+    double sx = 0, sy = 0;
+    uint8_t n = 0;
+    uint64_t oldest = UINT64_MAX, newest = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+      const Sample& s = _samples[i];
+      if (s.delayUs > limit) continue;
+      sx += x(s, localUs);
+      sy += (double)(s.offsetUs - yRef);
+      if (s.localUs < oldest) oldest = s.localUs;
+      if (s.localUs > newest) newest = s.localUs;
+      n++;
+    }
+    double mx = sx / n, my = sy / n;
+    double sxx = 0, sxy = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+      const Sample& s = _samples[i];
+      if (s.delayUs > limit) continue;
+      double dx = x(s, localUs) - mx;
+      sxx += dx * dx;
+      sxy += dx * ((double)(s.offsetUs - yRef) - my);
+    }
+    double skew = _stats.skewPpm;
+    if (n >= TIME_SYNC_MIN_FIT && newest - oldest >= TIME_SYNC_MIN_SPAN_US) {
+      double b = sxy / sxx;
+      if (fabs(b) <= TIME_SYNC_MAX_PPM) skew = b;
+    }
+    double offsetNow = my - skew * mx;  // A reta em x = 0 (agora)
+
+    double error = minDelay / 2.0;
+    if (n > 2 && sxx > 0) {
+      double ss = 0;
+      for (uint8_t i = 0; i < _count; i++) {
+        const Sample& s = _samples[i];
+        if (s.delayUs > limit) continue;
+        double r = (double)(s.offsetUs - yRef) - (offsetNow + skew * x(s, localUs));
+        ss += r * r;
+      }
+      error = sqrt(ss / (n - 2) * (1.0 / n + mx * mx / sxx));
+    }
+
+    _stats.minDelayUs = minDelay;
+    _stats.filtered = _count - n;
+    _stats.fitSamples = n;
+    _stats.skewPpm = (float)skew;
+    _stats.errorUs = (float)error;
+    discipline(localUs, (int64_t)localUs + yRef + (int64_t)llround(offsetNow), skew);
+  }
+
+  static double x(const Sample& s, uint64_t localUs) { return ((double)s.localUs - (double)localUs) * 1e-6; }
+
+  // Leva o relógio disciplinado ao horário "target" no instante local, com a nova deriva
+  void discipline(uint64_t localUs, int64_t target, double skewPpm) {
+    int64_t current = _synced ? nowUs(localUs) : target;  // Primeira estimativa: salta sem correção
+    int64_t correction = target - current;
+    _anchorUs = localUs;
+    _freqPpm = skewPpm;
+    if (!_synced || correction > TIME_SYNC_STEP_US || correction < -TIME_SYNC_STEP_US) {
+      _phaseUs = target;
+      _slewPpm = 0;
+      _slewUntilUs = localUs;
+      _synced = true;
+      _stats.steps++;
+    } else {
+      _phaseUs = current;
+      double rate = (double)correction * 1e6 / TIME_SYNC_SLEW_US;
+      if (rate > TIME_SYNC_SLEW_MAX_PPM) rate = TIME_SYNC_SLEW_MAX_PPM;
+      if (rate < -TIME_SYNC_SLEW_MAX_PPM) rate = -TIME_SYNC_SLEW_MAX_PPM;
+      _slewPpm = rate;
+      _slewUntilUs = localUs + (rate != 0 ? (uint64_t)((double)correction * 1e6 / rate) : 0);
+    }
+    _stats.lastCorrectionUs = (int32_t)(correction > INT32_MAX ? INT32_MAX : (correction < INT32_MIN ? INT32_MIN : correction));
+  }
+
+  Sample _samples[TIME_SYNC_WINDOW] = {};
+  uint8_t _count = 0;
+  uint8_t _next = 0;
+  uint64_t _pendingUs = 0;
+  bool _synced = false;
+  uint64_t _anchorUs = 0;      // Instante local da última estimativa
+  int64_t _phaseUs = 0;        // Horário disciplinado em _anchorUs
+  double _freqPpm = 0;         // Deriva corrigida a partir de _anchorUs
+  double _slewPpm = 0;         // Taxa extra do deslize em andamento
+  uint64_t _slewUntilUs = 0;   // Fim do deslize
+  TimeSyncStats _stats;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "broker_pool.h"
+
+// Socket TLS 1.2 (mbedtls do ESP-IDF) com a interface que o MqttClient usa
+// (connect/connected/write/available/read/stop), para MQTT sobre TLS sem pagar um
+// handshake completo a cada reconexão:
+//  - a sessão negociada com cada servidor (ticket RFC 5077 ou id de sessão) fica em uma de
+//    TLS_SESSION_SLOTS posições na memória RTC e é oferecida na próxima conexão ao mesmo
+//    servidor. O handshake abreviado não traz certificado, troca ECDHE nem verificação de
+//    assinatura, e a sessão sobrevive a reconexões, ao deep sleep e a reinícios por
+//    software (cada posição tem CRC; o lixo de depois de uma falta de energia é ignorado);
+//  - as suítes ECDHE-ECDSA vêm antes das ECDHE-RSA e a curva P-256 antes das outras: a
+//    verificação ECDSA custa menos ao ESP32 e o certificado, menor, cabe na posição da RTC;
+//  - cada handshake é medido (tempo, bytes, se retomou a sessão) e a energia é estimada
+//    pelo tempo com a potência média do rádio ligado (TLS_ACTIVE_MW).
+//
+// A sessão é guardada pelo nome do servidor (setServerName(), que também vai no SNI) e
+// porta; sem nome, pelo host de connect(). Sem setCACert() o certificado do servidor não é
+// verificado: serve ao broker de teste local (scripts/tls_broker.py), não a produção.
+
+#define TLS_SESSION_SLOTS 2            // Servidores com sessão guardada (o menos usado sai)
+#define TLS_SESSION_MAX 1024           // Sessão serializada, com o certificado do servidor
+#define TLS_CONNECT_TIMEOUT_MS 5000    // Handshake TCP
+#define TLS_HANDSHAKE_TIMEOUT_MS 10000
+#define TLS_WRITE_TIMEOUT_MS 5000
+#ifndef TLS_ACTIVE_MW
+#define TLS_ACTIVE_MW 400              // ESP32 com Wi-Fi ativo: ~120 mA a 3,3 V
+#endif
+
+struct TlsStats {
+  uint32_t fullHandshakes = 0;
+  uint32_t resumedHandshakes = 0;
+  uint32_t rejectedSessions = 0;   // Sessão oferecida e recusada (virou handshake completo)
+  uint32_t failures = 0;           // Handshakes que falharam ou estouraram o prazo
+  uint32_t restoredSessions = 0;   // Sessões válidas achadas na RTC no boot
+  uint32_t oversizedSessions = 0;  // Maiores que TLS_SESSION_MAX, não guardadas
+  uint32_t lastMs = 0;             // Último handshake (sem o TCP)
+  uint32_t lastBytes = 0;          // Bytes trocados no último handshake, nos dois sentidos
+  bool lastResumed = false;
+  uint64_t fullMsTotal = 0;
+  uint64_t resumedMsTotal = 0;
+  uint64_t fullBytesTotal = 0;
+  uint64_t resumedBytesTotal = 0;
+
+  uint32_t meanFullMs() const { return fullHandshakes ? (uint32_t)(fullMsTotal / fullHandshakes) : 0; }
+  uint32_t meanResumedMs() const { return resumedHandshakes ? (uint32_t)(resumedMsTotal / resumedHandshakes) : 0; }
+  uint32_t meanFullBytes() const { return fullHandshakes ? (uint32_t)(fullBytesTotal / fullHandshakes) : 0; }
+  uint32_t meanResumedBytes() const {
+    return resumedHandshakes ? (uint32_t)(resumedBytesTotal / resumedHandshakes) : 0;
+  }
+};
+
+struct TlsContext;
+
+class TlsClient {
+ public:
+  TlsClient();
+  ~TlsClient();
+
+  void setCACert(const char* pem) { _caCert = pem; }
+  void setServerName(const char* name);
+
+  int connect(const char* host, uint16_t port) { return connect(host, port, TLS_CONNECT_TIMEOUT_MS); }
+  int connect(const char* host, uint16_t port, int32_t timeoutMs);
+  uint8_t connected();
+  size_t write(const uint8_t* data, size_t length);
+  int available();
+  int read();
+  int read(uint8_t* buffer, size_t length);
+  void stop();
+
+  const TlsStats& stats() const { return _stats; }
+  const char* suite() const;       // Suíte da conexão atual ("" sem conexão)
+  size_t cachedSessions() const;
+
+ private:
+  bool setup();
+  void lose();
+  int findSession(const char* name, uint16_t port) const;
+  bool offerSession(int slot);
+  void saveSession(const char* name, uint16_t port);
+
+  TlsContext* _tls = nullptr;      // Alocado na primeira conexão
+  const char* _caCert = nullptr;
+  char _serverName[BROKER_HOST_MAX] = "";
+  TlsStats _stats;
+};
+
+// Nome do broker para o SNI e a sessão quando a conexão é pelo IP do cache de DNS
+// (mqtt_transport.h); os sockets sem TLS usam a versão sem efeito de transport.h
+inline void setServerName(TlsClient& socket, const char* name) { socket.setServerName(name); }
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mqtt_client.h"
+
+// Caminho de publicação independente do transporte. Não há classe base: cada transporte é
+// uma classe concreta com a mesma interface e o firmware é compilado para um deles
+// (UPLINK_TRANSPORT em main.cpp), então as chamadas do caminho quente são diretas e
+// inlináveis. Interface:
+//
+//   void begin(const TransportConfig& config)   identidade do dispositivo e comandos
+//   bool connect()                              um passo da tentativa; true com a conexão pronta
+//   bool connecting()                           tentativa em andamento: chamar connect() de novo
+//   bool connected()
+//   void loop()                                 confirmações, reenvios, comandos recebidos
+//   bool ready()                                cabe mais um send() (janela ou lote)
+//   bool send(const char* topic, ByteSpan payload, int8_t qos)
+//   bool flush()                                entrega o que send() acumulou
+//   void setWindow(uint8_t) / uint8_t window() / size_t inflight()
+//   int state() / const char* protocol() / const MqttStats& stats()
+//
+// send() não guarda o ponteiro: ao retornar, o buffer do chamador pode ser reutilizado.
+// O payload vai do buffer do chamador direto para o socket quando não precisa de
+// confirmação; com confirmação (QoS 1, lote HTTP) o transporte guarda a única cópia que
+// existe até a entrega. qos -1 é "sem conexão nem confirmação" onde existir (MQTT-SN) e
+// vira 0 nos demais. Os contadores seguem os do MqttStats: published/acked para o que
+// tem confirmação, qos0 para o resto.
+//
+// Transportes: mqtt_transport.h (MQTT e MQTT-SN), http_transport.h (POST HTTP/1.1 em
+// lote) e udp_transport.h (datagramas UDP crus).
+
+// Trecho de memória somente leitura (o std::span do C++20)
+struct ByteSpan {
+  const uint8_t* data;
+  size_t size;
+
+  ByteSpan(const void* bytes, size_t length) : data((const uint8_t*)bytes), size(length) {}
+};
+
+typedef void (*TransportCallback)(char* topic, uint8_t* payload, unsigned int length);
+
+// Tópico com id fixo combinado com o gateway MQTT-SN; os demais transportes ignoram
+struct TransportTopic {
+  const char* name;
+  uint16_t id;
+};
+
+// Ponteiros precisam continuar válidos enquanto o transporte existir
+struct TransportConfig {
+  const char* clientId;
+  const char* commandTopic;              // Comandos recebidos chegam ao callback com este tópico
+  TransportCallback callback;
+  uint32_t sessionExpiryS;               // MQTT 5: sessão guardada pelo broker após a queda
+  const TransportTopic* predefined;
+  size_t predefinedCount;
+};
+
+// Nome do servidor para um socket que conecta pelo IP já resolvido (broker_pool.h): o
+// TlsClient (tls_client.h) o usa no SNI e para achar a sessão guardada; os demais ignoram
+template <typename Socket>
+inline void setServerName(Socket&, const char*) {}
+
+// Dois transportes na mesma imagem com a escolha feita no boot (MQTT ou MQTT-SN): um
+// desvio por chamada, previsível, no lugar de uma chamada virtual
+template <typename Primary, typename Alternate>
+class SwitchableTransport {
+ public:
+  SwitchableTransport(Primary& primary, Alternate& alternate) : _primary(primary), _alternate(alternate) {}
+
+  // Só antes de begin()
+  void select(bool alternate) { _useAlternate = alternate; }
+  bool alternate() const { return _useAlternate; }
+
+  void begin(const TransportConfig& config) {
+    _primary.begin(config);
+    _alternate.begin(config);
+  }
+  bool connect() { return _useAlternate ? _alternate.connect() : _primary.connect(); }
+  bool connecting() const { return _useAlternate ? _alternate.connecting() : _primary.connecting(); }
+  bool connected() { return _useAlternate ? _alternate.connected() : _primary.connected(); }
+  void loop() {
+    if (_useAlternate) {
+      _alternate.loop();
+    } else {
+      _primary.loop();
+    }
+  }
+  bool ready() { return _useAlternate ? _alternate.ready() : _primary.ready(); }
+  bool send(const char* topic, ByteSpan payload, int8_t qos) {
+    return _useAlternate ? _alternate.send(topic, payload, qos) : _primary.send(topic, payload, qos);
+  }
+  bool flush() { return _useAlternate ? _alternate.flush() : _primary.flush(); }
+
+  void setWindow(uint8_t window) {
+    _primary.setWindow(window);
+    _alternate.setWindow(window);
+  }
+  uint8_t window() const { return _useAlternate ? _alternate.window() : _primary.window(); }
+  size_t inflight() const { return _useAlternate ? _alternate.inflight() : _primary.inflight(); }
+  int state() const { return _useAlternate ? _alternate.state() : _primary.state(); }
+  const char* protocol() const { return _useAlternate ? _alternate.protocol() : _primary.protocol(); }
+  const MqttStats& stats() const { return _useAlternate ? _alternate.stats() : _primary.stats(); }
+
+ private:
+  Primary& _primary;
+  Alternate& _alternate;
+  bool _useAlternate = false;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compressão de blocos de amostras no estilo Gorilla (Facebook, VLDB 2015):
+//  - timestamps: delta-of-delta com prefixos de tamanho variável
+//  - valores: inteiros em escala fixa (10^scale), delta com zigzag e largura variável
+//
+// Formato do bloco (little endian):
+//   0  'A' 'F'        magic
+//   2  uint8 versão   (TS_BLOCK_VERSION)
+//   3  uint8 escala   valor real = valor inteiro / 10^escala
+//   4  uint16 count   número de amostras
+//   6  uint64 t0      timestamp da primeira amostra (epoch ms)
+//   14 int32 v0       valor inteiro da primeira amostra
+//   18 uint32 epoch   época de boot e número de sequência da primeira amostra (sequence.h);
+//   22 uint32 seq     a amostra i tem seq + i * stride
+//   26 uint16 stride  1 para leituras; o fator de redução nas respostas de histórico
+//   28 bitstream      amostras 2..count, bit mais significativo primeiro
+//
+// Timestamp (dod = delta atual - delta anterior; o delta "anterior" da 2ª amostra é 0):
+//   '0' dod=0 | '10'+7 bits | '110'+9 bits | '1110'+12 bits | '1111'+32 bits (complemento de 2;
+//   faixas [-64,63], [-256,255] e [-2048,2047])
+// Valor (z = zigzag(v - v_anterior)):
+//   '0' z=0 | '1' + 5 bits (n-1) + n bits de z
+//
+// O decodificador de referência para o backend está em scripts/ts_codec.py.
+
+#define TS_BLOCK_VERSION 2
+#define TS_BLOCK_HEADER_SIZE 28
+#define TS_SAMPLE_MAX_BITS (4 + 32 + 1 + 5 + 32)
+
+class TsBlockEncoder {
+ public:
+  TsBlockEncoder(uint8_t* out, size_t capacity, uint8_t scale);
+
+  // Sequência da primeira amostra; as seguintes devem ser consecutivas (passo "stride")
+  void setSequence(uint32_t epoch, uint32_t firstSeq, uint16_t stride = 1);
+
+  // Acrescenta uma amostra; retorna false se o bloco não tem mais espaço garantido ou se o
+  // delta-of-delta não cabe em 32 bits (intervalo de mais de ~24,8 dias, ex.: um longo
+  // período desligado). Nos dois casos a amostra fica para um bloco novo.
+  bool add(uint64_t timestampMs, int32_t value);
+
+  // Grava o cabeçalho final e retorna o tamanho do bloco em bytes. Um bloco sem amostras
+  // (só o cabeçalho, count = 0) é válido e serve de marcador de fim de sequência.
+  size_t finish();
+
+  uint16_t count() const { return _count; }
+  size_t bitsUsed() const { return _bitPos; }
+
+ private:
+  void writeBits(uint32_t value, uint8_t bits);
+
+  uint8_t* _out;
+  size_t _capacity;
+  uint8_t _scale;
+  uint16_t _count = 0;
+  uint32_t _epoch = 0;
+  uint32_t _firstSeq = 0;
+  uint16_t _stride = 1;
+  size_t _bitPos = 0;  // Posição no bitstream (depois do cabeçalho)
+  uint64_t _lastTimestamp = 0;
+  int64_t _lastDelta = 0;
+  int32_t _lastValue = 0;
+};
+
+class TsBlockDecoder {
+ public:
+  // Retorna false se o cabeçalho for inválido
+  bool begin(const uint8_t* block, size_t length);
+  // Próxima amostra; retorna false ao fim do bloco ou se os dados estiverem truncados
+  bool next(uint64_t& timestampMs, int32_t& value);
+
+  uint16_t count() const { return _count; }
+  uint8_t scale() const { return _scale; }
+  uint32_t epoch() const { return _epoch; }
+  uint32_t firstSeq() const { return _firstSeq; }
+  uint16_t stride() const { return _stride; }
+
+ private:
+  bool readBits(uint8_t bits, uint32_t& value);
+
+  const uint8_t* _bits = nullptr;
+  size_t _bitLength = 0;
+  size_t _bitPos = 0;
+  uint8_t _scale = 0;
+  uint16_t _count = 0;
+  uint32_t _epoch = 0;
+  uint32_t _firstSeq = 0;
+  uint16_t _stride = 1;
+  uint16_t _read = 0;
+  uint64_t _lastTimestamp = 0;
+  int64_t _lastDelta = 0;
+  int32_t _lastValue = 0;
+};
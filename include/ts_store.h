@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sequence.h"
+
+// Histórico de leituras em flash, num log circular sobre uma partição de dados.
+//
+// Cada setor de 4 KB é uma página: um cabeçalho com número de sequência e timestamp base,
+// seguido de registros de 8 bytes gravados em ordem (offset em ms desde a base, valor em
+// escala fixa e CRC-16 do registro). Quando a partição enche, a página mais antiga é
+// apagada e reaproveitada: todos os setores recebem o mesmo número de apagamentos, sem
+// precisar de uma camada de wear levelling à parte.
+//
+// Os cabeçalhos das páginas formam o índice esparso (uma entrada por página): a busca por
+// tempo é binária sobre eles e depois linear dentro de uma página. No ESP32 a partição é
+// mapeada na memória (esp_partition_mmap) e a leitura não copia nada; no host uma região
+// em RAM simula a flash NOR (apagar deixa 0xFF, gravar só zera bits).
+//
+// Os timestamps precisam ser não decrescentes: append() ajusta para o último gravado
+// caso o relógio volte (correção do NTP).
+//
+// Cada página guarda também a época e o número de sequência da primeira leitura; o registro
+// no slot i tem seq = primeiro + i. Uma leitura fora de sequência (novo boot, leituras não
+// gravadas) abre uma página nova, então o número de cada registro sai de graça na leitura.
+
+#define TS_STORE_PAGE_SIZE 4096
+#define TS_STORE_PARTITION_LABEL "tslog"
+// Sem a partição "tslog" o histórico fica desligado. -DTS_STORE_FALLBACK_LABEL='"spiffs"' usa
+// outra partição de dados no lugar (ex.: a da tabela padrão do esp32dev), APAGANDO o que
+// houver nela; o begin() avisa na serial quando isso acontece.
+#ifndef TS_STORE_HOST_PAGES
+#define TS_STORE_HOST_PAGES 16
+#endif
+
+struct TsRecord {
+  uint64_t timestampMs;
+  int32_t value;
+  SeqNo seq;
+};
+
+// Posição de leitura: número de sequência da página (absoluto, não muda quando a mais
+// antiga é descartada durante a consulta) e registro dentro dela
+struct TsCursor {
+  uint32_t pageSeq;
+  uint16_t slot;
+};
+
+struct TsStoreStats {
+  uint32_t pages = 0;       // Páginas da partição
+  uint32_t usedPages = 0;   // Páginas com dados (a última pode estar incompleta)
+  uint32_t appended = 0;    // Registros gravados desde o boot
+  uint32_t erases = 0;      // Setores apagados desde o boot
+  uint32_t crcErrors = 0;   // Registros ou cabeçalhos corrompidos encontrados
+  uint32_t writeErrors = 0;
+};
+
+class TsStore {
+ public:
+  // Localiza a partição, mapeia e reconstrói a posição de escrita a partir dos cabeçalhos
+  bool begin();
+  bool ready() const { return _base != nullptr; }
+
+  // Grava uma leitura; o valor é limitado a int16 (umidade em centésimos cabe com folga)
+  bool append(uint64_t timestampMs, int32_t value, SeqNo seq);
+
+  // Posiciona o cursor no primeiro registro com timestamp >= timestampMs
+  TsCursor seek(uint64_t timestampMs) const;
+
+  // Lê o registro no cursor e avança; false no fim do log. Registros corrompidos são pulados;
+  // se a página do cursor foi reaproveitada nesse meio tempo, segue da mais antiga que restou.
+  bool read(TsCursor& cursor, TsRecord& record);
+
+  uint64_t oldestTimestamp() const;
+  const TsStoreStats& stats() const { return _stats; }
+
+  static constexpr uint16_t recordsPerPage();
+
+ private:
+  struct PageHeader {
+    uint32_t magic;
+    uint32_t pageSeq;  // Ordem das páginas no log circular
+    uint64_t baseTimestamp;
+    uint32_t epoch;    // Sequência da primeira leitura da página
+    uint32_t firstSeq;
+    uint32_t crc;
+    uint32_t reserved;
+  };
+  struct Record {
+    uint32_t offsetMs;
+    int16_t value;
+    uint16_t crc;
+  };
+
+  const PageHeader* header(uint32_t physical) const;
+  const Record* record(uint32_t physical, uint16_t slot) const;
+  bool headerValid(uint32_t physical) const;
+  uint32_t physicalPage(uint32_t logical) const { return (_oldest + logical) % _stats.pages; }
+  // As páginas são abertas em ordem física com sequência +1: a posição sai da distância à cabeça
+  uint32_t oldestPageSeq() const { return _headPageSeq - (_stats.usedPages - 1); }
+  uint32_t physicalOfSeq(uint32_t pageSeq) const {
+    return (_head + _stats.pages - (_headPageSeq - pageSeq) % _stats.pages) % _stats.pages;
+  }
+  bool openPage(uint64_t timestampMs, SeqNo seq);
+
+  const uint8_t* _base = nullptr;  // Partição mapeada (somente leitura)
+  uint32_t _oldest = 0;            // Página física mais antiga
+  uint32_t _head = 0;              // Página física em escrita
+  uint16_t _headSlot = 0;          // Próximo registro livre na página em escrita
+  uint32_t _headPageSeq = 0;
+  uint64_t _headBase = 0;
+  SeqNo _headFirst = {};
+  uint64_t _lastTimestamp = 0;
+  TsStoreStats _stats;
+};
+
+constexpr uint16_t TsStore::recordsPerPage() {
+  return (TS_STORE_PAGE_SIZE - sizeof(PageHeader)) / sizeof(Record);
+}
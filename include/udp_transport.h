@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "transport.h"
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Transporte de datagramas UDP crus (interface de transport.h): cada send() é um datagrama
+//   <tópico>\n<payload>
+// escrito direto do buffer do chamador, sem conexão, confirmação nem reenvio (todo envio
+// conta como qos0, qualquer que seja o QoS pedido). É o piso de custo contra o qual os
+// outros transportes são medidos. Datagramas recebidos do coletor na porta local são
+// comandos, entregues ao callback com o tópico de comando.
+//
+// O socket é um parâmetro de template (WiFiUDP no ESP32 ou qualquer classe com
+// begin/beginPacket/write/endPacket/parsePacket/read).
+
+#define UDP_TRANSPORT_LOCAL_PORT 10001
+#define UDP_TRANSPORT_RX_BUFFER 256    // Maior comando recebido; o resto do datagrama é descartado
+
+template <typename Udp>
+class UdpTransport {
+ public:
+  UdpTransport(Udp& udp, MqttMillisFn millisFn, const char* host, uint16_t port)
+      : _udp(udp), _millis(millisFn), _host(host), _port(port) {}
+
+  void begin(const TransportConfig& config) { _config = config; }
+
+  bool connect() {
+    if (!_udp.begin(UDP_TRANSPORT_LOCAL_PORT)) {
+      _state = MQTT_STATE_CONNECT_FAILED;
+      return false;
+    }
+    _state = MQTT_STATE_CONNECTED;
+    _stats.connects++;
+    return true;
+  }
+  bool connecting() const { return false; }
+  bool connected() const { return _state == MQTT_STATE_CONNECTED; }
+
+  void loop() {
+    int length = _udp.parsePacket();
+    if (length <= 0) return;
+    uint8_t command[UDP_TRANSPORT_RX_BUFFER];
+    int n = _udp.read(command, sizeof(command) - 1);
+    if (n <= 0 || !_config.callback) return;
+    command[n] = '\0';
+    _config.callback((char*)_config.commandTopic, command, (unsigned int)n);
+  }
+
+  bool ready() const { return true; }
+
+  bool send(const char* topic, ByteSpan payload, int8_t) {
+    if (!_udp.beginPacket(_host, _port)) {
+      _stats.rejected++;
+      return false;
+    }
+    _udp.write((const uint8_t*)topic, strlen(topic));
+    _udp.write((const uint8_t*)"\n", 1);
+    _udp.write(payload.data, payload.size);
+    if (!_udp.endPacket()) {
+      _stats.rejected++;
+      return false;
+    }
+    _stats.qos0++;
+    return true;
+  }
+  bool flush() { return true; }
+
+  void setWindow(uint8_t) {}
+  uint8_t window() const { return 0; }
+  size_t inflight() const { return 0; }
+  int state() const { return _state; }
+  const char* protocol() const { return "udp"; }
+  const MqttStats& stats() const { return _stats; }
+
+ private:
+  Udp& _udp;
+  MqttMillisFn _millis;
+  const char* _host;
+  uint16_t _port;
+  TransportConfig _config = {};
+  int _state = MQTT_STATE_DISCONNECTED;
+  MqttStats _stats;
+};
@@ -0,0 +1,71 @@
+"""
+Compara duas execuções dos microbenchmarks (saída de src/bench_main.cpp), da bateria de
+falhas da simulação (sim/replay_main.cpp --bench) ou da latência fim a fim
+(sim/broker_main.cpp --bench).
+
+Uso: python scripts/bench_compare.py antes.jsonl depois.jsonl [--limite 10]
+
+Aceita a saída crua do monitor serial: linhas que não são resultados são ignoradas.
+Retorna código 1 se algum caso piorar mais que o limite (%) em ns/op, ciclos/op,
+bytes alocados/op ou pilha; na bateria de falhas, em tempo de recuperação e de religação,
+leituras perdidas, maior buraco entre leituras ou CPU gasta na recuperação; na latência
+fim a fim, em p50/p99/p999 (a vazão máxima, em que maior é melhor, não é comparada).
+"""
+import argparse
+import json
+import sys
+
+METRICS = ("ns_per_op", "cycles_per_op", "alloc_bytes_per_op", "stack_bytes",
+           "recovery_ms", "reconnect_ms", "lost_readings", "hole_ms", "cpu_ms",
+           "p50_us", "p99_us", "p999_us")
+
+
+def load(path):
+    results = {}
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            start = line.find('{"bench":')
+            if start < 0:
+                continue
+            try:
+                entry = json.loads(line[start:])
+            except ValueError:
+                continue
+            results[(entry["platform"], entry["bench"])] = entry
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--limite", type=float, default=10.0,
+                        help="piora máxima aceita, em porcentagem")
+    args = parser.parse_args()
+
+    before, after = load(args.before), load(args.after)
+    regressions = 0
+    print("%-8s %-20s %-20s %14s %14s %9s" % ("plat", "caso", "metrica", "antes", "depois", "delta"))
+    for key in sorted(set(before) | set(after)):
+        if key not in before or key not in after:
+            print("%-8s %-20s %s" % (key[0], key[1], "ausente em uma das execucoes"))
+            continue
+        for metric in METRICS:
+            old, new = before[key].get(metric), after[key].get(metric)
+            if old is None or new is None:
+                continue
+            if old == 0:
+                delta = 0.0 if new == 0 else float("inf")
+            else:
+                delta = (new - old) * 100.0 / old
+            flag = ""
+            if delta > args.limite:
+                flag = "  <-- piorou"
+                regressions += 1
+            print("%-8s %-20s %-20s %14.2f %14.2f %+8.1f%%%s"
+                  % (key[0], key[1], metric, old, new, delta, flag))
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == "__main__":
+    main()
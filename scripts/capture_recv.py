@@ -0,0 +1,188 @@
+"""
+Receptor da captura binária do ADC (include/capture.h): lê os quadros COBS da serial,
+confere CRC e numeração e grava as amostras em arquivo.
+
+    python scripts/capture_recv.py /dev/ttyUSB0 captura.csv            # 921600 baud
+    python scripts/capture_recv.py /dev/ttyUSB0 captura.u16 --format u16
+    python scripts/capture_recv.py gravacao.bin captura.csv             # arquivo já gravado
+
+No dispositivo, a captura começa com o comando "CAPTURE <hz> [segundos]" ou ligando o
+pino CAPTURE_PIN ao GND (src/main.cpp), e termina no quadro vazio de fim, que também
+encerra este receptor (ou Ctrl+C).
+
+Formatos de saída:
+  csv  uma linha "quadro,t_us,raw" por amostra; t_us no relógio do dispositivo, sem a
+       volta dos 32 bits, e amostras de quadros perdidos simplesmente faltam
+  u16  só as leituras, uint16 little endian em sequência, para numpy.fromfile; quadros
+       perdidos viram 0xFFFF (fora dos 12 bits) para manter a base de tempo
+
+O resumo (quadros, amostras, CRC inválidos, quadros perdidos, taxa efetiva) vai para a
+saída de erro. Só usa a biblioteca padrão: a serial é configurada com termios (Linux/macOS).
+"""
+import argparse
+import os
+import struct
+import sys
+import termios
+import time
+
+VERSION = 1
+HEADER = struct.Struct("<BBHII")
+SAMPLES_PER_FRAME = 32  # CAPTURE_SAMPLES_PER_FRAME
+GAP_VALUE = 0xFFFF  # Fora da faixa de 12 bits do ADC
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, o mesmo de include/crc.h."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            raise ValueError("COBS invalido")
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class FrameError(ValueError):
+    pass
+
+
+def parse_frame(encoded):
+    """Retorna (seq, período µs, t0 µs, [raw]); FrameError se o quadro não confere."""
+    try:
+        frame = cobs_decode(encoded)
+    except ValueError as e:
+        raise FrameError(str(e))
+    if len(frame) < HEADER.size + 2:
+        raise FrameError("quadro curto (%d bytes)" % len(frame))
+    if crc16(frame[:-2]) != struct.unpack_from("<H", frame, len(frame) - 2)[0]:
+        raise FrameError("CRC invalido")
+    version, count, period, seq, t0 = HEADER.unpack_from(frame)
+    if version != VERSION or len(frame) != HEADER.size + 2 * count + 2:
+        raise FrameError("versao %d ou tamanho %d inesperado" % (version, len(frame)))
+    return seq, period, t0, struct.unpack_from("<%dH" % count, frame, HEADER.size)
+
+
+def open_source(path, baud):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        attrs = termios.tcgetattr(fd)
+        speed = getattr(termios, "B%d" % baud)
+        attrs[0] = 0                                  # iflag: sem tradução nem controle de fluxo
+        attrs[1] = 0                                  # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0                                  # lflag: modo bruto
+        attrs[4] = attrs[5] = speed
+        attrs[6][termios.VMIN] = 1
+        attrs[6][termios.VTIME] = 0
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+        termios.tcflush(fd, termios.TCIFLUSH)
+    return fd
+
+
+class Capture:
+    def __init__(self, out, fmt):
+        self.out = out
+        self.fmt = fmt
+        self.frames = 0
+        self.samples = 0
+        self.bad = 0
+        self.lost = 0
+        self.expected = None
+        self.period = 0
+        self.high = 0      # Voltas dos 32 bits do t0
+        self.last_t0 = None
+        self.first_t = None
+        self.last_t = None
+        self.done = False
+
+    def frame(self, encoded):
+        try:
+            seq, period, t0, raws = parse_frame(encoded)
+        except FrameError as e:
+            # O que vem antes do primeiro delimitador é lixo (log em texto): não conta
+            if self.expected is not None:
+                self.bad += 1
+                print("quadro descartado: %s" % e, file=sys.stderr)
+            return
+        if self.expected is not None and seq != self.expected:
+            missing = (seq - self.expected) & 0xFFFFFFFF
+            self.lost += missing
+            if self.fmt == "u16":
+                self.out.write(struct.pack("<H", GAP_VALUE) * (missing * SAMPLES_PER_FRAME))
+        self.expected = (seq + 1) & 0xFFFFFFFF
+        self.period = period
+        if not raws:
+            self.done = True
+            return
+        if self.last_t0 is not None and t0 < self.last_t0:
+            self.high += 1 << 32
+        self.last_t0 = t0
+        t = self.high + t0
+        if self.first_t is None:
+            self.first_t = t
+        self.last_t = t + (len(raws) - 1) * period
+        if self.fmt == "csv":
+            self.out.write("".join("%d,%d,%d\n" % (seq, t + i * period, raw) for i, raw in enumerate(raws)))
+        else:
+            self.out.write(struct.pack("<%dH" % len(raws), *raws))
+        self.frames += 1
+        self.samples += len(raws)
+
+    def summary(self):
+        span = (self.last_t - self.first_t) / 1e6 if self.first_t is not None and self.last_t > self.first_t else 0
+        return ("quadros=%d amostras=%d crc_invalidos=%d quadros_perdidos=%d periodo=%d us taxa_efetiva=%.1f Hz" % (
+            self.frames, self.samples, self.bad, self.lost, self.period, self.samples / span if span else 0))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("source", help="porta serial (ex.: /dev/ttyUSB0) ou arquivo gravado")
+    parser.add_argument("output", help="arquivo de saída")
+    parser.add_argument("--baud", type=int, default=921600)
+    parser.add_argument("--format", choices=("csv", "u16"), default="csv")
+    parser.add_argument("--seconds", type=float, default=0, help="para depois de N s (0: até o quadro de fim)")
+    args = parser.parse_args()
+
+    fd = open_source(args.source, args.baud)
+    out = open(args.output, "w" if args.format == "csv" else "wb")
+    if args.format == "csv":
+        out.write("quadro,t_us,raw\n")
+    capture = Capture(out, args.format)
+    pending = b""
+    deadline = time.monotonic() + args.seconds if args.seconds else None
+    try:
+        while not capture.done and (deadline is None or time.monotonic() < deadline):
+            chunk = os.read(fd, 65536)
+            if not chunk:
+                break  # Fim do arquivo
+            parts = (pending + chunk).split(b"\x00")
+            pending = parts.pop()
+            for encoded in parts:
+                if encoded:
+                    capture.frame(encoded)
+                if capture.done:
+                    break
+    except KeyboardInterrupt:
+        pass
+    out.close()
+    os.close(fd)
+    print(capture.summary(), file=sys.stderr)
+    return 0 if capture.bad == 0 and capture.lost == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
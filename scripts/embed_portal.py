@@ -0,0 +1,73 @@
+"""
+Gera include/portal_assets.h a partir de web/index.html.
+
+A pagina do portal e comprimida com gzip em tempo de build e embutida em PROGMEM,
+junto com um ETag forte (hash do conteudo comprimido). Roda automaticamente antes
+de cada build (extra_scripts = pre:scripts/embed_portal.py) e tambem pode ser
+executado manualmente a partir da raiz do projeto: python scripts/embed_portal.py
+"""
+import gzip
+import hashlib
+import os
+
+ASSETS = [
+    # (arquivo de origem, nome do simbolo C)
+    ("web/index.html", "index_html_gz"),
+]
+OUTPUT = "include/portal_assets.h"
+SCRIPT = "scripts/embed_portal.py"
+
+
+def _project_dir():
+    try:
+        Import("env")  # noqa: F821 -- injetado pelo SCons do PlatformIO
+        return env.subst("$PROJECT_DIR")  # noqa: F821
+    except NameError:
+        return os.getcwd()
+
+
+def _c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def generate(project_dir):
+    out_path = os.path.join(project_dir, OUTPUT)
+    sources = [os.path.join(project_dir, src) for src, _ in ASSETS]
+    if os.path.exists(out_path):
+        newest = max(os.path.getmtime(p) for p in sources + [os.path.join(project_dir, SCRIPT)])
+        if os.path.getmtime(out_path) >= newest:
+            return
+
+    parts = [
+        "// Gerado automaticamente por scripts/embed_portal.py -- NAO EDITE.",
+        "// Edite os arquivos em web/ e recompile.",
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+    ]
+    for src, symbol in ASSETS:
+        with open(os.path.join(project_dir, src), "rb") as f:
+            raw = f.read()
+        # mtime=0 deixa a saida deterministica (mesmo HTML -> mesmo ETag)
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha256(packed).hexdigest()[:16]
+        macro = symbol.upper()
+        parts += [
+            "// %s: %d bytes -> %d bytes (gzip)" % (src, len(raw), len(packed)),
+            '#define %s_ETAG "\\"%s\\""' % (macro, etag),
+            "const size_t %s_len = %d;" % (symbol, len(packed)),
+            "const uint8_t %s[] PROGMEM = {" % symbol,
+            _c_array(packed),
+            "};",
+            "",
+        ]
+    with open(out_path, "w", newline="\n") as f:
+        f.write("\n".join(parts))
+    print("embed_portal: %s atualizado" % OUTPUT)
+
+
+generate(_project_dir())
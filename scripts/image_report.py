@@ -0,0 +1,54 @@
+"""
+Relatório de tamanho da imagem, gerado depois de cada build
+(extra_scripts = post:scripts/image_report.py).
+
+Grava $BUILD_DIR/image_report.json com o tamanho do .bin, o uso de flash por seção e a RAM
+estática (DRAM/IRAM), para comparar as imagens híbrida, de fábrica e de sensoriamento.
+O tempo de boot é medido em execução: cada imagem imprime "BOOT image=... setup_ms=..."
+no Serial ao final do setup().
+"""
+import json
+import os
+import subprocess
+
+Import("env")  # noqa: F821
+
+FLASH_SECTIONS = (".flash.text", ".flash.rodata", ".flash.appdesc", ".iram0.text",
+                  ".iram0.vectors", ".dram0.data", ".rtc.text", ".rtc.data")
+DRAM_SECTIONS = (".dram0.data", ".dram0.bss", ".noinit")
+IRAM_SECTIONS = (".iram0.text", ".iram0.vectors")
+RTC_SECTIONS = (".rtc.data", ".rtc.bss", ".rtc_noinit", ".rtc.text")
+
+
+def _sections(elf):
+    out = subprocess.check_output([env.subst("$SIZETOOL"), "-A", "-d", elf]).decode()  # noqa: F821
+    sizes = {}
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith(".") and parts[1].isdigit():
+            sizes[parts[0]] = int(parts[1])
+    return sizes
+
+
+def _report(source, target, env):
+    build_dir = env.subst("$BUILD_DIR")
+    elf = os.path.join(build_dir, env.subst("${PROGNAME}.elf"))
+    binary = str(target[0])
+    sizes = _sections(elf)
+    total = lambda names: sum(sizes.get(n, 0) for n in names)
+    report = {
+        "env": env.subst("$PIOENV"),
+        "bin_bytes": os.path.getsize(binary),
+        "flash_bytes": total(FLASH_SECTIONS),
+        "dram_static_bytes": total(DRAM_SECTIONS),
+        "iram_bytes": total(IRAM_SECTIONS),
+        "rtc_bytes": total(RTC_SECTIONS),
+        "sections": sizes,
+    }
+    with open(os.path.join(build_dir, "image_report.json"), "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+    print("IMAGE env=%(env)s bin=%(bin_bytes)d flash=%(flash_bytes)d dram=%(dram_static_bytes)d "
+          "iram=%(iram_bytes)d" % report)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", _report)  # noqa: F821
@@ -0,0 +1,101 @@
+"""
+Gerador de traços sintéticos do ADC para o replay (sim/replay_main.cpp): umidade do solo
+secando entre irrigações, com ciclo diário, ruído e falhas do sensor, convertida para a
+leitura bruta com a calibração do firmware (DRY_VALUE/WET_VALUE em src/main.cpp).
+
+    python scripts/make_trace.py mes.csv                       # 30 dias a cada 5 s
+    python scripts/make_trace.py dia.csv --days 1 --period 1 --seed 7
+    python scripts/make_trace.py mes.u16 --format u16          # para o replay com --rate 0.2
+
+Cenário (todos os parâmetros têm opção):
+  - irrigação a cada --irrigate-hours: a umidade sobe a --wet em ~20 min e depois seca
+    exponencialmente em direção a --dry com constante --tau-hours;
+  - ciclo diário de +-1,5% (a evaporação acompanha o sol) e ruído gaussiano de --noise
+    contagens do ADC;
+  - --spikes picos isolados por dia (leitura no fundo de escala ou em 0) e --dropouts
+    desconexões por mês (saída do sensor em ~0 V por 10 min), que disparam os alarmes.
+
+Formatos: csv "t_ms,raw" (com cabeçalho) ou u16 (leituras uint16 little endian, sem tempo).
+Só usa a biblioteca padrão; a mesma semente gera o mesmo traço.
+"""
+import argparse
+import math
+import random
+import struct
+import sys
+
+DRY_VALUE = 2850  # src/main.cpp
+WET_VALUE = 1350
+
+
+def raw_from_humidity(humidity):
+    return DRY_VALUE + (WET_VALUE - DRY_VALUE) * humidity / 100.0
+
+
+def generate(args):
+    rng = random.Random(args.seed)
+    period_ms = int(args.period * 1000)
+    count = int(args.days * 86400 * 1000 / period_ms)
+    irrigate_ms = args.irrigate_hours * 3600 * 1000
+    tau_ms = args.tau_hours * 3600 * 1000
+    spike_p = args.spikes * period_ms / 86400000.0
+    dropout_p = args.dropouts * period_ms / (30 * 86400000.0)
+    dropout_left = 0
+
+    humidity = args.dry + (args.wet - args.dry) * 0.5
+    next_irrigation = irrigate_ms / 2
+    filling_until = -1
+    for i in range(count):
+        t = i * period_ms
+        if t >= next_irrigation:
+            filling_until = t + 20 * 60 * 1000
+            next_irrigation += irrigate_ms
+        if t < filling_until:
+            humidity += (args.wet - humidity) * min(1.0, period_ms / (5 * 60 * 1000.0))
+        else:
+            humidity += (args.dry - humidity) * (1 - math.exp(-period_ms / tau_ms))
+        diurnal = 1.5 * math.sin(2 * math.pi * (t / 86400000.0 - 0.25))
+        raw = raw_from_humidity(humidity + diurnal) + rng.gauss(0, args.noise)
+
+        if dropout_left > 0:
+            dropout_left -= 1
+            raw = rng.uniform(0, 40)
+        elif rng.random() < dropout_p:
+            dropout_left = max(1, 10 * 60 * 1000 // period_ms)
+            raw = rng.uniform(0, 40)
+        elif rng.random() < spike_p:
+            raw = rng.choice((0, 4095))
+        yield t, max(0, min(4095, int(round(raw))))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("output", help="arquivo de saída ('-' para a saída padrão, só csv)")
+    parser.add_argument("--format", choices=("csv", "u16"), default=None, help="padrão pela extensão")
+    parser.add_argument("--days", type=float, default=30)
+    parser.add_argument("--period", type=float, default=5, help="segundos entre leituras")
+    parser.add_argument("--wet", type=float, default=75, help="umidade logo após a irrigação (%%)")
+    parser.add_argument("--dry", type=float, default=10, help="umidade para onde o solo seca (%%)")
+    parser.add_argument("--tau-hours", type=float, default=36)
+    parser.add_argument("--irrigate-hours", type=float, default=72)
+    parser.add_argument("--noise", type=float, default=8, help="desvio padrão do ruído (contagens)")
+    parser.add_argument("--spikes", type=float, default=2, help="picos por dia")
+    parser.add_argument("--dropouts", type=float, default=3, help="desconexões por mês")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    fmt = args.format or ("u16" if args.output.endswith((".u16", ".bin")) else "csv")
+    if fmt == "u16":
+        with open(args.output, "wb") as out:
+            out.write(b"".join(struct.pack("<H", raw) for _, raw in generate(args)))
+    else:
+        out = sys.stdout if args.output == "-" else open(args.output, "w")
+        out.write("t_ms,raw\n")
+        out.writelines("%d,%d\n" % sample for sample in generate(args))
+        if out is not sys.stdout:
+            out.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,257 @@
+"""
+Gateway MQTT-SN mínimo para testes locais do transporte UDP (include/mqttsn_client.h).
+
+Não repassa nada a um broker: cada PUBLISH recebido é impresso como uma linha
+"<tópico> <payload>", no mesmo formato de "mosquitto_sub -v", então a saída pode ir
+direto para scripts/seq_tracker.py. Payloads binários (blocos de sensors/<id>/batch)
+saem em hex.
+
+Suporta CONNECT, REGISTER, PUBLISH (QoS -1, 0 e 1), SUBSCRIBE, PINGREQ e DISCONNECT,
+inclusive o cliente dormindo: depois de um DISCONNECT com duração as mensagens para ele
+ficam guardadas e são entregues no próximo PINGREQ com o id do cliente (ou CONNECT).
+
+    python scripts/mqttsn_gateway.py -p 1=sensors/humidity -p 2=sensors/{client}/metrics
+    python scripts/mqttsn_gateway.py --drop 0.2 --command "RATE 1000 60000"
+
+Tópicos predefinidos (-p) aceitam {client} no nome, trocado pelo id do cliente. --drop
+descarta uma fração dos datagramas recebidos, para exercitar os reenvios do cliente.
+--command publica um comando (QoS 1) em sensors/<cliente>/command assim que o cliente
+se inscreve nele. Linhas "<cliente> <comando>" na entrada padrão fazem o mesmo a
+qualquer momento (guardadas se o cliente estiver dormindo).
+"""
+import argparse
+import random
+import select
+import socket
+import struct
+import sys
+
+CONNECT, CONNACK, REGISTER, REGACK = 0x04, 0x05, 0x0A, 0x0B
+PUBLISH, PUBACK, SUBSCRIBE, SUBACK = 0x0C, 0x0D, 0x12, 0x13
+PINGREQ, PINGRESP, DISCONNECT = 0x16, 0x17, 0x18
+
+TOPIC_NORMAL, TOPIC_PREDEFINED = 0x00, 0x01
+RC_ACCEPTED, RC_INVALID_TOPIC = 0x00, 0x02
+FLAG_DUP = 0x80
+
+
+def frame(msg_type, body=b""):
+    length = 2 + len(body)
+    if length < 256:
+        return bytes([length, msg_type]) + body
+    return struct.pack(">BHB", 0x01, length + 2, msg_type) + body
+
+
+def parse(data):
+    if len(data) < 2:
+        return None, b""
+    if data[0] == 0x01:
+        if len(data) < 4:
+            return None, b""
+        length = struct.unpack(">H", data[1:3])[0]
+        return (data[3], data[4:length]) if length <= len(data) else (None, b"")
+    length = data[0]
+    return (data[1], data[2:length]) if 2 <= length <= len(data) else (None, b"")
+
+
+def qos_of(flags):
+    return {0x60: -1, 0x20: 1, 0x40: 2}.get(flags & 0x60, 0)
+
+
+class Client:
+    def __init__(self, client_id, address):
+        self.id = client_id
+        self.address = address
+        self.topics = {}        # id -> nome (registrados nesta sessão)
+        self.subscriptions = {}  # nome -> id
+        self.asleep = False
+        self.pending = []       # Datagramas guardados enquanto dorme
+        self.next_msg_id = 0
+        self.seen = set()       # msg ids QoS 1 já recebidos (duplicatas)
+
+
+class Gateway:
+    def __init__(self, sock, predefined, drop, commands, out):
+        self.sock = sock
+        self.predefined = predefined  # id -> modelo do nome
+        self.drop = drop
+        self.commands = commands
+        self.out = out
+        self.clients = {}   # id do cliente -> Client
+        self.by_address = {}
+        self.next_topic_id = 100
+        self.names = {}     # nome -> id (compartilhado entre clientes, como no gateway da Paho)
+        self.stats = {"received": 0, "dropped": 0, "duplicates": 0}
+
+    def topic_id(self, name):
+        if name not in self.names:
+            self.names[name] = self.next_topic_id
+            self.next_topic_id += 1
+        return self.names[name]
+
+    def send(self, client, data):
+        if client.asleep:
+            client.pending.append(data)
+        else:
+            self.sock.sendto(data, client.address)
+
+    def deliver(self, client, name, payload):
+        client.next_msg_id = client.next_msg_id % 0xFFFF + 1
+        body = struct.pack(">BHH", 0x20 | TOPIC_NORMAL, client.subscriptions[name], client.next_msg_id) + payload
+        self.send(client, frame(PUBLISH, body))
+
+    def flush(self, client):
+        for data in client.pending:
+            self.sock.sendto(data, client.address)
+        client.pending = []
+
+    def resolve(self, client, flags, topic_id):
+        if flags & 0x03 == TOPIC_PREDEFINED:
+            template = self.predefined.get(topic_id)
+            return template.replace("{client}", client.id) if template else None
+        return client.topics.get(topic_id)
+
+    def print_message(self, topic, payload):
+        try:
+            text = payload.decode("utf-8")
+            if not text.isprintable():
+                raise ValueError
+        except ValueError:
+            text = payload.hex()
+        print("%s %s" % (topic, text), file=self.out, flush=True)
+
+    def inject(self, line):
+        client_id, _, command = line.strip().partition(" ")
+        client = self.clients.get(client_id)
+        name = "sensors/%s/command" % client_id
+        if client is None or name not in client.subscriptions:
+            print("cliente %s sem inscricao em %s" % (client_id, name), file=sys.stderr)
+            return
+        self.deliver(client, name, command.encode("utf-8"))
+
+    def handle(self, data, address):
+        if self.drop and random.random() < self.drop:
+            self.stats["dropped"] += 1
+            return
+        self.stats["received"] += 1
+        msg_type, body = parse(data)
+        client = self.by_address.get(address)
+        if msg_type is None:
+            return
+
+        if msg_type == CONNECT:
+            client_id = body[4:].decode("utf-8", "replace")
+            clean = bool(body[0] & 0x04)
+            client = self.clients.get(client_id)
+            if client is None or clean:
+                client = Client(client_id, address)
+                self.clients[client_id] = client
+            client.address = address
+            client.asleep = False
+            self.by_address[address] = client
+            self.sock.sendto(frame(CONNACK, bytes([RC_ACCEPTED])), address)
+            self.flush(client)
+            return
+
+        if msg_type == PINGREQ and body:  # Cliente dormindo acordou
+            client = self.clients.get(body.decode("utf-8", "replace"))
+            if client is None:
+                return
+            client.address = address
+            self.by_address[address] = client
+            self.flush(client)
+            self.sock.sendto(frame(PINGRESP), address)
+            return
+
+        if msg_type == PUBLISH and qos_of(body[0]) == -1:  # Sem conexão: só predefinidos
+            flags, topic_id = body[0], struct.unpack(">H", body[1:3])[0]
+            template = self.predefined.get(topic_id) if flags & 0x03 == TOPIC_PREDEFINED else None
+            if template and (client or "{client}" not in template):
+                self.print_message(template.replace("{client}", client.id if client else ""), body[5:])
+            return
+
+        if client is None:
+            return
+
+        if msg_type == REGISTER:
+            msg_id = struct.unpack(">H", body[2:4])[0]
+            name = body[4:].decode("utf-8", "replace")
+            topic_id = self.topic_id(name)
+            client.topics[topic_id] = name
+            self.send(client, frame(REGACK, struct.pack(">HHB", topic_id, msg_id, RC_ACCEPTED)))
+        elif msg_type == PUBLISH:
+            flags = body[0]
+            topic_id, msg_id = struct.unpack(">HH", body[1:5])
+            name = self.resolve(client, flags, topic_id)
+            if qos_of(flags) == 1:
+                rc = RC_ACCEPTED if name else RC_INVALID_TOPIC
+                self.send(client, frame(PUBACK, struct.pack(">HHB", topic_id, msg_id, rc)))
+                if name and msg_id in client.seen:
+                    self.stats["duplicates"] += 1
+                    return
+                client.seen.add(msg_id)
+            if name:
+                self.print_message(name, body[5:])
+        elif msg_type == SUBSCRIBE:
+            flags, msg_id = body[0], struct.unpack(">H", body[1:3])[0]
+            name = body[3:].decode("utf-8", "replace")
+            topic_id = self.topic_id(name)
+            client.subscriptions[name] = topic_id
+            client.topics[topic_id] = name
+            self.send(client, frame(SUBACK, struct.pack(">BHHB", flags & 0x60, topic_id, msg_id, RC_ACCEPTED)))
+            if name == "sensors/%s/command" % client.id:
+                for command in self.commands:
+                    self.deliver(client, name, command.encode("utf-8"))
+        elif msg_type == PUBACK:
+            pass
+        elif msg_type == PINGREQ:
+            self.send(client, frame(PINGRESP))
+        elif msg_type == DISCONNECT:
+            self.sock.sendto(frame(DISCONNECT), address)
+            if len(body) >= 2:
+                client.asleep = True
+            else:
+                del self.by_address[address]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--port", type=int, default=10000)
+    parser.add_argument("-p", "--predefined", action="append", default=[], metavar="ID=TOPICO")
+    parser.add_argument("--drop", type=float, default=0.0, help="fracao de datagramas descartados")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--command", action="append", default=[])
+    args = parser.parse_args()
+
+    random.seed(args.seed)
+    predefined = {}
+    for item in args.predefined:
+        topic_id, _, name = item.partition("=")
+        predefined[int(topic_id)] = name
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("0.0.0.0", args.port))
+    gateway = Gateway(sock, predefined, args.drop, args.command, sys.stdout)
+    print("Gateway MQTT-SN na porta %d" % args.port, file=sys.stderr)
+    sources = [sock, sys.stdin]
+    try:
+        while True:
+            for source in select.select(sources, [], [])[0]:
+                if source is sock:
+                    data, address = sock.recvfrom(65535)
+                    gateway.handle(data, address)
+                else:
+                    line = sys.stdin.readline()
+                    if line:
+                        gateway.inject(line)
+                    else:
+                        sources.remove(sys.stdin)  # Fim da entrada: segue só com o UDP
+    except KeyboardInterrupt:
+        pass
+    print("recebidos=%(received)d descartados=%(dropped)d duplicados=%(duplicates)d" % gateway.stats,
+          file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
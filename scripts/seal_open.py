@@ -0,0 +1,155 @@
+"""
+Abre os envelopes AES-128-GCM publicados pelo dispositivo quando ele tem chave de
+cifra (include/seal.h): sensors/<id>/batch e sensors/<id>/history.
+
+Pode ser importado pelo backend:
+
+    from seal_open import open_envelope, ReplayGuard
+    key_id, epoch, counter, block = open_envelope(key, topic, payload)
+    if guard.accept(device, epoch, counter):
+        ts_codec.decode_block(block)
+
+ou usado na linha de comando sobre a saída de "mosquitto_sub -v" (ou de
+scripts/uplink_sink.py e scripts/tls_broker.py), com o payload em hex:
+
+    mosquitto_sub -v -t 'sensors/+/batch' -F '%t %x' | python scripts/seal_open.py --key <32 hex>
+    python scripts/seal_open.py --keys chaves.txt --decode captura.txt
+
+Cada envelope aberto sai como "<tópico> <bloco em hex>" (ou, com --decode, uma linha
+"<tópico> epoch,seq,timestamp_ms,valor" por amostra); envelopes que não autenticam, de
+outro tópico, repetidos ou de um boot anterior ao último visto vão para a saída de erro.
+O arquivo de --keys tem uma linha "<dispositivo> <chave em hex> [id da chave]" por chave.
+
+Requer o pacote cryptography (pip install cryptography).
+"""
+import argparse
+import collections
+import struct
+import sys
+
+from cryptography.exceptions import InvalidTag
+from cryptography.hazmat.primitives.ciphers.aead import AESGCM
+
+MAGIC = b"AS"
+VERSION = 1
+HEADER = struct.Struct("<2sBBIQ")
+TAG_SIZE = 16
+REPLAY_WINDOW = 4096  # Contadores lembrados por dispositivo na época atual
+
+
+class SealError(ValueError):
+    pass
+
+
+def parse_header(envelope):
+    if len(envelope) < HEADER.size + TAG_SIZE:
+        raise SealError("envelope curto (%d bytes)" % len(envelope))
+    magic, version, key_id, epoch, counter = HEADER.unpack_from(envelope)
+    if magic != MAGIC or version != VERSION:
+        raise SealError("nao e um envelope v%d" % VERSION)
+    return key_id, epoch, counter
+
+
+def open_envelope(key, topic, envelope):
+    """Retorna (id da chave, epoch, contador, bloco aberto); SealError se não autentica."""
+    key_id, epoch, counter = parse_header(envelope)
+    header = envelope[:HEADER.size]
+    try:
+        block = AESGCM(key).decrypt(header[4:], envelope[HEADER.size:], header + topic.encode("utf-8"))
+    except InvalidTag:
+        raise SealError("autenticacao falhou (chave, topico ou conteudo)")
+    return key_id, epoch, counter, block
+
+
+class ReplayGuard:
+    """Aceita cada nonce (época, contador) uma vez por dispositivo, e só da época mais nova."""
+
+    def __init__(self, window=REPLAY_WINDOW):
+        self.window = window
+        self.epoch = {}
+        self.seen = collections.defaultdict(set)
+
+    def accept(self, device, epoch, counter):
+        current = self.epoch.get(device, 0)
+        if epoch < current:
+            return False
+        if epoch > current:
+            self.epoch[device] = epoch
+            self.seen[device] = set()
+        seen = self.seen[device]
+        if counter in seen or (seen and counter + self.window < max(seen)):
+            return False
+        seen.add(counter)
+        if len(seen) > self.window:
+            seen.discard(min(seen))
+        return True
+
+
+def device_of(topic):
+    parts = topic.split("/")
+    return parts[1] if len(parts) >= 3 and parts[0] == "sensors" else ""
+
+
+def load_keys(path):
+    keys = collections.defaultdict(dict)  # dispositivo -> {id da chave: chave}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) >= 2 and not fields[0].startswith("#"):
+                keys[fields[0]][int(fields[2]) if len(fields) > 2 else None] = bytes.fromhex(fields[1])
+    return keys
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("capture", nargs="?", help="arquivo com linhas '<topico> <hex>' (padrao: entrada padrao)")
+    parser.add_argument("--key", help="chave de 16 bytes em hex, para qualquer dispositivo")
+    parser.add_argument("--keys", help="arquivo '<dispositivo> <chave hex> [id]'")
+    parser.add_argument("--decode", action="store_true", help="decodifica o bloco (scripts/ts_codec.py)")
+    args = parser.parse_args()
+    if not args.key and not args.keys:
+        parser.error("informe --key ou --keys")
+
+    keys = load_keys(args.keys) if args.keys else {}
+    default_key = bytes.fromhex(args.key) if args.key else None
+    if args.decode:
+        from ts_codec import BlockError, decode_block
+    guard = ReplayGuard()
+    stats = collections.Counter()
+    source = open(args.capture) if args.capture else sys.stdin
+    for line in source:
+        topic, _, payload = line.strip().partition(" ")
+        if not payload:
+            continue
+        device = device_of(topic)
+        try:
+            envelope = bytes.fromhex(payload)
+            key_id = parse_header(envelope)[0]
+            device_keys = keys.get(device, {})
+            key = device_keys.get(key_id, device_keys.get(None, default_key))
+            if key is None:
+                raise SealError("sem chave para %s (id %d)" % (device, key_id))
+            key_id, epoch, counter, block = open_envelope(key, topic, envelope)
+        except (SealError, ValueError) as e:
+            stats["rejected"] += 1
+            print("%s: %s" % (topic, e), file=sys.stderr)
+            continue
+        if not guard.accept(device, epoch, counter):
+            stats["replayed"] += 1
+            print("%s: repetido ou antigo (epoch %d, contador %d)" % (topic, epoch, counter), file=sys.stderr)
+            continue
+        stats["opened"] += 1
+        if not args.decode:
+            print("%s %s" % (topic, block.hex()), flush=True)
+            continue
+        try:
+            for sample in decode_block(block):
+                print("%s %d,%d,%d,%g" % ((topic,) + tuple(sample)), flush=True)
+        except BlockError as e:
+            print("%s: bloco invalido: %s" % (topic, e), file=sys.stderr)
+    print("abertos=%(opened)d rejeitados=%(rejected)d repetidos=%(replayed)d" % stats, file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
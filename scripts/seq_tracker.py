@@ -0,0 +1,154 @@
+"""
+Detector de buracos e duplicatas para as mensagens numeradas do dispositivo.
+
+Toda mensagem leva (epoch, seq): a época de boot e um contador que recomeça em 0 a cada
+boot, independente por fluxo (leituras, alarmes, resumos, métricas). O backend pode
+então aceitar reenvios e reposições de histórico sem comparar timestamps:
+
+    from seq_tracker import SequenceTracker
+    tracker = SequenceTracker()
+    status = tracker.observe(("A1B2C3D4E5F6", "reading"), msg["epoch"], msg["seq"])
+    if status == DUPLICATE:
+        descartar
+    tracker.gaps(("A1B2C3D4E5F6", "reading"))  # {epoch: [(primeiro, ultimo), ...]} faltando
+
+Blocos comprimidos (sensors/<id>/batch e /history) entram por observe_block(), que
+numera cada amostra a partir do cabeçalho do bloco.
+
+O custo por mensagem é O(1) no caso normal (em ordem) e O(log b) com b buracos abertos.
+Leituras perdidas no fim de uma época (antes de um reboot) não aparecem como buraco:
+o dispositivo não informa o último número de cada boot.
+
+Na linha de comando, lê a saída de "mosquitto_sub -v -t 'sensors/#'" (tópico e payload
+JSON por linha) e imprime o relatório por fluxo:
+
+    mosquitto_sub -h broker -v -t 'sensors/#' | python scripts/seq_tracker.py
+    python scripts/seq_tracker.py captura.txt
+"""
+import argparse
+import bisect
+import json
+import sys
+
+NEW = "new"              # Próxima da sequência (ou adiante, abrindo um buraco)
+LATE = "late"            # Preencheu um buraco (reenvio ou histórico)
+DUPLICATE = "duplicate"  # Já recebida
+
+
+class _EpochState:
+    __slots__ = ("next_seq", "gap_starts", "gap_ends")
+
+    def __init__(self):
+        self.next_seq = 0      # Primeiro número ainda não visto no fim da sequência
+        self.gap_starts = []   # Buracos abertos, ordenados: [início, fim] inclusivos
+        self.gap_ends = []
+
+    def observe(self, seq):
+        if seq >= self.next_seq:
+            if seq > self.next_seq:
+                self.gap_starts.append(self.next_seq)
+                self.gap_ends.append(seq - 1)
+            self.next_seq = seq + 1
+            return NEW
+
+        i = bisect.bisect_right(self.gap_starts, seq) - 1
+        if i < 0 or seq > self.gap_ends[i]:
+            return DUPLICATE
+        start, end = self.gap_starts[i], self.gap_ends[i]
+        if start == end:
+            del self.gap_starts[i]
+            del self.gap_ends[i]
+        elif seq == start:
+            self.gap_starts[i] = seq + 1
+        elif seq == end:
+            self.gap_ends[i] = seq - 1
+        else:
+            self.gap_ends[i] = seq - 1
+            self.gap_starts.insert(i + 1, seq + 1)
+            self.gap_ends.insert(i + 1, end)
+        return LATE
+
+    def gaps(self):
+        return list(zip(self.gap_starts, self.gap_ends))
+
+
+class SequenceTracker:
+    """Estado por fluxo (chave livre, ex.: (id, "reading")) e por época de boot."""
+
+    def __init__(self, max_epochs=16):
+        self.max_epochs = max_epochs  # Épocas antigas guardadas por fluxo
+        self._streams = {}
+        self.counts = {NEW: 0, LATE: 0, DUPLICATE: 0}
+
+    def observe(self, key, epoch, seq):
+        epochs = self._streams.setdefault(key, {})
+        state = epochs.get(epoch)
+        if state is None:
+            if len(epochs) >= self.max_epochs and epoch < min(epochs):
+                # Época mais antiga que tudo que ainda guardamos: não há como saber
+                self.counts[DUPLICATE] += 1
+                return DUPLICATE
+            state = epochs[epoch] = _EpochState()
+            while len(epochs) > self.max_epochs:
+                del epochs[min(epochs)]
+        status = state.observe(seq)
+        self.counts[status] += 1
+        return status
+
+    def observe_block(self, key, block):
+        """Decodifica um bloco comprimido e registra cada amostra; retorna [(Sample, status)]."""
+        from ts_codec import Sample, decode_block_raw
+
+        # Com stride > 1 (histórico reduzido) cada amostra é a média de "stride" leituras e
+        # cobre todos esses números; a última do bloco pode cobrir menos do que isso.
+        b = decode_block_raw(block)
+        result = []
+        for i, (timestamp, value) in enumerate(b.samples):
+            seq = b.first_seq + i * b.stride
+            statuses = {self.observe(key, b.epoch, s) for s in range(seq, seq + b.stride)}
+            status = NEW if NEW in statuses else (LATE if LATE in statuses else DUPLICATE)
+            result.append((Sample(b.epoch, seq, timestamp, value / 10 ** b.scale), status))
+        return result
+
+    def gaps(self, key):
+        return {epoch: state.gaps()
+                for epoch, state in sorted(self._streams.get(key, {}).items()) if state.gap_starts}
+
+    def keys(self):
+        return list(self._streams)
+
+
+def _stream_of(topic):
+    # sensors/humidity -> reading; sensors/<id>/<fluxo> -> fluxo
+    parts = topic.split("/")
+    return "reading" if parts[-1] == "humidity" else parts[-1]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("capture", nargs="?", help="saida do mosquitto_sub -v (padrao: stdin)")
+    args = parser.parse_args()
+
+    tracker = SequenceTracker()
+    source = open(args.capture, encoding="utf-8", errors="replace") if args.capture else sys.stdin
+    with source:
+        for line in source:
+            topic, _, payload = line.strip().partition(" ")
+            try:
+                msg = json.loads(payload)
+                key = (msg["id"], _stream_of(topic))
+                tracker.observe(key, msg["epoch"], msg["seq"])
+            except (ValueError, KeyError, TypeError):
+                continue
+
+    for key in sorted(tracker.keys()):
+        gaps = tracker.gaps(key)
+        missing = sum(end - start + 1 for ranges in gaps.values() for start, end in ranges)
+        print("%s/%s: %d faltando %s" % (key[0], key[1], missing, json.dumps(gaps) if gaps else ""))
+    print("novas=%d atrasadas=%d duplicadas=%d"
+          % (tracker.counts[NEW], tracker.counts[LATE], tracker.counts[DUPLICATE]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
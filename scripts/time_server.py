@@ -0,0 +1,155 @@
+"""
+Servidor de horário da frota (include/time_sync.h): responde, pelo broker MQTT, aos pedidos
+de horário dos dispositivos, e o relógio desta máquina vira a referência comum da frota.
+Rode-o numa máquina com NTP (ou PTP) em ordem; o alinhamento entre dispositivos não
+depende do erro absoluto dela, só de todos usarem o mesmo servidor.
+
+    python scripts/time_server.py                       # broker em localhost:1883
+    python scripts/time_server.py --broker 192.168.0.10 --report
+
+Cada pedido "<t1>" em sensors/<id>/time é respondido em sensors/<id>/command com
+"TIME <t1> <t2> <t3>", t2 e t3 em µs Unix: chegada do pedido e saída da resposta aqui,
+tomados o mais perto possível do socket. A resposta vai com QoS 0: um reenvio só mediria a
+fila do broker, que o dispositivo já descarta no filtro por RTT.
+
+--report também acompanha sensors/+/metrics e imprime, a cada métrica com o bloco "time",
+o erro estimado, o limite pela assimetria e a deriva de cada dispositivo.
+
+Cliente MQTT 3.1.1 mínimo, sem dependências.
+"""
+import argparse
+import json
+import select
+import socket
+import sys
+import time
+
+KEEPALIVE_S = 60
+
+
+def encode_length(length):
+    out = bytearray()
+    while True:
+        byte = length & 0x7F
+        length >>= 7
+        out.append(byte | (0x80 if length else 0))
+        if not length:
+            return bytes(out)
+
+
+def encode_string(text):
+    data = text.encode("utf-8")
+    return len(data).to_bytes(2, "big") + data
+
+
+def packet(header, body):
+    return bytes([header]) + encode_length(len(body)) + body
+
+
+def parse_packets(buffer):
+    """Separa os pacotes completos do buffer; retorna ([(cabeçalho, corpo)], resto)."""
+    packets = []
+    while len(buffer) >= 2:
+        length = 0
+        shift = 0
+        pos = 1
+        while True:
+            if pos >= len(buffer):
+                return packets, buffer
+            byte = buffer[pos]
+            pos += 1
+            length |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                break
+        if len(buffer) < pos + length:
+            break
+        packets.append((buffer[0], buffer[pos:pos + length]))
+        buffer = buffer[pos + length:]
+    return packets, buffer
+
+
+def now_us():
+    return time.time_ns() // 1000
+
+
+def device_of(topic):
+    parts = topic.split("/")
+    return parts[1] if len(parts) == 3 and parts[0] == "sensors" else None
+
+
+def report(device, metrics, out):
+    sync = metrics.get("time")
+    if not sync:
+        return
+    print("%s synced=%s err=%d us bound=%d us skew=%.2f ppm rtt_min=%d us fit=%d/%d" % (
+        device, sync.get("synced"), sync.get("err_us", 0), sync.get("bound_us", 0), sync.get("skew_ppm", 0),
+        sync.get("rtt_min_us", 0), sync.get("fit", 0), sync.get("fit", 0) + sync.get("filtered", 0)),
+        file=out, flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--broker", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--client-id", default="agroflow-time-server")
+    parser.add_argument("--report", action="store_true", help="imprime o bloco 'time' das métricas de cada dispositivo")
+    args = parser.parse_args()
+
+    conn = socket.create_connection((args.broker, args.port))
+    conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    connect = encode_string("MQTT") + bytes([4, 0x02]) + KEEPALIVE_S.to_bytes(2, "big") + encode_string(args.client_id)
+    conn.sendall(packet(0x10, connect))
+    topics = ["sensors/+/time"] + (["sensors/+/metrics"] if args.report else [])
+    subscribe = (1).to_bytes(2, "big") + b"".join(encode_string(t) + b"\x00" for t in topics)
+    conn.sendall(packet(0x82, subscribe))
+    print("Servidor de horario em %s:%d" % (args.broker, args.port), file=sys.stderr, flush=True)
+
+    buffer = b""
+    served = 0
+    last_sent = time.monotonic()
+    try:
+        while True:
+            ready, _, _ = select.select([conn], [], [], KEEPALIVE_S / 2)
+            if ready:
+                chunk = conn.recv(65536)
+                received = now_us()  # t2 de todos os pedidos que chegaram neste recv
+                if not chunk:
+                    print("Broker fechou a conexao", file=sys.stderr)
+                    return 1
+                packets, buffer = parse_packets(buffer + chunk)
+                for header, body in packets:
+                    if header >> 4 != 3:  # Só PUBLISH interessa (CONNACK/SUBACK/PINGRESP)
+                        continue
+                    topic_length = body[0] << 8 | body[1]
+                    topic = body[2:2 + topic_length].decode("utf-8", "replace")
+                    pos = 2 + topic_length + (2 if (header >> 1) & 3 else 0)
+                    payload = body[pos:]
+                    device = device_of(topic)
+                    if device is None:
+                        continue
+                    if topic.endswith("/time"):
+                        try:
+                            t1 = int(payload.decode("ascii").strip())
+                        except ValueError:
+                            continue
+                        reply = "TIME %d %d %d" % (t1, received, now_us())
+                        conn.sendall(packet(0x30, encode_string("sensors/%s/command" % device) + reply.encode()))
+                        last_sent = time.monotonic()
+                        served += 1
+                    elif args.report:
+                        try:
+                            report(device, json.loads(payload), sys.stdout)
+                        except ValueError:
+                            pass
+            if time.monotonic() - last_sent > KEEPALIVE_S / 2:
+                conn.sendall(b"\xc0\x00")  # PINGREQ
+                last_sent = time.monotonic()
+    except KeyboardInterrupt:
+        pass
+    print("respostas: %d" % served, file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,232 @@
+"""
+Broker MQTT mínimo sobre TLS 1.2, para medir os handshakes do TlsClient
+(include/tls_client.h) no local, sem depender de um broker público.
+
+    python scripts/tls_broker.py                  # porta 8883, certificado ECDSA P-256
+    python scripts/tls_broker.py --rsa            # certificado RSA 2048, para comparar
+    python scripts/tls_broker.py --no-tickets     # retomada só por id de sessão
+    python scripts/tls_broker.py --drop-every 30  # derruba cada conexão após 30 s
+
+No dispositivo (env esp32dev_tls), aponte a lista de brokers para esta máquina com o
+comando "BROKERS <ip>:8883". O certificado, autoassinado, é gerado com o openssl na
+primeira execução (ou passado com --cert/--key); o firmware sem MQTT_TLS_CA não o verifica.
+
+Responde CONNECT, SUBSCRIBE, PUBLISH (QoS 0/1), PINGREQ e DISCONNECT, em MQTT 3.1.1 ou 5,
+e imprime cada mensagem como "<tópico> <payload>" (o formato de scripts/uplink_sink.py).
+Cada handshake vai para a saída de erro com a duração vista pelo servidor (do accept ao
+Finished) e se a sessão foi retomada; ao sair (Ctrl+C), o resumo compara completos e
+retomados. O tempo e a energia do lado do dispositivo saem nas métricas, em "tls".
+"""
+import argparse
+import os
+import socket
+import ssl
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+
+def make_certificate(directory, rsa):
+    cert = os.path.join(directory, "broker-rsa.crt" if rsa else "broker-ecdsa.crt")
+    key = os.path.join(directory, "broker-rsa.key" if rsa else "broker-ecdsa.key")
+    if os.path.exists(cert) and os.path.exists(key):
+        return cert, key
+    algorithm = ["-newkey", "rsa:2048"] if rsa else ["-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:P-256"]
+    subprocess.run(["openssl", "req", "-x509", "-nodes", "-days", "365", "-subj", "/CN=agroflow-test-broker",
+                    "-keyout", key, "-out", cert] + algorithm,
+                   check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return cert, key
+
+
+def read_exact(conn, length):
+    data = b""
+    while len(data) < length:
+        chunk = conn.recv(length - len(data))
+        if not chunk:
+            raise EOFError
+        data += chunk
+    return data
+
+
+def read_packet(conn):
+    header = read_exact(conn, 1)[0]
+    length = 0
+    shift = 0
+    while True:
+        byte = read_exact(conn, 1)[0]
+        length |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            break
+    return header, read_exact(conn, length)
+
+
+def read_varint(body, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = body[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            return value, pos
+
+
+def topic_alias(body, pos):
+    """Topic Alias (0x23) nas propriedades do PUBLISH do MQTT 5; retorna (alias, fim)."""
+    length, pos = read_varint(body, pos)
+    end = pos + length
+    while pos < end:
+        prop = body[pos]
+        if prop == 0x23:
+            return body[pos + 1] << 8 | body[pos + 2], end
+        if prop == 0x01:  # Payload Format Indicator
+            pos += 2
+        elif prop == 0x02:  # Message Expiry Interval
+            pos += 5
+        else:
+            break  # O firmware não manda outras; o resto do bloco é ignorado
+    return None, end
+
+
+class Broker:
+    def __init__(self, context, drop_every, out):
+        self.context = context
+        self.drop_every = drop_every
+        self.out = out
+        self.lock = threading.Lock()
+        self.handshakes = {"full": [], "resumed": []}
+        self.messages = 0
+
+    def record(self, address, elapsed_ms, resumed, cipher):
+        with self.lock:
+            self.handshakes["resumed" if resumed else "full"].append(elapsed_ms)
+        print("handshake %s %.1f ms %s %s" % (address, elapsed_ms, "retomado" if resumed else "completo", cipher),
+              file=sys.stderr, flush=True)
+
+    def serve(self, raw, address):
+        started = time.perf_counter()
+        try:
+            conn = self.context.wrap_socket(raw, server_side=True)  # Handshake aqui
+        except (ssl.SSLError, OSError) as error:
+            print("handshake %s falhou: %s" % (address, error), file=sys.stderr, flush=True)
+            raw.close()
+            return
+        self.record(address, (time.perf_counter() - started) * 1000, conn.session_reused, conn.cipher()[0])
+        version = 4
+        aliases = {}
+        deadline = time.monotonic() + self.drop_every
+        try:
+            while True:
+                if self.drop_every:
+                    conn.settimeout(max(deadline - time.monotonic(), 0.001))
+                header, body = read_packet(conn)
+                kind = header >> 4
+                if kind == 1:  # CONNECT
+                    version = body[6]
+                    conn.sendall(b"\x20\x03\x00\x00\x00" if version == 5 else b"\x20\x02\x00\x00")
+                elif kind == 8:  # SUBSCRIBE: concede QoS 1
+                    granted = b"\x00\x01" if version == 5 else b"\x01"
+                    conn.sendall(bytes([0x90, 2 + len(granted)]) + body[:2] + granted)
+                elif kind == 3:  # PUBLISH
+                    qos = (header >> 1) & 3
+                    topic_length = body[0] << 8 | body[1]
+                    topic = body[2:2 + topic_length].decode("utf-8", "replace")
+                    pos = 2 + topic_length
+                    packet_id = body[pos:pos + 2] if qos else b""
+                    pos += len(packet_id)
+                    if version == 5:
+                        alias, pos = topic_alias(body, pos)
+                        if alias is not None and topic:
+                            aliases[alias] = topic
+                        elif alias is not None:
+                            topic = aliases.get(alias, "?")
+                    payload = body[pos:]
+                    with self.lock:
+                        self.messages += 1
+                    try:
+                        text = payload.decode("utf-8")
+                    except ValueError:
+                        text = payload.hex()
+                    print("%s %s" % (topic, text), file=self.out, flush=True)
+                    if qos == 1:
+                        conn.sendall(b"\x40\x02" + packet_id)
+                elif kind == 12:  # PINGREQ
+                    conn.sendall(b"\xd0\x00")
+                elif kind == 14:  # DISCONNECT
+                    break
+        except socket.timeout:
+            print("conexao %s derrubada (--drop-every)" % address, file=sys.stderr, flush=True)
+        except (EOFError, OSError, IndexError):
+            pass
+        # close_notify: o OpenSSL descarta do cache a sessão de uma conexão fechada sem ele,
+        # e aí o id de sessão (--no-tickets) não seria retomado
+        try:
+            conn.settimeout(0.5)
+            conn.unwrap()
+        except (OSError, ValueError):
+            pass
+        conn.close()
+
+    def summary(self):
+        lines = []
+        for kind in ("full", "resumed"):
+            times = self.handshakes[kind]
+            if times:
+                lines.append("%s: %d handshakes, media %.1f ms, mediana %.1f ms, max %.1f ms" % (
+                    "completos" if kind == "full" else "retomados", len(times), statistics.mean(times),
+                    statistics.median(times), max(times)))
+            else:
+                lines.append("%s: nenhum" % ("completos" if kind == "full" else "retomados"))
+        lines.append("mensagens: %d" % self.messages)
+        return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--port", type=int, default=8883)
+    parser.add_argument("--cert", help="certificado PEM (padrão: autoassinado gerado com o openssl)")
+    parser.add_argument("--key")
+    parser.add_argument("--rsa", action="store_true", help="gera certificado RSA 2048 em vez de ECDSA P-256")
+    parser.add_argument("--no-tickets", action="store_true", help="sem tickets: retomada só por id de sessão")
+    parser.add_argument("--drop-every", type=float, default=0, help="derruba cada conexão após N s")
+    args = parser.parse_args()
+
+    if args.cert:
+        cert, key = args.cert, args.key or args.cert
+    else:
+        cert, key = make_certificate(tempfile.gettempdir(), args.rsa)
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.minimum_version = ssl.TLSVersion.TLSv1_2
+    context.maximum_version = ssl.TLSVersion.TLSv1_2  # O mbedtls 2.x do ESP32 só fala TLS 1.2
+    context.set_ciphers("ECDHE+AESGCM:ECDHE+CHACHA20:ECDHE+AES")
+    context.load_cert_chain(cert, key)
+    if args.no_tickets:
+        context.options |= ssl.OP_NO_TICKET
+
+    listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    listener.bind(("0.0.0.0", args.port))
+    listener.listen(8)
+    broker = Broker(context, args.drop_every, sys.stdout)
+    print("Broker TLS na porta %d (%s, %s)" % (args.port, "RSA" if args.rsa else "ECDSA P-256",
+                                               "id de sessao" if args.no_tickets else "tickets"),
+          file=sys.stderr, flush=True)
+
+    try:
+        while True:
+            raw, address = listener.accept()
+            raw.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            threading.Thread(target=broker.serve, args=(raw, address[0]), daemon=True).start()
+    except KeyboardInterrupt:
+        pass
+    print(broker.summary(), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,122 @@
+"""
+Decodificador dos blocos comprimidos publicados em sensors/<id>/batch.
+
+Referência do formato: include/ts_codec.h (delta-of-delta nos timestamps, zigzag com
+largura variável nos valores). Pode ser importado pelo backend:
+
+    from ts_codec import decode_block
+    for sample in decode_block(payload):
+        sample.epoch, sample.seq, sample.timestamp_ms, sample.value
+
+ou usado na linha de comando com um bloco salvo em arquivo (ou em hex):
+
+    python scripts/ts_codec.py bloco.bin
+    python scripts/ts_codec.py --hex 4146010203...
+"""
+import argparse
+import collections
+import struct
+import sys
+
+MAGIC = b"AF"
+# v1: sem sequência (18 bytes); v2: + epoch, seq e stride (28 bytes)
+HEADERS = {
+    1: struct.Struct("<2sBBHQi"),
+    2: struct.Struct("<2sBBHQiIIH"),
+}
+DOD_BITS = (0, 7, 9, 12, 32)
+
+Block = collections.namedtuple("Block", "scale epoch first_seq stride samples")
+Sample = collections.namedtuple("Sample", "epoch seq timestamp_ms value")
+
+
+class BlockError(ValueError):
+    pass
+
+
+class _BitReader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def read(self, bits):
+        if self.pos + bits > len(self.data) * 8:
+            raise BlockError("bloco truncado")
+        value = 0
+        for _ in range(bits):
+            byte = self.data[self.pos >> 3]
+            value = (value << 1) | ((byte >> (7 - (self.pos & 7))) & 1)
+            self.pos += 1
+        return value
+
+
+def _sign_extend(value, bits):
+    sign = 1 << (bits - 1)
+    return (value ^ sign) - sign
+
+
+def decode_block_raw(block):
+    """Retorna um Block com samples = [(timestamp_ms, valor_inteiro), ...]."""
+    if len(block) < 3 or block[:2] != MAGIC or block[2] not in HEADERS:
+        raise BlockError("cabecalho invalido")
+    header = HEADERS[block[2]]
+    if len(block) < header.size:
+        raise BlockError("bloco menor que o cabecalho")
+    fields = header.unpack_from(block)
+    scale, count, timestamp, value = fields[2:6]
+    epoch, first_seq, stride = fields[6:9] if len(fields) > 6 else (0, 0, 1)
+    if count == 0:
+        return Block(scale, epoch, first_seq, stride, [])
+
+    samples = [(timestamp, value)]
+    reader = _BitReader(block[header.size:])
+    delta = 0
+    for _ in range(count - 1):
+        ones = 0
+        while ones < 4 and reader.read(1):
+            ones += 1
+        if ones:
+            delta += _sign_extend(reader.read(DOD_BITS[ones]), DOD_BITS[ones])
+        timestamp += delta
+
+        if reader.read(1):
+            width = reader.read(5) + 1
+            z = reader.read(width)
+            value += (z >> 1) ^ -(z & 1)
+        samples.append((timestamp, value))
+    return Block(scale, epoch, first_seq, stride, samples)
+
+
+def decode_block(block):
+    """Retorna [Sample, ...] com o valor já convertido pela escala do bloco."""
+    b = decode_block_raw(block)
+    divisor = 10 ** b.scale
+    return [Sample(b.epoch, b.first_seq + i * b.stride, t, v / divisor)
+            for i, (t, v) in enumerate(b.samples)]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("block", help="arquivo com o bloco binario (ou o bloco em hex com --hex)")
+    parser.add_argument("--hex", action="store_true")
+    args = parser.parse_args()
+
+    if args.hex:
+        block = bytes.fromhex(args.block)
+    else:
+        with open(args.block, "rb") as f:
+            block = f.read()
+    try:
+        samples = decode_block(block)
+    except BlockError as e:
+        print("erro: %s" % e, file=sys.stderr)
+        return 1
+    for sample in samples:
+        print("%d,%d,%d,%g" % sample)
+    print("%d amostras, %d bytes (%.2f bits/amostra)"
+          % (len(samples), len(block), len(block) * 8.0 / max(len(samples), 1)), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,210 @@
+"""
+Coletor mínimo para os transportes HTTP em lote (include/http_transport.h) e UDP
+(include/udp_transport.h), para testes locais e para comparar transportes no mesmo local.
+
+Cada mensagem recebida é impressa como uma linha "<tópico> <payload>", no mesmo formato
+de "mosquitto_sub -v" e de scripts/mqttsn_gateway.py, então a saída pode ir direto para
+scripts/seq_tracker.py. Payloads binários (blocos de sensors/<id>/batch) saem em hex.
+
+    python scripts/uplink_sink.py                       # HTTP na 8080, UDP na 9999
+    python scripts/uplink_sink.py --status 503 --command "RATE 1000 60000"
+
+HTTP: POST com um registro por mensagem ("<tópico> <bytes>\\n<payload>\\n"), respondido com
+--status (503 exercita o reenvio do lote) e, no corpo, os comandos pendentes para o
+dispositivo do cabeçalho X-Device-Id, um por linha. UDP: um datagrama por mensagem
+("<tópico>\\n<payload>"); comandos vão em datagramas para o endereço de origem do
+dispositivo (o id é lido do tópico sensors/<id>/...).
+
+--command enfileira um comando para todo dispositivo que aparecer; linhas
+"<dispositivo> <comando>" na entrada padrão fazem o mesmo a qualquer momento.
+"""
+import argparse
+import select
+import socket
+import sys
+import time
+
+MAX_BODY = 1 << 20
+
+
+def print_message(topic, payload, out):
+    try:
+        text = payload.decode("utf-8")
+        if not text.isprintable():
+            raise ValueError
+    except ValueError:
+        text = payload.hex()
+    print("%s %s" % (topic, text), file=out, flush=True)
+
+
+def parse_batch(body):
+    """Registros "<tópico> <bytes>\\n<payload>\\n"; None se o corpo estiver malformado."""
+    records = []
+    pos = 0
+    while pos < len(body):
+        end = body.find(b"\n", pos)
+        if end < 0:
+            return None
+        topic, _, length = body[pos:end].decode("utf-8", "replace").rpartition(" ")
+        if not topic or not length.isdigit():
+            return None
+        start = end + 1
+        stop = start + int(length)
+        if body[stop:stop + 1] != b"\n":
+            return None
+        records.append((topic, body[start:stop]))
+        pos = stop + 1
+    return records
+
+
+def device_of(topic):
+    parts = topic.split("/")
+    return parts[1] if len(parts) >= 3 and parts[0] == "sensors" else None
+
+
+class HttpConnection:
+    def __init__(self, sock):
+        self.sock = sock
+        self.buffer = b""
+
+
+class Sink:
+    def __init__(self, udp, status, commands, out):
+        self.udp = udp
+        self.status = status
+        self.commands = commands
+        self.out = out
+        self.pending = {}        # dispositivo -> comandos ainda não entregues
+        self.udp_address = {}    # dispositivo -> (host, porta) do último datagrama
+        self.known = set()
+        self.stats = {"requests": 0, "records": 0, "bytes": 0, "datagrams": 0, "rejected": 0}
+
+    def seen(self, device):
+        if device and device not in self.known:
+            self.known.add(device)
+            self.pending.setdefault(device, []).extend(self.commands)
+
+    def inject(self, line):
+        device, _, command = line.strip().partition(" ")
+        if device and command:
+            self.pending.setdefault(device, []).append(command)
+            self.deliver_udp(device)
+
+    def deliver_udp(self, device):
+        address = self.udp_address.get(device)
+        if address is None:
+            return
+        for command in self.pending.pop(device, []):
+            self.udp.sendto(command.encode("utf-8"), address)
+
+    def handle_datagram(self, data, address):
+        self.stats["datagrams"] += 1
+        self.stats["bytes"] += len(data)
+        topic, sep, payload = data.partition(b"\n")
+        if not sep:
+            self.stats["rejected"] += 1
+            return
+        topic = topic.decode("utf-8", "replace")
+        print_message(topic, payload, self.out)
+        device = device_of(topic)
+        if device:
+            self.udp_address[device] = address
+            self.seen(device)
+            self.deliver_udp(device)
+
+    # Retorna a resposta para a primeira requisição completa do buffer, ou None
+    def handle_http(self, conn):
+        head_end = conn.buffer.find(b"\r\n\r\n")
+        if head_end < 0:
+            return None
+        lines = conn.buffer[:head_end].decode("latin-1").split("\r\n")
+        headers = {}
+        for line in lines[1:]:
+            name, _, value = line.partition(":")
+            headers[name.strip().lower()] = value.strip()
+        length = int(headers.get("content-length", "0"))
+        if length > MAX_BODY:
+            conn.buffer = b""
+            return b"HTTP/1.1 413 Payload Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"
+        if len(conn.buffer) < head_end + 4 + length:
+            return None
+        body = conn.buffer[head_end + 4:head_end + 4 + length]
+        conn.buffer = conn.buffer[head_end + 4 + length:]
+        self.stats["requests"] += 1
+        self.stats["bytes"] += length
+        device = headers.get("x-device-id")
+        self.seen(device)
+
+        records = parse_batch(body) if lines[0].startswith("POST ") else None
+        if records is None:
+            self.stats["rejected"] += 1
+            return b"HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n"
+        if self.status >= 300:
+            return ("HTTP/1.1 %d Error\r\nContent-Length: 0\r\n\r\n" % self.status).encode("latin-1")
+        for topic, payload in records:
+            print_message(topic, payload, self.out)
+        self.stats["records"] += len(records)
+        reply = "".join(command + "\n" for command in self.pending.pop(device, [])).encode("utf-8")
+        return b"HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s" % (len(reply), reply)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--http-port", type=int, default=8080)
+    parser.add_argument("--udp-port", type=int, default=9999)
+    parser.add_argument("--status", type=int, default=200, help="status das respostas HTTP com lote valido")
+    parser.add_argument("--command", action="append", default=[])
+    args = parser.parse_args()
+
+    listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    listener.bind(("0.0.0.0", args.http_port))
+    listener.listen(8)
+    udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    udp.bind(("0.0.0.0", args.udp_port))
+    sink = Sink(udp, args.status, args.command, sys.stdout)
+    print("Coletor: HTTP na porta %d, UDP na porta %d" % (args.http_port, args.udp_port), file=sys.stderr)
+
+    connections = {}
+    stdin_open = True
+    started = time.time()
+    try:
+        while True:
+            sources = [listener, udp] + list(connections) + ([sys.stdin] if stdin_open else [])
+            for source in select.select(sources, [], [])[0]:
+                if source is listener:
+                    sock, _ = listener.accept()
+                    connections[sock] = HttpConnection(sock)
+                elif source is udp:
+                    data, address = udp.recvfrom(65535)
+                    sink.handle_datagram(data, address)
+                elif source is sys.stdin:
+                    line = sys.stdin.readline()
+                    if line:
+                        sink.inject(line)
+                    else:
+                        stdin_open = False  # Fim da entrada: segue só com a rede
+                else:
+                    conn = connections[source]
+                    data = source.recv(65536)
+                    if not data:
+                        del connections[source]
+                        source.close()
+                        continue
+                    conn.buffer += data
+                    while True:
+                        response = sink.handle_http(conn)
+                        if response is None:
+                            break
+                        source.sendall(response)
+    except KeyboardInterrupt:
+        pass
+    elapsed = max(time.time() - started, 1e-9)
+    sink.stats["records_per_s"] = (sink.stats["records"] + sink.stats["datagrams"]) / elapsed
+    print("requisicoes=%(requests)d registros=%(records)d datagramas=%(datagrams)d bytes=%(bytes)d "
+          "rejeitados=%(rejected)d mensagens/s=%(records_per_s).1f" % sink.stats, file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,221 @@
+#pragma once
+
+// Arduino-ESP32 simulado para o replay no host (sim/replay_main.cpp): só o que o firmware
+// (src/main.cpp e os headers que ele inclui) usa, com o tempo no relógio virtual de sim.h.
+// delay() avança o relógio em vez de dormir, analogRead() lê o traço carregado e a Serial
+// vai para um arquivo ou para lugar nenhum.
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include "sim.h"
+
+#define HEX 16
+#define DEC 10
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+using std::max;
+using std::min;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ====== STRING ======
+class String {
+ public:
+  String(const char* text = "") : _s(text ? text : "") {}
+  String(const std::string& text) : _s(text) {}
+  String(char c) : _s(1, c) {}
+  String(unsigned char value, int base = DEC) : _s(format((unsigned long long)value, base)) {}
+  String(int value, int base = DEC) : _s(formatSigned(value, base)) {}
+  String(unsigned value, int base = DEC) : _s(format(value, base)) {}
+  String(long value, int base = DEC) : _s(formatSigned(value, base)) {}
+  String(unsigned long value, int base = DEC) : _s(format(value, base)) {}
+  String(double value, unsigned decimals = 2) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+    _s = buf;
+  }
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned length() const { return (unsigned)_s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  char operator[](unsigned i) const { return i < _s.size() ? _s[i] : 0; }
+  void toUpperCase() {
+    for (char& c : _s) c = (char)toupper((unsigned char)c);
+  }
+  int indexOf(char c, unsigned from = 0) const {
+    size_t p = _s.find(c, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  String substring(unsigned from, unsigned to = ~0u) const {
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, to == ~0u ? std::string::npos : to - from));
+  }
+  long toInt() const { return atol(_s.c_str()); }
+
+  String& operator+=(const String& other) { _s += other._s; return *this; }
+  String& operator+=(const char* other) { _s += other; return *this; }
+  String& operator+=(char c) { _s += c; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+  friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+  bool operator==(const String& other) const { return _s == other._s; }
+  bool operator==(const char* other) const { return _s == other; }
+  bool operator!=(const String& other) const { return _s != other._s; }
+  bool operator!=(const char* other) const { return _s != other; }
+
+ private:
+  static std::string format(unsigned long long value, int base) {
+    char buf[72];
+    char* p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    do {
+      int digit = (int)(value % base);
+      *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+      value /= base;
+    } while (value != 0);
+    return p;
+  }
+  static std::string formatSigned(long long value, int base) {
+    if (value < 0 && base == DEC) return "-" + format((unsigned long long)-value, base);
+    return format((unsigned long long)value, base);
+  }
+
+  std::string _s;
+};
+
+// O ArduinoJson (com ARDUINOJSON_ENABLE_ARDUINO_STRING) reconhece os dois tipos
+class StringSumHelper : public String {
+ public:
+  using String::String;
+};
+
+// ====== IPAddress ======
+class IPAddress {
+ public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+  uint8_t operator[](int i) const { return _bytes[i]; }
+  uint8_t& operator[](int i) { return _bytes[i]; }
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+    return String(buf);
+  }
+
+ private:
+  uint8_t _bytes[4] = {};
+};
+
+// ====== SERIAL ======
+// Sem destino (simSetSerialOutput()), nada é formatado: o replay não paga pelos prints
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(const uint8_t* data, size_t length) = 0;
+  virtual bool discarding() const { return false; }
+
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const char* text) { return discarding() ? 0 : write((const uint8_t*)text, strlen(text)); }
+
+  size_t print(const char* text) { return write(text); }
+  size_t print(const String& text) { return write(text.c_str()); }
+  size_t print(char c) { return discarding() ? 0 : write((uint8_t)c); }
+  size_t print(const IPAddress& ip) { return discarding() ? 0 : print(ip.toString()); }
+  size_t print(double value, int digits = 2) {
+    if (discarding()) return 0;
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, value);
+    return write(buf);
+  }
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value, size_t>::type print(T value, int base = DEC) {
+    if (discarding()) return 0;
+    return print(std::is_signed<T>::value ? String((long)value, base) : String((unsigned long)value, base));
+  }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    if (discarding()) return 0;
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return n > 0 ? write((const uint8_t*)buf, std::min((size_t)n, sizeof(buf) - 1)) : 0;
+  }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T& value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <typename T>
+  size_t println(const T& value, int format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+};
+
+class HardwareSerial : public Print {
+ public:
+  using Print::write;
+  size_t write(const uint8_t* data, size_t length) override { return simSerialWrite(data, length); }
+  bool discarding() const override { return !simSerialEnabled(); }
+
+  void begin(unsigned long baud) { _baud = baud; }
+  void end() {}
+  void flush() {}
+  size_t setTxBufferSize(size_t size) { return size; }
+  int availableForWrite() { return 1 << 20; }  // Fila infinita: a captura nunca perde quadros
+  int available() { return 0; }
+  int read() { return -1; }
+  unsigned long baudRate() const { return _baud; }
+
+ private:
+  unsigned long _baud = 0;
+};
+
+extern HardwareSerial Serial;
+
+// ====== TEMPO E PINOS ======
+inline unsigned long millis() { return (unsigned long)(simNowUs() / 1000); }
+inline unsigned long micros() { return (unsigned long)simNowUs(); }
+inline void delay(unsigned long ms) { simAdvanceUs((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned us) { simAdvanceUs(us); }
+inline void yield() {}
+
+inline int analogRead(uint8_t pin) { return simAnalogRead(pin); }
+inline int digitalRead(uint8_t pin) { return simDigitalRead(pin); }
+inline void pinMode(uint8_t pin, uint8_t mode) { simPinMode(pin, mode); }
+inline void digitalWrite(uint8_t pin, uint8_t level) { simDigitalWrite(pin, level); }
+
+// NTP: o relógio de parede simulado começa a valer a partir daqui (sim.h)
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2 = nullptr,
+                const char* server3 = nullptr);
+inline uint32_t getCpuFrequencyMhz() { return 240; }
+
+// ====== ESP ======
+class EspClass {
+ public:
+  // Encerra o processo do boot; simRun() começa o próximo com os globais zerados
+  [[noreturn]] void restart() { simRestart(); }
+  uint32_t getFreeHeap() { return 0; }
+  uint32_t getCycleCount() { return (uint32_t)(simNowUs() * getCpuFrequencyMhz()); }
+};
+
+extern EspClass ESP;
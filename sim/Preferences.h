@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+
+// NVS simulada (sim.h): namespaces e chaves na memória compartilhada entre os boots,
+// valores guardados como bytes
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false);
+  void end() { _open = false; }
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+
+  size_t putBytes(const char* key, const void* value, size_t length);
+  size_t getBytes(const char* key, void* buffer, size_t capacity);
+  size_t getBytesLength(const char* key);
+
+  size_t putString(const char* key, const String& value) { return putBytes(key, value.c_str(), value.length()); }
+  String getString(const char* key, const String& defaultValue = String());
+
+  size_t putUChar(const char* key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return get(key, defaultValue); }
+  size_t putUShort(const char* key, uint16_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint16_t getUShort(const char* key, uint16_t defaultValue = 0) { return get(key, defaultValue); }
+  size_t putInt(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+  int32_t getInt(const char* key, int32_t defaultValue = 0) { return get(key, defaultValue); }
+  size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+  size_t putULong64(const char* key, uint64_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint64_t getULong64(const char* key, uint64_t defaultValue = 0) { return get(key, defaultValue); }
+
+ private:
+  // Como na NVS, um valor de outro tamanho é tratado como ausente
+  template <typename T>
+  T get(const char* key, T defaultValue) {
+    T value;
+    return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : defaultValue;
+  }
+
+  char _ns[16] = {};
+  bool _open = false;
+  bool _readOnly = false;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "net.h"
+
+// WiFi simulado (sim.h): a estação conecta na hora e fica fora enquanto durar uma falha
+// "wifi" (net.h); DNS e TCP são os da rede simulada
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_CONNECTED = 3,
+  WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3,
+} wifi_mode_t;
+
+class WiFiClass {
+ public:
+  void macAddress(uint8_t mac[6]) { memcpy(mac, _mac, sizeof(_mac)); }
+  bool mode(wifi_mode_t mode) {
+    _mode = mode;
+    return true;
+  }
+  wl_status_t begin(const char*, const char* = nullptr) {
+    _status = WL_CONNECTED;
+    return _status;
+  }
+  bool disconnect(bool = false) {
+    _status = WL_DISCONNECTED;
+    return true;
+  }
+  wl_status_t status() const { return _status == WL_CONNECTED && !simWifiUp() ? WL_DISCONNECTED : _status; }
+  IPAddress localIP() const { return status() == WL_CONNECTED ? IPAddress(10, 0, 0, 2) : IPAddress(); }
+  int hostByName(const char* host, IPAddress& address) {
+    uint8_t ip[4];
+    if (!simResolve(host, ip)) return 0;
+    address = IPAddress(ip[0], ip[1], ip[2], ip[3]);
+    return 1;
+  }
+
+ private:
+  uint8_t _mac[6] = {0x24, 0x0A, 0xC4, 0x5A, 0x11, 0x00};
+  wifi_mode_t _mode = WIFI_OFF;
+  wl_status_t _status = WL_IDLE_STATUS;
+};
+
+extern WiFiClass WiFi;
+
+// Conexão TCP da rede simulada (net.h); connect() sem timeout espera o do arduino-esp32
+class WiFiClient {
+ public:
+  int connect(const char* host, uint16_t port) { return connect(host, port, SIM_TCP_CONNECT_TIMEOUT_MS); }
+  int connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    stop();
+    _id = simTcpConnect(host, port, (uint32_t)timeoutMs);
+    return _id >= 0;
+  }
+  int connect(IPAddress ip, uint16_t port) { return connect(ip, port, SIM_TCP_CONNECT_TIMEOUT_MS); }
+  int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) { return connect(ip.toString().c_str(), port, timeoutMs); }
+  uint8_t connected() { return _id >= 0 && simTcpConnected(_id); }
+  int available() { return _id >= 0 ? simTcpAvailable(_id) : 0; }
+  int read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  int read(uint8_t* buffer, size_t length) { return _id >= 0 ? simTcpRead(_id, buffer, length) : -1; }
+  size_t write(const uint8_t* data, size_t length) { return _id >= 0 ? simTcpWrite(_id, data, length) : 0; }
+  void flush() {}
+  void stop() {
+    if (_id >= 0) simTcpClose(_id);
+    _id = -1;
+  }
+  void setNoDelay(bool) {}
+
+ private:
+  int _id = -1;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+#include <string>
+
+// UDP simulado (sim.h): cada endPacket() entrega o datagrama à função de saída, com o
+// instante virtual (com o WiFi fora, o datagrama se perde); parsePacket() só vê os
+// comandos já vencidos
+class WiFiUDP {
+ public:
+  uint8_t begin(uint16_t port) {
+    _localPort = port;
+    return 1;
+  }
+  void stop() {}
+
+  int beginPacket(const char* host, uint16_t port) {
+    _host = host;
+    _port = port;
+    _packet.clear();
+    return 1;
+  }
+  int beginPacket(IPAddress ip, uint16_t port) { return beginPacket(ip.toString().c_str(), port); }
+  size_t write(const uint8_t* data, size_t length) {
+    _packet.append((const char*)data, length);
+    return length;
+  }
+  size_t write(uint8_t c) { return write(&c, 1); }
+  int endPacket();
+
+  int parsePacket();
+  int available() { return (int)(_received.size() - _readPos); }
+  int read(uint8_t* buffer, size_t length) {
+    size_t n = std::min(length, _received.size() - _readPos);
+    memcpy(buffer, _received.data() + _readPos, n);
+    _readPos += n;
+    return (int)n;
+  }
+  int read(char* buffer, size_t length) { return read((uint8_t*)buffer, length); }
+  int read() { return _readPos < _received.size() ? (uint8_t)_received[_readPos++] : -1; }
+  void flush() {}
+
+ private:
+  std::string _host;
+  uint16_t _port = 0;
+  uint16_t _localPort = 0;
+  std::string _packet;
+  std::string _received;
+  size_t _readPos = 0;
+};
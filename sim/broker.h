@@ -0,0 +1,295 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include "mqtt_packet.h"
+
+// Lado broker do MQTT 3.1.1 e 5, no mínimo que o cliente do firmware (mqtt_client.h) usa:
+// CONNECT, SUBSCRIBE, PUBLISH QoS 0 e 1 (com aliases de tópico no 5), PUBACK, PINGREQ e
+// DISCONNECT. Sem E/S: receive() recebe os bytes de uma conexão, na ordem em que chegam,
+// e acrescenta as respostas em out, então o mesmo código atende o TCP simulado
+// (sim/net.cpp) e um socket de verdade. Sessões, inscrições e o destino das mensagens
+// ficam com o Handler (parâmetro de template), que responde:
+//   uint8_t onConnect(const char* clientId, bool cleanStart, bool& sessionPresent)
+//       0 aceita; senão o código de recusa do MQTT 5 (convertido no 3.1.1)
+//   void onSubscribe(const char* topic, uint8_t qos)
+//   void onPublish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool dup)
+//   void onAck(uint16_t packetId)        PUBACK de uma mensagem enviada com publish()
+// O keepalive não é cobrado: quem tem o socket decide quando a conexão morreu.
+
+#define MQTT_BROKER_RECEIVE_MAXIMUM 20      // Anunciados no CONNACK do 5 (padrões do mosquitto)
+#define MQTT_BROKER_TOPIC_ALIAS_MAXIMUM 10
+#define MQTT_BROKER_PACKET_MAX 268435455    // Maior comprimento restante do protocolo
+#define MQTT_CONNACK_UNAVAILABLE_V5 0x88    // Server unavailable
+#define MQTT_CONNACK_UNAVAILABLE_V311 0x03
+
+template <typename Handler>
+class MqttBrokerConnection {
+ public:
+  explicit MqttBrokerConnection(Handler& handler) : _handler(handler) {}
+
+  bool connected() const { return _connected; }
+  bool closed() const { return _closed; }
+  uint8_t version() const { return _version; }
+
+  // Processa os bytes recebidos; false quando a conexão deve ser fechada (DISCONNECT,
+  // CONNECT recusado ou pacote malformado), depois de enviar o que estiver em out
+  bool receive(const uint8_t* data, size_t length, std::string& out) {
+    if (_closed) return false;
+    _rx.append((const char*)data, length);
+    size_t pos = 0;
+    while (!_closed) {
+      uint8_t first;
+      uint32_t remaining;
+      int header = mqttReadFixedHeader((const uint8_t*)_rx.data() + pos, _rx.size() - pos, first, remaining);
+      if (header < 0 || remaining > MQTT_BROKER_PACKET_MAX) {
+        _closed = true;
+        break;
+      }
+      if (header == 0 || _rx.size() - pos < header + remaining) break;
+      handle(first, (const uint8_t*)_rx.data() + pos + header, remaining, out);
+      pos += header + remaining;
+    }
+    _rx.erase(0, pos);
+    return !_closed;
+  }
+
+  // PUBLISH do broker para o cliente (o nome do tópico sempre vai inteiro); retorna o
+  // packet id, que volta no onAck() (0 no QoS 0 ou se o tópico não couber)
+  uint16_t publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, std::string& out) {
+    uint16_t packetId = 0;
+    if (qos > 0) {
+      if (++_nextPacketId == 0) _nextPacketId = 1;
+      packetId = _nextPacketId;
+    }
+    uint8_t header[MQTT_FIXED_HEADER_MAX + 2 + 256 + 2 + 1];
+    size_t n = mqttWritePublishHeader(header, sizeof(header), _version, topic, length, qos > 0 ? 1 : 0, false,
+                                      packetId, 0);
+    if (n == 0) return 0;
+    out.append((const char*)header, n);
+    out.append((const char*)payload, length);
+    return qos > 0 ? packetId : 0;
+  }
+
+ private:
+  static uint16_t readU16(const uint8_t* in) { return (uint16_t)(in[0] << 8 | in[1]); }
+
+  void handle(uint8_t first, const uint8_t* body, uint32_t length, std::string& out) {
+    uint8_t type = first >> 4;
+    if (!_connected && type != MQTT_CONNECT) {
+      _closed = true;
+      return;
+    }
+    switch (type) {
+      case MQTT_CONNECT:
+        if (_connected) _closed = true;  // Segundo CONNECT: erro de protocolo
+        else handleConnect(body, length, out);
+        break;
+      case MQTT_PUBLISH:
+        handlePublish(first, body, length, out);
+        break;
+      case MQTT_PUBACK:
+        if (length >= 2) _handler.onAck(readU16(body));
+        break;
+      case MQTT_SUBSCRIBE:
+        handleSubscribe(first, body, length, out);
+        break;
+      case MQTT_PINGREQ: {
+        uint8_t packet[2];
+        out.append((const char*)packet, mqttWriteEmpty(packet, MQTT_PINGRESP));
+        break;
+      }
+      default:  // DISCONNECT; QoS 2, UNSUBSCRIBE e AUTH ficam fora do que o firmware usa
+        _closed = true;
+    }
+  }
+
+  // Pula o bloco de propriedades do MQTT 5 em body[pos]; false se estiver malformado
+  bool skipProperties(const uint8_t* body, uint32_t length, size_t& pos) {
+    if (_version != MQTT_V5) return true;
+    uint32_t properties;
+    int n = mqttReadVarInt(body + pos, length - pos, properties);
+    if (n <= 0 || pos + n + properties > length) return false;
+    pos += n + properties;
+    return true;
+  }
+
+  void writeConnack(std::string& out, bool sessionPresent, uint8_t reason) {
+    uint8_t packet[16];
+    size_t n = 0;
+    packet[n++] = MQTT_CONNACK << 4;
+    if (_version == MQTT_V5) {
+      bool accepted = reason == 0;
+      packet[n++] = accepted ? 9 : 3;
+      packet[n++] = sessionPresent ? 1 : 0;
+      packet[n++] = reason;
+      packet[n++] = accepted ? 6 : 0;
+      if (accepted) {
+        packet[n++] = MQTT_PROP_RECEIVE_MAXIMUM;
+        packet[n++] = (uint8_t)(MQTT_BROKER_RECEIVE_MAXIMUM >> 8);
+        packet[n++] = (uint8_t)MQTT_BROKER_RECEIVE_MAXIMUM;
+        packet[n++] = MQTT_PROP_TOPIC_ALIAS_MAXIMUM;
+        packet[n++] = (uint8_t)(MQTT_BROKER_TOPIC_ALIAS_MAXIMUM >> 8);
+        packet[n++] = (uint8_t)MQTT_BROKER_TOPIC_ALIAS_MAXIMUM;
+      }
+    } else {
+      packet[n++] = 2;
+      packet[n++] = sessionPresent ? 1 : 0;
+      packet[n++] = reason == 0 ? 0 : v311Reason(reason);
+    }
+    out.append((const char*)packet, n);
+  }
+
+  static uint8_t v311Reason(uint8_t reason) {
+    switch (reason) {
+      case MQTT_CONNACK_BAD_VERSION_V5: return MQTT_CONNACK_BAD_VERSION_V311;
+      case 0x85: return 0x02;  // Client identifier not valid
+      case 0x86: return 0x04;  // Bad user name or password
+      case 0x87: return 0x05;  // Not authorized
+      default: return MQTT_CONNACK_UNAVAILABLE_V311;
+    }
+  }
+
+  // "MQTT", nível, flags, keepalive, [propriedades], client id (o resto não interessa)
+  void handleConnect(const uint8_t* body, uint32_t length, std::string& out) {
+    if (length < 10 || readU16(body) != 4 || memcmp(body + 2, "MQTT", 4) != 0) {
+      _closed = true;
+      return;
+    }
+    uint8_t level = body[6];
+    bool cleanStart = (body[7] & 0x02) != 0;
+    if (level != MQTT_V311 && level != MQTT_V5) {
+      _version = MQTT_V311;
+      writeConnack(out, false, MQTT_CONNACK_BAD_VERSION_V5);
+      _closed = true;
+      return;
+    }
+    _version = level;
+    size_t pos = 10;
+    if (!skipProperties(body, length, pos) || pos + 2 > length || pos + 2 + readU16(body + pos) > length) {
+      _closed = true;
+      return;
+    }
+    std::string clientId((const char*)body + pos + 2, readU16(body + pos));
+    bool sessionPresent = false;
+    uint8_t reason = _handler.onConnect(clientId.c_str(), cleanStart, sessionPresent);
+    writeConnack(out, reason == 0 && sessionPresent, reason);
+    if (reason != 0) {
+      _closed = true;
+      return;
+    }
+    _connected = true;
+  }
+
+  void handleSubscribe(uint8_t first, const uint8_t* body, uint32_t length, std::string& out) {
+    size_t pos = 2;
+    if ((first & 0x0F) != 0x02 || length < 2 || !skipProperties(body, length, pos)) {
+      _closed = true;
+      return;
+    }
+    uint16_t packetId = readU16(body);
+    std::string codes;
+    while (pos + 2 <= length) {
+      size_t topicLength = readU16(body + pos);
+      if (pos + 2 + topicLength + 1 > length) break;
+      std::string topic((const char*)body + pos + 2, topicLength);
+      uint8_t qos = body[pos + 2 + topicLength] & 0x03;
+      if (qos > 1) qos = 1;  // Sem QoS 2: concedido o 1
+      _handler.onSubscribe(topic.c_str(), qos);
+      codes += (char)qos;
+      pos += 2 + topicLength + 1;
+    }
+    if (codes.empty() || pos != length) {
+      _closed = true;
+      return;
+    }
+    uint8_t header[MQTT_FIXED_HEADER_MAX + 3];
+    uint32_t remaining = 2 + (_version == MQTT_V5 ? 1 : 0) + codes.size();
+    size_t n = 0;
+    header[n++] = MQTT_SUBACK << 4;
+    n += mqttWriteRemainingLength(header + n, remaining);
+    header[n++] = (uint8_t)(packetId >> 8);
+    header[n++] = (uint8_t)packetId;
+    if (_version == MQTT_V5) header[n++] = 0;
+    out.append((const char*)header, n);
+    out.append(codes);
+  }
+
+  void handlePublish(uint8_t first, const uint8_t* body, uint32_t length, std::string& out) {
+    uint8_t qos = (first >> 1) & 0x03;
+    if (qos > 1 || length < 2 || 2 + (size_t)readU16(body) + (qos ? 2 : 0) > length) {
+      _closed = true;
+      return;
+    }
+    std::string topic((const char*)body + 2, readU16(body));
+    size_t pos = 2 + topic.size();
+    uint16_t packetId = 0;
+    if (qos > 0) {
+      packetId = readU16(body + pos);
+      pos += 2;
+    }
+    if (_version == MQTT_V5 && !readPublishProperties(body, length, pos, topic)) {
+      _closed = true;
+      return;
+    }
+    _handler.onPublish(topic.c_str(), body + pos, length - pos, qos, (first & MQTT_PUBLISH_DUP) != 0);
+    if (qos > 0) {
+      uint8_t ack[4];
+      out.append((const char*)ack, mqttWriteAck(ack, MQTT_PUBACK, packetId));
+    }
+  }
+
+  // Propriedades do PUBLISH: só o alias de tópico muda alguma coisa aqui; as que um
+  // cliente pode mandar são puladas pelo tamanho
+  bool readPublishProperties(const uint8_t* body, uint32_t length, size_t& pos, std::string& topic) {
+    uint32_t properties;
+    int n = mqttReadVarInt(body + pos, length - pos, properties);
+    if (n <= 0 || pos + n + properties > length) return false;
+    const uint8_t* p = body + pos + n;
+    const uint8_t* end = p + properties;
+    pos += n + properties;
+    while (p < end) {
+      uint8_t id = *p++;
+      size_t size;
+      uint32_t ignored;
+      switch (id) {
+        case 0x01: size = 1; break;                        // Payload format
+        case 0x02: size = 4; break;                        // Message expiry
+        case MQTT_PROP_TOPIC_ALIAS: size = 2; break;
+        case 0x03: case 0x08: case 0x09:                   // Content type, response topic, correlation
+          size = end - p < 2 ? 0 : 2 + readU16(p);
+          break;
+        case 0x26:                                         // User property (par de strings)
+          size = end - p < 4 ? 0 : 4 + readU16(p);
+          size = size == 0 || (size_t)(end - p) < size ? 0 : size + readU16(p + size - 2);
+          break;
+        case 0x0B: {                                       // Subscription identifier
+          int k = mqttReadVarInt(p, end - p, ignored);
+          size = k > 0 ? (size_t)k : 0;
+          break;
+        }
+        default:
+          return false;
+      }
+      if (size == 0 || p + size > end) return false;
+      if (id == MQTT_PROP_TOPIC_ALIAS) {
+        uint16_t alias = readU16(p);
+        if (alias == 0 || alias > MQTT_BROKER_TOPIC_ALIAS_MAXIMUM) return false;
+        if (topic.empty()) topic = _aliases[alias];
+        else _aliases[alias] = topic;
+      }
+      p += size;
+    }
+    return !topic.empty();
+  }
+
+  Handler& _handler;
+  std::string _rx;
+  uint8_t _version = MQTT_V311;
+  bool _connected = false;
+  bool _closed = false;
+  uint16_t _nextPacketId = 0;
+  std::string _aliases[MQTT_BROKER_TOPIC_ALIAS_MAXIMUM + 1];  // Alias -> tópico, nesta conexão
+};
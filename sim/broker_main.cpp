@@ -0,0 +1,462 @@
+// Broker MQTT de bancada (sim/broker_server.h) e benchmark de latência fim a fim do
+// caminho de publicação do firmware.
+//
+//   .pio/build/broker_native/program [--port 1883] [--quiet]
+//   .pio/build/broker_native/program --bench [--rate 1000] [--count 10000] > e2e.jsonl
+//
+// Broker: escuta em todas as interfaces (no dispositivo, "BROKERS <ip>:1883") e imprime
+// cada mensagem como "<tópico> <payload>" (binários em hex com o prefixo "hex:", como o
+// replay), o formato de scripts/seq_tracker.py. Roteia para quem estiver inscrito, então
+// mosquitto_pub/mosquitto_sub servem para mandar comandos e acompanhar. Ao sair (Ctrl+C),
+// o resumo vai para a saída de erro: mensagens por segundo e a latência de cada leitura,
+// do "timestamp" do payload (instante da leitura do ADC no relógio do dispositivo) à
+// chegada no broker, em p50/p99/p999 (só faz sentido com os dois relógios sincronizados).
+//
+// Benchmark (--bench): o broker roda numa thread deste processo, em 127.0.0.1, e o cliente
+// do firmware (mqtt_client.h, QoS 1 com a janela padrão) publica por um socket TCP de
+// verdade. Cada leitura é marcada na captura (antes da conversão do ADC) e na chegada ao
+// broker (quando os bytes saem do socket), no mesmo relógio monotônico. Para cada
+// codificação e tamanho de lote (BENCH_CASES):
+//   - latência: --count leituras a --rate por segundo, com a espera para completar o lote
+//     incluída (é o preço do lote); p50/p99/p999/máximo em µs;
+//   - vazão: leituras tão rápido quanto a janela deixa por --seconds; mensagens e leituras
+//     por segundo na chegada ao broker.
+// Uma linha JSON por caso, {"bench":"e2e_<caso>","platform":"native",...}, para
+// scripts/bench_compare.py (que compara as latências; a vazão sai para leitura).
+//
+// Opções:
+//   --port <n>      porta do broker (padrão 1883)
+//   --quiet         não imprime as mensagens
+//   --bench         roda o benchmark em vez do broker
+//   --rate <hz>     leituras por segundo na medida de latência (padrão 1000)
+//   --count <n>     leituras na medida de latência (padrão 10000)
+//   --seconds <s>   duração da medida de vazão (padrão 2)
+//   --window <n>    janela QoS 1 do cliente (padrão MQTT_INFLIGHT_WINDOW do firmware, 8)
+
+#include <errno.h>
+#include <math.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "broker_server.h"
+#include "calibration.h"
+#include "mqtt_client.h"
+#include "payload.h"
+#include "readings.h"
+#include "seal.h"
+#include "ts_codec.h"
+
+#define BROKER_DEFAULT_PORT 1883
+#define BENCH_DEFAULT_RATE_HZ 1000
+#define BENCH_DEFAULT_COUNT 10000
+#define BENCH_DEFAULT_SECONDS 2
+#define BENCH_DEFAULT_WINDOW 8         // MQTT_INFLIGHT_WINDOW em src/main.cpp
+#define BENCH_DEVICE_ID "240AC45A1100"
+#define BENCH_READING_TOPIC "sensors/humidity"            // MQTT_PUB_TOPIC em src/main.cpp
+#define BENCH_BATCH_TOPIC "sensors/" BENCH_DEVICE_ID "/batch"
+#define BENCH_BLOCK_SIZE 1024          // BATCH_BLOCK_SIZE em src/main.cpp
+#define BENCH_VALUE_SCALE 2            // BATCH_VALUE_SCALE em src/main.cpp
+#define BENCH_PERIOD_MS 5000
+#define BENCH_DRAIN_TIMEOUT_US 5000000 // Espera pelos últimos PUBACK
+#define BENCH_DRY_VALUE 2850           // Calibração padrão (src/main.cpp)
+#define BENCH_WET_VALUE 1350
+
+// ====== BROKER ======
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) { stopRequested = 1; }
+
+struct BrokerLog {
+  bool quiet;
+  int64_t wallOffsetUs;  // CLOCK_REALTIME - CLOCK_MONOTONIC na partida
+  uint64_t firstUs;
+  uint64_t lastUs;
+  uint64_t messages;
+  std::vector<int64_t> latenciesMs;
+};
+
+static void printMessage(const char* topic, const uint8_t* payload, size_t length) {
+  bool text = true;
+  for (size_t i = 0; i < length && text; i++) text = payload[i] >= 0x20 && payload[i] < 0x7F;
+  printf("%s ", topic);
+  if (text) {
+    fwrite(payload, 1, length, stdout);
+  } else {
+    fputs("hex:", stdout);
+    for (size_t i = 0; i < length; i++) printf("%02x", payload[i]);
+  }
+  putchar('\n');
+  fflush(stdout);
+}
+
+static void onBrokerMessage(void* context, uint64_t receivedUs, const char*, const char* topic, const uint8_t* payload,
+                            size_t length) {
+  BrokerLog& log = *(BrokerLog*)context;
+  if (log.messages++ == 0) log.firstUs = receivedUs;
+  log.lastUs = receivedUs;
+  if (!log.quiet) printMessage(topic, payload, length);
+  int64_t receivedMs = ((int64_t)receivedUs + log.wallOffsetUs) / 1000;
+  forEachReading(topic, payload, length, [&log, receivedMs](uint32_t, uint32_t, unsigned long long timestampMs) {
+    if (timestampMs != 0) log.latenciesMs.push_back(receivedMs - (int64_t)timestampMs);
+  });
+}
+
+template <typename T>
+static T percentile(const std::vector<T>& sorted, unsigned perMille) {
+  if (sorted.empty()) return 0;
+  return sorted[std::min(sorted.size() - 1, sorted.size() * perMille / 1000)];
+}
+
+static int runBroker(uint16_t port, bool quiet) {
+  MqttBrokerServer server;
+  if (!server.listen(port, false)) {
+    fprintf(stderr, "broker: porta %u: %s\n", port, strerror(errno));
+    return 1;
+  }
+  struct timespec wall;
+  clock_gettime(CLOCK_REALTIME, &wall);
+  BrokerLog log = {};
+  log.quiet = quiet;
+  log.wallOffsetUs = (int64_t)wall.tv_sec * 1000000 + wall.tv_nsec / 1000 - (int64_t)brokerMonotonicUs();
+  server.setReceiveHook(onBrokerMessage, &log);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  fprintf(stderr, "broker: escutando na porta %u\n", server.port());
+  while (!stopRequested) server.poll(200);
+
+  const MqttBrokerStats& stats = server.stats();
+  double spanS = log.messages > 1 ? (log.lastUs - log.firstUs) * 1e-6 : 0;
+  fprintf(stderr, "broker: conexoes=%llu mensagens=%llu entregues=%llu bytes=%llu msgs/s=%.1f\n",
+          (unsigned long long)stats.connections, (unsigned long long)stats.published,
+          (unsigned long long)stats.delivered, (unsigned long long)stats.bytes,
+          spanS > 0 ? (log.messages - 1) / spanS : 0);
+  std::vector<int64_t>& latencies = log.latenciesMs;
+  std::sort(latencies.begin(), latencies.end());
+  fprintf(stderr, "broker: leituras=%zu latencia p50=%lld p99=%lld p999=%lld max=%lld ms\n", latencies.size(),
+          (long long)percentile(latencies, 500), (long long)percentile(latencies, 990),
+          (long long)percentile(latencies, 999), (long long)(latencies.empty() ? 0 : latencies.back()));
+  return 0;
+}
+
+// ====== BENCHMARK ======
+// Socket TCP bloqueante com a interface do WiFiClient que o MqttClient usa; a leitura não
+// bloqueia. Sem detecção de queda além do erro de escrita: o broker é local e confiável.
+class PosixClient {
+ public:
+  int connect(const char* host, uint16_t port) {
+    stop();
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1) return 0;
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0) return 0;
+    if (::connect(_fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+      stop();
+      return 0;
+    }
+    int one = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // Como o lwIP do ESP32 com setNoDelay(true)
+    return 1;
+  }
+  uint8_t connected() { return _fd >= 0; }
+  int available() {
+    int n = 0;
+    return _fd >= 0 && ioctl(_fd, FIONREAD, &n) == 0 ? n : 0;
+  }
+  int read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  int read(uint8_t* buffer, size_t length) {
+    ssize_t n = _fd >= 0 ? recv(_fd, buffer, length, MSG_DONTWAIT) : -1;
+    return n > 0 ? (int)n : -1;
+  }
+  size_t write(const uint8_t* data, size_t length) {
+    size_t sent = 0;
+    while (_fd >= 0 && sent < length) {
+      ssize_t n = send(_fd, data + sent, length - sent, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) {
+        stop();
+        break;
+      }
+      sent += (size_t)n;
+    }
+    return sent;
+  }
+  void flush() {}
+  void stop() {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+  }
+
+ private:
+  int _fd = -1;
+};
+
+static unsigned long hostMillis() { return (unsigned long)(brokerMonotonicUs() / 1000); }
+
+enum BenchEncoding { ENCODING_JSON, ENCODING_BLOCK, ENCODING_SEALED };
+static const char* const encodingNames[] = {"json", "block", "sealed"};
+
+// JSON é sempre uma leitura por mensagem (o formato de MQTT_PUB_TOPIC); os blocos
+// (BATCH <n>) e os envelopes cifrados variam o lote
+static const struct {
+  BenchEncoding encoding;
+  uint16_t batch;
+} BENCH_CASES[] = {
+    {ENCODING_JSON, 1},   {ENCODING_BLOCK, 1},   {ENCODING_BLOCK, 10},
+    {ENCODING_BLOCK, 50}, {ENCODING_SEALED, 10}, {ENCODING_SEALED, 50},
+};
+
+static const uint8_t benchKey[SEAL_KEY_SIZE] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                                0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+
+// Chegadas ao broker, na ordem (uma conexão QoS 1 sem reenvio entrega na ordem do envio)
+struct Arrivals {
+  std::vector<uint64_t> atUs;
+};
+
+static void onBenchMessage(void* context, uint64_t receivedUs, const char*, const char*, const uint8_t*, size_t) {
+  ((Arrivals*)context)->atUs.push_back(receivedUs);
+}
+
+struct BenchResult {
+  uint64_t readings;
+  uint64_t messages;
+  uint64_t payloadBytes;
+  uint32_t p50Us, p99Us, p999Us, maxUs;
+  double messagesPerS;
+  double readingsPerS;
+};
+
+// Uma conexão do cliente do firmware a um broker próprio, numa thread
+class BenchSession {
+ public:
+  BenchSession(BenchEncoding encoding, uint16_t batch, uint8_t window)
+      : _encoding(encoding), _batch(batch), _client(_socket, hostMillis), _window(window) {}
+
+  bool start() {
+    if (!_server.listen(0, true)) return false;
+    _server.setReceiveHook(onBenchMessage, &_arrivals);
+    _thread = std::thread([this]() {
+      while (!_stop.load(std::memory_order_relaxed)) _server.poll(1);
+    });
+    _client.setServer("127.0.0.1", _server.port());
+    _client.setWindow(_window);
+    if (_encoding == ENCODING_SEALED) _sealer.begin(benchKey, 1, 1);
+    return _client.connect("bench-" BENCH_DEVICE_ID, true);
+  }
+
+  // Lê o "ADC" e guarda a leitura no lote; publica quando o lote fecha
+  bool capture(uint64_t capturedUs) {
+    uint32_t seq = (uint32_t)_capturedUs.size();
+    _capturedUs.push_back(capturedUs);
+    int raw = 2100 + (int)(seq % 80) - 40;
+    float humidity = humidityFromRaw(raw, BENCH_DRY_VALUE, BENCH_WET_VALUE);
+    unsigned long long timestampMs = 1767225600000ULL + capturedUs / 1000;
+    if (_encoding == ENCODING_JSON) {
+      size_t n = serializeReading((char*)_block, sizeof(_block), BENCH_DEVICE_ID, SeqNo{1, seq}, humidity, timestampMs,
+                                  BENCH_PERIOD_MS);
+      return publish(BENCH_READING_TOPIC, _block, n, 1);
+    }
+    if (_pending == 0) {
+      _encoder = TsBlockEncoder(_block + SEAL_HEADER_SIZE, BENCH_BLOCK_SIZE, BENCH_VALUE_SCALE);
+      _encoder.setSequence(1, seq);
+    }
+    _encoder.add(timestampMs, (int32_t)lroundf(humidity * 100));
+    return ++_pending < _batch || flush();
+  }
+
+  // Publica o lote incompleto
+  bool flush() {
+    if (_pending == 0) return true;
+    uint16_t count = _pending;
+    _pending = 0;
+    size_t n = _encoder.finish();
+    if (_encoding == ENCODING_SEALED) {
+      n = _sealer.seal(BENCH_BATCH_TOPIC, _block, n);
+      return n > 0 && publish(BENCH_BATCH_TOPIC, _block, n, count);
+    }
+    return publish(BENCH_BATCH_TOPIC, _block + SEAL_HEADER_SIZE, n, count);
+  }
+
+  // Atende os PUBACK até o instante dado
+  void idleUntil(uint64_t untilUs) {
+    while (brokerMonotonicUs() < untilUs) _client.loop();
+  }
+
+  // Espera os PUBACK pendentes e para o broker; false se faltou alguma chegada
+  bool finish(uint64_t& lastArrivalUs) {
+    uint64_t deadline = brokerMonotonicUs() + BENCH_DRAIN_TIMEOUT_US;
+    while (_client.inflight() > 0 && brokerMonotonicUs() < deadline) _client.loop();
+    _client.disconnect();
+    _stop.store(true);
+    _thread.join();
+    lastArrivalUs = _arrivals.atUs.empty() ? 0 : _arrivals.atUs.back();
+    return _arrivals.atUs.size() == _messageFirst.size();
+  }
+
+  // Latência de cada leitura: chegada da mensagem que a levou menos a captura
+  void latencies(std::vector<uint32_t>& out) const {
+    for (size_t m = 0; m < _messageFirst.size(); m++) {
+      size_t end = m + 1 < _messageFirst.size() ? _messageFirst[m + 1] : _capturedUs.size();
+      for (size_t i = _messageFirst[m]; i < end; i++) out.push_back((uint32_t)(_arrivals.atUs[m] - _capturedUs[i]));
+    }
+  }
+
+  uint64_t readings() const { return _capturedUs.size(); }
+  uint64_t messages() const { return _messageFirst.size(); }
+  uint64_t payloadBytes() const { return _payloadBytes; }
+  uint64_t firstCaptureUs() const { return _capturedUs.empty() ? 0 : _capturedUs.front(); }
+
+ private:
+  bool publish(const char* topic, const uint8_t* payload, size_t length, uint16_t count) {
+    if (length == 0) return false;
+    while (!_client.publish(topic, payload, length, 1)) {
+      if (!_client.loop()) return false;
+    }
+    _messageFirst.push_back(_capturedUs.size() - count);
+    _payloadBytes += length;
+    return true;
+  }
+
+  BenchEncoding _encoding;
+  uint16_t _batch;
+  PosixClient _socket;
+  MqttClient<PosixClient> _client;
+  uint8_t _window;
+  MqttBrokerServer _server;
+  Arrivals _arrivals;
+  std::thread _thread;
+  std::atomic<bool> _stop{false};
+  PayloadSealer _sealer;
+  TsBlockEncoder _encoder{nullptr, 0, BENCH_VALUE_SCALE};
+  uint8_t _block[SEAL_HEADER_SIZE + BENCH_BLOCK_SIZE + SEAL_TAG_SIZE];
+  uint16_t _pending = 0;
+  std::vector<uint64_t> _capturedUs;   // Por leitura (seq)
+  std::vector<size_t> _messageFirst;   // Primeira leitura de cada mensagem publicada
+  uint64_t _payloadBytes = 0;
+};
+
+// Leituras a rateHz, com o cliente atendendo os PUBACK entre uma e outra
+static bool measureLatency(BenchEncoding encoding, uint16_t batch, uint8_t window, double rateHz, uint32_t count,
+                           BenchResult& result) {
+  BenchSession session(encoding, batch, window);
+  if (!session.start()) return false;
+  uint64_t periodUs = (uint64_t)(1e6 / rateHz);
+  uint64_t dueUs = brokerMonotonicUs();
+  for (uint32_t i = 0; i < count; i++) {
+    session.idleUntil(dueUs);
+    if (!session.capture(brokerMonotonicUs())) return false;
+    dueUs += periodUs;
+  }
+  uint64_t lastUs;
+  if (!session.flush() || !session.finish(lastUs)) return false;
+  std::vector<uint32_t> latencies;
+  session.latencies(latencies);
+  std::sort(latencies.begin(), latencies.end());
+  result.readings = session.readings();
+  result.messages = session.messages();
+  result.payloadBytes = session.payloadBytes();
+  result.p50Us = percentile(latencies, 500);
+  result.p99Us = percentile(latencies, 990);
+  result.p999Us = percentile(latencies, 999);
+  result.maxUs = latencies.empty() ? 0 : latencies.back();
+  return true;
+}
+
+// Leituras tão rápido quanto a janela deixa, por seconds
+static bool measureThroughput(BenchEncoding encoding, uint16_t batch, uint8_t window, double seconds,
+                              BenchResult& result) {
+  BenchSession session(encoding, batch, window);
+  if (!session.start()) return false;
+  uint64_t endUs = brokerMonotonicUs() + (uint64_t)(seconds * 1e6);
+  while (brokerMonotonicUs() < endUs) {
+    if (!session.capture(brokerMonotonicUs())) return false;
+  }
+  uint64_t lastUs;
+  if (!session.flush() || !session.finish(lastUs)) return false;
+  double spanS = (lastUs - session.firstCaptureUs()) * 1e-6;
+  result.messagesPerS = spanS > 0 ? session.messages() / spanS : 0;
+  result.readingsPerS = spanS > 0 ? session.readings() / spanS : 0;
+  return true;
+}
+
+static int runBench(double rateHz, uint32_t count, double seconds, uint8_t window) {
+  for (size_t i = 0; i < sizeof(BENCH_CASES) / sizeof(BENCH_CASES[0]); i++) {
+    BenchEncoding encoding = BENCH_CASES[i].encoding;
+    uint16_t batch = BENCH_CASES[i].batch;
+    BenchResult result = {};
+    if (!measureLatency(encoding, batch, window, rateHz, count, result) ||
+        !measureThroughput(encoding, batch, window, seconds, result)) {
+      fprintf(stderr, "broker: caso %s_b%u falhou (conexao ou mensagens perdidas)\n", encodingNames[encoding], batch);
+      return 1;
+    }
+    printf("{\"bench\":\"e2e_%s_b%u\",\"platform\":\"native\",\"encoding\":\"%s\",\"batch\":%u,\"window\":%u,"
+           "\"readings\":%llu,\"messages\":%llu,\"bytes_per_reading\":%.1f,\"p50_us\":%u,\"p99_us\":%u,"
+           "\"p999_us\":%u,\"max_us\":%u,\"max_msgs_per_s\":%.0f,\"max_readings_per_s\":%.0f}\n",
+           encodingNames[encoding], batch, encodingNames[encoding], batch, window,
+           (unsigned long long)result.readings, (unsigned long long)result.messages,
+           result.readings ? (double)result.payloadBytes / result.readings : 0, result.p50Us, result.p99Us,
+           result.p999Us, result.maxUs, result.messagesPerS, result.readingsPerS);
+    fflush(stdout);
+  }
+  return 0;
+}
+
+static int usage() {
+  fprintf(stderr,
+          "uso: broker [--port n] [--quiet]\n"
+          "       broker --bench [--rate hz] [--count n] [--seconds s] [--window n]\n");
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  uint16_t port = BROKER_DEFAULT_PORT;
+  bool quiet = false;
+  bool bench = false;
+  double rateHz = BENCH_DEFAULT_RATE_HZ;
+  uint32_t count = BENCH_DEFAULT_COUNT;
+  double seconds = BENCH_DEFAULT_SECONDS;
+  unsigned window = BENCH_DEFAULT_WINDOW;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strcmp(arg, "--quiet") == 0) {
+      quiet = true;
+      continue;
+    }
+    if (strcmp(arg, "--bench") == 0) {
+      bench = true;
+      continue;
+    }
+    if (i + 1 >= argc) return usage();
+    const char* value = argv[++i];
+    if (strcmp(arg, "--port") == 0) {
+      port = (uint16_t)atoi(value);
+    } else if (strcmp(arg, "--rate") == 0) {
+      rateHz = atof(value);
+    } else if (strcmp(arg, "--count") == 0) {
+      count = (uint32_t)strtoul(value, nullptr, 10);
+    } else if (strcmp(arg, "--seconds") == 0) {
+      seconds = atof(value);
+    } else if (strcmp(arg, "--window") == 0) {
+      window = (unsigned)atoi(value);
+    } else {
+      return usage();
+    }
+  }
+  if (rateHz <= 0 || count == 0 || seconds <= 0 || window < 1 || window > MQTT_INFLIGHT_MAX) return usage();
+  return bench ? runBench(rateHz, count, seconds, (uint8_t)window) : runBroker(port, quiet);
+}
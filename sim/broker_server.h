@@ -0,0 +1,261 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "broker.h"
+
+// Broker MQTT mínimo para Linux sobre sockets de verdade: o lado broker de sim/broker.h
+// atrás de um laço de poll(), com várias conexões, para o dispositivo (comando
+// "BROKERS <ip>:<porta>") ou o cliente do firmware no host (sim/broker_main.cpp):
+//  - roteia cada PUBLISH para as conexões inscritas num filtro que casa (com + e #), no
+//    menor QoS entre o da publicação e o da inscrição, sem reenvio nem fila para quem
+//    está desconectado;
+//  - a sessão (inscrições) fica pelo client id enquanto o processo viver, então um
+//    CONNECT sem clean start volta com session present;
+//  - a função de recebimento vê cada PUBLISH com o instante (CLOCK_MONOTONIC) em que os
+//    bytes saíram do socket, antes de qualquer processamento do broker.
+// Tudo roda na thread que chama poll().
+
+#define MQTT_BROKER_BACKLOG 16
+#define MQTT_BROKER_READ_CHUNK 16384
+
+struct MqttBrokerStats {
+  uint64_t connections = 0;
+  uint64_t published = 0;   // PUBLISH recebidos
+  uint64_t delivered = 0;   // Cópias entregues aos inscritos
+  uint64_t bytes = 0;       // Payload recebido
+};
+
+inline uint64_t brokerMonotonicUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Filtro de inscrição do MQTT: "+" casa um nível e "#" (no fim) o resto
+inline bool mqttTopicMatches(const char* filter, const char* topic) {
+  for (;;) {
+    if (filter[0] == '#') return true;
+    if (filter[0] == '+') {
+      filter++;
+      while (*topic != '\0' && *topic != '/') topic++;
+    } else {
+      for (; *filter != '\0' && *filter != '/'; filter++, topic++) {
+        if (*filter != *topic) return false;
+      }
+      if (*topic != '\0' && *topic != '/') return false;
+    }
+    // Fim de nível nos dois
+    if (*filter == '\0') return *topic == '\0';
+    if (*topic == '\0') return strcmp(filter, "/#") == 0;  // "a/#" também casa "a"
+    filter++;
+    topic++;
+  }
+}
+
+class MqttBrokerServer {
+ public:
+  typedef void (*ReceiveHook)(void* context, uint64_t receivedUs, const char* clientId, const char* topic,
+                              const uint8_t* payload, size_t length);
+
+  ~MqttBrokerServer() {
+    for (size_t i = 0; i < _clients.size(); i++) ::close(_clients[i]->fd);
+    if (_listenFd >= 0) ::close(_listenFd);
+  }
+
+  // Porta 0: o sistema escolhe (port() diz qual); loopbackOnly escuta só em 127.0.0.1
+  bool listen(uint16_t port, bool loopbackOnly) {
+    _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_listenFd < 0) return false;
+    int one = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+    socklen_t length = sizeof(address);
+    if (bind(_listenFd, (struct sockaddr*)&address, sizeof(address)) != 0 || ::listen(_listenFd, MQTT_BROKER_BACKLOG) != 0 ||
+        getsockname(_listenFd, (struct sockaddr*)&address, &length) != 0) {
+      ::close(_listenFd);
+      _listenFd = -1;
+      return false;
+    }
+    _port = ntohs(address.sin_port);
+    fcntl(_listenFd, F_SETFL, O_NONBLOCK);
+    return true;
+  }
+
+  uint16_t port() const { return _port; }
+  size_t clientCount() const { return _clients.size(); }
+  const MqttBrokerStats& stats() const { return _stats; }
+
+  void setReceiveHook(ReceiveHook hook, void* context) {
+    _hook = hook;
+    _hookContext = context;
+  }
+
+  // Espera até timeoutMs por atividade e atende tudo o que estiver pronto
+  void poll(int timeoutMs) {
+    std::vector<struct pollfd> fds(1 + _clients.size());
+    fds[0].fd = _listenFd;
+    fds[0].events = POLLIN;
+    for (size_t i = 0; i < _clients.size(); i++) {
+      fds[1 + i].fd = _clients[i]->fd;
+      fds[1 + i].events = (short)(POLLIN | (_clients[i]->out.empty() ? 0 : POLLOUT));
+    }
+    if (::poll(fds.data(), fds.size(), timeoutMs) <= 0) return;
+    size_t count = _clients.size();  // accept() acrescenta no fim
+    if (fds[0].revents & POLLIN) accept();
+    for (size_t i = 0; i < count; i++) {
+      if (fds[1 + i].revents & (POLLIN | POLLHUP | POLLERR)) receive(*_clients[i]);
+    }
+    flushAll();
+    for (size_t i = 0; i < _clients.size();) {
+      Client& client = *_clients[i];
+      if (client.closing && client.out.empty()) {
+        ::close(client.fd);
+        _clients.erase(_clients.begin() + i);
+      } else {
+        i++;
+      }
+    }
+  }
+
+ private:
+  struct Client;
+
+  struct Subscription {
+    std::string filter;
+    uint8_t qos;
+  };
+
+  struct Handler {
+    MqttBrokerServer* server;
+    Client* client;
+
+    uint8_t onConnect(const char* clientId, bool cleanStart, bool& sessionPresent) {
+      std::map<std::string, std::vector<Subscription> >::iterator it = server->_sessions.find(clientId);
+      sessionPresent = !cleanStart && it != server->_sessions.end();
+      if (cleanStart) server->_sessions[clientId].clear();
+      else server->_sessions[clientId];
+      // Um segundo cliente com o mesmo id derruba o primeiro, como no MQTT
+      for (size_t i = 0; i < server->_clients.size(); i++) {
+        Client& other = *server->_clients[i];
+        if (&other != client && other.id == clientId) other.closing = true;
+      }
+      client->id = clientId;
+      return 0;
+    }
+    void onSubscribe(const char* topic, uint8_t qos) {
+      std::vector<Subscription>& subscriptions = server->_sessions[client->id];
+      for (size_t i = 0; i < subscriptions.size(); i++) {
+        if (subscriptions[i].filter == topic) {
+          subscriptions[i].qos = qos;
+          return;
+        }
+      }
+      subscriptions.push_back(Subscription{topic, qos});
+    }
+    void onPublish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool) {
+      server->route(*client, topic, payload, length, qos);
+    }
+    void onAck(uint16_t) {}
+  };
+
+  struct Client {
+    int fd;
+    std::string id;
+    std::string out;
+    uint64_t receivedUs = 0;
+    bool closing = false;
+    Handler handler;
+    MqttBrokerConnection<Handler> link;
+
+    Client(MqttBrokerServer* server, int socket) : fd(socket), handler{server, this}, link(handler) {}
+  };
+
+  void accept() {
+    for (;;) {
+      int fd = ::accept(_listenFd, nullptr, nullptr);
+      if (fd < 0) return;
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      fcntl(fd, F_SETFL, O_NONBLOCK);
+      _clients.push_back(std::unique_ptr<Client>(new Client(this, fd)));
+      _stats.connections++;
+    }
+  }
+
+  void receive(Client& client) {
+    uint8_t buffer[MQTT_BROKER_READ_CHUNK];
+    for (;;) {
+      ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+      if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        client.closing = true;
+        client.out.clear();
+        return;
+      }
+      if (n < 0) return;
+      client.receivedUs = brokerMonotonicUs();
+      if (!client.link.receive(buffer, (size_t)n, client.out)) client.closing = true;
+      if (client.closing) return;
+    }
+  }
+
+  void route(Client& from, const char* topic, const uint8_t* payload, size_t length, uint8_t qos) {
+    _stats.published++;
+    _stats.bytes += length;
+    if (_hook != nullptr) _hook(_hookContext, from.receivedUs, from.id.c_str(), topic, payload, length);
+    for (size_t i = 0; i < _clients.size(); i++) {
+      Client& client = *_clients[i];
+      if (!client.link.connected() || client.closing) continue;
+      const std::vector<Subscription>& subscriptions = _sessions[client.id];
+      for (size_t k = 0; k < subscriptions.size(); k++) {
+        if (!mqttTopicMatches(subscriptions[k].filter.c_str(), topic)) continue;
+        uint8_t granted = subscriptions[k].qos < qos ? subscriptions[k].qos : qos;
+        client.link.publish(topic, payload, length, granted, client.out);
+        _stats.delivered++;
+        break;  // Uma cópia por conexão, mesmo com filtros sobrepostos
+      }
+    }
+  }
+
+  void flushAll() {
+    for (size_t i = 0; i < _clients.size(); i++) {
+      Client& client = *_clients[i];
+      while (!client.out.empty()) {
+        ssize_t n = send(client.fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+        if (n <= 0) {
+          if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            client.out.clear();
+            client.closing = true;
+          }
+          break;
+        }
+        client.out.erase(0, (size_t)n);
+      }
+    }
+  }
+
+  int _listenFd = -1;
+  uint16_t _port = 0;
+  std::vector<std::unique_ptr<Client> > _clients;
+  std::map<std::string, std::vector<Subscription> > _sessions;  // Client id -> inscrições
+  ReceiveHook _hook = nullptr;
+  void* _hookContext = nullptr;
+  MqttBrokerStats _stats;
+};
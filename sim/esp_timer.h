@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+#include "sim.h"
+
+// esp_timer simulado: µs desde o boot no relógio virtual (sim.h)
+inline int64_t esp_timer_get_time() { return (int64_t)simNowUs(); }
@@ -0,0 +1,633 @@
+// Implementação da rede simulada (net.h): falhas, DNS e TCP até os brokers de broker.h,
+// no relógio virtual. As conexões são do boot atual (morrem com ele); sessões dos
+// brokers, estatísticas e o gerador de números aleatórios ficam na memória compartilhada.
+
+#include "net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "async_net.h"
+#include "broker.h"
+#include "sim.h"
+
+struct BrokerState {
+  char host[SIM_HOST_MAX];
+  uint8_t ip[4];
+  uint16_t port;
+  uint32_t rttMs;
+  bool session;                // Sessão do dispositivo guardada
+  char clientId[64];
+  char subscription[128];      // Tópico de comando inscrito na sessão
+};
+
+struct NetState {
+  uint64_t random;
+  size_t brokerCount;
+  BrokerState brokers[SIM_BROKERS_MAX];
+  size_t commandsAcked;        // Comandos de simQueueCommand() já confirmados
+  SimNetStats stats;
+  bool outageOpen;             // A conexão caiu e o CONNACK seguinte ainda não chegou
+  size_t outageCount;
+  SimOutage outages[SIM_OUTAGES_MAX];
+};
+
+static NetState* shared = nullptr;
+static std::vector<SimFault> faults;
+static SimPublishSink publishSink = nullptr;
+
+static NetState& net() {
+  if (shared == nullptr) {
+    shared = (NetState*)simShared(sizeof(NetState));
+    shared->random = 0x9E3779B97F4A7C15ULL;
+  }
+  return *shared;
+}
+
+// xorshift64*: perdas e jitter reproduzíveis pela semente
+static uint32_t randomU32() {
+  uint64_t& x = net().random;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+void simSetNetSeed(uint64_t seed) {
+  net().random = seed ^ 0x9E3779B97F4A7C15ULL;
+  if (net().random == 0) net().random = 1;
+}
+
+void simSetPublishSink(SimPublishSink sink) { publishSink = sink; }
+const SimNetStats& simNetStats() { return net().stats; }
+
+size_t simOutageCount() { return net().outageCount + (net().outageOpen ? 1 : 0); }
+const SimOutage& simOutageAt(size_t i) { return net().outages[i]; }
+
+void simAddBroker(const char* host, uint16_t port, uint32_t rttMs) {
+  NetState& s = net();
+  if (s.brokerCount >= SIM_BROKERS_MAX) return;
+  BrokerState& broker = s.brokers[s.brokerCount++];
+  snprintf(broker.host, sizeof(broker.host), "%s", host);
+  broker.ip[0] = 10;
+  broker.ip[1] = 1;
+  broker.ip[2] = 0;
+  broker.ip[3] = (uint8_t)s.brokerCount;
+  broker.port = port;
+  broker.rttMs = rttMs;
+}
+
+// ====== FALHAS ======
+static const char* const faultNames[] = {"latency", "loss", "refuse", "reset", "dns", "down", "blackhole", "wifi"};
+
+const char* simFaultName(SimFaultType type) { return faultNames[type]; }
+
+bool simParseFault(const char* spec, SimFault& fault) {
+  memset(&fault, 0, sizeof(fault));
+  char* end;
+  double startS = strtod(spec, &end);
+  if (end == spec || *end != ':' || startS < 0) return false;
+  const char* name = end + 1;
+  size_t nameLength = strcspn(name, "@:");
+  int type = -1;
+  for (size_t i = 0; i < sizeof(faultNames) / sizeof(faultNames[0]); i++) {
+    if (strlen(faultNames[i]) == nameLength && strncmp(name, faultNames[i], nameLength) == 0) type = (int)i;
+  }
+  if (type < 0) return false;
+  fault.type = (SimFaultType)type;
+  fault.value = type == SIM_FAULT_LATENCY ? 500 : type == SIM_FAULT_LOSS ? 10 : 0;
+  const char* p = name + nameLength;
+  if (*p == '@') {
+    size_t hostLength = strcspn(p + 1, ":");
+    if (hostLength == 0 || hostLength >= SIM_HOST_MAX) return false;
+    memcpy(fault.host, p + 1, hostLength);
+    p += 1 + hostLength;
+  }
+  double durationS = type == SIM_FAULT_RESET ? 0 : SIM_FAULT_DEFAULT_S;
+  if (*p == ':') {
+    durationS = strtod(p + 1, &end);
+    if (end == p + 1 || durationS < 0) return false;
+    p = end;
+  }
+  if (*p == ':') {
+    fault.value = (uint32_t)strtoul(p + 1, &end, 10);
+    if (end == p + 1) return false;
+    p = end;
+  }
+  if (*p != '\0') return false;
+  fault.startUs = (uint64_t)(startS * 1e6);
+  fault.endUs = fault.startUs + (type == SIM_FAULT_RESET ? 0 : (uint64_t)(durationS * 1e6));
+  return true;
+}
+
+void simAddFault(const SimFault& fault) { faults.push_back(fault); }
+size_t simFaultCount() { return faults.size(); }
+const SimFault& simFaultAt(size_t i) { return faults[i]; }
+
+static bool hits(const SimFault& fault, const char* host) {
+  return fault.type == SIM_FAULT_WIFI || fault.host[0] == '\0' || strcmp(fault.host, host) == 0;
+}
+
+static bool active(const SimFault& fault, SimFaultType type, const char* host, uint64_t atUs) {
+  return fault.type == type && atUs >= fault.startUs && atUs < fault.endUs && hits(fault, host);
+}
+
+static bool anyActive(SimFaultType type, const char* host, uint64_t atUs) {
+  for (size_t i = 0; i < faults.size(); i++) {
+    if (active(faults[i], type, host, atUs)) return true;
+  }
+  return false;
+}
+
+static bool wifiDown(uint64_t atUs) { return anyActive(SIM_FAULT_WIFI, "", atUs); }
+
+static uint32_t lossPercent(const BrokerState& broker, uint64_t atUs) {
+  uint32_t percent = 0;
+  for (size_t i = 0; i < faults.size(); i++) {
+    if (active(faults[i], SIM_FAULT_LOSS, broker.host, atUs)) percent = std::max(percent, faults[i].value);
+  }
+  return percent;
+}
+
+static uint64_t extraLatencyUs(const BrokerState& broker, uint64_t atUs) {
+  uint64_t extra = 0;
+  for (size_t i = 0; i < faults.size(); i++) {
+    if (active(faults[i], SIM_FAULT_LATENCY, broker.host, atUs)) extra += (uint64_t)faults[i].value * 1000;
+  }
+  return extra;
+}
+
+// Primeira falha que derruba conexões abertas (reset, down, wifi) em (fromUs, toUs]
+static bool firstReset(const BrokerState& broker, uint64_t fromUs, uint64_t toUs, uint64_t& atUs) {
+  bool found = false;
+  for (size_t i = 0; i < faults.size(); i++) {
+    const SimFault& fault = faults[i];
+    if (fault.type != SIM_FAULT_RESET && fault.type != SIM_FAULT_DOWN && fault.type != SIM_FAULT_WIFI) continue;
+    if (fault.startUs <= fromUs || fault.startUs > toUs || !hits(fault, broker.host)) continue;
+    if (!found || fault.startUs < atUs) atUs = fault.startUs;
+    found = true;
+  }
+  return found;
+}
+
+// Chegada de um segmento enviado em sendUs: perdas e buraco negro custam retransmissões
+// (RTO dobrando); false se elas esgotarem SIM_TCP_GIVEUP_US
+static bool arrival(const BrokerState& broker, uint64_t sendUs, uint64_t& atUs) {
+  uint64_t t = sendUs;
+  uint64_t rto = SIM_TCP_RTO_US;
+  for (;;) {
+    uint32_t loss = lossPercent(broker, t);
+    bool lost = anyActive(SIM_FAULT_BLACKHOLE, broker.host, t) || wifiDown(t) || (loss > 0 && randomU32() % 100 < loss);
+    if (!lost) break;
+    t += rto;
+    rto = std::min(rto * 2, (uint64_t)SIM_TCP_RTO_MAX_US);
+    if (t - sendUs > SIM_TCP_GIVEUP_US) return false;
+  }
+  uint64_t half = (uint64_t)broker.rttMs * 500;
+  uint64_t jitter = half / 10;
+  atUs = t + half - jitter + (jitter > 0 ? randomU32() % (2 * jitter + 1) : 0) + extraLatencyUs(broker, t);
+  return true;
+}
+
+// ====== QUEDAS ======
+static void connectionLost(uint64_t atUs) {
+  NetState& s = net();
+  if (s.outageOpen || s.outageCount >= SIM_OUTAGES_MAX) return;
+  s.outages[s.outageCount].lostUs = atUs;
+  s.outages[s.outageCount].connackUs = 0;
+  s.outageOpen = true;
+}
+
+static void connackArrived(uint64_t atUs) {
+  NetState& s = net();
+  if (!s.outageOpen) return;
+  s.outages[s.outageCount++].connackUs = atUs;
+  s.outageOpen = false;
+}
+
+// ====== CONEXÕES ======
+struct Connection;
+
+// Lado broker de uma conexão (Handler de MqttBrokerConnection)
+struct LinkHandler {
+  Connection* connection;
+  uint8_t onConnect(const char* clientId, bool cleanStart, bool& sessionPresent);
+  void onSubscribe(const char* topic, uint8_t qos);
+  void onPublish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool dup);
+  void onAck(uint16_t packetId);
+};
+
+struct Segment {
+  uint64_t atUs;
+  std::string data;
+};
+
+struct Connection {
+  int broker;
+  uint64_t openedUs;
+  uint64_t deadUs = UINT64_MAX;  // RST ou desistência: a conexão morre neste instante
+  uint64_t finUs = UINT64_MAX;   // O broker fechou: o dispositivo vê o fim depois dos dados
+  bool dead = false;
+  bool closedByClient = false;   // stop(): o que já foi escrito ainda chega ao broker
+  uint64_t lastUp = 0;           // TCP: cada sentido entrega em ordem
+  uint64_t lastDown = 0;
+  std::deque<Segment> up;        // Dispositivo -> broker
+  std::deque<Segment> down;      // Broker -> dispositivo
+  size_t downRead = 0;           // Bytes já lidos do primeiro segmento de down
+  uint64_t brokerNowUs = 0;      // Chegada do segmento que o broker está processando
+  uint64_t readyUs = UINT64_MAX; // Sessão pronta para receber comandos
+  uint16_t commandPacketId = 0;  // Comando em voo, até o PUBACK
+  LinkHandler handler;
+  MqttBrokerConnection<LinkHandler> link;
+
+  Connection() : handler{this}, link(handler) {}
+};
+
+static std::map<int, std::unique_ptr<Connection> > connections;
+static int nextConnectionId = 0;
+
+static BrokerState& brokerOf(const Connection& connection) { return net().brokers[connection.broker]; }
+
+uint8_t LinkHandler::onConnect(const char* clientId, bool cleanStart, bool& sessionPresent) {
+  BrokerState& broker = brokerOf(*connection);
+  SimNetStats& stats = net().stats;
+  if (anyActive(SIM_FAULT_REFUSE, broker.host, connection->brokerNowUs)) {
+    stats.refusals++;
+    return MQTT_CONNACK_UNAVAILABLE_V5;
+  }
+  sessionPresent = !cleanStart && broker.session && strcmp(broker.clientId, clientId) == 0;
+  if (!sessionPresent) {
+    snprintf(broker.clientId, sizeof(broker.clientId), "%s", clientId);
+    broker.subscription[0] = '\0';
+  }
+  broker.session = true;  // Sem expiração no simulador
+  stats.connacks++;
+  if (sessionPresent) {
+    stats.sessionsResumed++;
+    connection->readyUs = connection->brokerNowUs;
+  }
+  return 0;
+}
+
+void LinkHandler::onSubscribe(const char* topic, uint8_t) {
+  snprintf(brokerOf(*connection).subscription, sizeof(BrokerState::subscription), "%s", topic);
+  if (connection->readyUs == UINT64_MAX) connection->readyUs = connection->brokerNowUs;
+}
+
+void LinkHandler::onPublish(const char* topic, const uint8_t* payload, size_t length, uint8_t, bool) {
+  if (publishSink != nullptr) publishSink(connection->brokerNowUs, brokerOf(*connection).host, topic, payload, length);
+}
+
+void LinkHandler::onAck(uint16_t packetId) {
+  if (packetId == 0 || packetId != connection->commandPacketId) return;
+  connection->commandPacketId = 0;
+  net().commandsAcked++;
+  net().stats.commandsDelivered++;
+}
+
+// Enfileira bytes do broker para o dispositivo; retorna a chegada (0 se a conexão desistiu)
+static uint64_t sendDown(Connection& connection, uint64_t sendUs, const std::string& data) {
+  uint64_t atUs;
+  if (!arrival(brokerOf(connection), sendUs, atUs)) {
+    connection.deadUs = std::min(connection.deadUs, sendUs + SIM_TCP_GIVEUP_US);
+    return 0;
+  }
+  atUs = std::max(atUs, connection.lastDown);
+  connection.lastDown = atUs;
+  connection.down.push_back(Segment{atUs, data});
+  return atUs;
+}
+
+static void kill(Connection& connection) {
+  if (!connection.closedByClient) {
+    net().stats.resets++;
+    if (connection.link.connected()) connectionLost(connection.deadUs);
+  }
+  connection.dead = true;
+  connection.up.clear();
+  connection.down.clear();
+}
+
+// Próximo comando, quando a sessão do dispositivo está pronta e não há outro em voo
+static void deliverCommand(Connection& connection, uint64_t nowUs) {
+  NetState& s = net();
+  BrokerState& broker = brokerOf(connection);
+  if (!connection.link.connected() || connection.link.closed() || connection.commandPacketId != 0) return;
+  if (s.commandsAcked >= simCommandCount() || broker.subscription[0] == '\0') return;
+  SimCommand command = simCommandAt(s.commandsAcked);
+  uint64_t sendUs = std::max(command.atUs, connection.readyUs);
+  if (sendUs > nowUs) return;
+  std::string out;
+  connection.commandPacketId = connection.link.publish(broker.subscription, command.data, command.length, 1, out);
+  if (!out.empty()) sendDown(connection, sendUs, out);
+}
+
+// Leva a conexão até o instante atual: falhas que a derrubam e segmentos que já chegaram
+// ao broker (processados na ordem, no instante da chegada)
+static void pump(Connection& connection, uint64_t nowUs) {
+  if (connection.dead) return;
+  uint64_t resetUs;
+  if (firstReset(brokerOf(connection), connection.openedUs, nowUs, resetUs)) {
+    connection.deadUs = std::min(connection.deadUs, resetUs);
+  }
+  while (!connection.up.empty() && connection.up.front().atUs <= nowUs && connection.up.front().atUs < connection.deadUs) {
+    Segment segment = connection.up.front();
+    connection.up.pop_front();
+    if (connection.link.closed()) continue;
+    std::string out;
+    connection.brokerNowUs = segment.atUs;
+    bool wasConnected = connection.link.connected();
+    bool open = connection.link.receive((const uint8_t*)segment.data.data(), segment.data.size(), out);
+    uint64_t outAt = out.empty() ? 0 : sendDown(connection, segment.atUs, out);
+    if (!wasConnected && connection.link.connected() && outAt != 0) connackArrived(outAt);
+    if (!open) {
+      connection.finUs = std::max(connection.lastDown, segment.atUs + (uint64_t)brokerOf(connection).rttMs * 500);
+    }
+  }
+  if (!connection.closedByClient) deliverCommand(connection, nowUs);
+  if (connection.deadUs <= nowUs) kill(connection);
+}
+
+// Toda chamada do dispositivo atualiza todas as conexões: as fechadas por ele só saem
+// da tabela depois de entregar o que ainda estava a caminho
+static void pumpAll() {
+  uint64_t nowUs = simNowUs();
+  for (std::map<int, std::unique_ptr<Connection> >::iterator it = connections.begin(); it != connections.end();) {
+    Connection& connection = *it->second;
+    pump(connection, nowUs);
+    if (connection.dead || (connection.closedByClient && connection.up.empty())) {
+      it = connections.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+static Connection* find(int id) {
+  std::map<int, std::unique_ptr<Connection> >::iterator it = connections.find(id);
+  return it == connections.end() || it->second->closedByClient ? nullptr : it->second.get();
+}
+
+static size_t readable(const Connection& connection, uint64_t nowUs) {
+  size_t n = 0;
+  for (size_t i = 0; i < connection.down.size() && connection.down[i].atUs <= nowUs; i++) {
+    n += connection.down[i].data.size();
+  }
+  return n - connection.downRead;
+}
+
+static bool parseIp(const char* text, uint8_t ip[4]) {
+  unsigned a, b, c, d;
+  char extra;
+  if (sscanf(text, "%u.%u.%u.%u%c", &a, &b, &c, &d, &extra) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+    return false;
+  }
+  ip[0] = (uint8_t)a;
+  ip[1] = (uint8_t)b;
+  ip[2] = (uint8_t)c;
+  ip[3] = (uint8_t)d;
+  return true;
+}
+
+// ====== API DOS HEADERS SIMULADOS ======
+bool simWifiUp() { return !wifiDown(simNowUs()); }
+bool simUdpSend() { return simWifiUp(); }
+
+bool simResolve(const char* host, uint8_t ip[4]) {
+  if (parseIp(host, ip)) return true;
+  NetState& s = net();
+  if (!simWifiUp()) {
+    s.stats.dnsFailures++;
+    return false;
+  }
+  if (anyActive(SIM_FAULT_DNS, host, simNowUs())) {
+    s.stats.dnsFailures++;
+    simAdvanceUs(SIM_DNS_TIMEOUT_US);
+    return false;
+  }
+  simAdvanceUs(SIM_RESOLVER_RTT_US);
+  for (size_t i = 0; i < s.brokerCount; i++) {
+    if (strcmp(s.brokers[i].host, host) == 0) {
+      memcpy(ip, s.brokers[i].ip, 4);
+      return true;
+    }
+  }
+  s.stats.dnsFailures++;  // NXDOMAIN
+  return false;
+}
+
+int simTcpConnect(const char* host, uint16_t port, uint32_t timeoutMs) {
+  NetState& s = net();
+  pumpAll();
+  uint8_t ip[4];
+  if (!simWifiUp() || !simResolve(host, ip)) {
+    s.stats.tcpFailures++;
+    return -1;
+  }
+  int index = -1;
+  for (size_t i = 0; i < s.brokerCount; i++) {
+    if (memcmp(s.brokers[i].ip, ip, 4) == 0 && s.brokers[i].port == port) index = (int)i;
+  }
+  uint64_t startUs = simNowUs();
+  uint64_t timeoutUs = (uint64_t)timeoutMs * 1000;
+  uint64_t synUs, answerUs;
+  const BrokerState* broker = index >= 0 ? &s.brokers[index] : nullptr;
+  // SYN e a resposta (SYN-ACK, ou RST com a porta fechada); ninguém no endereço: timeout
+  if (broker == nullptr || !arrival(*broker, startUs, synUs) || !arrival(*broker, synUs, answerUs) ||
+      answerUs - startUs > timeoutUs) {
+    s.stats.tcpFailures++;
+    simAdvanceUs(timeoutUs);
+    return -1;
+  }
+  simAdvanceUs(answerUs - startUs);
+  if (anyActive(SIM_FAULT_DOWN, broker->host, synUs)) {
+    s.stats.tcpFailures++;
+    return -1;
+  }
+  s.stats.tcpConnects++;
+  int id = nextConnectionId++;
+  std::unique_ptr<Connection> connection(new Connection());
+  connection->broker = index;
+  connection->openedUs = answerUs;
+  connection->lastUp = connection->lastDown = answerUs;
+  connections[id] = std::move(connection);
+  return id;
+}
+
+bool simTcpConnected(int id) {
+  pumpAll();
+  Connection* connection = find(id);
+  if (connection == nullptr || connection->dead) return false;
+  uint64_t nowUs = simNowUs();
+  return !(connection->finUs <= nowUs && readable(*connection, nowUs) == 0);
+}
+
+int simTcpAvailable(int id) {
+  pumpAll();
+  Connection* connection = find(id);
+  size_t n = connection != nullptr ? readable(*connection, simNowUs()) : 0;
+  if (n == 0) simBusyUs(SIM_POLL_US);
+  return (int)n;
+}
+
+int simTcpRead(int id, uint8_t* buffer, size_t length) {
+  pumpAll();
+  Connection* connection = find(id);
+  if (connection == nullptr) return -1;
+  uint64_t nowUs = simNowUs();
+  size_t n = 0;
+  while (n < length && !connection->down.empty() && connection->down.front().atUs <= nowUs) {
+    const std::string& data = connection->down.front().data;
+    size_t chunk = std::min(length - n, data.size() - connection->downRead);
+    memcpy(buffer + n, data.data() + connection->downRead, chunk);
+    n += chunk;
+    connection->downRead += chunk;
+    if (connection->downRead == data.size()) {
+      connection->down.pop_front();
+      connection->downRead = 0;
+    }
+  }
+  return n > 0 ? (int)n : -1;
+}
+
+size_t simTcpWrite(int id, const uint8_t* data, size_t length) {
+  pumpAll();
+  Connection* connection = find(id);
+  if (connection == nullptr || connection->dead) return 0;
+  uint64_t nowUs = simNowUs();
+  uint64_t atUs;
+  if (!arrival(brokerOf(*connection), nowUs, atUs)) {
+    connection->deadUs = std::min(connection->deadUs, nowUs + SIM_TCP_GIVEUP_US);
+    return length;  // Aceito no buffer de envio; a conexão morre depois
+  }
+  atUs = std::max(atUs, connection->lastUp);
+  connection->lastUp = atUs;
+  connection->up.push_back(Segment{atUs, std::string((const char*)data, length)});
+  return length;
+}
+
+void simTcpClose(int id) {
+  pumpAll();
+  Connection* connection = find(id);
+  if (connection == nullptr) return;
+  if (connection->link.connected()) connectionLost(simNowUs());
+  connection->closedByClient = true;
+  pumpAll();
+}
+
+void simNetReboot() {
+  pumpAll();
+  for (std::map<int, std::unique_ptr<Connection> >::iterator it = connections.begin(); it != connections.end(); ++it) {
+    Connection& connection = *it->second;
+    if (!connection.closedByClient && connection.link.connected()) {
+      connectionLost(simNowUs());
+    }
+  }
+}
+
+// ====== DNS E PROBE SEM BLOQUEIO (async_net.h) ======
+// A resposta fica pronta num instante virtual e o loop() segue enquanto isso, como com a
+// task do lwIP no ESP32
+struct PendingQuery {
+  char host[SIM_HOST_MAX];
+  uint64_t readyUs;
+  bool timeout;                // O resolvedor não responde: falha depois de SIM_DNS_TIMEOUT_US
+  bool active;
+};
+
+static PendingQuery query = {};
+
+ResolveStatus netResolve(const char* host, uint8_t address[4]) {
+  if (parseIp(host, address)) return RESOLVE_OK;
+  NetState& s = net();
+  uint64_t nowUs = simNowUs();
+  if (!query.active) {
+    if (!simWifiUp()) {
+      s.stats.dnsFailures++;
+      return RESOLVE_FAILED;
+    }
+    snprintf(query.host, sizeof(query.host), "%s", host);
+    query.timeout = anyActive(SIM_FAULT_DNS, host, nowUs);
+    query.readyUs = nowUs + (query.timeout ? SIM_DNS_TIMEOUT_US : SIM_RESOLVER_RTT_US);
+    query.active = true;
+  }
+  if (strcmp(query.host, host) != 0 || nowUs < query.readyUs) return RESOLVE_PENDING;
+  query.active = false;
+  if (!query.timeout) {
+    for (size_t i = 0; i < s.brokerCount; i++) {
+      if (strcmp(s.brokers[i].host, host) == 0) {
+        memcpy(address, s.brokers[i].ip, 4);
+        return RESOLVE_OK;
+      }
+    }
+  }
+  s.stats.dnsFailures++;
+  return RESOLVE_FAILED;
+}
+
+// Handshake de um probe: pronto em readyUs (UINT64_MAX se o SYN ou a resposta nunca chegam)
+struct PendingProbe {
+  uint64_t readyUs;
+  bool accepted;               // SYN-ACK; senão RST
+  bool counted;
+};
+
+static std::map<int, PendingProbe> probes;
+
+bool TcpProbe::start(const char* ip, uint16_t port) {
+  stop();
+  NetState& s = net();
+  uint8_t address[4];
+  if (!simWifiUp() || !parseIp(ip, address)) {
+    s.stats.tcpFailures++;
+    return false;
+  }
+  const BrokerState* broker = nullptr;
+  for (size_t i = 0; i < s.brokerCount; i++) {
+    if (memcmp(s.brokers[i].ip, address, 4) == 0 && s.brokers[i].port == port) broker = &s.brokers[i];
+  }
+  PendingProbe probe = {UINT64_MAX, false, false};
+  uint64_t startUs = simNowUs();
+  uint64_t synUs, answerUs;
+  if (broker != nullptr && arrival(*broker, startUs, synUs) && arrival(*broker, synUs, answerUs)) {
+    probe.readyUs = answerUs;
+    probe.accepted = !anyActive(SIM_FAULT_DOWN, broker->host, synUs);
+  }
+  _fd = nextConnectionId++;
+  probes[_fd] = probe;
+  return true;
+}
+
+int TcpProbe::poll() {
+  std::map<int, PendingProbe>::iterator it = probes.find(_fd);
+  if (it == probes.end()) return -1;
+  PendingProbe& probe = it->second;
+  if (simNowUs() < probe.readyUs) {
+    simBusyUs(SIM_POLL_US);
+    return 0;
+  }
+  if (!probe.counted) {
+    probe.counted = true;
+    if (probe.accepted) {
+      net().stats.tcpConnects++;
+    } else {
+      net().stats.tcpFailures++;
+    }
+  }
+  return probe.accepted ? 1 : -1;
+}
+
+void TcpProbe::stop() {
+  std::map<int, PendingProbe>::iterator it = probes.find(_fd);
+  if (it != probes.end()) {
+    if (!it->second.counted) net().stats.tcpFailures++;  // Desistiu antes da resposta
+    probes.erase(it);
+  }
+  _fd = -1;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Rede simulada (sim.h) entre o dispositivo e os brokers MQTT de sim/broker.h, no relógio
+// virtual e com falhas injetadas em instantes marcados:
+//  - cada broker tem um host, um IP (10.1.0.x), uma porta e o RTT base; o DNS resolve os
+//    hosts cadastrados (~1 RTT do resolvedor) e o TCP entrega os bytes em ordem, com
+//    metade do RTT (±10%) por sentido;
+//  - um segmento perdido é retransmitido depois do RTO (1 s, dobrando até 60 s), como no
+//    lwIP; se nada passa por SIM_TCP_GIVEUP_US a conexão é desfeita;
+//  - o connect() espera o handshake no relógio virtual (CPU parada) até o timeout do
+//    chamador; available() sem dados custa SIM_POLL_US de CPU, que é o que um laço de
+//    espera do firmware gasta de verdade;
+//  - netResolve() e o TcpProbe (async_net.h) não param a CPU: a resposta fica pronta no
+//    instante virtual em que chegaria e o loop() segue enquanto isso;
+//  - a sessão de cada broker (cliente, inscrição) sobrevive aos boots do dispositivo e os
+//    comandos de simQueueCommand() são publicados com QoS 1 no tópico inscrito, um por
+//    vez, até o PUBACK (com a sessão persistente o broker entrega os pendentes na volta).
+//
+// Falhas ("<s>:<tipo>[@host][:<duração_s>[:<valor>]]", sem host valem para todos os brokers;
+// duração padrão SIM_FAULT_DEFAULT_S):
+//   latency    +valor ms por sentido (padrão 500)
+//   loss       valor % dos segmentos perdidos (padrão 10)
+//   refuse     o broker aceita o TCP e recusa o CONNECT (Server unavailable)
+//   reset      RST nas conexões abertas no instante (sem duração)
+//   dns        o resolvedor não responde (SIM_DNS_TIMEOUT_US por consulta)
+//   down       RST nas conexões abertas e em cada SYN (porta fechada)
+//   blackhole  nada passa nem volta: só retransmissões e timeouts
+//   wifi       a estação perde o AP: WiFi.status() desconectado, conexões desfeitas
+
+#define SIM_HOST_MAX 64
+#define SIM_BROKERS_MAX 8
+#define SIM_TCP_CONNECT_TIMEOUT_MS 3000   // WiFiClient::connect() sem timeout (arduino-esp32)
+#define SIM_TCP_RTO_US 1000000
+#define SIM_TCP_RTO_MAX_US 60000000
+#define SIM_TCP_GIVEUP_US 120000000       // Retransmissões sem resposta antes de desistir
+#define SIM_DNS_TIMEOUT_US 5000000
+#define SIM_RESOLVER_RTT_US 30000
+#define SIM_POLL_US 20                    // available() sem dados
+#define SIM_OUTAGES_MAX 4096
+#define SIM_FAULT_DEFAULT_S 60
+
+enum SimFaultType {
+  SIM_FAULT_LATENCY,
+  SIM_FAULT_LOSS,
+  SIM_FAULT_REFUSE,
+  SIM_FAULT_RESET,
+  SIM_FAULT_DNS,
+  SIM_FAULT_DOWN,
+  SIM_FAULT_BLACKHOLE,
+  SIM_FAULT_WIFI,
+};
+
+struct SimFault {
+  SimFaultType type;
+  uint64_t startUs;
+  uint64_t endUs;             // reset: igual ao início
+  uint32_t value;
+  char host[SIM_HOST_MAX];    // Vazio: todos os brokers
+};
+
+// Lê a especificação da linha de comando; false se for inválida
+bool simParseFault(const char* spec, SimFault& fault);
+const char* simFaultName(SimFaultType type);
+void simAddFault(const SimFault& fault);
+size_t simFaultCount();
+const SimFault& simFaultAt(size_t i);
+
+// Cadastra um broker; os cadastrados antes do primeiro boot valem em todos
+void simAddBroker(const char* host, uint16_t port, uint32_t rttMs);
+// Semente das perdas e do jitter
+void simSetNetSeed(uint64_t seed);
+
+// Mensagem recebida por um broker, no instante virtual da chegada
+typedef void (*SimPublishSink)(uint64_t atUs, const char* broker, const char* topic, const uint8_t* payload,
+                               size_t length);
+void simSetPublishSink(SimPublishSink sink);
+
+struct SimNetStats {
+  uint32_t tcpConnects;        // Handshakes completos
+  uint32_t tcpFailures;        // SYN sem resposta, RST ou sem rota
+  uint32_t resets;             // Conexões abertas desfeitas pela rede
+  uint32_t dnsFailures;
+  uint32_t connacks;           // CONNECT aceitos
+  uint32_t refusals;
+  uint32_t sessionsResumed;    // CONNACK com sessão presente
+  uint32_t commandsDelivered;  // Comandos confirmados com PUBACK
+};
+const SimNetStats& simNetStats();
+
+// Quedas da conexão MQTT aceita: quando ela caiu (na rede ou fechada pelo dispositivo) e
+// quando o CONNACK seguinte chegou ao dispositivo (0 se não voltou até o fim)
+struct SimOutage {
+  uint64_t lostUs;
+  uint64_t connackUs;
+};
+size_t simOutageCount();
+const SimOutage& simOutageAt(size_t i);
+
+// ====== USADOS PELOS HEADERS SIMULADOS ======
+bool simWifiUp();
+void simNetReboot();  // ESP.restart(): as conexões do boot morrem com ele
+bool simResolve(const char* host, uint8_t ip[4]);
+bool simUdpSend();  // false com o WiFi fora
+int simTcpConnect(const char* host, uint16_t port, uint32_t timeoutMs);  // id da conexão ou -1
+bool simTcpConnected(int id);
+int simTcpAvailable(int id);
+int simTcpRead(int id, uint8_t* buffer, size_t length);
+size_t simTcpWrite(int id, const uint8_t* data, size_t length);
+void simTcpClose(int id);
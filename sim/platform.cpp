@@ -0,0 +1,406 @@
+// Implementação da plataforma simulada (sim.h) e dos módulos do firmware que dependem do
+// ESP-IDF e por isso ficam fora da build do replay: clock.cpp, boot_image.cpp e a parte
+// de captura do capture.cpp (que entra, sem ARDUINO, só com a montagem dos quadros).
+// O estado que sobrevive a um reinício (relógio, NVS) mora na memória compartilhada; o
+// resto é global comum, que cada boot recebe do driver pelo fork().
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "boot_image.h"
+#include "capture.h"
+#include "clock.h"
+#include "net.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+
+// ====== MEMÓRIA COMPARTILHADA ======
+// Reservada sem ocupar: as páginas só existem quando usadas
+#define SIM_SHARED_BYTES ((size_t)1 << 30)
+#define SIM_NVS_ENTRIES 64
+#define SIM_NVS_VALUE_MAX 512          // Maior valor que o firmware grava (lista de brokers)
+#define SIM_EXIT_RESTART 100           // Códigos de saída de um boot para o simRun()
+#define SIM_EXIT_END 101
+
+static uint8_t* arena = nullptr;
+
+void* simShared(size_t size) {
+  if (arena == nullptr) {
+    arena = (uint8_t*)mmap(nullptr, SIM_SHARED_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE,
+                           -1, 0);
+    if (arena == MAP_FAILED) {
+      perror("sim: mmap");
+      abort();
+    }
+    *(size_t*)arena = 64;
+  }
+  size_t& used = *(size_t*)arena;
+  size = (size + 63) & ~(size_t)63;
+  if (used + size > SIM_SHARED_BYTES) {
+    fprintf(stderr, "sim: memoria compartilhada esgotada (%zu bytes pedidos)\n", size);
+    abort();
+  }
+  void* block = arena + used;
+  used += size;
+  return block;
+}
+
+struct NvsEntry {
+  bool used;
+  char ns[16];                         // Limites de nome da NVS: 15 caracteres
+  char key[16];
+  uint16_t length;
+  uint8_t value[SIM_NVS_VALUE_MAX];
+};
+
+// O que sobrevive a um ESP.restart()
+struct PlatformState {
+  uint64_t nowUs;
+  uint64_t endUs;
+  uint64_t activeUs;
+  uint32_t* activePerSecond;           // CPU ocupada em cada segundo virtual (µs)
+  size_t activeSeconds;
+  uint32_t boots;
+  uint64_t loops;
+  unsigned long long wallStartMs;
+  size_t commandsRead;                 // Comandos já lidos pelo WiFiUDP
+  NvsEntry nvs[SIM_NVS_ENTRIES];
+};
+
+static PlatformState* platform = nullptr;
+
+static PlatformState& state() {
+  if (platform == nullptr) platform = (PlatformState*)simShared(sizeof(PlatformState));
+  return *platform;
+}
+
+// ====== BOOTS ======
+static uint64_t bootStartedUs = 0;
+
+[[noreturn]] static void endBoot(int code) {
+  fflush(nullptr);
+  _exit(code);
+}
+
+SimRunStats simRun(void (*setupFn)(), void (*loopFn)(), uint64_t endUs, uint64_t loopUs) {
+  PlatformState& s = state();
+  SimRunStats stats = {};
+  s.endUs = endUs;
+  s.activeSeconds = (size_t)(endUs / 1000000) + 1;
+  s.activePerSecond = (uint32_t*)simShared(s.activeSeconds * sizeof(uint32_t));
+  while (s.nowUs < endUs) {
+    fflush(nullptr);  // Nada do driver pode sair duplicado pelos buffers do filho
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("sim: fork");
+      stats.crashed = true;
+      break;
+    }
+    if (pid == 0) {
+      s.boots++;
+      bootStartedUs = s.nowUs;
+      setupFn();
+      for (;;) {
+        loopFn();
+        s.loops++;
+        simBusyUs(loopUs);
+      }
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (WIFEXITED(status) && WEXITSTATUS(status) == SIM_EXIT_RESTART) {
+      s.nowUs = std::min(s.nowUs + SIM_BOOT_US, endUs);
+      continue;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != SIM_EXIT_END) {
+      if (WIFSIGNALED(status)) {
+        fprintf(stderr, "sim: boot %u terminou com o sinal %d em t=%.3f s\n", s.boots, WTERMSIG(status), s.nowUs * 1e-6);
+      } else {
+        fprintf(stderr, "sim: boot %u saiu com %d em t=%.3f s\n", s.boots, WEXITSTATUS(status), s.nowUs * 1e-6);
+      }
+      stats.crashed = true;
+    }
+    break;
+  }
+  stats.boots = s.boots;
+  stats.loops = s.loops;
+  return stats;
+}
+
+// ====== RELÓGIO ======
+static bool ntpConfigured = false;
+
+uint64_t simNowUs() { return state().nowUs; }
+
+// O boot acaba quando o relógio chega ao fim, onde quer que o firmware esteja (inclusive
+// num laço bloqueante como a conexão WiFi do setup())
+void simAdvanceUs(uint64_t us) {
+  PlatformState& s = state();
+  s.nowUs += us;
+  if (s.nowUs >= s.endUs) {
+    s.nowUs = s.endUs;
+    endBoot(SIM_EXIT_END);
+  }
+}
+
+void simBusyUs(uint64_t us) {
+  PlatformState& s = state();
+  s.activeUs += us;
+  if (s.activePerSecond != nullptr) s.activePerSecond[std::min((size_t)(s.nowUs / 1000000), s.activeSeconds - 1)] += us;
+  simAdvanceUs(us);
+}
+
+uint64_t simActiveUs() { return state().activeUs; }
+
+uint64_t simActiveUsBetween(uint64_t fromUs, uint64_t toUs) {
+  PlatformState& s = state();
+  uint64_t total = 0;
+  for (size_t i = (size_t)(fromUs / 1000000); i < s.activeSeconds && i * 1000000 < toUs; i++) {
+    total += s.activePerSecond[i];
+  }
+  return total;
+}
+
+void simSetWallStart(unsigned long long unixMs) { state().wallStartMs = unixMs; }
+unsigned long long simWallStart() { return state().wallStartMs; }
+
+void configTime(long, int, const char*, const char*, const char*) { ntpConfigured = true; }
+
+// clock.h: o mesmo contrato do src/clock.cpp, com o NTP trocado pelo relógio virtual
+static WallClockSource wallClockSource = nullptr;
+
+void setWallClockSource(WallClockSource source) { wallClockSource = source; }
+
+unsigned long long getUnixTimestampMillis() {
+  if (wallClockSource != nullptr) {
+    unsigned long long synced = wallClockSource();
+    if (synced != 0) return synced;
+  }
+  if (!ntpConfigured) return 0;
+  return state().wallStartMs + state().nowUs / 1000;
+}
+
+// ====== PINOS E ADC ======
+static SimAdcSource adcSource = nullptr;
+static uint8_t pinLevels[64];
+static bool pinForced[64];
+
+void simSetAdcSource(SimAdcSource source) { adcSource = source; }
+
+void simSetPin(uint8_t pin, uint8_t level) {
+  if (pin >= sizeof(pinLevels)) return;
+  pinLevels[pin] = level;
+  pinForced[pin] = true;
+}
+
+int simAnalogRead(uint8_t pin) { return adcSource != nullptr ? adcSource(pin, simNowUs()) : 0; }
+
+int simDigitalRead(uint8_t pin) {
+  if (pin >= sizeof(pinLevels)) return LOW;
+  return pinForced[pin] ? pinLevels[pin] : HIGH;
+}
+
+void simPinMode(uint8_t, uint8_t) {}
+
+void simDigitalWrite(uint8_t pin, uint8_t level) {
+  if (pin < sizeof(pinLevels) && !pinForced[pin]) pinLevels[pin] = level;
+}
+
+// ====== SERIAL E REINÍCIO ======
+static FILE* serialOutput = nullptr;
+
+void simSetSerialOutput(FILE* out) { serialOutput = out; }
+bool simSerialEnabled() { return serialOutput != nullptr; }
+
+size_t simSerialWrite(const uint8_t* data, size_t length) {
+  if (serialOutput == nullptr) return length;
+  return fwrite(data, 1, length, serialOutput);
+}
+
+void simRestart() {
+  simNetReboot();
+  endBoot(SIM_EXIT_RESTART);
+}
+
+// ====== NVS ======
+static NvsEntry* findPreference(const char* ns, const char* key) {
+  PlatformState& s = state();
+  for (size_t i = 0; i < SIM_NVS_ENTRIES; i++) {
+    NvsEntry& entry = s.nvs[i];
+    if (entry.used && strcmp(entry.ns, ns) == 0 && strcmp(entry.key, key) == 0) return &entry;
+  }
+  return nullptr;
+}
+
+// Como na NVS: nomes de até 15 caracteres; sem espaço, nada é gravado
+static size_t putPreference(const char* ns, const char* key, const void* value, size_t length) {
+  if (strlen(ns) >= sizeof(NvsEntry::ns) || strlen(key) >= sizeof(NvsEntry::key) || length > SIM_NVS_VALUE_MAX) {
+    return 0;
+  }
+  NvsEntry* entry = findPreference(ns, key);
+  for (size_t i = 0; entry == nullptr && i < SIM_NVS_ENTRIES; i++) {
+    if (!state().nvs[i].used) entry = &state().nvs[i];
+  }
+  if (entry == nullptr) return 0;
+  entry->used = true;
+  strcpy(entry->ns, ns);
+  strcpy(entry->key, key);
+  entry->length = (uint16_t)length;
+  memcpy(entry->value, value, length);
+  return length;
+}
+
+void simSetPreference(const char* ns, const char* key, const void* data, size_t length) {
+  putPreference(ns, key, data, length);
+}
+
+size_t simGetPreference(const char* ns, const char* key, void* buffer, size_t capacity) {
+  const NvsEntry* entry = findPreference(ns, key);
+  if (entry == nullptr || entry->length > capacity) return 0;
+  memcpy(buffer, entry->value, entry->length);
+  return entry->length;
+}
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  if (strlen(name) >= sizeof(_ns)) return false;
+  strcpy(_ns, name);
+  _open = true;
+  _readOnly = readOnly;
+  return true;
+}
+
+bool Preferences::clear() {
+  if (!_open || _readOnly) return false;
+  for (size_t i = 0; i < SIM_NVS_ENTRIES; i++) {
+    NvsEntry& entry = state().nvs[i];
+    if (entry.used && strcmp(entry.ns, _ns) == 0) entry.used = false;
+  }
+  return true;
+}
+
+bool Preferences::remove(const char* key) {
+  if (!_open || _readOnly) return false;
+  NvsEntry* entry = findPreference(_ns, key);
+  if (entry == nullptr) return false;
+  entry->used = false;
+  return true;
+}
+
+bool Preferences::isKey(const char* key) { return _open && findPreference(_ns, key) != nullptr; }
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+  if (!_open || _readOnly) return 0;
+  return putPreference(_ns, key, value, length);
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  const NvsEntry* entry = _open ? findPreference(_ns, key) : nullptr;
+  return entry != nullptr ? entry->length : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t capacity) {
+  return _open ? simGetPreference(_ns, key, buffer, capacity) : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+  const NvsEntry* entry = _open ? findPreference(_ns, key) : nullptr;
+  if (entry == nullptr) return defaultValue;
+  return String(std::string((const char*)entry->value, entry->length));
+}
+
+// ====== COMANDOS E UDP ======
+// Na memória do driver, herdada pelos boots (só leitura depois do primeiro)
+struct PendingCommand {
+  uint64_t atUs;
+  std::string data;
+};
+static std::vector<PendingCommand> commands;
+static SimDatagramSink datagramSink = nullptr;
+
+void simQueueCommand(uint64_t atUs, const uint8_t* data, size_t length) {
+  PendingCommand command = {atUs, std::string((const char*)data, length)};
+  std::vector<PendingCommand>::iterator it = commands.begin();
+  while (it != commands.end() && it->atUs <= atUs) ++it;
+  commands.insert(it, command);
+}
+
+size_t simCommandCount() { return commands.size(); }
+
+SimCommand simCommandAt(size_t i) {
+  SimCommand command = {commands[i].atUs, (const uint8_t*)commands[i].data.data(), commands[i].data.size()};
+  return command;
+}
+
+void simSetDatagramSink(SimDatagramSink sink) { datagramSink = sink; }
+
+int WiFiUDP::endPacket() {
+  bool sent = simUdpSend();
+  if (sent && datagramSink != nullptr) {
+    datagramSink(simNowUs(), _host.c_str(), _port, (const uint8_t*)_packet.data(), _packet.size());
+  }
+  _packet.clear();
+  return sent ? 1 : 0;
+}
+
+int WiFiUDP::parsePacket() {
+  PlatformState& s = state();
+  if (s.commandsRead >= commands.size() || commands[s.commandsRead].atUs > s.nowUs || !simWifiUp()) return 0;
+  _received = commands[s.commandsRead++].data;
+  _readPos = 0;
+  return (int)_received.size();
+}
+
+// ====== IMAGENS DE BOOT ======
+// Sem partições: o replay só tem a imagem que está rodando
+bool switchToSensingImage() { return false; }
+bool switchToFactoryImage() { return false; }
+
+void reportBootTime(const char* image) {
+  Serial.printf("BOOT image=%s setup_ms=%llu free_heap=0\n", image,
+                (unsigned long long)((simNowUs() - bootStartedUs) / 1000));
+}
+
+// ====== CAPTURA ======
+// Mesmos quadros do ESP32, no relógio virtual e sem perdas: gravando a Serial em arquivo
+// (--serial do replay), scripts/capture_recv.py lê a captura dele
+CaptureStats runCapture(uint8_t pin, uint32_t rateHz, uint32_t durationMs, bool (*keepGoing)(),
+                        unsigned long) {
+  CaptureStats stats;
+  if (rateHz == 0) return stats;
+  if (rateHz > CAPTURE_RATE_MAX_HZ) rateHz = CAPTURE_RATE_MAX_HZ;
+  uint32_t periodUs = 1000000 / rateHz;
+  uint64_t limitUs = (uint64_t)(durationMs != 0 ? durationMs : CAPTURE_DURATION_MAX_S * 1000) * 1000;
+
+  Serial.write((uint8_t)0);
+  static CaptureFramer framer;
+  static uint8_t encoded[CAPTURE_ENCODED_MAX];
+  framer.begin(periodUs);
+  uint64_t started = simNowUs();
+  while (simNowUs() - started < limitUs && (durationMs != 0 || keepGoing())) {
+    uint16_t raw = (uint16_t)analogRead(pin);
+    stats.samples++;
+    bool full = framer.add(raw, (uint32_t)simNowUs());
+    simBusyUs(periodUs);
+    if (!full) continue;
+    size_t n = framer.encode(encoded);
+    Serial.write(encoded, n);
+    stats.frames++;
+    stats.wireBytes += n;
+  }
+  for (bool last = framer.count() == 0; ; last = true) {
+    size_t n = framer.encode(encoded);
+    Serial.write(encoded, n);
+    stats.wireBytes += n;
+    if (last) break;
+  }
+  return stats;
+}
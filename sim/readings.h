@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ts_codec.h"
+
+// Leituras de uma mensagem do dispositivo, para quem mede a entrega no destino (o replay e
+// o broker de sim/broker_main.cpp): o JSON de sensors/humidity (payload.h) ou um bloco de
+// sensors/<id>/batch (ts_codec.h). Envelopes cifrados (seal.h) e as outras mensagens não
+// têm leituras. Chama fn(epoch, seq, timestampMs) para cada uma; retorna quantas achou.
+
+// Campo numérico de um JSON plano (os payloads do firmware não aninham leituras)
+inline bool readingJsonNumber(const char* json, const char* key, unsigned long long& value) {
+  char pattern[32];
+  snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+  const char* p = strstr(json, pattern);
+  if (p == nullptr) return false;
+  value = strtoull(p + strlen(pattern), nullptr, 10);
+  return true;
+}
+
+template <typename Fn>
+size_t forEachReading(const char* topic, const uint8_t* payload, size_t length, Fn fn) {
+  size_t topicLength = strlen(topic);
+  if (topicLength >= 6 && strcmp(topic + topicLength - 6, "/batch") == 0) {
+    TsBlockDecoder decoder;
+    if (!decoder.begin(payload, length)) return 0;
+    uint64_t timestampMs;
+    int32_t value;
+    size_t n = 0;
+    for (; decoder.next(timestampMs, value); n++) {
+      fn(decoder.epoch(), decoder.firstSeq() + (uint32_t)n * decoder.stride(), (unsigned long long)timestampMs);
+    }
+    return n;
+  }
+  char json[512];
+  if (length >= sizeof(json)) return 0;
+  memcpy(json, payload, length);
+  json[length] = '\0';
+  unsigned long long epoch, seq, timestamp, period;
+  if (!readingJsonNumber(json, "period_ms", period) || !readingJsonNumber(json, "epoch", epoch) ||
+      !readingJsonNumber(json, "seq", seq) || !readingJsonNumber(json, "timestamp", timestamp)) {
+    return 0;
+  }
+  fn((uint32_t)epoch, (uint32_t)seq, timestamp);
+  return 1;
+}
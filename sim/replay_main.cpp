@@ -0,0 +1,676 @@
+// Replay de cenários: roda o firmware (src/main.cpp, setup() e loop()) no host sobre a
+// plataforma simulada (sim.h), com o ADC alimentado por um traço gravado ou sintético, o
+// relógio virtual e a rede simulada (net.h) com falhas injetadas, e registra cada mensagem
+// que chega ao destino.
+//
+//   .pio/build/replay_native/program traco.csv [opções] > mensagens.txt
+//   .pio/build/sim_native/program --duration 3600 --fault 600:down:300 > mensagens.txt
+//   .pio/build/sim_native/program --bench > recuperacao.jsonl
+//
+// Traços:
+//   csv  com cabeçalho: coluna "raw" e o tempo em "t_ms", "t_us" ou "t_s" (a saída csv de
+//        scripts/capture_recv.py serve direto); sem cabeçalho: "raw" ou "t_ms,raw"
+//   u16  leituras uint16 little endian a --rate Hz (capture_recv.py --format u16); 0xFFFF
+//        (quadro perdido) repete a leitura anterior
+// O traço começa no boot (tempo 0 do relógio virtual) e cada leitura vale até a próxima;
+// o replay termina no fim do traço ou em --duration. scripts/make_trace.py gera traços.
+// Sem traço, o ADC lê uma senoide lenta e o período de leitura fica preso em 5 s (NVS),
+// para que as falhas sejam medidas sempre sobre o mesmo fluxo de leituras.
+//
+// Opções:
+//   --rate <hz>             taxa do traço sem coluna de tempo (padrão 0.2: uma leitura a cada 5 s)
+//   --format csv|u16        padrão pela extensão (.u16 e .bin são u16)
+//   --duration <s>          tempo virtual máximo (obrigatório sem traço)
+//   --start <unix_ms>       horário de parede no boot (padrão 2026-01-01 00:00 UTC)
+//   --command <s>:<texto>   comando entregue no instante <s> (repetível), ex.: "0:BATCH 60"
+//   --fault <especificação> falha da rede (repetível), ex.: "600:down@test.mosquitto.org:300"
+//                           (sintaxe e tipos em sim/net.h)
+//   --seed <n>              semente das perdas e do jitter da rede (padrão 1)
+//   --bench                 roda a bateria de falhas (REPLAY_BENCH_*) e imprime uma linha
+//                           JSON por cenário (scripts/bench_compare.py compara execuções)
+//   --out <arquivo>         mensagens (padrão: saída padrão; com --bench, descartadas)
+//   --serial <arquivo>      log da Serial, inclusive a captura binária (padrão: descartado)
+//   --loop-us <µs>          custo de CPU de cada volta do loop() no relógio virtual (padrão 50)
+//   --times                 prefixa cada mensagem com o instante virtual da chegada (ms)
+//
+// Cada mensagem é uma linha "<tópico> <payload>", como no "mosquitto_sub -v" (então
+// scripts/seq_tracker.py lê a saída direto); payloads binários (blocos comprimidos ou
+// cifrados) saem em hex com o prefixo "hex:". Mesma entrada e mesma semente, mesma saída:
+// duas versões do firmware se comparam com diff. Um ESP.restart() é um boot novo (sim.h).
+//
+// O resumo vai para a saída de erro: mensagens por tópico, boots, quedas da conexão MQTT e,
+// para cada falha, o custo da recuperação:
+//   reconnect_ms   da queda da conexão ao CONNACK seguinte (a maior da janela da falha)
+//   recovery_ms    do fim da falha até chegar ao broker a primeira leitura feita depois
+//                  dela (sem recuperação até o fim, o tempo que restava)
+//   lost_readings  lacunas de seq dentro de cada época de boot (leituras na fila perdidas
+//                  num reinício só aparecem em hole_ms)
+//   hole_ms        maior intervalo entre leituras entregues, pelo instante da leitura
+//   cpu_ms         CPU ocupada do início da falha até a recuperação
+//
+// As imagens simuladas usam o transporte UDP (replay_native, uma mensagem por send(), sem
+// confirmação) ou MQTT sobre TCP (sim_native, com os brokers padrão do firmware na rede
+// simulada). O MQTT-SN não tem gateway simulado.
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "net.h"
+#include "readings.h"
+#include "sim.h"
+
+void setup();
+void loop();
+
+#define REPLAY_DEFAULT_START_MS 1767225600000ULL  // 2026-01-01 00:00:00 UTC
+#define REPLAY_DEFAULT_RATE_HZ 0.2
+#define REPLAY_DEFAULT_LOOP_US 50
+#define REPLAY_DEFAULT_SEED 1
+#define REPLAY_GAP_VALUE 0xFFFF
+#define REPLAY_SYNTHETIC_PERIOD_MS 5000   // Período de leitura preso sem traço
+#define REPLAY_TOPICS_MAX 32
+#define REPLAY_READINGS_MAX (1 << 22)     // Leituras recebidas registradas (~1 ano a cada 5 s)
+
+// Bateria de --bench: cada cenário roda REPLAY_BENCH_DURATION_S com a falha em
+// REPLAY_BENCH_FAULT_S, num processo próprio (rede, NVS e relógio zerados)
+#define REPLAY_BENCH_DURATION_S 1800
+#define REPLAY_BENCH_FAULT_S 600
+
+// Brokers padrão do firmware (MQTT_BROKERS_DEFAULT em src/main.cpp), com o RTT medido a partir do Brasil
+static const struct {
+  const char* host;
+  uint16_t port;
+  uint32_t rttMs;
+} replayBrokers[] = {
+    {"test.mosquitto.org", 1883, 180},
+    {"broker.hivemq.com", 1883, 120},
+    {"broker.emqx.io", 1883, 150},
+};
+
+static const struct {
+  const char* name;
+  const char* faults;  // Separadas por vírgula e sem o instante (todas em REPLAY_BENCH_FAULT_S); nullptr: referência
+} benchScenarios[] = {
+    {"baseline", nullptr},
+    {"reset", "reset"},
+    {"broker_restart", "reset,refuse:120"},
+    {"down_current", "down@broker.hivemq.com:300"},  // O de menor RTT, onde o dispositivo está
+    {"down_all", "down:300"},
+    {"dns", "dns:600"},
+    {"latency", "latency:300:800"},
+    {"loss", "loss:300:20"},
+    {"blackhole", "blackhole:120"},
+    {"wifi_10s", "wifi:10"},
+    {"wifi_60s", "wifi:60"},
+};
+
+struct TracePoint {
+  uint64_t atUs;
+  uint16_t raw;
+};
+
+static std::vector<TracePoint> trace;
+static size_t traceIndex = 0;
+
+// O relógio virtual só anda para frente: a busca continua de onde parou
+static uint16_t traceAdc(uint8_t, uint64_t nowUs) {
+  while (traceIndex + 1 < trace.size() && trace[traceIndex + 1].atUs <= nowUs) traceIndex++;
+  return trace[traceIndex].raw;
+}
+
+// Sem traço: ±40 contagens em torno do meio da calibração, com período de 1 h
+static uint16_t syntheticAdc(uint8_t, uint64_t nowUs) {
+  return (uint16_t)lround(2100 + 40 * sin(2 * M_PI * (double)nowUs / 3.6e9));
+}
+
+// ====== LEITURA DO TRAÇO ======
+static bool endsWith(const char* text, const char* suffix) {
+  size_t n = strlen(text), m = strlen(suffix);
+  return n >= m && strcmp(text + n - m, suffix) == 0;
+}
+
+static bool loadU16(const char* path, double rateHz) {
+  FILE* in = fopen(path, "rb");
+  if (in == nullptr) return false;
+  uint8_t pair[2];
+  uint64_t index = 0;
+  uint16_t last = 0;
+  while (fread(pair, 1, 2, in) == 2) {
+    uint16_t raw = (uint16_t)(pair[0] | pair[1] << 8);
+    if (raw == REPLAY_GAP_VALUE) raw = last;
+    trace.push_back(TracePoint{(uint64_t)(index++ * 1e6 / rateHz), raw});
+    last = raw;
+  }
+  fclose(in);
+  return true;
+}
+
+static int splitCsv(char* line, char* fields[], int max) {
+  int n = 0;
+  for (char* p = line; n < max;) {
+    fields[n++] = p;
+    p = strchr(p, ',');
+    if (p == nullptr) break;
+    *p++ = '\0';
+  }
+  for (int i = 0; i < n; i++) fields[i][strcspn(fields[i], "\r\n")] = '\0';
+  return n;
+}
+
+static bool loadCsv(const char* path, double rateHz) {
+  FILE* in = fopen(path, "r");
+  if (in == nullptr) return false;
+  char line[256];
+  char* fields[8];
+  int rawColumn = -1, timeColumn = -1;
+  double timeScale = 1000;  // Coluna de tempo -> µs
+  uint64_t index = 0, t0 = 0;
+  bool first = true;
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    int n = splitCsv(line, fields, 8);
+    if (first && !(fields[0][0] >= '0' && fields[0][0] <= '9')) {
+      for (int i = 0; i < n; i++) {
+        if (strcmp(fields[i], "raw") == 0) rawColumn = i;
+        if (strcmp(fields[i], "t_ms") == 0) timeColumn = i, timeScale = 1000;
+        if (strcmp(fields[i], "t_us") == 0) timeColumn = i, timeScale = 1;
+        if (strcmp(fields[i], "t_s") == 0) timeColumn = i, timeScale = 1e6;
+      }
+      first = false;
+      if (rawColumn < 0) {
+        fprintf(stderr, "replay: %s sem coluna \"raw\"\n", path);
+        fclose(in);
+        return false;
+      }
+      continue;
+    }
+    if (first) {
+      if (n > 2) {
+        fprintf(stderr, "replay: %s tem %d colunas e nenhum cabecalho\n", path, n);
+        fclose(in);
+        return false;
+      }
+      rawColumn = n - 1;
+      timeColumn = n == 2 ? 0 : -1;
+      first = false;
+    }
+    if (n <= rawColumn || (timeColumn >= 0 && n <= timeColumn) || fields[rawColumn][0] == '\0') continue;
+    uint16_t raw = (uint16_t)strtoul(fields[rawColumn], nullptr, 10);
+    uint64_t atUs;
+    if (timeColumn >= 0) {
+      uint64_t t = (uint64_t)(strtod(fields[timeColumn], nullptr) * timeScale);
+      if (trace.empty()) t0 = t;
+      if (t < t0 || (!trace.empty() && t - t0 < trace.back().atUs)) continue;  // Fora de ordem
+      atUs = t - t0;
+    } else {
+      atUs = (uint64_t)(index * 1e6 / rateHz);
+    }
+    index++;
+    trace.push_back(TracePoint{atUs, raw});
+  }
+  fclose(in);
+  return true;
+}
+
+// ====== MENSAGENS ======
+// O registro é escrito pelos boots (processos filhos) e lido pelo driver no fim: fica na
+// memória compartilhada da simulação (simShared())
+struct TopicCount {
+  char name[96];
+  uint64_t messages;
+  uint64_t bytes;
+};
+
+struct ReceivedReading {
+  uint32_t epoch;
+  uint32_t seq;
+  uint64_t sampledUs;   // Instante virtual da leitura (pelo timestamp); UINT64_MAX sem relógio
+  uint64_t receivedUs;  // Chegada ao destino
+};
+
+struct Report {
+  uint64_t messages;
+  size_t topicCount;
+  TopicCount topics[REPLAY_TOPICS_MAX];
+  size_t readingCount;
+  ReceivedReading* readings;
+};
+
+static Report* report = nullptr;
+static FILE* messageOut = stdout;
+static bool messageTimes = false;
+
+static void countTopic(const std::string& topic, size_t bytes) {
+  report->messages++;
+  size_t i = 0;
+  while (i < report->topicCount && strcmp(report->topics[i].name, topic.c_str()) != 0) i++;
+  if (i == report->topicCount) {
+    if (i == REPLAY_TOPICS_MAX) return;
+    snprintf(report->topics[i].name, sizeof(report->topics[i].name), "%s", topic.c_str());
+    report->topicCount++;
+  }
+  report->topics[i].messages++;
+  report->topics[i].bytes += bytes;
+}
+
+static void addReading(uint32_t epoch, uint32_t seq, unsigned long long timestampMs, uint64_t receivedUs) {
+  if (report->readingCount == REPLAY_READINGS_MAX) return;
+  unsigned long long startMs = simWallStart();
+  uint64_t sampledUs = timestampMs >= startMs ? (timestampMs - startMs) * 1000 : UINT64_MAX;
+  report->readings[report->readingCount++] = ReceivedReading{epoch, seq, sampledUs, receivedUs};
+}
+
+static void record(uint64_t atUs, const std::string& topic, const uint8_t* payload, size_t payloadLength) {
+  countTopic(topic, payloadLength);
+  forEachReading(topic.c_str(), payload, payloadLength, [atUs](uint32_t epoch, uint32_t seq, unsigned long long timestampMs) {
+    addReading(epoch, seq, timestampMs, atUs);
+  });
+  if (messageOut == nullptr) return;
+
+  bool text = true;
+  for (size_t i = 0; i < payloadLength && text; i++) text = payload[i] >= 0x20 && payload[i] < 0x7F;
+  if (messageTimes) fprintf(messageOut, "%llu ", (unsigned long long)(atUs / 1000));
+  fprintf(messageOut, "%s ", topic.c_str());
+  if (text) {
+    fwrite(payload, 1, payloadLength, messageOut);
+  } else {
+    fputs("hex:", messageOut);
+    for (size_t i = 0; i < payloadLength; i++) fprintf(messageOut, "%02x", payload[i]);
+  }
+  fputc('\n', messageOut);
+}
+
+// Imagem UDP: "<tópico>\n<payload>" num datagrama
+static void onDatagram(uint64_t atUs, const char*, uint16_t, const uint8_t* data, size_t length) {
+  const uint8_t* newline = (const uint8_t*)memchr(data, '\n', length);
+  size_t topicLength = newline != nullptr ? (size_t)(newline - data) : 0;
+  const uint8_t* payload = newline != nullptr ? newline + 1 : data;
+  record(atUs, std::string((const char*)data, topicLength), payload, length - (payload - data));
+}
+
+// Imagem MQTT: PUBLISH recebido por um dos brokers
+static void onPublish(uint64_t atUs, const char*, const char* topic, const uint8_t* payload, size_t length) {
+  record(atUs, topic, payload, length);
+}
+
+// ====== MÉTRICAS ======
+struct DeliveryStats {
+  uint64_t unique;
+  uint64_t duplicates;
+  uint64_t lost;
+  uint64_t holeMs;
+  uint64_t latencyP50Ms;
+  uint64_t latencyP99Ms;
+  uint64_t latencyMaxMs;
+};
+
+struct FaultStats {
+  uint32_t outages;
+  int64_t reconnectMs;  // -1: sem queda na janela
+  bool recovered;
+  uint64_t recoveryMs;
+  uint64_t cpuMs;
+};
+
+static bool bySeq(const ReceivedReading& a, const ReceivedReading& b) {
+  if (a.epoch != b.epoch) return a.epoch < b.epoch;
+  if (a.seq != b.seq) return a.seq < b.seq;
+  return a.receivedUs < b.receivedUs;
+}
+
+static bool bySample(const ReceivedReading& a, const ReceivedReading& b) { return a.sampledUs < b.sampledUs; }
+
+// Ordena o registro por (época, seq): fica só a primeira chegada de cada leitura
+static DeliveryStats deliveryStats(std::vector<ReceivedReading>& unique, uint64_t endUs) {
+  DeliveryStats stats = {};
+  std::vector<ReceivedReading> all(report->readings, report->readings + report->readingCount);
+  std::sort(all.begin(), all.end(), bySeq);
+  unique.clear();
+  for (size_t i = 0; i < all.size(); i++) {
+    bool repeated = !unique.empty() && unique.back().epoch == all[i].epoch && unique.back().seq == all[i].seq;
+    if (repeated) {
+      stats.duplicates++;
+      continue;
+    }
+    // Numeração de cada época começa em 0 (sequence.h)
+    bool newEpoch = unique.empty() || unique.back().epoch != all[i].epoch;
+    uint32_t expected = newEpoch ? 0 : unique.back().seq + 1;
+    stats.lost += all[i].seq - expected;
+    unique.push_back(all[i]);
+  }
+  stats.unique = unique.size();
+
+  std::vector<uint64_t> latencies;
+  for (size_t i = 0; i < unique.size(); i++) {
+    if (unique[i].sampledUs <= unique[i].receivedUs) latencies.push_back((unique[i].receivedUs - unique[i].sampledUs) / 1000);
+  }
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    stats.latencyP50Ms = latencies[latencies.size() / 2];
+    stats.latencyP99Ms = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    stats.latencyMaxMs = latencies.back();
+  }
+
+  std::vector<ReceivedReading> timed;
+  for (size_t i = 0; i < unique.size(); i++) {
+    if (unique[i].sampledUs != UINT64_MAX) timed.push_back(unique[i]);
+  }
+  std::sort(timed.begin(), timed.end(), bySample);
+  uint64_t previousUs = timed.empty() ? 0 : timed.front().sampledUs;
+  for (size_t i = 0; i < timed.size(); i++) {
+    stats.holeMs = std::max(stats.holeMs, (timed[i].sampledUs - previousUs) / 1000);
+    previousUs = timed[i].sampledUs;
+  }
+  // Depois da última entregue também é buraco (nada mais chegou até o fim)
+  if (!timed.empty() && endUs > previousUs) stats.holeMs = std::max(stats.holeMs, (endUs - previousUs) / 1000);
+  return stats;
+}
+
+// A janela da falha vai do início dela ao início da próxima (ou ao fim da simulação)
+static FaultStats faultStats(size_t index, const std::vector<ReceivedReading>& unique, uint64_t endUs) {
+  const SimFault& fault = simFaultAt(index);
+  uint64_t windowEndUs = endUs;
+  for (size_t i = 0; i < simFaultCount(); i++) {
+    uint64_t startUs = simFaultAt(i).startUs;
+    if (startUs > fault.startUs && startUs < windowEndUs) windowEndUs = startUs;
+  }
+  FaultStats stats = {};
+  stats.reconnectMs = -1;
+  for (size_t i = 0; i < simOutageCount(); i++) {
+    const SimOutage& outage = simOutageAt(i);
+    if (outage.lostUs < fault.startUs || outage.lostUs >= windowEndUs) continue;
+    stats.outages++;
+    uint64_t untilUs = outage.connackUs != 0 ? outage.connackUs : endUs;
+    stats.reconnectMs = std::max(stats.reconnectMs, (int64_t)((untilUs - outage.lostUs) / 1000));
+  }
+  uint64_t firstUs = UINT64_MAX;
+  for (size_t i = 0; i < unique.size(); i++) {
+    if (unique[i].sampledUs != UINT64_MAX && unique[i].sampledUs >= fault.endUs && unique[i].receivedUs >= fault.endUs) {
+      firstUs = std::min(firstUs, unique[i].receivedUs);
+    }
+  }
+  stats.recovered = firstUs != UINT64_MAX;
+  uint64_t recoveredUs = stats.recovered ? firstUs : endUs;
+  stats.recoveryMs = (recoveredUs - std::min(fault.endUs, recoveredUs)) / 1000;
+  stats.cpuMs = simActiveUsBetween(fault.startUs, recoveredUs) / 1000;
+  return stats;
+}
+
+// ====== EXECUÇÃO ======
+struct Scenario {
+  const char* tracePath;
+  uint64_t endUs;
+  unsigned long long startMs;
+  uint64_t loopUs;
+  uint64_t seed;
+  std::vector<std::pair<uint64_t, std::string> > commands;
+  std::vector<SimFault> faults;
+  FILE* serialOut;
+};
+
+struct Outcome {
+  SimRunStats run;
+  DeliveryStats delivery;
+  std::vector<FaultStats> faults;
+  bool credentialsLost;
+  double elapsedS;
+};
+
+static double monotonicSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void runScenario(const Scenario& scenario, Outcome& outcome) {
+  report = (Report*)simShared(sizeof(Report));
+  report->readings = (ReceivedReading*)simShared(REPLAY_READINGS_MAX * sizeof(ReceivedReading));
+  simSetWallStart(scenario.startMs);
+  simSetAdcSource(trace.empty() ? syntheticAdc : traceAdc);
+  simSetDatagramSink(onDatagram);
+  simSetPublishSink(onPublish);
+  simSetSerialOutput(scenario.serialOut);
+  simSetNetSeed(scenario.seed);
+  for (size_t i = 0; i < sizeof(replayBrokers) / sizeof(replayBrokers[0]); i++) {
+    simAddBroker(replayBrokers[i].host, replayBrokers[i].port, replayBrokers[i].rttMs);
+  }
+  for (size_t i = 0; i < scenario.faults.size(); i++) simAddFault(scenario.faults[i]);
+  simSetPreference("sensor-config", "ssid", "replay", 6);
+  if (trace.empty()) {
+    uint32_t period = REPLAY_SYNTHETIC_PERIOD_MS;
+    simSetPreference("sensor-config", "rate_min", &period, sizeof(period));
+    simSetPreference("sensor-config", "rate_max", &period, sizeof(period));
+  }
+  for (size_t i = 0; i < scenario.commands.size(); i++) {
+    const std::string& text = scenario.commands[i].second;
+    simQueueCommand(scenario.commands[i].first, (const uint8_t*)text.data(), text.size());
+  }
+
+  double started = monotonicSeconds();
+  outcome.run = simRun(setup, loop, scenario.endUs, scenario.loopUs);
+  outcome.elapsedS = monotonicSeconds() - started;
+  if (messageOut != nullptr) fflush(messageOut);
+
+  std::vector<ReceivedReading> unique;
+  outcome.delivery = deliveryStats(unique, simNowUs());
+  outcome.faults.clear();
+  for (size_t i = 0; i < simFaultCount(); i++) outcome.faults.push_back(faultStats(i, unique, simNowUs()));
+  char ssid[64];
+  outcome.credentialsLost = simGetPreference("sensor-config", "ssid", ssid, sizeof(ssid)) == 0;
+}
+
+static void printSummary(const Scenario& scenario, const Outcome& outcome) {
+  double virtualS = simNowUs() * 1e-6;
+  fprintf(stderr, "replay: traco=%s virtual=%.0f s (%.2f dias) real=%.2f s aceleracao=%.0fx boots=%u voltas=%llu\n",
+          scenario.tracePath != nullptr ? scenario.tracePath : "sintetico", virtualS, virtualS / 86400,
+          outcome.elapsedS, outcome.elapsedS > 0 ? virtualS / outcome.elapsedS : 0, outcome.run.boots,
+          (unsigned long long)outcome.run.loops);
+  fprintf(stderr, "replay: mensagens=%llu\n", (unsigned long long)report->messages);
+  std::vector<TopicCount> topics(report->topics, report->topics + report->topicCount);
+  std::sort(topics.begin(), topics.end(),
+            [](const TopicCount& a, const TopicCount& b) { return strcmp(a.name, b.name) < 0; });
+  for (size_t i = 0; i < topics.size(); i++) {
+    fprintf(stderr, "  %-40s %8llu mensagens %10llu bytes\n", topics[i].name, (unsigned long long)topics[i].messages,
+            (unsigned long long)topics[i].bytes);
+  }
+  const DeliveryStats& d = outcome.delivery;
+  fprintf(stderr,
+          "replay: leituras entregues=%llu duplicadas=%llu perdidas=%llu buraco=%llu ms latencia p50=%llu p99=%llu "
+          "max=%llu ms\n",
+          (unsigned long long)d.unique, (unsigned long long)d.duplicates, (unsigned long long)d.lost,
+          (unsigned long long)d.holeMs, (unsigned long long)d.latencyP50Ms, (unsigned long long)d.latencyP99Ms,
+          (unsigned long long)d.latencyMaxMs);
+  const SimNetStats& net = simNetStats();
+  fprintf(stderr,
+          "replay: rede tcp=%u falhas_tcp=%u resets=%u falhas_dns=%u connack=%u recusas=%u sessoes_retomadas=%u "
+          "comandos=%u quedas=%zu\n",
+          net.tcpConnects, net.tcpFailures, net.resets, net.dnsFailures, net.connacks, net.refusals,
+          net.sessionsResumed, net.commandsDelivered, simOutageCount());
+  for (size_t i = 0; i < outcome.faults.size(); i++) {
+    const SimFault& fault = simFaultAt(i);
+    const FaultStats& f = outcome.faults[i];
+    fprintf(stderr, "  falha %.1f s %s%s%s: quedas=%u religacao=%lld ms recuperacao=%llu ms%s cpu=%llu ms\n",
+            fault.startUs * 1e-6, simFaultName(fault.type), fault.host[0] ? "@" : "", fault.host, f.outages,
+            (long long)f.reconnectMs, (unsigned long long)f.recoveryMs, f.recovered ? "" : " (sem recuperacao)",
+            (unsigned long long)f.cpuMs);
+  }
+  if (outcome.credentialsLost) fprintf(stderr, "replay: credenciais do WiFi apagadas pelo firmware\n");
+  if (outcome.run.crashed) fprintf(stderr, "replay: simulacao interrompida por falha do firmware\n");
+}
+
+// Uma linha da bateria, no formato dos microbenchmarks (src/bench_main.cpp). Com falhas
+// simultâneas, vale a que termina por último
+static void printBench(const char* name, const Outcome& outcome) {
+  const DeliveryStats& d = outcome.delivery;
+  size_t last = 0;
+  for (size_t i = 1; i < outcome.faults.size(); i++) {
+    if (simFaultAt(i).endUs > simFaultAt(last).endUs) last = i;
+  }
+  FaultStats f = outcome.faults.empty() ? FaultStats() : outcome.faults[last];
+  printf("{\"bench\":\"recovery_%s\",\"platform\":\"sim\",\"recovery_ms\":%llu,\"recovered\":%s,"
+         "\"reconnect_ms\":%lld,\"outages\":%u,\"lost_readings\":%llu,\"duplicates\":%llu,\"hole_ms\":%llu,"
+         "\"cpu_ms\":%llu,\"lat_p99_ms\":%llu,\"boots\":%u,\"credentials_lost\":%s}\n",
+         name, (unsigned long long)f.recoveryMs, outcome.faults.empty() || f.recovered ? "true" : "false",
+         (long long)(f.reconnectMs < 0 ? 0 : f.reconnectMs), f.outages, (unsigned long long)d.lost,
+         (unsigned long long)d.duplicates, (unsigned long long)d.holeMs, (unsigned long long)f.cpuMs,
+         (unsigned long long)d.latencyP99Ms, outcome.run.boots, outcome.credentialsLost ? "true" : "false");
+}
+
+// Cada cenário num processo: a memória compartilhada e as falhas nascem e morrem com ele
+static int runBench(Scenario scenario) {
+  for (size_t i = 0; i < sizeof(benchScenarios) / sizeof(benchScenarios[0]); i++) {
+    scenario.faults.clear();
+    for (const char* p = benchScenarios[i].faults; p != nullptr && *p != '\0';) {
+      size_t n = strcspn(p, ",");
+      char spec[128];
+      snprintf(spec, sizeof(spec), "%d:%.*s", REPLAY_BENCH_FAULT_S, (int)n, p);
+      SimFault fault;
+      if (!simParseFault(spec, fault)) {
+        fprintf(stderr, "replay: falha invalida na bateria: %s\n", spec);
+        return 1;
+      }
+      scenario.faults.push_back(fault);
+      p += n + (p[n] == ',' ? 1 : 0);
+    }
+    fflush(nullptr);
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("replay: fork");
+      return 1;
+    }
+    if (pid == 0) {
+      Outcome outcome;
+      runScenario(scenario, outcome);
+      fprintf(stderr, "== %s\n", benchScenarios[i].name);
+      printSummary(scenario, outcome);
+      printBench(benchScenarios[i].name, outcome);
+      fflush(nullptr);
+      _exit(outcome.run.crashed ? 3 : 0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return 3;
+  }
+  return 0;
+}
+
+static int usage() {
+  fprintf(stderr,
+          "uso: replay [traco] [--rate hz] [--format csv|u16] [--duration s] [--start unix_ms]\n"
+          "            [--command s:texto]... [--fault especificacao]... [--seed n] [--bench]\n"
+          "            [--out arquivo] [--serial arquivo] [--loop-us us] [--times]\n");
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  Scenario scenario;
+  scenario.tracePath = nullptr;
+  scenario.startMs = REPLAY_DEFAULT_START_MS;
+  scenario.loopUs = REPLAY_DEFAULT_LOOP_US;
+  scenario.seed = REPLAY_DEFAULT_SEED;
+  scenario.serialOut = nullptr;
+  const char* format = nullptr;
+  const char* outPath = nullptr;
+  const char* serialPath = nullptr;
+  double rateHz = REPLAY_DEFAULT_RATE_HZ;
+  double durationS = 0;
+  bool bench = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (arg[0] != '-' && scenario.tracePath == nullptr) {
+      scenario.tracePath = arg;
+      continue;
+    }
+    if (strcmp(arg, "--times") == 0) {
+      messageTimes = true;
+      continue;
+    }
+    if (strcmp(arg, "--bench") == 0) {
+      bench = true;
+      continue;
+    }
+    if (value == nullptr) return usage();
+    i++;
+    if (strcmp(arg, "--rate") == 0) {
+      rateHz = atof(value);
+    } else if (strcmp(arg, "--format") == 0) {
+      format = value;
+    } else if (strcmp(arg, "--duration") == 0) {
+      durationS = atof(value);
+    } else if (strcmp(arg, "--start") == 0) {
+      scenario.startMs = strtoull(value, nullptr, 10);
+    } else if (strcmp(arg, "--command") == 0) {
+      const char* colon = strchr(value, ':');
+      if (colon == nullptr) return usage();
+      scenario.commands.push_back(std::make_pair((uint64_t)(atof(value) * 1e6), std::string(colon + 1)));
+    } else if (strcmp(arg, "--fault") == 0) {
+      SimFault fault;
+      if (!simParseFault(value, fault)) {
+        fprintf(stderr, "replay: falha invalida: %s\n", value);
+        return usage();
+      }
+      scenario.faults.push_back(fault);
+    } else if (strcmp(arg, "--seed") == 0) {
+      scenario.seed = strtoull(value, nullptr, 10);
+    } else if (strcmp(arg, "--out") == 0) {
+      outPath = value;
+    } else if (strcmp(arg, "--serial") == 0) {
+      serialPath = value;
+    } else if (strcmp(arg, "--loop-us") == 0) {
+      scenario.loopUs = strtoull(value, nullptr, 10);
+    } else {
+      return usage();
+    }
+  }
+  if (bench && durationS == 0) durationS = REPLAY_BENCH_DURATION_S;
+  if (rateHz <= 0 || (scenario.tracePath == nullptr && durationS <= 0)) return usage();
+
+  scenario.endUs = (uint64_t)(durationS * 1e6);
+  if (scenario.tracePath != nullptr) {
+    const char* path = scenario.tracePath;
+    if (format == nullptr) format = endsWith(path, ".u16") || endsWith(path, ".bin") ? "u16" : "csv";
+    bool loaded = strcmp(format, "u16") == 0 ? loadU16(path, rateHz) : loadCsv(path, rateHz);
+    if (!loaded || trace.empty()) {
+      fprintf(stderr, "replay: traco %s vazio ou ilegivel (%s)\n", path, loaded ? "sem leituras" : strerror(errno));
+      return 1;
+    }
+    // A última leitura vale por um intervalo igual ao anterior
+    uint64_t step = trace.size() > 1 ? trace.back().atUs - trace[trace.size() - 2].atUs : (uint64_t)(1e6 / rateHz);
+    uint64_t traceEndUs = trace.back().atUs + step;
+    if (scenario.endUs == 0 || traceEndUs < scenario.endUs) scenario.endUs = traceEndUs;
+  }
+
+  if (bench && outPath == nullptr) messageOut = nullptr;
+  if (outPath != nullptr && (messageOut = fopen(outPath, "w")) == nullptr) {
+    fprintf(stderr, "replay: %s: %s\n", outPath, strerror(errno));
+    return 1;
+  }
+  static char messageBuffer[1 << 16];
+  if (messageOut != nullptr) setvbuf(messageOut, messageBuffer, _IOFBF, sizeof(messageBuffer));
+  if (serialPath != nullptr && (scenario.serialOut = fopen(serialPath, "wb")) == nullptr) {
+    fprintf(stderr, "replay: %s: %s\n", serialPath, strerror(errno));
+    return 1;
+  }
+
+  int status;
+  if (bench) {
+    status = runBench(scenario);
+  } else {
+    Outcome outcome;
+    runScenario(scenario, outcome);
+    printSummary(scenario, outcome);
+    status = outcome.run.crashed ? 3 : 0;
+  }
+  if (messageOut != nullptr && messageOut != stdout) fclose(messageOut);
+  if (scenario.serialOut != nullptr) fclose(scenario.serialOut);
+  return status;
+}
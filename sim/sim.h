@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Plataforma simulada para rodar o firmware no host (sim/replay_main.cpp). O src/main.cpp
+// é compilado sem ARDUINO, contra os headers deste diretório (Arduino.h, WiFi.h,
+// WiFiUdp.h, Preferences.h, esp_timer.h), e cada módulo usa o seu caminho de host:
+//  - relógio virtual em µs desde o primeiro boot: millis(), micros() e
+//    esp_timer_get_time() o leem e só delay() e o custo de CPU simulado (simBusyUs()) o
+//    avançam, então um mês de operação roda em segundos e duas execuções com a mesma
+//    entrada produzem a mesma saída;
+//  - o relógio de parede (clock.h) é o início configurado (simSetWallStart()) mais o
+//    relógio virtual, a partir do configTime();
+//  - analogRead() vem de uma função de entrada (o traço carregado pelo replay), com o
+//    instante virtual da leitura;
+//  - WiFi, DNS e TCP são a rede simulada de sim/net.h, com brokers MQTT e falhas
+//    injetadas; cada datagrama do WiFiUDP vai para a função de saída;
+//  - comandos para o dispositivo chegam no instante virtual marcado, como datagrama
+//    (imagem UDP) ou pelo broker simulado no tópico de comando (imagem MQTT);
+//  - a NVS (Preferences) fica em memória e pode ser preenchida antes do primeiro boot.
+//
+// Cada boot roda num processo filho (fork()): ESP.restart() encerra o filho e o próximo
+// boot começa de globais zerados, como no ESP32. O que sobrevive ao reinício (relógio,
+// NVS, sessões dos brokers e o que o driver registra) fica em memória compartilhada entre
+// os processos, pedida a simShared().
+
+// ====== BOOTS ======
+#define SIM_BOOT_US 300000  // Do reset ao setup(): ROM, bootloader e carga da imagem
+
+// Memória zerada e compartilhada por todos os boots; só o driver pede, antes de simRun()
+void* simShared(size_t size);
+
+struct SimRunStats {
+  uint32_t boots;
+  uint64_t loops;
+  bool crashed;  // Um boot terminou por sinal ou exit() do firmware: a simulação para
+};
+
+// Roda boots até o relógio virtual chegar a endUs: setup() e loop() em sequência, cada
+// volta custando loopUs de CPU. Um reinício leva SIM_BOOT_US até o próximo setup().
+SimRunStats simRun(void (*setupFn)(), void (*loopFn)(), uint64_t endUs, uint64_t loopUs);
+
+// ====== RELÓGIO ======
+uint64_t simNowUs();
+void simAdvanceUs(uint64_t us);  // CPU parada (delay(), espera da rede)
+void simBusyUs(uint64_t us);     // CPU ocupada (laço do firmware, polling)
+
+// CPU ocupada desde o boot e num intervalo [fromUs, toUs) (resolução de 1 s)
+uint64_t simActiveUs();
+uint64_t simActiveUsBetween(uint64_t fromUs, uint64_t toUs);
+
+// Época Unix (ms) do relógio de parede quando o relógio virtual está em 0
+void simSetWallStart(unsigned long long unixMs);
+unsigned long long simWallStart();
+
+// ====== ENTRADAS ======
+typedef uint16_t (*SimAdcSource)(uint8_t pin, uint64_t nowUs);
+void simSetAdcSource(SimAdcSource source);
+
+// Pinos digitais leem HIGH (pull-up) até receberem outro nível aqui
+void simSetPin(uint8_t pin, uint8_t level);
+
+// Comando para o dispositivo a partir do instante virtual atUs (entregues na ordem do tempo)
+void simQueueCommand(uint64_t atUs, const uint8_t* data, size_t length);
+
+// Valor inicial da NVS: namespace, chave e o valor em bytes (texto sem o '\0')
+void simSetPreference(const char* ns, const char* key, const void* data, size_t length);
+// Valor atual, depois do replay; 0 se ausente
+size_t simGetPreference(const char* ns, const char* key, void* buffer, size_t capacity);
+
+// ====== SAÍDAS ======
+typedef void (*SimDatagramSink)(uint64_t atUs, const char* host, uint16_t port, const uint8_t* data, size_t length);
+void simSetDatagramSink(SimDatagramSink sink);
+
+// Destino da Serial (texto e a captura binária); nullptr descarta sem formatar
+void simSetSerialOutput(FILE* out);
+bool simSerialEnabled();
+size_t simSerialWrite(const uint8_t* data, size_t length);
+
+// ESP.restart(): encerra o boot; simRun() começa o próximo
+[[noreturn]] void simRestart();
+
+// ====== USADOS PELOS HEADERS SIMULADOS ======
+int simAnalogRead(uint8_t pin);
+int simDigitalRead(uint8_t pin);
+void simPinMode(uint8_t pin, uint8_t mode);
+void simDigitalWrite(uint8_t pin, uint8_t level);
+
+struct SimCommand {
+  uint64_t atUs;
+  const uint8_t* data;
+  size_t length;
+};
+size_t simCommandCount();
+SimCommand simCommandAt(size_t i);
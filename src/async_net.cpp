@@ -0,0 +1,92 @@
+#include "async_net.h"
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <lwip/dns.h>
+
+// ====== DNS ======
+// A consulta em andamento; o callback roda na task do lwIP e só escreve queryState depois
+// do endereço
+static char queryHost[BROKER_HOST_MAX];
+static ip_addr_t queryAddress;
+static volatile int8_t queryState = -1;  // -1 livre, ou o ResolveStatus da consulta de queryHost
+
+static void dnsFound(const char*, const ip_addr_t* address, void*) {
+  if (address != nullptr && IP_IS_V4(address)) {
+    queryAddress = *address;
+    queryState = RESOLVE_OK;
+  } else {
+    queryState = RESOLVE_FAILED;
+  }
+}
+
+static void copyAddress(const ip_addr_t& address, uint8_t out[4]) {
+  const ip4_addr_t* ip = ip_2_ip4(&address);
+  out[0] = ip4_addr1(ip);
+  out[1] = ip4_addr2(ip);
+  out[2] = ip4_addr3(ip);
+  out[3] = ip4_addr4(ip);
+}
+
+ResolveStatus netResolve(const char* host, uint8_t address[4]) {
+  if (queryState == RESOLVE_PENDING) return RESOLVE_PENDING;  // Esta ou outra: uma por vez
+  if (queryState != -1 && strcmp(host, queryHost) == 0) {
+    ResolveStatus status = (ResolveStatus)queryState;
+    if (status == RESOLVE_OK) copyAddress(queryAddress, address);
+    queryState = -1;
+    return status;
+  }
+  strncpy(queryHost, host, sizeof(queryHost) - 1);
+  queryHost[sizeof(queryHost) - 1] = '\0';
+  queryState = RESOLVE_PENDING;
+  ip_addr_t cached;
+  err_t err = dns_gethostbyname(host, &cached, dnsFound, nullptr);
+  if (err == ERR_INPROGRESS) return RESOLVE_PENDING;
+  queryState = -1;
+  if (err != ERR_OK || !IP_IS_V4(&cached)) return RESOLVE_FAILED;
+  copyAddress(cached, address);  // Cache do lwIP ou IP literal
+  return RESOLVE_OK;
+}
+
+// ====== PROBE TCP ======
+bool TcpProbe::start(const char* ip, uint16_t port) {
+  stop();
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  if (inet_pton(AF_INET, ip, &address.sin_addr) != 1) return false;
+  _fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (_fd < 0) return false;
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+  if (::connect(_fd, (struct sockaddr*)&address, sizeof(address)) != 0 && errno != EINPROGRESS) {
+    stop();
+    return false;
+  }
+  return true;
+}
+
+int TcpProbe::poll() {
+  if (_fd < 0) return -1;
+  fd_set writable;
+  FD_ZERO(&writable);
+  FD_SET(_fd, &writable);
+  struct timeval zero = {0, 0};
+  int n = select(_fd + 1, nullptr, &writable, nullptr, &zero);
+  if (n == 0) return 0;
+  int error = 0;
+  socklen_t length = sizeof(error);
+  if (n < 0 || getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) return -1;
+  return 1;
+}
+
+void TcpProbe::stop() {
+  if (_fd >= 0) close(_fd);
+  _fd = -1;
+}
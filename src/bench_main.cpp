@@ -0,0 +1,591 @@
+/*
+===========================================================================================
+ ==         ESP32 - Sensor de Umidade - Microbenchmarks dos Caminhos Quentes         ==
+===========================================================================================
+ == No ESP32: pio run -e bench_esp32 -t upload && pio device monitor                 ==
+ == No host:  pio run -e bench_native -t exec                                        ==
+ ==                                                                                  ==
+ == Cada caso imprime uma linha JSON (fácil de comparar entre versões com            ==
+ == scripts/bench_compare.py):                                                       ==
+ ==   {"bench":"<caso>","platform":"esp32","iters":N,"ns_per_op":..,                 ==
+ ==    "cycles_per_op":..,"allocs_per_op":..,"alloc_bytes_per_op":..,"stack_bytes":..}==
+== Casos que medem mais alguma grandeza (ex.: bits/amostra) acrescentam um campo.   ==
+ ==                                                                                  ==
+ == Alocações: malloc/calloc/realloc são redirecionados pelo linker (-Wl,--wrap) e   ==
+ == operator new passa por malloc. Pilha: cada caso roda numa pilha própria,         ==
+ == preenchida com um padrão, descontando o consumo de um caso vazio.                ==
+===========================================================================================
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#define BENCH_PLATFORM "esp32"
+#else
+#include <pthread.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#define BENCH_PLATFORM "native"
+#endif
+
+#include "calibration.h"
+#include "command.h"
+#include "payload.h"
+#include "json_stream.h"
+#include "scan_json.h"
+#include "clock.h"
+#include "aggregator.h"
+#include "ts_codec.h"
+#include "mqtt_transport.h"
+#include "http_transport.h"
+#include "udp_transport.h"
+#include "seal.h"
+#include "capture.h"
+#include "filter.h"
+
+// --- Configurações ---
+#ifndef BENCH_ITERS
+#ifdef ARDUINO
+#define BENCH_ITERS 2000
+#else
+#define BENCH_ITERS 200000
+#endif
+#endif
+#ifdef ARDUINO
+#define BENCH_STACK_SIZE 8192
+#else
+#define BENCH_STACK_SIZE 65536
+#endif
+#define STACK_PAINT 0xA5
+
+// ====== CONTAGEM DE ALOCAÇÕES ======
+static volatile bool countAllocs = false;
+static uint32_t allocCount = 0;
+static uint64_t allocBytes = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  if (countAllocs) { allocCount++; allocBytes += size; }
+  return __real_malloc(size);
+}
+void* __wrap_calloc(size_t n, size_t size) {
+  if (countAllocs) { allocCount++; allocBytes += n * size; }
+  return __real_calloc(n, size);
+}
+void* __wrap_realloc(void* ptr, size_t size) {
+  if (countAllocs) { allocCount++; allocBytes += size; }
+  return __real_realloc(ptr, size);
+}
+}
+
+void* operator new(size_t size) {
+  void* p = malloc(size);
+  if (p == nullptr) abort();
+  return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// ====== RELÓGIOS ======
+static uint64_t nowNs() {
+#ifdef ARDUINO
+  return (uint64_t)esp_timer_get_time() * 1000;
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Contador de ciclos: CCOUNT no ESP32 (32 bits, dá a volta em ~17 s a 240 MHz, bem acima
+// da duração de um caso), TSC no x86. Em outras arquiteturas o valor não é reportado.
+static bool hasCycleCounter() {
+#if defined(ARDUINO) || defined(__x86_64__) || defined(__i386__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+static uint64_t readCycles() {
+#ifdef ARDUINO
+  return ESP.getCycleCount();
+#elif defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static uint64_t cyclesBetween(uint64_t start, uint64_t end) {
+#ifdef ARDUINO
+  return (uint32_t)((uint32_t)end - (uint32_t)start);
+#else
+  return end - start;
+#endif
+}
+
+// ====== CASOS ======
+typedef void (*BenchFn)(uint32_t iters);
+
+// Impede que o compilador descarte o trabalho medido
+static volatile uint32_t sinkValue;
+
+static void benchEmpty(uint32_t iters) { sinkValue = iters; }
+
+// Só o map() da calibração
+static void benchCalibrationMap(uint32_t iters) {
+  uint32_t acc = 0;
+  for (uint32_t i = 0; i < iters; i++) {
+    acc += (uint32_t)mapRange(1000 + (i & 2047), 2850, 1350, 0, 100);
+  }
+  sinkValue = acc;
+}
+
+// Conversão completa feita por readSensorData(): map + limites + float
+static void benchReadingConversion(uint32_t iters) {
+  float acc = 0;
+  for (uint32_t i = 0; i < iters; i++) {
+    acc += humidityFromRaw(1000 + (i & 2047), 2850, 1350);
+  }
+  sinkValue = (uint32_t)acc;
+}
+
+static void benchPayloadSerialize(uint32_t iters) {
+  char buffer[200];
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < iters; i++) {
+    total += serializeReading(buffer, sizeof(buffer), "A1B2C3D4E5F6", SeqNo{ 42, i }, (float)(i % 101),
+                              1700000000000ULL + (unsigned long long)i * 5000, 5000);
+  }
+  sinkValue = total;
+}
+
+// Mesmo caminho do mqttCallback(), com comandos válidos, inválidos e com espaços
+static void benchCommandParse(uint32_t iters) {
+  static const char* const messages[] = { "RESET", "  reset\r\n", "RATE 1000 300000", "STATUS" };
+  uint32_t acc = 0;
+  for (uint32_t i = 0; i < iters; i++) {
+    const char* m = messages[i & 3];
+    acc += parseCommand((const uint8_t*)m, strlen(m)).type;
+  }
+  sinkValue = acc;
+}
+
+// Geração do JSON do /scan para uma área densa (32 redes, com ocultas e caracteres a escapar)
+#define SCAN_NETWORKS 32
+static char scanSsids[SCAN_NETWORKS][33];
+static int scanRssi[SCAN_NETWORKS];
+
+static void prepareScanData() {
+  for (int i = 0; i < SCAN_NETWORKS; i++) {
+    if (i % 8 == 7) {
+      scanSsids[i][0] = '\0';  // Rede oculta
+    } else if (i % 5 == 0) {
+      snprintf(scanSsids[i], sizeof(scanSsids[i]), "Casa \"Sede\" \\ %02d", i);
+    } else {
+      snprintf(scanSsids[i], sizeof(scanSsids[i]), "Fazenda-AP-%02d", i);
+    }
+    scanRssi[i] = -40 - i;
+  }
+}
+
+static void benchScanJson(uint32_t iters) {
+  uint32_t bytes = 0;
+  auto sink = [&bytes](const char*, size_t len) { bytes += len; };
+  for (uint32_t i = 0; i < iters; i++) {
+    JsonStreamWriter<decltype(sink)> out(sink);
+    writeScanJson(out, SCAN_NETWORKS, [](int n, ScanEntry& entry) {
+      entry.ssid = scanSsids[n];
+      entry.ssidMaxLen = sizeof(scanSsids[n]);
+      entry.rssi = scanRssi[n];
+      return true;
+    });
+  }
+  sinkValue = bytes;
+}
+
+static void benchTimestamp(uint32_t iters) {
+  unsigned long long acc = 0;
+  for (uint32_t i = 0; i < iters; i++) acc += getUnixTimestampMillis();
+  sinkValue = (uint32_t)acc;
+}
+
+// Custo por amostra da agregação em janela (Welford + min/max + 3 quantis P²)
+static void benchAggregateAdd(uint32_t iters) {
+  static WindowAggregator window(60000);
+  for (uint32_t i = 0; i < iters; i++) {
+    window.add(40.0f + (float)((i * 2654435761u) >> 27));
+  }
+  WindowSummary summary = {};
+  window.close(0, summary);
+  sinkValue = summary.count;
+}
+
+// Filtro de cada amostra do ADC (filter.h), com ruído de ±16 contagens e um pico no
+// fundo de escala a cada 64 amostras
+template <typename Policy>
+static void benchFilter(uint32_t iters) {
+  static SensorFilter<Policy> filter;
+  uint32_t acc = 0;
+  for (uint32_t i = 0; i < iters; i++) {
+    int raw = (i & 63) == 7 ? 4095 : 2100 + (int)((i * 2654435761u) >> 27) - 16;
+    acc += (uint32_t)filter.update(raw);
+  }
+  sinkValue = acc;
+}
+
+// Compressão de lotes: uma operação = uma amostra, em blocos de 60 (5 min a 5 s).
+// Dados sintéticos próximos dos reais: umidade inteira em centésimos, período de
+// 5000 ms com jitter ocasional de alguns ms. Reporta também os bits por amostra.
+#define TS_BENCH_BLOCK 60
+static const char* extraMetric = nullptr;
+static double extraValue = 0;
+
+static void benchTsEncode(uint32_t iters) {
+  uint8_t block[TS_BLOCK_HEADER_SIZE + TS_BENCH_BLOCK * TS_SAMPLE_MAX_BITS / 8 + 1];
+  uint64_t timestamp = 1700000000000ULL;
+  int32_t value = 4500;
+  uint64_t bytes = 0;
+  uint32_t samples = 0;
+  uint32_t seed = 12345;
+  while (samples < iters) {
+    TsBlockEncoder encoder(block, sizeof(block), 2);
+    for (int i = 0; i < TS_BENCH_BLOCK && samples < iters; i++, samples++) {
+      seed = seed * 1664525u + 1013904223u;
+      timestamp += 5000 + ((seed >> 28) == 0 ? (seed >> 24 & 7) : 0);
+      if ((seed >> 20 & 7) == 0) value += (seed & 1) ? 100 : -100;
+      encoder.add(timestamp, value);
+    }
+    bytes += encoder.finish();
+  }
+  extraMetric = "bits_per_sample";
+  extraValue = (double)bytes * 8 / iters;
+  sinkValue = (uint32_t)bytes;
+}
+
+// Transportes da telemetria (transport.h): uma operação = um send() da mesma leitura
+// JSON, com flush() a cada TRANSPORT_BENCH_FLUSH mensagens. Os sockets só contam bytes
+// (o custo medido é o do firmware, sem rede) e devolvem uma resposta pronta: CONNACK do
+// MQTT 5 no connect, 200 sem corpo a cada POST. Reporta os bytes no fio por mensagem.
+#define TRANSPORT_BENCH_FLUSH 16
+
+struct NullSocket {
+  const uint8_t* reply = nullptr;
+  size_t replyLength = 0;
+  size_t replyPos = 0;
+  volatile uint64_t bytes = 0;  // volatile: o envio é um efeito colateral, não some na otimização
+
+  int connect(const char*, uint16_t) {
+    replyPos = 0;
+    return 1;
+  }
+  bool connected() const { return true; }
+  // Cada escrita rearma a resposta já consumida (um POST, uma resposta)
+  size_t write(const uint8_t*, size_t n) {
+    bytes += n;
+    if (replyPos >= replyLength) replyPos = 0;
+    return n;
+  }
+  int available() const { return (int)(replyLength - replyPos); }
+  int read() { return replyPos < replyLength ? reply[replyPos++] : -1; }
+  int read(uint8_t* out, size_t n) {
+    size_t k = n < replyLength - replyPos ? n : replyLength - replyPos;
+    memcpy(out, reply + replyPos, k);
+    replyPos += k;
+    return (int)k;
+  }
+  void stop() {}
+};
+
+struct NullUdp {
+  volatile uint64_t bytes = 0;
+
+  int begin(uint16_t) { return 1; }
+  int beginPacket(const char*, uint16_t) { return 1; }
+  size_t write(const uint8_t*, size_t n) {
+    bytes += n;
+    return n;
+  }
+  int endPacket() { return 1; }
+  int parsePacket() { return 0; }
+  int read(uint8_t*, size_t) { return 0; }
+};
+
+static unsigned long benchMillis() { return (unsigned long)(nowNs() / 1000000); }
+
+static const uint8_t mqttConnack[] = { 0x20, 0x03, 0x00, 0x00, 0x00 };
+static const char httpOk[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+static NullSocket mqttSocket;
+static NullSocket httpSocket;
+static NullUdp udpSocket;
+static MqttTransport<NullSocket> mqttBench(mqttSocket, benchMillis, "bench", 1883);
+static HttpBatchTransport<NullSocket> httpBench(httpSocket, benchMillis, "bench", 8080, "/ingest");
+static UdpTransport<NullUdp> udpBench(udpSocket, benchMillis, "bench", 9999);
+
+template <typename Transport>
+static void benchTransport(Transport& transport, const volatile uint64_t& wireBytes, uint32_t iters) {
+  static const char reading[] =
+      "{\"id\":\"A1B2C3D4E5F6\",\"epoch\":7,\"seq\":1234,\"humidity\":45.25,\"ts\":1700000000000,\"period_ms\":5000}";
+  if (!transport.connected()) {
+    TransportConfig config = {};
+    config.clientId = "A1B2C3D4E5F6";
+    config.commandTopic = "sensors/A1B2C3D4E5F6/command";
+    transport.begin(config);
+    transport.connect();
+  }
+  uint64_t before = wireBytes;
+  for (uint32_t i = 0; i < iters; i++) {
+    transport.send("sensors/humidity", ByteSpan(reading, sizeof(reading) - 1), 0);
+    if (i % TRANSPORT_BENCH_FLUSH == TRANSPORT_BENCH_FLUSH - 1) transport.flush();
+  }
+  transport.flush();
+  extraMetric = "wire_bytes_per_msg";
+  extraValue = (double)(wireBytes - before) / iters;
+}
+
+static void benchTransportMqtt(uint32_t iters) {
+  mqttSocket.reply = mqttConnack;
+  mqttSocket.replyLength = sizeof(mqttConnack);
+  benchTransport(mqttBench, mqttSocket.bytes, iters);
+}
+
+static void benchTransportHttp(uint32_t iters) {
+  httpSocket.reply = (const uint8_t*)httpOk;
+  httpSocket.replyLength = sizeof(httpOk) - 1;
+  benchTransport(httpBench, httpSocket.bytes, iters);
+}
+
+static void benchTransportUdp(uint32_t iters) { benchTransport(udpBench, udpSocket.bytes, iters); }
+
+// Envelope AES-128-GCM (seal.h): uma operação = cifrar e autenticar no lugar um bloco de
+// SEAL_BENCH_BLOCK bytes (um lote típico) ou de 64 (uma leitura). O campo extra são os
+// ciclos por byte medidos pelo próprio sealer; MB/s = bytes por operação / ns_per_op * 1000.
+#define SEAL_BENCH_BLOCK 1024
+static uint8_t sealBuffer[SEAL_HEADER_SIZE + SEAL_BENCH_BLOCK + SEAL_TAG_SIZE];
+
+static void benchSeal(uint32_t iters, size_t length) {
+  static const uint8_t key[SEAL_KEY_SIZE] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                                              0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+  PayloadSealer sealer;
+  sealer.begin(key, 1, 7);
+  for (size_t i = 0; i < length; i++) sealBuffer[SEAL_HEADER_SIZE + i] = (uint8_t)(i * 31);
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < iters; i++) {
+    total += sealer.seal("sensors/A1B2C3D4E5F6/batch", sealBuffer, length);
+  }
+  extraMetric = "cycles_per_byte";
+  extraValue = sealer.stats().cyclesPerByte();
+  sinkValue = total;
+}
+
+// Captura binária do ADC (capture.h): uma operação = uma amostra, com o quadro COBS e o CRC
+// a cada CAPTURE_SAMPLES_PER_FRAME. Mostra a taxa que a CPU sustentaria sem o analogRead().
+static void benchCaptureFrame(uint32_t iters) {
+  static CaptureFramer framer;
+  static uint8_t encoded[CAPTURE_ENCODED_MAX];
+  framer.begin(200);
+  uint64_t bytes = 0;
+  uint32_t seed = 12345;
+  for (uint32_t i = 0; i < iters; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    if (framer.add((uint16_t)(2048 + (seed >> 24) - 128), i * 200)) bytes += framer.encode(encoded);
+  }
+  extraMetric = "wire_bytes_per_sample";
+  extraValue = (double)bytes / iters;
+  sinkValue = (uint32_t)bytes;
+}
+
+static void benchSeal1k(uint32_t iters) { benchSeal(iters, SEAL_BENCH_BLOCK); }
+static void benchSeal64(uint32_t iters) { benchSeal(iters, 64); }
+
+struct BenchCase {
+  const char* name;
+  BenchFn fn;
+  uint32_t iters;
+};
+
+static const BenchCase benchCases[] = {
+  { "calibration_map", benchCalibrationMap, BENCH_ITERS * 10 },
+  { "reading_conversion", benchReadingConversion, BENCH_ITERS * 10 },
+  { "payload_serialize", benchPayloadSerialize, BENCH_ITERS },
+  { "command_parse", benchCommandParse, BENCH_ITERS * 10 },
+  { "scan_json_32", benchScanJson, BENCH_ITERS / 10 },
+  { "timestamp", benchTimestamp, BENCH_ITERS },
+  { "aggregate_add", benchAggregateAdd, BENCH_ITERS * 10 },
+  { "filter_ema", benchFilter<EmaPolicy>, BENCH_ITERS * 10 },
+  { "filter_kalman", benchFilter<KalmanPolicy>, BENCH_ITERS * 10 },
+  { "filter_hampel", benchFilter<HampelPolicy>, BENCH_ITERS * 10 },
+  { "ts_encode_sample", benchTsEncode, BENCH_ITERS * 10 },
+  { "transport_mqtt_send", benchTransportMqtt, BENCH_ITERS },
+  { "transport_http_send", benchTransportHttp, BENCH_ITERS },
+  { "transport_udp_send", benchTransportUdp, BENCH_ITERS },
+  { "seal_1k", benchSeal1k, BENCH_ITERS / 10 },
+  { "capture_sample", benchCaptureFrame, BENCH_ITERS * 10 },
+  { "seal_64", benchSeal64, BENCH_ITERS },
+};
+
+// ====== EXECUÇÃO ======
+struct BenchResult {
+  uint64_t ns;
+  uint64_t cycles;
+  uint32_t allocs;
+  uint64_t allocBytes;
+  size_t stackBytes;
+};
+
+struct BenchRun {
+  const BenchCase* benchCase;
+  BenchResult result;
+#ifdef ARDUINO
+  TaskHandle_t parent;
+#else
+  uint8_t* stack;
+#endif
+};
+
+// Corpo executado dentro da pilha isolada do caso
+static void measureCase(BenchRun* run) {
+  const BenchCase* c = run->benchCase;
+  c->fn(c->iters / 10 + 1);  // Aquecimento (cache de instruções, inicializações preguiçosas)
+
+  allocCount = 0;
+  allocBytes = 0;
+  countAllocs = true;
+  uint64_t c0 = readCycles();
+  uint64_t t0 = nowNs();
+  c->fn(c->iters);
+  uint64_t t1 = nowNs();
+  uint64_t c1 = readCycles();
+  countAllocs = false;
+
+  run->result.ns = t1 - t0;
+  run->result.cycles = cyclesBetween(c0, c1);
+  run->result.allocs = allocCount;
+  run->result.allocBytes = allocBytes;
+}
+
+#ifdef ARDUINO
+static void benchTask(void* arg) {
+  BenchRun* run = (BenchRun*)arg;
+  measureCase(run);
+  // No ESP-IDF a marca d'água é em bytes: o mínimo de pilha livre desde a criação da tarefa
+  run->result.stackBytes = BENCH_STACK_SIZE - uxTaskGetStackHighWaterMark(NULL);
+  xTaskNotifyGive(run->parent);
+  vTaskDelete(NULL);
+}
+
+static void runIsolated(BenchRun& run) {
+  run.parent = xTaskGetCurrentTaskHandle();
+  xTaskCreatePinnedToCore(benchTask, "bench", BENCH_STACK_SIZE, &run, 1, NULL, 1);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+#else
+static void* benchThread(void* arg) {
+  measureCase((BenchRun*)arg);
+  return nullptr;
+}
+
+static void runIsolated(BenchRun& run) {
+  static uint8_t stack[BENCH_STACK_SIZE] __attribute__((aligned(64)));
+  memset(stack, STACK_PAINT, sizeof(stack));
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstack(&attr, stack, sizeof(stack));
+  pthread_t thread;
+  pthread_create(&thread, &attr, benchThread, &run);
+  pthread_join(thread, nullptr);
+  pthread_attr_destroy(&attr);
+
+  // A pilha cresce para baixo: o primeiro byte alterado marca o ponto mais fundo usado
+  size_t untouched = 0;
+  while (untouched < sizeof(stack) && stack[untouched] == STACK_PAINT) untouched++;
+  run.result.stackBytes = sizeof(stack) - untouched;
+}
+#endif
+
+static void emit(const char* line) {
+#ifdef ARDUINO
+  Serial.println(line);
+#else
+  puts(line);
+  fflush(stdout);
+#endif
+}
+
+static void runAllBenchmarks() {
+  prepareScanData();
+
+  // Consumo de pilha da própria infraestrutura, descontado de cada caso. A primeira
+  // execução é descartada: no host ela inclui a resolução preguiçosa de símbolos.
+  BenchCase emptyCase = { "empty", benchEmpty, 1 };
+  BenchRun baseline = {};
+  baseline.benchCase = &emptyCase;
+  runIsolated(baseline);
+  baseline = {};
+  baseline.benchCase = &emptyCase;
+  runIsolated(baseline);
+
+  char line[320];
+  for (const BenchCase& c : benchCases) {
+    extraMetric = nullptr;
+    BenchRun run = {};
+    run.benchCase = &c;
+    runIsolated(run);
+
+    const BenchResult& r = run.result;
+    size_t stack = r.stackBytes > baseline.result.stackBytes ? r.stackBytes - baseline.result.stackBytes : 0;
+    char cycles[24];
+    if (hasCycleCounter()) {
+      snprintf(cycles, sizeof(cycles), "%.2f", (double)r.cycles / c.iters);
+    } else {
+      snprintf(cycles, sizeof(cycles), "null");
+    }
+    snprintf(line, sizeof(line),
+             "{\"bench\":\"%s\",\"platform\":\"%s\",\"iters\":%lu,\"ns_per_op\":%.2f,"
+             "\"cycles_per_op\":%s,\"allocs_per_op\":%.3f,\"alloc_bytes_per_op\":%.2f,\"stack_bytes\":%lu}",
+             c.name, BENCH_PLATFORM, (unsigned long)c.iters, (double)r.ns / c.iters, cycles,
+             (double)r.allocs / c.iters, (double)r.allocBytes / c.iters, (unsigned long)stack);
+    if (extraMetric != nullptr) {
+      size_t len = strlen(line) - 1;  // Reabre o objeto para o campo extra
+      snprintf(line + len, sizeof(line) - len, ",\"%s\":%.2f}", extraMetric, extraValue);
+    }
+    emit(line);
+  }
+  emit("{\"bench_done\":true}");
+}
+
+#ifdef ARDUINO
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  // Relógio fixo para que getLocalTime() responda sem esperar pelo NTP
+  struct timeval tv = { 1700000000, 0 };
+  settimeofday(&tv, NULL);
+  runAllBenchmarks();
+}
+
+void loop() { delay(1000); }
+#else
+int main() {
+  runAllBenchmarks();
+  return 0;
+}
+#endif
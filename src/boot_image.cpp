@@ -0,0 +1,35 @@
+#include "boot_image.h"
+
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include <esp_timer.h>
+
+static bool switchToPartition(esp_partition_subtype_t subtype, const char* label) {
+  const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_APP, subtype, NULL);
+  esp_app_desc_t desc;
+  if (part == NULL || esp_ota_get_partition_description(part, &desc) != ESP_OK) {
+    Serial.printf("Imagem '%s' nao encontrada na flash.\n", label);
+    return false;
+  }
+  esp_err_t err = esp_ota_set_boot_partition(part);
+  if (err != ESP_OK) {
+    Serial.printf("Falha ao selecionar a imagem '%s' (erro %d).\n", label, err);
+    return false;
+  }
+  Serial.printf("Proximo boot: imagem '%s' (%s, versao %s).\n", label, part->label, desc.version);
+  return true;
+}
+
+bool switchToSensingImage() {
+  return switchToPartition(ESP_PARTITION_SUBTYPE_APP_OTA_0, "sensoriamento");
+}
+
+bool switchToFactoryImage() {
+  return switchToPartition(ESP_PARTITION_SUBTYPE_APP_FACTORY, "provisionamento");
+}
+
+void reportBootTime(const char* image) {
+  // esp_timer conta desde o início da aplicação (após o bootloader)
+  Serial.printf("BOOT image=%s setup_ms=%llu free_heap=%u\n", image,
+                (unsigned long long)(esp_timer_get_time() / 1000), (unsigned)ESP.getFreeHeap());
+}
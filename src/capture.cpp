@@ -0,0 +1,138 @@
+#include "capture.h"
+
+#include "crc.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#endif
+
+static void putLe(uint8_t* p, uint32_t v, int bytes) {
+  for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// ====== COBS ======
+size_t cobsEncode(const uint8_t* data, size_t length, uint8_t* out) {
+  size_t code = 0;  // Posição do byte de código do grupo atual
+  size_t n = 1;
+  out[code] = 1;
+  for (size_t i = 0; i < length; i++) {
+    if (data[i] != 0) {
+      out[n++] = data[i];
+      out[code]++;
+    }
+    // Grupo fecha num zero ou com 254 bytes não nulos
+    if (data[i] == 0 || out[code] == 0xFF) {
+      if (data[i] != 0 && i + 1 == length) break;  // Grupo cheio no fim: sem código extra
+      code = n++;
+      out[code] = 1;
+    }
+  }
+  return n;
+}
+
+size_t cobsDecode(const uint8_t* data, size_t length, uint8_t* out) {
+  size_t n = 0;
+  size_t i = 0;
+  while (i < length) {
+    uint8_t code = data[i++];
+    if (code == 0 || i + code - 1 > length) return 0;
+    for (uint8_t k = 1; k < code; k++) {
+      if (data[i] == 0) return 0;
+      out[n++] = data[i++];
+    }
+    if (code != 0xFF && i < length) out[n++] = 0;
+  }
+  return n;
+}
+
+// ====== QUADROS ======
+void CaptureFramer::begin(uint32_t periodUs) {
+  _periodUs = (uint16_t)(periodUs > 0xFFFF ? 0xFFFF : periodUs);
+  _seq = 0;
+  _count = 0;
+}
+
+bool CaptureFramer::add(uint16_t raw, uint32_t sampledUs) {
+  if (_count == 0) putLe(_frame + 8, sampledUs, 4);
+  putLe(_frame + CAPTURE_HEADER_SIZE + 2 * _count, raw, 2);
+  _count++;
+  return ready();
+}
+
+size_t CaptureFramer::encode(uint8_t* out) {
+  _frame[0] = CAPTURE_FRAME_VERSION;
+  _frame[1] = _count;
+  putLe(_frame + 2, _periodUs, 2);
+  putLe(_frame + 4, _seq, 4);
+  if (_count == 0) putLe(_frame + 8, 0, 4);
+  size_t length = CAPTURE_HEADER_SIZE + 2 * _count;
+  putLe(_frame + length, crc16(_frame, length), 2);
+  size_t n = cobsEncode(_frame, length + 2, out);
+  out[n++] = 0;
+  _seq++;
+  _count = 0;
+  return n;
+}
+
+#ifdef ARDUINO
+// ====== CAPTURA NO ESP32 ======
+CaptureStats runCapture(uint8_t pin, uint32_t rateHz, uint32_t durationMs, bool (*keepGoing)(),
+                        unsigned long restoreBaud) {
+  CaptureStats stats;
+  if (rateHz == 0) return stats;
+  if (rateHz > CAPTURE_RATE_MAX_HZ) rateHz = CAPTURE_RATE_MAX_HZ;
+  uint32_t periodUs = 1000000 / rateHz;
+
+  // A fila de transmissão só pode mudar com a UART parada; com ela, Serial.write() copia o
+  // quadro e volta na hora, e a interrupção da UART alimenta a FIFO enquanto amostramos
+  Serial.flush();
+  Serial.end();
+  Serial.setTxBufferSize(CAPTURE_TX_BUFFER);
+  Serial.begin(CAPTURE_BAUD);
+  Serial.write((uint8_t)0);  // Delimitador: descarta no receptor o que veio antes
+
+  static CaptureFramer framer;
+  static uint8_t encoded[CAPTURE_ENCODED_MAX];
+  framer.begin(periodUs);
+  uint64_t started = esp_timer_get_time();
+  uint64_t deadline = started;
+  while (durationMs != 0 ? esp_timer_get_time() - started < (uint64_t)durationMs * 1000 : keepGoing()) {
+    uint64_t now;
+    while ((now = esp_timer_get_time()) < deadline) {
+    }
+    uint32_t late = (uint32_t)(now - deadline);
+    if (late > periodUs) {
+      stats.lateSamples++;
+      if (late > stats.maxLateUs) stats.maxLateUs = late;
+    }
+    // Próximo prazo pela grade, sem acumular atraso; se perdeu um prazo inteiro, recomeça
+    deadline = late > periodUs ? now + periodUs : deadline + periodUs;
+
+    uint16_t raw = (uint16_t)analogRead(pin);
+    stats.samples++;
+    if (!framer.add(raw, (uint32_t)now)) continue;
+    size_t n = framer.encode(encoded);
+    if ((size_t)Serial.availableForWrite() < n) {
+      stats.droppedFrames++;  // O número do quadro avança: o receptor vê o buraco
+      continue;
+    }
+    Serial.write(encoded, n);
+    stats.frames++;
+    stats.wireBytes += n;
+  }
+  // Quadro parcial que sobrou e o marcador de fim (vazio); esperam espaço na fila
+  for (bool last = framer.count() == 0; ; last = true) {
+    size_t n = framer.encode(encoded);
+    Serial.write(encoded, n);
+    stats.wireBytes += n;
+    if (last) break;
+  }
+
+  Serial.flush();
+  Serial.end();
+  Serial.setTxBufferSize(0);
+  Serial.begin(restoreBaud);
+  return stats;
+}
+#endif
@@ -0,0 +1,39 @@
+#include "clock.h"
+
+static WallClockSource wallClockSource = nullptr;
+
+void setWallClockSource(WallClockSource source) { wallClockSource = source; }
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <sys/time.h>
+#include "time.h"
+
+unsigned long long getUnixTimestampMillis() {
+  if (wallClockSource != nullptr) {
+    unsigned long long synced = wallClockSource();
+    if (synced != 0) return synced;
+  }
+  struct tm timeinfo;
+  if (!getLocalTime(&timeinfo)) {
+    Serial.println("Falha ao obter o tempo");
+    return 0;
+  }
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return (unsigned long long)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+#else
+#include <time.h>
+
+unsigned long long getUnixTimestampMillis() {
+  if (wallClockSource != nullptr) {
+    unsigned long long synced = wallClockSource();
+    if (synced != 0) return synced;
+  }
+  struct timespec ts;
+  if (clock_gettime(CLOCK_REALTIME, &ts) != 0) return 0;
+  return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+#endif
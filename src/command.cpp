@@ -0,0 +1,95 @@
+#include "command.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Palavras-chave conhecidas e a quantidade de argumentos que cada uma aceita
+struct CommandSpec {
+  const char* keyword;
+  CommandType type;
+  uint8_t minArgs;
+  uint8_t maxArgs;
+  bool text;  // Um argumento de texto (o resto da linha) no lugar dos numéricos
+};
+
+static const CommandSpec commandSpecs[] = {
+  { "RESET", CMD_RESET, 0, 0, false },
+  { "RATE", CMD_RATE, 2, 2, false },
+  { "RAW", CMD_RAW, 1, 1, false },
+  { "BATCH", CMD_BATCH, 1, 1, false },
+  { "HISTORY", CMD_HISTORY, 2, 3, false },
+  { "INFLIGHT", CMD_INFLIGHT, 1, 1, false },
+  { "TRANSPORT", CMD_TRANSPORT, 1, 1, false },
+  { "BROKERS", CMD_BROKERS, 0, 0, true },
+  { "TIME", CMD_TIME, 3, 3, false },
+  { "CAPTURE", CMD_CAPTURE, 1, 2, false },
+  { "FILTER", CMD_FILTER, 1, 2, false },
+};
+
+// Compara o token com a palavra-chave (em maiúsculas), ignorando a caixa
+static bool tokenEquals(const uint8_t* token, size_t length, const char* keyword) {
+  if (strlen(keyword) != length) return false;
+  for (size_t i = 0; i < length; i++) {
+    if (toupper(token[i]) != keyword[i]) return false;
+  }
+  return true;
+}
+
+// Avança até o próximo token; retorna seu tamanho (0 se acabou)
+static size_t nextToken(const uint8_t* payload, size_t length, size_t& pos) {
+  while (pos < length && isspace(payload[pos])) pos++;
+  size_t start = pos;
+  while (pos < length && !isspace(payload[pos])) pos++;
+  return pos - start;
+}
+
+static bool parseNumber(const uint8_t* token, size_t length, double& value) {
+  char text[32];
+  if (length >= sizeof(text)) return false;
+  memcpy(text, token, length);
+  text[length] = '\0';
+  char* end;
+  value = strtod(text, &end);
+  return end == text + length;
+}
+
+Command parseCommand(const uint8_t* payload, size_t length) {
+  Command command = {};
+  size_t pos = 0;
+  size_t tokenLength = nextToken(payload, length, pos);
+  if (tokenLength == 0) {
+    command.type = CMD_EMPTY;
+    return command;
+  }
+
+  command.type = CMD_INVALID;
+  const uint8_t* keyword = payload + pos - tokenLength;
+  const CommandSpec* spec = nullptr;
+  for (const CommandSpec& candidate : commandSpecs) {
+    if (tokenEquals(keyword, tokenLength, candidate.keyword)) spec = &candidate;
+  }
+  if (spec == nullptr) return command;
+
+  if (spec->text) {
+    while (pos < length && isspace(payload[pos])) pos++;
+    size_t end = length;
+    while (end > pos && isspace(payload[end - 1])) end--;
+    command.text = payload + pos;
+    command.textLength = end - pos;
+    command.type = spec->type;
+    return command;
+  }
+
+  while ((tokenLength = nextToken(payload, length, pos)) > 0) {
+    if (command.argCount == spec->maxArgs) return command;
+    if (!parseNumber(payload + pos - tokenLength, tokenLength, command.args[command.argCount])) {
+      return command;
+    }
+    command.argCount++;
+  }
+  if (command.argCount < spec->minArgs) return command;
+
+  command.type = spec->type;
+  return command;
+}
@@ -0,0 +1,41 @@
+/*
+===========================================================================================
+ ==         ESP32 - Sensor de Umidade - Imagem de Fábrica (Provisionamento)          ==
+===========================================================================================
+ == Gravada na partição "factory". Só contém o portal de configuração: depois que a    ==
+ == rede informada é validada, aponta o boot para a imagem de sensoriamento (ota_0) e   ==
+ == reinicia. A imagem de sensoriamento volta para cá quando as credenciais são apagadas.==
+===========================================================================================
+*/
+
+#include <WiFi.h>
+#include <Preferences.h>
+#include "portal.h"
+#include "boot_image.h"
+
+Preferences preferences;
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("\n\nIniciando imagem de provisionamento...");
+
+  preferences.begin("sensor-config", false);
+  if (preferences.getString("ssid", "") != "" && switchToSensingImage()) {
+    Serial.println("Dispositivo ja configurado. Reiniciando na imagem de sensoriamento...");
+    ESP.restart();
+  }
+
+  startConfigurationPortal();
+  reportBootTime("factory");
+}
+
+void loop() {
+  if (servicePortal()) {
+    if (switchToSensingImage()) {
+      delay(100);
+      ESP.restart();
+    }
+    Serial.println("Grave a imagem de sensoriamento em ota_0 (pio run -e sensing -t upload).");
+  }
+  delay(1);
+}
@@ -9,31 +9,172 @@
  == 4. Após o usuário fornecer as credenciais, salva-as e conecta à rede principal.      ==
  == 5. Usa seu endereço MAC como um ID único para se identificar na rede MQTT.           ==
  == 6. Lê um sensor de umidade de solo real (HW-080) e envia os dados via MQTT.          ==
+ == 7. Continua coletando leituras enquanto aguarda configuração e as envia depois.   ==
 ===========================================================================================
 */
 
 // --- Bibliotecas ---
 #include <WiFi.h>
-#include <WebServer.h>
-#include <DNSServer.h>
-#include <PubSubClient.h>
-#include <ArduinoJson.h>
 #include <Preferences.h>
 #include "time.h"
-
-// ====== OBJETOS GLOBAIS ======
-WebServer server(80);
-DNSServer dnsServer;
-Preferences preferences;
-WiFiClient espClient;
-PubSubClient mqtt(espClient);
+#include "outbound_queue.h"
+#include "alarms.h"
+#include "calibration.h"
+#include "command.h"
+#include "payload.h"
+#include "clock.h"
+#include "boot_image.h"
+#include "scheduler.h"
+#include "adaptive_rate.h"
+#include "aggregator.h"
+#include "ts_codec.h"
+#include "ts_store.h"
+#include "sequence.h"
+#include "transport.h"
+#include "mqtt_transport.h"
+#include "http_transport.h"
+#include "udp_transport.h"
+#include "tls_client.h"
+#include "async_net.h"
+#include "seal.h"
+#include "time_sync.h"
+#include "capture.h"
+#include "filter.h"
+#include <esp_timer.h>
+#ifndef AGROFLOW_SENSING_IMAGE
+#include "portal.h"
+#endif
 
 // ====== CONFIGURAÇÕES GLOBAIS ======
 #define MQTT_HOST "test.mosquitto.org"
+#ifndef MQTT_TLS
+#define MQTT_TLS 0                    // 1: MQTT sobre TLS com retomada de sessão (tls_client.h, env esp32dev_tls)
+#endif
+#if MQTT_TLS
+#define MQTT_PORT 8883
+#ifndef MQTT_BROKERS_DEFAULT
+#define MQTT_BROKERS_DEFAULT "test.mosquitto.org:8883,broker.hivemq.com:8883,broker.emqx.io:8883"
+#endif
+#else
 #define MQTT_PORT 1883
+#ifndef MQTT_BROKERS_DEFAULT
+#define MQTT_BROKERS_DEFAULT "test.mosquitto.org:1883,broker.hivemq.com:1883,broker.emqx.io:1883"
+#endif
+#endif
+// -DMQTT_TLS_CA='"-----BEGIN CERTIFICATE-----\n..."' verifica o broker; sem ela, só cifra
+#define BROKER_POLL_MS 100            // Passo do DNS e do probe dos brokers (broker_pool.h), sem bloquear
 #define MQTT_PUB_TOPIC "sensors/humidity"
+// Transporte da imagem, escolhido na build (-DUPLINK_TRANSPORT=2) para comparar por local
+#define UPLINK_TRANSPORT_MQTT 0       // MQTT sobre TCP ou MQTT-SN sobre UDP, escolhido no boot
+#define UPLINK_TRANSPORT_HTTP 1       // POST HTTP/1.1 em lote numa conexão keep-alive (http_transport.h)
+#define UPLINK_TRANSPORT_UDP 2        // Datagramas UDP sem confirmação (udp_transport.h)
+#ifndef UPLINK_TRANSPORT
+#define UPLINK_TRANSPORT UPLINK_TRANSPORT_MQTT
+#endif
+#define UPLINK_MQTT 0                 // MQTT sobre TCP (mqtt_client.h)
+#define UPLINK_MQTTSN 1               // MQTT-SN sobre UDP, via gateway (mqttsn_client.h)
+#ifndef UPLINK_TRANSPORT_DEFAULT
+#define UPLINK_TRANSPORT_DEFAULT UPLINK_MQTT  // Na build: -DUPLINK_TRANSPORT_DEFAULT=1; em campo: "TRANSPORT <0|1>"
+#endif
+#ifndef MQTTSN_GATEWAY_HOST
+#define MQTTSN_GATEWAY_HOST "mqttsn-gateway.local"
+#endif
+#define MQTTSN_GATEWAY_PORT 10000
+#ifndef INGEST_HOST
+#define INGEST_HOST "agroflow-ingest.local"  // Coletor HTTP/UDP (scripts/uplink_sink.py)
+#endif
+#define HTTP_INGEST_PORT 8080
+#define HTTP_INGEST_PATH "/ingest"
+#define UDP_INGEST_PORT 9999
+#define MQTTSN_TOPIC_READINGS 1       // Ids predefinidos no gateway (scripts/mqttsn_gateway.py -p)
+#define MQTTSN_TOPIC_METRICS 2        // sensors/<id>/metrics
 #define RESET_PIN_1 22
 #define RESET_PIN_2 23
+#define SERIAL_BAUD 115200
+#define CAPTURE_PIN 21                // Ligado ao RESET_PIN_2 (GND): captura binária do ADC enquanto ligado
+#ifdef AGROFLOW_SENSING_IMAGE
+#define BOOT_IMAGE_NAME "sensing"
+#else
+#define BOOT_IMAGE_NAME "hybrid"
+#endif
+#define ADC_SAMPLE_MS 100             // Amostragem rápida do ADC (10 Hz)
+#define SAMPLE_INTERVAL_MS 5000       // Decimação: período inicial de leitura (média das amostras)
+#define PUBLISH_INTERVAL_MS 5000      // Publicação da telemetria acumulada (segue o período adaptativo)
+#define RATE_MIN_PERIOD_MS 1000       // Período adaptativo mínimo (sinal mudando rápido)
+#define RATE_MAX_PERIOD_MS 300000     // Período adaptativo máximo (sinal estável)
+#define HOUSEKEEPING_MS 200           // Botão de reset e pino de captura
+#define WIFI_CHECK_MS 1000            // Estado do WiFi (reconexão em segundo plano)
+#define WIFI_RETRY_MS 20000           // Espera pela primeira tentativa antes de tentar de novo (dobra a cada falha)
+#define WIFI_RETRY_MAX_MS 300000
+#define WIFI_PORTAL_AFTER_MS 20000    // Sem rede por esse tempo, a imagem híbrida abre o portal junto com as tentativas
+#define UPLINK_CHECK_MS 1000          // Verificação da conexão do uplink (no máximo uma tentativa por vez)
+#define UPLINK_POLL_MS 20             // Nova conferência com o CONNACK a caminho ou a janela QoS 1 cheia
+#define UPLINK_BACKOFF_MS 5000        // Espera depois da primeira falha seguida sem pool de brokers (dobra a cada nova)
+#define UPLINK_BACKOFF_MAX_MS 60000
+#ifndef LOOP_IDLE_MAX_MS
+#define LOOP_IDLE_MAX_MS 10           // Espera máxima por volta do loop(), para atender a rede
+#endif
+#define SAMPLE_BUFFER_SIZE 720        // Leituras guardadas em RAM (1 hora a cada 5 s)
+#define PUBLISH_BURST_MAX 10          // Máximo de mensagens de telemetria por volta do loop()
+#define ALARM_QUEUE_SIZE 16           // Eventos de alarme aguardando publicação
+#define SUMMARY_QUEUE_SIZE 32         // Resumos de janela aguardando publicação
+#define AGG_WINDOW_SHORT_MS 60000     // Janela curta de agregação (1 min)
+#define AGG_WINDOW_LONG_MS 900000     // Janela longa de agregação (15 min)
+#define PUBLISH_RAW_DEFAULT true      // Publica as leituras além dos resumos (comando "RAW 0|1")
+#define METRICS_INTERVAL_MS 60000     // Intervalo de publicação das métricas do dispositivo
+#define BATCH_SIZE_DEFAULT 0          // Leituras por bloco comprimido (0 = uma mensagem JSON por leitura)
+#define BATCH_SIZE_MAX 120            // Limite do comando "BATCH <n>" (10 min a 5 s)
+#define BATCH_MAX_AGE_MS 900000       // Bloco incompleto é enviado quando a leitura mais antiga atinge 15 min
+#define BATCH_VALUE_SCALE 2           // Umidade em centésimos de ponto percentual no bloco
+#define MQTT_QOS_DATA 1               // Alarmes, resumos, leituras e blocos com PUBACK
+#define MQTT_QOS_METRICS -1           // Métricas sem confirmação: QoS -1 no MQTT-SN (nem conexão), 0 no MQTT
+#define MQTT_INFLIGHT_WINDOW 8        // Mensagens QoS 1 em voo sem esperar PUBACK (comando "INFLIGHT <n>")
+#define MQTT_SESSION_EXPIRY_S 3600    // Broker guarda inscrição e comandos por 1 h com o dispositivo fora do ar
+#define METRICS_BUFFER_SIZE 4096      // JSON das métricas do dispositivo
+#define HISTORY_FACTOR_MAX 720        // Maior fator de redução aceito pelo comando "HISTORY"
+#define HISTORY_RETRY_MS 1000         // Nova tentativa de envio do histórico (sem MQTT)
+#define TIME_SYNC_INTERVAL_MS 60000   // Troca com o servidor de horário (scripts/time_server.py)
+#define TIME_SYNC_FAST_MS 5000        // Primeiras trocas do boot, até a reta ter pontos suficientes
+#define TIME_SYNC_FAST_REQUESTS 8
+#define CAPTURE_DURATION_DEFAULT_S 10 // Duração do comando "CAPTURE <hz>" sem segundos
+#define CAPTURE_PIN_RATE_HZ 5000      // Taxa da captura iniciada pelo CAPTURE_PIN
+#define MQTT_QOS_TIME 0               // Pedido de horário sem reenvio: um reenvio só mediria a fila
+// Filtro de cada amostra do ADC (filter.h), escolhido na build (-DSENSOR_FILTER=1); os
+// parâmetros mudam em campo com "FILTER <p1> [p2]"
+#define SENSOR_FILTER_EMA 0
+#define SENSOR_FILTER_KALMAN 1
+#define SENSOR_FILTER_HAMPEL 2        // Só troca os picos pela mediana; o ruído fica para a média da decimação
+#ifndef SENSOR_FILTER
+#define SENSOR_FILTER SENSOR_FILTER_HAMPEL
+#endif
+
+// ====== OBJETOS GLOBAIS ======
+Preferences preferences;
+WiFiClient espClient;
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_HTTP
+typedef HttpBatchTransport<WiFiClient> Uplink;
+Uplink uplink(espClient, millis, INGEST_HOST, HTTP_INGEST_PORT, HTTP_INGEST_PATH);
+#elif UPLINK_TRANSPORT == UPLINK_TRANSPORT_UDP
+WiFiUDP uplinkUdp;
+typedef UdpTransport<WiFiUDP> Uplink;
+Uplink uplink(uplinkUdp, millis, INGEST_HOST, UDP_INGEST_PORT);
+#else
+void loadBrokers();
+TcpProbe brokerProbe;
+BrokerPool<TcpProbe> brokers(brokerProbe, millis, netResolve);
+WiFiUDP snUdp;
+#if MQTT_TLS
+typedef TlsClient MqttSocket;
+TlsClient mqttSocket;
+#else
+typedef WiFiClient MqttSocket;
+WiFiClient& mqttSocket = espClient;
+#endif
+MqttTransport<MqttSocket, TcpProbe> mqttUplink(mqttSocket, millis, MQTT_HOST, MQTT_PORT);
+MqttSnTransport<WiFiUDP> mqttSnUplink(snUdp, millis, MQTTSN_GATEWAY_HOST, MQTTSN_GATEWAY_PORT);
+typedef SwitchableTransport<MqttTransport<MqttSocket, TcpProbe>, MqttSnTransport<WiFiUDP> > Uplink;
+Uplink uplink(mqttUplink, mqttSnUplink);
+#endif
 
 // --- NOVO: CONFIGURAÇÕES DO SENSOR ---
 #define SENSOR_PIN 34 // Pino analógico onde o sensor está conectado (AOUT -> GPIO 34)
@@ -45,6 +186,35 @@ PubSubClient mqtt(espClient);
 const int DRY_VALUE = 2850; // Valor de exemplo para sensor seco (maior valor)
 const int WET_VALUE = 1350; // Valor de exemplo para sensor em água (menor valor)
 
+// --- Filtro das amostras do ADC (parâmetros na NVS, por política) ---
+#if SENSOR_FILTER == SENSOR_FILTER_EMA
+SensorFilter<EmaPolicy> sensorFilter;
+#elif SENSOR_FILTER == SENSOR_FILTER_KALMAN
+SensorFilter<KalmanPolicy> sensorFilter;
+#else
+SensorFilter<HampelPolicy> sensorFilter;
+#endif
+
+// --- Limiares de Alarme (publicados imediatamente em sensors/<id>/alarm) ---
+const AlarmThresholds alarmThresholds = {
+  20.0,  // dryBelow: solo seco abaixo de 20%
+  90.0,  // saturatedAbove: solo encharcado acima de 90%
+  3.0,   // hysteresis: o alarme só normaliza 3% depois do limite
+  100,   // disconnectedBelow: saída do sensor perto de 0 V
+  4000,  // railAbove: ADC no fundo de escala (máximo 4095)
+  3,     // debounceSamples: 300 ms seguidos a 10 Hz para fio solto e fundo de escala
+  100,   // settleSamples: 10 s válidos depois de uma amostra inválida (o Kalman leva ~7 s a 1%)
+};
+
+// --- Amostragem Adaptativa (limites ajustáveis pelo comando "RATE <min_ms> <max_ms>") ---
+const AdaptiveRateConfig adaptiveRateConfig = {
+  RATE_MIN_PERIOD_MS,
+  RATE_MAX_PERIOD_MS,
+  0.5,    // slopeThreshold: variação acima de 0,5%/min acelera a amostragem
+  1.5,    // stddevThreshold: desvio padrão acima de 1,5% acelera a amostragem
+  30000,  // tauMs: constante de tempo da média e da variância
+};
+
 
 // --- Configurações do Servidor de Horário (NTP) ---
 const char* ntpServer = "pool.ntp.org";
@@ -53,61 +223,132 @@ const int daylightOffset_sec = 0;      // Sem horário de verão
 
 // --- Variáveis de Operação ---
 String uniqueId = "";
-long lastMsg = 0;
-char msgBuffer[200];
+char msgBuffer[256];
 char commandTopic[100];
+char alarmTopic[100];
+char metricsTopic[100];
+char summaryTopic[100];
+char batchTopic[100];
+char historyTopic[100];
+char timeTopic[100];
+bool publishRaw = PUBLISH_RAW_DEFAULT;
+// Reinícios pedidos por comando só acontecem depois do callback, quando o PUBACK já saiu:
+// com sessão persistente o broker entregaria o mesmo comando de novo a cada boot
+bool resetRequested = false;
+bool restartRequested = false;
+// Captura binária do ADC (capture.h) pedida por comando ou pelo CAPTURE_PIN; roda no loop(),
+// fora do callback, porque bloqueia (duração 0: enquanto o pino estiver ligado)
+uint32_t captureRateHz = 0;
+uint32_t captureDurationMs = 0;
+uint8_t batchSize = BATCH_SIZE_DEFAULT;
+// Compartilhado pelos blocos de telemetria e de histórico (cada envio termina antes do
+// próximo). O bloco é montado em batchBlock, com folga antes e depois para o envelope
+// cifrado (seal.h), que é feito no lugar.
+#define BATCH_BLOCK_SIZE (TS_BLOCK_HEADER_SIZE + BATCH_SIZE_MAX * TS_SAMPLE_MAX_BITS / 8 + 1)
+uint8_t batchBuffer[SEAL_HEADER_SIZE + BATCH_BLOCK_SIZE + SEAL_TAG_SIZE];
+uint8_t* const batchBlock = batchBuffer + SEAL_HEADER_SIZE;
+PayloadSealer sealer;
+bool bootEpochSaved = false;  // Época nova gravada na NVS: o nonce do envelope não se repete
 
-// PÁGINA HTML DE CONFIGURAÇÃO (ARMAZENADA NA MEMÓRIA FLASH)
-const char index_html[] PROGMEM = R"rawliteral(
-<!DOCTYPE HTML><html><head>
-  <title>Configurar Sensor AgroFlow</title>
-  <meta name="viewport" content="width=device-width, initial-scale=1">
-  <style>
-    body { font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, Helvetica, Arial, sans-serif; display: flex; justify-content: center; align-items: center; min-height: 100vh; background-color: #f0f2f5; margin: 0; }
-    .container { background-color: white; padding: 2rem; border-radius: 8px; box-shadow: 0 4px 12px rgba(0,0,0,0.1); width: 100%; max-width: 400px; }
-    h2 { color: #1a202c; text-align: center; }
-    label { display: block; margin-bottom: 0.5rem; font-weight: 600; color: #4a5568; }
-    input, select { width: 100%; padding: 0.75rem; margin-bottom: 1rem; border: 1px solid #cbd5e0; border-radius: 4px; box-sizing: border-box; }
-    button { width: 100%; background-color: #2e7d32; color: white; padding: 0.85rem; border: none; border-radius: 4px; cursor: pointer; font-size: 1rem; }
-    .wifi-scan { display: flex; align-items: center; gap: 0.5rem; }
-    #spinner { cursor: pointer; font-size: 1.5rem; }
-  </style>
-  <script>
-    function scanNetworks() {
-      const select = document.getElementById('ssid');
-      const spinner = document.getElementById('spinner');
-      select.innerHTML = '<option>Procurando redes...</option>';
-      fetch('/scan').then(r => r.json()).then(nets => {
-        select.innerHTML = '<option value="">Selecione uma rede</option>';
-        nets.forEach(n => {
-          const opt = document.createElement('option');
-          opt.value = n.ssid;
-          opt.textContent = `${n.ssid} (${n.rssi}dBm)`;
-          select.appendChild(opt);
-        });
-      }).catch(e => {
-        select.innerHTML = '<option>Erro ao buscar redes</option>';
-      });
-    }
-    window.onload = scanNetworks;
-  </script>
-</head><body>
-  <div class="container">
-    <h2>Conectar Sensor à Rede</h2>
-    <form action="/save" method="POST">
-      <label for="ssid">Rede Wi-Fi:</label>
-      <div class="wifi-scan">
-        <select id="ssid" name="ssid" required></select>
-        <span id="spinner" onclick="scanNetworks()">&#8635;</span>
-      </div>
-      <label for="password">Senha da Rede:</label>
-      <input type="password" id="password" name="password">
-      <button type="submit">Salvar e Conectar</button>
-    </form>
-  </div>
-</body></html>
-)rawliteral";
+// Leituras aguardando publicação. O horário é guardado em millis() porque o relógio só é
+// sincronizado depois que o dispositivo está na rede; o timestamp real é calculado no envio.
+struct Reading {
+  unsigned long sampledAt;
+  float humidity;
+  uint32_t periodMs;  // Período de amostragem em vigor (para o backend reconstruir a série)
+};
+
+// Fila de saída em faixas por prioridade: alarmes são publicados antes de tudo, depois os
+// resumos de janela; a telemetria bruta continua saindo em rajadas curtas.
+OutboundLane<AlarmEvent, ALARM_QUEUE_SIZE> alarmLane;
+OutboundLane<WindowSummary, SUMMARY_QUEUE_SIZE> summaryLane;
+OutboundLane<Reading, SAMPLE_BUFFER_SIZE> telemetryLane;
+AlarmMonitor alarmMonitor(alarmThresholds);
+AdaptiveRate adaptiveRate(adaptiveRateConfig);
+unsigned long lastDecimation = 0;
+
+// Acumulador da amostragem rápida, esvaziado a cada decimação
+uint32_t adcSum = 0;
+uint16_t adcCount = 0;
+
+// Estatísticas por janela, alimentadas com cada amostra do ADC
+WindowAggregator shortWindow(AGG_WINDOW_SHORT_MS);
+WindowAggregator longWindow(AGG_WINDOW_LONG_MS);
+
+// Histórico em flash e a consulta em andamento (uma por vez; uma nova substitui a anterior)
+TsStore history;
+struct HistoryQuery {
+  bool active;
+  unsigned long long toMs;
+  uint16_t factor;
+  TsCursor cursor;
+};
+HistoryQuery historyQuery = {};
+
+// Numeração das mensagens por fluxo, com a época de boot guardada na NVS (sequence.h).
+// Toda leitura decimada recebe um número, mesmo sem ser publicada ("RAW 0"), para que a
+// telemetria e o histórico em flash usem a mesma numeração.
+SequenceCounter readingSeq;
+SequenceCounter alarmSeq;
+SequenceCounter summarySeq;
+SequenceCounter metricsSeq;
+
+// --- Escalonador ---
+uint64_t schedulerClock() { return (uint64_t)esp_timer_get_time(); }
+Scheduler scheduler(schedulerClock);
+int decimateJob = -1;
+int publishJob = -1;
+int historyJob = -1;
+int brokerJob = -1;
+int timeSyncJob = -1;
+int connectJob = -1;
+bool wallClockAligned = false;
+
+// Reconexão do uplink pelo escalonador: o ritmo vem do backoff do pool de brokers (MQTT) ou,
+// sem ele, do backoff local abaixo
+bool uplinkStarted = false;
+unsigned long connectRetryAt = 0;
+uint32_t connectBackoffMs = 0;
+
+// Reconexão do WiFi com as credenciais guardadas (wifiTask)
+bool wifiWaiting = false;     // Estação fora da rede desde wifiLostAt
+unsigned long wifiLostAt = 0;
+unsigned long wifiRetryAt = 0;
+uint32_t wifiBackoffMs = 0;
+
+// Relógio disciplinado pelo servidor de horário (time_sync.h), sobre o esp_timer; enquanto
+// não há resposta, getUnixTimestampMillis() continua no NTP do sistema
+TimeSync timeSync;
+unsigned long long syncedClockMillis() {
+  int64_t us = timeSync.nowUs((uint64_t)esp_timer_get_time());
+  return us > 0 ? (unsigned long long)us / 1000 : 0;
+}
 
+// Incrementa a época de boot. Fica num namespace próprio da NVS para sobreviver ao
+// clearConfigAndRestart(): a numeração nunca volta atrás, nem depois de um reset.
+uint32_t nextBootEpoch() {
+  Preferences sequencePrefs;
+  sequencePrefs.begin("sequence", false);
+  uint32_t epoch = sequencePrefs.getUInt("epoch", 0) + 1;
+  bootEpochSaved = sequencePrefs.putUInt("epoch", epoch) == sizeof(epoch);
+  sequencePrefs.end();
+  return epoch;
+}
+
+// Chave de cifra do dispositivo, gravada pelo portal (seal_key, com o id em seal_kid); sem
+// ela, ou sem a época gravada, os blocos saem abertos
+void loadSealKey(uint32_t epoch) {
+  uint8_t key[SEAL_KEY_SIZE];
+  if (preferences.getBytes("seal_key", key, sizeof(key)) != sizeof(key)) return;
+  bool ok = sealer.begin(key, preferences.getUChar("seal_kid", 0), bootEpochSaved ? epoch : 0);
+  memset(key, 0, sizeof(key));
+  if (!ok) {
+    Serial.println("Chave de cifra presente, mas o envelope nao pode ser usado: blocos sairao abertos.");
+    return;
+  }
+  Serial.print("Blocos cifrados com AES-GCM, chave ");
+  Serial.println(sealer.keyId());
+}
 
 // ====== FUNÇÕES AUXILIARES (DA VERSÃO ORIGINAL) ======
 void clearConfigAndRestart() {
@@ -117,154 +358,748 @@ void clearConfigAndRestart() {
   ESP.restart();
 }
 
-unsigned long long getUnixTimestampMillis() {
-  time_t now;
-  struct tm timeinfo;
-  if (!getLocalTime(&timeinfo)) {
-    Serial.println("Falha ao obter o tempo");
-    return 0;
-  }
-  time(&now);
-  return (unsigned long long)now * 1000;
-}
-
-// ====== FUNÇÕES DO PORTAL DE CONFIGURAÇÃO ======
-void handleRoot() { server.send(200, "text/html", index_html); }
-void handleScan() {
-  int n = WiFi.scanNetworks();
-  String json = "[";
-  for (int i = 0; i < n; ++i) {
-    if (WiFi.SSID(i) == "") continue;
-    if (i > 0) json += ",";
-    json += "{\"ssid\":\"" + WiFi.SSID(i) + "\",\"rssi\":" + String(WiFi.RSSI(i)) + "}";
-  }
-  json += "]";
-  server.send(200, "application/json", json);
-}
-void handleSave() {
-  preferences.putString("ssid", server.arg("ssid"));
-  preferences.putString("password", server.arg("password"));
-  String responsePage = "<html><body style='font-family: sans-serif; text-align: center; margin-top: 50px;'>";
-  responsePage += "<h2>Configuracoes salvas!</h2>";
-  responsePage += "<p>O dispositivo sera reiniciado em 3 segundos para se conectar a sua rede.</p>";
-  responsePage += "</body></html>";
-  server.send(200, "text/html", responsePage);
-  delay(3000);
-  ESP.restart();
+// Parâmetros do filtro ficam numa chave por política: os de uma não valem para a outra
+void filterPrefsKey(char* key, size_t capacity) {
+  snprintf(key, capacity, "filter_%s", sensorFilter.name());
 }
-void startConfigurationPortal() {
-  byte mac[6];
-  WiFi.macAddress(mac);
-  String apName = "AgroFlowSensor-" + String(mac[3], HEX) + String(mac[4], HEX) + String(mac[5], HEX);
-  apName.toUpperCase();
-  WiFi.softAP(apName.c_str());
-  IPAddress ip = WiFi.softAPIP();
-  Serial.println("\n--- MODO DE CONFIGURACAO VIA PORTAL WEB ---");
-  Serial.print("Conecte-se a rede: ");
-  Serial.println(apName);
-  Serial.print("Acesse o IP: http://");
-  Serial.println(ip);
-  dnsServer.start(53, "*", ip);
-  server.on("/", HTTP_GET, handleRoot);
-  server.on("/scan", HTTP_GET, handleScan);
-  server.on("/save", HTTP_POST, handleSave);
-  server.onNotFound(handleRoot);
-  server.begin();
-  Serial.println("Servidor web iniciado. Aguardando configuracao...");
-  while (true) {
-    dnsServer.processNextRequest();
-    server.handleClient();
-    delay(1);
-  }
+
+void loadFilterParams() {
+  char key[16];
+  filterPrefsKey(key, sizeof(key));
+  float params[2];
+  if (preferences.getBytes(key, params, sizeof(params)) != sizeof(params)) return;
+  if (!sensorFilter.setParams(params[0], params[1])) preferences.remove(key);
 }
 
 // --- NOVO: FUNÇÃO PARA LER O SENSOR ---
+// Enfileira a transição de um alarme e antecipa a publicação
+void emitAlarm(const AlarmEvent& event) {
+  Serial.print("Alarme ");
+  Serial.print(alarmName(event.type));
+  Serial.println(event.active ? " disparado." : " normalizado.");
+  alarmLane.push(event, millis(), alarmSeq.next());
+  scheduler.runNow(publishJob);  // Alarme não espera o próximo ciclo de publicação
+}
+
+// Amostragem rápida: acumula o valor do pino do sensor, já filtrado (picos e ruído do ADC).
+// Os alarmes são avaliados aqui, a cada amostra (alarms.h): um pico curto sumiria na média
+// da decimação.
+void sampleAdc() {
+  int pin = analogRead(SENSOR_PIN);
+  int raw = sensorFilter.update(pin);
+  adcSum += raw;
+  adcCount++;
+
+  float humidity = humidityFromRaw(raw, DRY_VALUE, WET_VALUE);
+  shortWindow.add(humidity);
+  longWindow.add(humidity);
+  alarmMonitor.update(pin, raw, humidity, emitAlarm);
+}
+
+// Leitura decimada: média das amostras acumuladas desde a última chamada
 float readSensorData() {
-  // Lê o valor analógico bruto do pino do sensor
-  int rawValue = analogRead(SENSOR_PIN);
-  
+  if (adcCount == 0) sampleAdc();
+  int rawValue = (int)(adcSum / adcCount);
+
   // Imprime o valor bruto para ajudar na calibração
   Serial.print("Valor bruto do sensor: ");
-  Serial.println(rawValue);
+  Serial.print(rawValue);
+  Serial.print(" (media de ");
+  Serial.print(adcCount);
+  Serial.println(" amostras)");
+  adcSum = 0;
+  adcCount = 0;
 
-  // Mapeia o valor lido para uma porcentagem (0-100%)
-  // A ordem de DRY e WET é invertida na função map() porque um valor
-  // analógico mais ALTO (seco) corresponde a 0% de umidade.
-  int humidityPercent = map(rawValue, DRY_VALUE, WET_VALUE, 0, 100);
+  // Mapeia o valor lido para uma porcentagem (0-100%), limitada ao intervalo válido
+  return humidityFromRaw(rawValue, DRY_VALUE, WET_VALUE);
+}
 
-  // Garante que o valor final esteja sempre dentro do intervalo de 0 a 100
-  humidityPercent = constrain(humidityPercent, 0, 100);
 
-  return (float)humidityPercent;
+// Aplica o período adaptativo aos jobs de leitura e de publicação
+void applySamplePeriod(uint32_t periodMs) {
+  if (periodMs == scheduler.period(decimateJob)) return;
+  Serial.print("Novo periodo de amostragem: ");
+  Serial.print(periodMs);
+  Serial.println(" ms");
+  scheduler.setPeriod(decimateJob, periodMs);
+  scheduler.setPeriod(publishJob, periodMs);
 }
 
 
 // ====== FUNÇÕES DE OPERAÇÃO (WIFI & MQTT) ======
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
+  uint64_t receivedUs = (uint64_t)esp_timer_get_time();  // t4 da troca de horário, antes dos prints
   Serial.print("Mensagem recebida no topico: ");
   Serial.println(topic);
-  if (length > 0) {
-    payload[length] = '\0';
-    String message = (char*)payload;
-    Serial.print("Payload recebido: '");
-    Serial.print(message);
-    Serial.println("'");
-    message.trim();
-    if (message.equalsIgnoreCase("RESET")) {
+  Serial.print("Payload recebido: '");
+  Serial.write(payload, length);
+  Serial.println("'");
+
+  Command command = parseCommand(payload, length);
+  switch (command.type) {
+    case CMD_RESET:
       Serial.println("Comando de reset valido! Reiniciando...");
-      clearConfigAndRestart();
-    } else {
-      Serial.println("Comando invalido.");
+      resetRequested = true;
+      break;
+    case CMD_RATE:
+      adaptiveRate.setLimits((uint32_t)command.args[0], (uint32_t)command.args[1]);
+      preferences.putUInt("rate_min", adaptiveRate.minPeriod());
+      preferences.putUInt("rate_max", adaptiveRate.maxPeriod());
+      applySamplePeriod(adaptiveRate.period());
+      Serial.println("Limites de amostragem atualizados.");
+      break;
+    case CMD_RAW:
+      publishRaw = command.args[0] != 0;
+      preferences.putUChar("raw", publishRaw);
+      Serial.println(publishRaw ? "Leituras brutas: ligadas." : "Leituras brutas: desligadas (so resumos).");
+      break;
+    case CMD_BATCH:
+      batchSize = (uint8_t)constrain(command.args[0], 0, BATCH_SIZE_MAX);
+      preferences.putUChar("batch", batchSize);
+      Serial.print("Leituras por bloco comprimido: ");
+      Serial.println(batchSize);
+      break;
+    case CMD_INFLIGHT:
+      // Guarda o valor pedido; a janela efetiva também respeita o Receive Maximum do broker
+      preferences.putUChar("inflight", (uint8_t)constrain(command.args[0], 1, MQTT_INFLIGHT_MAX));
+      uplink.setWindow(preferences.getUChar("inflight"));
+      Serial.print("Janela de mensagens em voo: ");
+      Serial.println(preferences.getUChar("inflight"));
+      break;
+    case CMD_TRANSPORT:
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+      preferences.putUChar("transport", command.args[0] != 0 ? UPLINK_MQTTSN : UPLINK_MQTT);
+      Serial.println("Transporte alterado. Reiniciando...");
+      restartRequested = true;
+#else
+      Serial.println("Transporte fixo nesta imagem.");
+#endif
+      break;
+    case CMD_BROKERS:
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+      // A conexão atual segue até cair; a nova lista é medida e vale a partir daí
+      if (command.textLength > 0) {
+        char list[BROKER_POOL_MAX * (BROKER_HOST_MAX + 7)];
+        size_t n = min(command.textLength, sizeof(list) - 1);
+        memcpy(list, command.text, n);
+        list[n] = '\0';
+        preferences.putString("brokers", list);
+      } else {
+        preferences.remove("brokers");
+      }
+      loadBrokers();
+      scheduler.runNow(brokerJob);
+      Serial.print("Brokers: ");
+      Serial.println(brokers.count());
+#else
+      Serial.println("Sem MQTT nesta imagem.");
+#endif
+      break;
+    case CMD_HISTORY:
+      if (!history.ready()) {
+        Serial.println("Historico indisponivel (sem particao).");
+        break;
+      }
+      historyQuery.toMs = (unsigned long long)command.args[1];
+      historyQuery.factor = command.argCount > 2 ? (uint16_t)constrain(command.args[2], 1, HISTORY_FACTOR_MAX) : 1;
+      historyQuery.cursor = history.seek((unsigned long long)command.args[0]);
+      historyQuery.active = true;
+      scheduler.runNow(historyJob);
+      Serial.println("Consulta de historico iniciada.");
+      break;
+    case CMD_TIME: {
+      uint32_t steps = timeSync.stats().steps;
+      if (!timeSync.onResponse((uint64_t)command.args[0], (int64_t)command.args[1], (int64_t)command.args[2],
+                               receivedUs)) {
+        Serial.println("Resposta de horario sem pedido correspondente, ignorada.");
+        break;
+      }
+      // Salto no relógio: os jobs alinhados ao relógio de parede voltam a cair nas fronteiras
+      if (timeSync.stats().steps != steps && wallClockAligned) scheduler.alignToWallClock(getUnixTimestampMillis());
+      Serial.print("Horario sincronizado: correcao ");
+      Serial.print(timeSync.stats().lastCorrectionUs);
+      Serial.print(" us, erro estimado ");
+      Serial.print(timeSync.stats().errorUs, 0);
+      Serial.println(" us");
+      break;
     }
-  } else {
-    Serial.println("Payload vazio.");
+    case CMD_CAPTURE:
+      captureRateHz = (uint32_t)constrain(command.args[0], 1, CAPTURE_RATE_MAX_HZ);
+      captureDurationMs = 1000 * (uint32_t)(command.argCount > 1 ? constrain(command.args[1], 1, CAPTURE_DURATION_MAX_S)
+                                                                  : CAPTURE_DURATION_DEFAULT_S);
+      Serial.println("Captura do ADC pedida; a serial vai para o modo binario.");
+      break;
+    case CMD_FILTER: {
+      // Sem p2, mantém o atual (a EMA só tem um parâmetro)
+      float p2 = command.argCount > 1 ? (float)command.args[1] : sensorFilter.param(1);
+      if (!sensorFilter.setParams((float)command.args[0], p2)) {
+        Serial.println("Parametros do filtro invalidos.");
+        break;
+      }
+      char key[16];
+      filterPrefsKey(key, sizeof(key));
+      float params[2] = { sensorFilter.param(0), sensorFilter.param(1) };
+      preferences.putBytes(key, params, sizeof(params));
+      Serial.print("Filtro ");
+      Serial.print(sensorFilter.name());
+      Serial.print(": ");
+      Serial.print(params[0]);
+      Serial.print(" ");
+      Serial.println(params[1]);
+      break;
+    }
+    case CMD_EMPTY:
+      Serial.println("Payload vazio.");
+      break;
+    default:
+      Serial.println("Comando invalido.");
   }
 }
 
-void reconnectMQTT() {
-  while (!mqtt.connected()) {
-    Serial.print("Conectando ao MQTT Broker...");
-    if (mqtt.connect(uniqueId.c_str())) {
-      Serial.println("conectado.");
-      mqtt.subscribe(commandTopic);
-      Serial.print("Inscrito no topico de comando: ");
-      Serial.println(commandTopic);
-    } else {
-      Serial.print("falhou, rc=");
-      Serial.print(mqtt.state());
-      Serial.println(" tentando novamente em 5 segundos");
-      delay(5000);
+// ====== TRANSPORTE (ESCOLHIDO NA BUILD; MQTT OU MQTT-SN NO BOOT) ======
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+// Lista de brokers da NVS ("host[:porta],..."), ou a padrão
+void loadBrokers() {
+  String list = preferences.getString("brokers", MQTT_BROKERS_DEFAULT);
+  if (brokers.parse(list.c_str(), list.length(), MQTT_PORT) == 0) {
+    brokers.parse(MQTT_BROKERS_DEFAULT, strlen(MQTT_BROKERS_DEFAULT), MQTT_PORT);
+  }
+}
+#endif
+
+// Um passo da conexão por execução, sem segurar o loop(): a amostragem, os alarmes e as
+// filas seguem enquanto o uplink está fora do ar. Com a tentativa em andamento (CONNACK a
+// caminho) o job volta em UPLINK_POLL_MS; com o pool de brokers (MQTT) só tenta quando um
+// broker respondeu ao probe e saiu do backoff, e o brokerTask o chama assim que isso acontece.
+void connectTask() {
+#ifndef AGROFLOW_SENSING_IMAGE
+  if (portalActive) return;
+#endif
+  if (!uplinkStarted || uplink.connected() || WiFi.status() != WL_CONNECTED) return;
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+  bool pooled = !uplink.alternate() && brokers.count() > 0;
+#else
+  bool pooled = false;
+#endif
+  if (!uplink.connecting()) {
+    bool due = connectBackoffMs == 0 || (long)(millis() - connectRetryAt) >= 0;
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+    if (pooled) due = brokers.ready() >= 0 || brokers.current() >= 0;  // Com a conexão caída, lost() vem antes
+#endif
+    if (!due) return;
+    Serial.print("Conectando (");
+    Serial.print(uplink.protocol());
+    Serial.print(")...");
+  }
+  if (uplink.connect()) {
+    connectBackoffMs = 0;
+    Serial.print("conectado (");
+    Serial.print(uplink.protocol());
+    Serial.println(").");
+    Serial.print("Topico de comando: ");
+    Serial.println(commandTopic);
+    scheduler.runNow(publishJob);  // Esvazia o que acumulou na fila enquanto estava fora
+    return;
+  }
+  if (uplink.connecting()) {
+    scheduler.runIn(connectJob, UPLINK_POLL_MS);
+    return;
+  }
+  Serial.print("falhou, rc=");
+  Serial.print(uplink.state());
+  if (pooled) {
+    Serial.println(" tentando o proximo broker que responder");  // O pool espaça os probes
+    return;
+  }
+  connectBackoffMs = connectBackoffMs == 0 ? UPLINK_BACKOFF_MS : min(connectBackoffMs * 2, (uint32_t)UPLINK_BACKOFF_MAX_MS);
+  connectRetryAt = millis() + connectBackoffMs;
+  Serial.print(" tentando novamente em ");
+  Serial.print(connectBackoffMs / 1000);
+  Serial.println(" segundos");
+}
+
+// Lê o sensor e enfileira a leitura. Funciona com ou sem rede.
+void collectSample() {
+  unsigned long now = millis();
+  Reading reading;
+  reading.sampledAt = now;
+  reading.humidity = readSensorData();
+  reading.periodMs = scheduler.period(decimateJob);
+
+  // O histórico só grava com o relógio já sincronizado (timestamps reais e crescentes)
+  SeqNo seq = readingSeq.next();
+  if (wallClockAligned) {
+    history.append(getUnixTimestampMillis(), (int32_t)lroundf(reading.humidity * 100), seq);
+  }
+
+  if (publishRaw) {
+    if (telemetryLane.full()) {
+      Serial.println("Buffer de leituras cheio, descartando a mais antiga.");
     }
+    telemetryLane.push(reading, now, seq);
   }
+
+  // Ajusta o ritmo de leitura e publicação conforme a dinâmica da umidade
+  uint32_t elapsed = lastDecimation == 0 ? 0 : now - lastDecimation;
+  lastDecimation = now;
+  applySamplePeriod(adaptiveRate.update(reading.humidity, elapsed));
+}
+
+// Publica o bloco montado em batchBlock; com chave de cifra, dentro do envelope AES-GCM
+// (seal.h, aberto no backend por scripts/seal_open.py)
+bool sendBlock(const char* topic, size_t length) {
+  if (!sealer.enabled()) return uplink.send(topic, ByteSpan(batchBlock, length), MQTT_QOS_DATA);
+  size_t n = sealer.seal(topic, batchBuffer, length);
+  return n > 0 && uplink.send(topic, ByteSpan(batchBuffer, n), MQTT_QOS_DATA);
 }
 
-// --- MODIFICADO: Agora publica dados REAIS do sensor ---
-void publishSensorData() {
-  // Chama a nova função para obter a umidade do sensor
-  float humidity = readSensorData();
+// Comprime até batchSize leituras da fila num bloco (scripts/ts_codec.py decodifica) e
+// publica em sensors/<id>/batch. Um bloco incompleto só sai quando a leitura mais antiga
+// passa de BATCH_MAX_AGE_MS. O bloco só leva leituras de numeração contínua (o cabeçalho
+// guarda o número da primeira). Retorna false se o envio falhou (as leituras ficam na fila).
+bool publishBatch(unsigned long long timestamp, unsigned long nowMs) {
+  if (telemetryLane.size() < batchSize && nowMs - telemetryLane.frontQueuedAt() < BATCH_MAX_AGE_MS) {
+    return true;
+  }
+  TsBlockEncoder encoder(batchBlock, BATCH_BLOCK_SIZE, BATCH_VALUE_SCALE);
+  SeqNo first = telemetryLane.frontSeq();
+  encoder.setSequence(first.epoch, first.seq);
+  for (size_t i = 0; i < telemetryLane.size() && encoder.count() < batchSize; i++) {
+    if (!seqFollows(first, telemetryLane.seqAt(i), i)) break;
+    const Reading& reading = telemetryLane.at(i);
+    if (!encoder.add(timestamp - (nowMs - reading.sampledAt), (int32_t)lroundf(reading.humidity * 100))) break;
+  }
+  uint16_t count = encoder.count();
+  size_t n = encoder.finish();
+  if (!sendBlock(batchTopic, n)) {
+    Serial.println("Falha ao publicar bloco, mantendo leituras no buffer.");
+    return false;
+  }
+  for (uint16_t i = 0; i < count; i++) telemetryLane.markSent(millis());
+
+  Serial.print("Bloco publicado: ");
+  Serial.print(count);
+  Serial.print(" leituras em ");
+  Serial.print(n);
+  Serial.println(" bytes");
+  return true;
+}
+
+// Publica a fila de saída: primeiro todos os alarmes pendentes, depois uma rajada de
+// telemetria acumulada (inclusive a coletada antes do provisionamento). O timestamp de
+// cada mensagem é reconstruído a partir da sua idade em millis().
+// Mensagens de dados saem com QoS 1: ficam na janela do cliente MQTT até o PUBACK e são
+// reenviadas por ele numa reconexão, então saem da fila assim que aceitas. Com a janela
+// cheia o envio só pausa até os PUBACKs liberarem espaço.
+// Retorna true se ainda restam mensagens e vale a pena continuar esvaziando a fila.
+bool publishSensorData() {
+  if (alarmLane.empty() && summaryLane.empty() && telemetryLane.empty()) return false;
   unsigned long long timestamp = getUnixTimestampMillis();
 
   if (timestamp == 0) {
     Serial.println("Aguardando sincronizacao de tempo...");
-    return;
+    return false;
+  }
+  unsigned long nowMs = millis();
+  if (!wallClockAligned) {
+    scheduler.alignToWallClock(timestamp);
+    wallClockAligned = true;
+  }
+
+  while (!alarmLane.empty()) {
+    if (!uplink.ready()) return true;
+    size_t n = serializeAlarm(msgBuffer, sizeof(msgBuffer), uniqueId.c_str(), alarmLane.frontSeq(), alarmLane.front(),
+                              timestamp - (nowMs - alarmLane.frontQueuedAt()));
+    if (!uplink.send(alarmTopic, ByteSpan(msgBuffer, n), MQTT_QOS_DATA)) {
+      Serial.println("Falha ao publicar alarme, mantendo na fila.");
+      return false;
+    }
+    alarmLane.markSent(millis());
+    Serial.print("Alarme publicado: ");
+    Serial.println(msgBuffer);
+  }
+
+  while (!summaryLane.empty()) {
+    if (!uplink.ready()) return true;
+    WindowSummary& summary = summaryLane.front();
+    size_t n = serializeSummary(msgBuffer, sizeof(msgBuffer), uniqueId.c_str(), summaryLane.frontSeq(), summary,
+                                timestamp - (nowMs - summary.startedAt));
+    if (!uplink.send(summaryTopic, ByteSpan(msgBuffer, n), MQTT_QOS_DATA)) {
+      Serial.println("Falha ao publicar resumo, mantendo na fila.");
+      return false;
+    }
+    summaryLane.markSent(millis());
+  }
+
+  if (batchSize > 0) {
+    if (!uplink.ready()) return true;
+    if (!telemetryLane.empty() && !publishBatch(timestamp, nowMs)) return false;
+    return !alarmLane.empty() || !summaryLane.empty() || telemetryLane.size() >= batchSize;
+  }
+
+  for (int sent = 0; sent < PUBLISH_BURST_MAX && !telemetryLane.empty(); sent++) {
+    if (!uplink.ready()) return true;
+    Reading& reading = telemetryLane.front();
+    size_t n = serializeReading(msgBuffer, sizeof(msgBuffer), uniqueId.c_str(), telemetryLane.frontSeq(), reading.humidity,
+                                timestamp - (nowMs - reading.sampledAt), reading.periodMs);
+    if (!uplink.send(MQTT_PUB_TOPIC, ByteSpan(msgBuffer, n), MQTT_QOS_DATA)) {
+      Serial.println("Falha ao publicar, mantendo leitura no buffer.");
+      return false;
+    }
+    telemetryLane.markSent(millis());
+
+    Serial.print("Mensagem publicada: ");
+    Serial.println(msgBuffer);
   }
+  return !alarmLane.empty() || !summaryLane.empty() || !telemetryLane.empty();
+}
 
-  StaticJsonDocument<200> doc;
+// Publica as métricas do dispositivo (profundidade e latência de cada faixa da fila,
+// atraso e estouros de cada job do escalonador)
+void publishMetrics() {
+  static StaticJsonDocument<5120> doc;
+  doc.clear();
+  SeqNo seq = metricsSeq.next();
   doc["id"] = uniqueId;
-  doc["humidity"] = humidity;
-  doc["timestamp"] = timestamp;
-  
-  size_t n = serializeJson(doc, msgBuffer);
-  mqtt.publish(MQTT_PUB_TOPIC, msgBuffer, n);
-  
-  Serial.print("Mensagem publicada: ");
-  Serial.println(msgBuffer);
+  doc["epoch"] = seq.epoch;
+  doc["seq"] = seq.seq;
+  doc["uptime_ms"] = millis();
+  JsonObject lanes = doc.createNestedObject("lanes");
+  writeLaneMetrics(lanes, "alarm", alarmLane.stats(), alarmLane.size());
+  writeLaneMetrics(lanes, "summary", summaryLane.stats(), summaryLane.size());
+  writeLaneMetrics(lanes, "telemetry", telemetryLane.stats(), telemetryLane.size());
+  JsonObject rate = doc.createNestedObject("rate");
+  rate["period_ms"] = adaptiveRate.period();
+  rate["min_ms"] = adaptiveRate.minPeriod();
+  rate["max_ms"] = adaptiveRate.maxPeriod();
+  rate["slope_pct_min"] = adaptiveRate.slope();
+  rate["stddev_pct"] = adaptiveRate.stddev();
+  writeFilterMetrics(doc.as<JsonObject>(), "filter", sensorFilter.name(), sensorFilter.stats(), sensorFilter.param(0),
+                     sensorFilter.param(1));
+  JsonObject jobs = doc.createNestedObject("jobs");
+  for (size_t i = 0; i < scheduler.count(); i++) {
+    writeJobMetrics(jobs, scheduler.name(i), scheduler.stats(i), scheduler.period(i));
+  }
+  writeStoreMetrics(doc.as<JsonObject>(), "history", history.stats(), history.oldestTimestamp());
+  writeUplinkMetrics(doc.as<JsonObject>(), "uplink", uplink.stats(), uplink.protocol(), uplink.inflight(),
+                     uplink.window());
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+  if (!uplink.alternate()) {
+    JsonObject pool = doc.createNestedObject("brokers");
+    pool["failovers"] = brokers.failovers();
+    pool["reconnect_ms"] = brokers.lastFailoverMs();
+    JsonArray list = pool.createNestedArray("list");
+    for (size_t i = 0; i < brokers.count(); i++) {
+      writeBrokerMetrics(list, brokers.at(i), (int)i == brokers.current(), brokers.healthy(i));
+    }
+#if MQTT_TLS
+    writeTlsMetrics(doc.as<JsonObject>(), "tls", mqttSocket.stats(), mqttSocket.suite(), mqttSocket.cachedSessions());
+#endif
+  }
+#endif
+
+  if (timeSync.stats().requests > 0) {
+    writeTimeSyncMetrics(doc.as<JsonObject>(), "time", timeSync.stats(), timeSync.synced());
+  }
+  if (sealer.enabled()) {
+    writeSealMetrics(doc.as<JsonObject>(), "seal", sealer.stats(), sealer.keyId(), getCpuFrequencyMhz());
+  }
+
+  static char buffer[METRICS_BUFFER_SIZE];
+  size_t n = serializeJson(doc, buffer, sizeof(buffer));
+  uplink.send(metricsTopic, ByteSpan(buffer, n), MQTT_QOS_METRICS);
+}
+
+// ====== JOBS DO ESCALONADOR ======
+// Só publica com a rede de pé; enquanto isso as leituras continuam na fila
+void publishTask() {
+#ifndef AGROFLOW_SENSING_IMAGE
+  if (portalActive) return;
+#endif
+  if (!uplink.connected()) return;
+  bool more = publishSensorData();
+  uplink.flush();  // Transporte em lote (HTTP): um POST por rodada
+  if (more) {
+    // Ainda há acumulado: continua na próxima volta, ou quando os PUBACKs abrirem a janela
+    if (uplink.ready()) {
+      scheduler.runNow(publishJob);
+    } else {
+      scheduler.runIn(publishJob, UPLINK_POLL_MS);
+    }
+  }
+}
+
+void metricsTask() {
+#ifndef AGROFLOW_SENSING_IMAGE
+  if (portalActive) return;
+#endif
+  if (!uplink.connected()) return;
+  publishMetrics();
+  uplink.flush();
+}
+
+// Envia a consulta de histórico em blocos comprimidos (mesmo formato de sensors/<id>/batch)
+// em sensors/<id>/history, um bloco por execução. Um bloco vazio marca o fim da consulta.
+// Cada amostra é a média de "factor" leituras e leva o número da primeira (stride = factor);
+// uma quebra na numeração (reboot, leituras sem relógio) encerra o bloco.
+void historyTask() {
+  if (!historyQuery.active) return;
+#ifndef AGROFLOW_SENSING_IMAGE
+  if (portalActive) return;
+#endif
+  if (!uplink.connected()) return;
+
+  // O cursor só avança depois que o bloco foi publicado
+  TsCursor cursor = historyQuery.cursor;
+  TsBlockEncoder encoder(batchBlock, BATCH_BLOCK_SIZE, BATCH_VALUE_SCALE);
+  TsRecord record;
+  SeqNo blockFirst = {};
+  bool done = false;
+  bool broken = false;
+  while (!done && !broken && encoder.count() < BATCH_SIZE_MAX) {
+    int64_t sum = 0;
+    uint16_t n = 0;
+    unsigned long long first = 0;
+    TsCursor groupStart = cursor;
+    while (n < historyQuery.factor) {
+      TsCursor before = cursor;
+      if (!history.read(cursor, record) || record.timestampMs > historyQuery.toMs) {
+        done = true;
+        break;
+      }
+      uint32_t expected = encoder.count() * historyQuery.factor + n;
+      if (encoder.count() + n > 0 && !seqFollows(blockFirst, record.seq, expected)) {
+        cursor = before;  // Esta leitura abre o próximo bloco
+        broken = true;
+        break;
+      }
+      if (encoder.count() + n == 0) {
+        blockFirst = record.seq;
+        encoder.setSequence(blockFirst.epoch, blockFirst.seq, historyQuery.factor);
+      }
+      if (n == 0) first = record.timestampMs;
+      sum += record.value;
+      n++;
+    }
+    if (n > 0 && !encoder.add(first, (int32_t)(sum / n))) {
+      cursor = groupStart;  // Salto de tempo grande demais para o bloco: o grupo abre o próximo
+      done = false;
+      broken = true;
+    }
+  }
+
+  size_t length = encoder.finish();
+  if (encoder.count() > 0 && !sendBlock(historyTopic, length)) return;
+  historyQuery.cursor = cursor;
+  if (!done) {
+    uplink.flush();
+    scheduler.runNow(historyJob);
+    return;
+  }
+
+  TsBlockEncoder end(batchBlock, BATCH_BLOCK_SIZE, BATCH_VALUE_SCALE);
+  if (!sendBlock(historyTopic, end.finish())) return;
+  uplink.flush();
+  historyQuery.active = false;
+  Serial.println("Consulta de historico concluida.");
+}
+
+// Fecha a janela de agregação e enfileira o resumo para publicação
+void closeWindow(WindowAggregator& window) {
+  WindowSummary summary;
+  if (window.close(millis(), summary)) {
+    summaryLane.push(summary, millis(), summarySeq.next());
+    scheduler.runNow(publishJob);
+  }
+}
+
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+// DNS e probe dos brokers, um passo por vez; a nova ordem vale na próxima (re)conexão, e um
+// broker que volta a responder com o uplink fora do ar é tentado na hora
+void brokerTask() {
+#ifndef AGROFLOW_SENSING_IMAGE
+  if (portalActive) return;
+#endif
+  if (uplink.alternate() || WiFi.status() != WL_CONNECTED) return;
+  if (brokers.poll() && uplinkStarted && !uplink.connected() && !uplink.connecting()) scheduler.runNow(connectJob);
+  if (brokers.probing()) scheduler.runIn(brokerJob, UPLINK_POLL_MS);  // Handshake a caminho
+}
+#endif
+
+// Pede o horário ao servidor: publica t1 (esp_timer, µs) em sensors/<id>/time; a resposta
+// volta pelo tópico de comando ("TIME ...") e é tratada no mqttCallback()
+void timeSyncTask() {
+#ifndef AGROFLOW_SENSING_IMAGE
+  if (portalActive) return;
+#endif
+  if (!uplink.connected()) return;
+  char payload[24];
+  size_t n = snprintf(payload, sizeof(payload), "%llu",
+                      (unsigned long long)timeSync.request((uint64_t)esp_timer_get_time()));
+  uplink.send(timeTopic, ByteSpan(payload, n), MQTT_QOS_TIME);
+  uplink.flush();
+  if (timeSync.stats().requests == TIME_SYNC_FAST_REQUESTS) scheduler.setPeriod(timeSyncJob, TIME_SYNC_INTERVAL_MS);
+}
+
+void shortWindowTask() { closeWindow(shortWindow); }
+void longWindowTask() { closeWindow(longWindow); }
+
+bool capturePinHeld() { return digitalRead(CAPTURE_PIN) == LOW; }
+
+// Captura binária do ADC pela serial (scripts/capture_recv.py grava em arquivo). Bloqueia:
+// a rede e o escalonador param e retomam depois (jobs em CATCHUP_SKIP, MQTT reconecta).
+void runAdcCapture() {
+  Serial.print("Captura do ADC a ");
+  Serial.print(captureRateHz);
+  Serial.print(" Hz em ");
+  Serial.print(CAPTURE_BAUD);
+  Serial.println(" baud.");
+  CaptureStats stats = runCapture(SENSOR_PIN, captureRateHz, captureDurationMs, capturePinHeld, SERIAL_BAUD);
+  captureRateHz = 0;
+  Serial.print("Captura encerrada: ");
+  Serial.print(stats.samples);
+  Serial.print(" amostras, ");
+  Serial.print(stats.frames);
+  Serial.print(" quadros, ");
+  Serial.print(stats.droppedFrames);
+  Serial.print(" descartados, ");
+  Serial.print(stats.lateSamples);
+  Serial.print(" atrasadas (max ");
+  Serial.print(stats.maxLateUs);
+  Serial.println(" us).");
+}
+
+void housekeepingTask() {
+  if (digitalRead(RESET_PIN_1) == LOW) {
+    Serial.println("Reset fisico detectado durante a operacao!");
+    clearConfigAndRestart();
+  }
+  if (capturePinHeld() && captureRateHz == 0) {
+    captureRateHz = CAPTURE_PIN_RATE_HZ;
+    captureDurationMs = 0;
+  }
+}
+
+// Inicia os serviços que dependem da rede (relógio e MQTT) depois que o WiFi conecta
+void startNetworkServices() {
+  Serial.print("\nWiFi conectado! IP: ");
+  Serial.println(WiFi.localIP());
+
+  Serial.println("Sincronizando relogio com servidor NTP...");
+  configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+
+  static const TransportTopic predefined[] = {
+    { MQTT_PUB_TOPIC, MQTTSN_TOPIC_READINGS },
+    { metricsTopic, MQTTSN_TOPIC_METRICS },
+  };
+  TransportConfig config = {};
+  config.clientId = uniqueId.c_str();
+  config.commandTopic = commandTopic;
+  config.callback = mqttCallback;
+  config.sessionExpiryS = MQTT_SESSION_EXPIRY_S;
+  config.predefined = predefined;
+  config.predefinedCount = sizeof(predefined) / sizeof(predefined[0]);
+  uplink.begin(config);
+  uplinkStarted = true;
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+  scheduler.runNow(brokerJob);  // DNS e probe começam já; a conexão vai ao primeiro broker que responder
+#endif
+  scheduler.runNow(connectJob);
+}
+
+// Fora da rede, tenta de novo em segundo plano com as credenciais guardadas (backoff
+// exponencial); a coleta e as filas seguem. Só o portal (handleSave) e o reset trocam ou
+// apagam as credenciais: uma queda do roteador não leva o dispositivo ao provisionamento.
+// Na imagem híbrida o portal abre depois de WIFI_PORTAL_AFTER_MS, junto com as tentativas.
+void wifiTask() {
+#ifndef AGROFLOW_SENSING_IMAGE
+  if (portalConnecting()) return;  // O portal está testando credenciais novas
+#endif
+  if (WiFi.status() == WL_CONNECTED) {
+    if (!wifiWaiting) return;
+    wifiWaiting = false;
+    wifiBackoffMs = 0;
+#ifndef AGROFLOW_SENSING_IMAGE
+    if (portalActive) stopConfigurationPortal();
+#endif
+    if (uplinkStarted) {
+      Serial.println("WiFi reconectado.");
+    } else {
+      startNetworkServices();
+    }
+    return;
+  }
+
+  String ssid = preferences.getString("ssid", "");
+  if (ssid == "") return;  // Sem credenciais: o provisionamento cuida
+  unsigned long now = millis();
+  if (!wifiWaiting) {
+    Serial.println("Conexao WiFi perdida. Tentando reconectar em segundo plano...");
+    wifiWaiting = true;
+    wifiLostAt = now;
+    wifiRetryAt = now;
+  }
+#ifndef AGROFLOW_SENSING_IMAGE
+  if (!portalActive && now - wifiLostAt >= WIFI_PORTAL_AFTER_MS) {
+    Serial.println("Rede indisponivel. Abrindo o portal; as tentativas continuam.");
+    startConfigurationPortal();
+  }
+#endif
+  if ((long)(now - wifiRetryAt) < 0) return;
+
+  wifiBackoffMs = wifiBackoffMs == 0 ? WIFI_RETRY_MS : min(wifiBackoffMs * 2, (uint32_t)WIFI_RETRY_MAX_MS);
+  wifiRetryAt = now + wifiBackoffMs;
+  Serial.print("Tentando conectar a rede ");
+  Serial.print(ssid);
+  Serial.print(" (proxima tentativa em ");
+  Serial.print(wifiBackoffMs / 1000);
+  Serial.println(" s)");
+  String password = preferences.getString("password", "");
+  WiFi.disconnect();
+  WiFi.begin(ssid.c_str(), password.c_str());
+}
+
+// A coleta roda sempre, inclusive enquanto o dispositivo aguarda provisionamento.
+// As janelas de agregação vêm antes do "adc": a amostra do instante do fechamento entra na
+// janela seguinte. O primeiro fechamento fica um período depois do boot (ou na fronteira do
+// horário, depois do alinhamento), não no add().
+void startScheduler() {
+  int shortJob = scheduler.add("agg_short", AGG_WINDOW_SHORT_MS, shortWindowTask, CATCHUP_SKIP, true);
+  int longJob = scheduler.add("agg_long", AGG_WINDOW_LONG_MS, longWindowTask, CATCHUP_SKIP, true);
+  shortWindow.restart(millis());
+  longWindow.restart(millis());
+  scheduler.runIn(shortJob, AGG_WINDOW_SHORT_MS);
+  scheduler.runIn(longJob, AGG_WINDOW_LONG_MS);
+  scheduler.add("adc", ADC_SAMPLE_MS, sampleAdc);
+  decimateJob = scheduler.add("decimate", SAMPLE_INTERVAL_MS, collectSample, CATCHUP_SKIP, true);
+  publishJob = scheduler.add("publish", PUBLISH_INTERVAL_MS, publishTask, CATCHUP_SKIP, true);
+  scheduler.add("metrics", METRICS_INTERVAL_MS, metricsTask, CATCHUP_SKIP, true);
+  historyJob = scheduler.add("history", HISTORY_RETRY_MS, historyTask);
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+  brokerJob = scheduler.add("brokers", BROKER_POLL_MS, brokerTask);
+#endif
+  timeSyncJob = scheduler.add("timesync", TIME_SYNC_FAST_MS, timeSyncTask);
+  scheduler.add("wifi", WIFI_CHECK_MS, wifiTask);
+  connectJob = scheduler.add("connect", UPLINK_CHECK_MS, connectTask);
+  scheduler.add("housekeeping", HOUSEKEEPING_MS, housekeepingTask);
 }
 
+// Sem credenciais válidas: abre o portal (imagem híbrida) ou volta para a imagem de fábrica
+void enterProvisioning() {
+#ifdef AGROFLOW_SENSING_IMAGE
+  Serial.println("Sem configuracao valida. Voltando para a imagem de provisionamento...");
+  if (switchToFactoryImage()) {
+    delay(100);
+    ESP.restart();
+  }
+#else
+  startConfigurationPortal(); // Não bloqueia: o portal é atendido pelo loop()
+#endif
+}
 
 // ====== FUNÇÕES PRINCIPAIS: SETUP & LOOP ======
 void setup() {
-  Serial.begin(115200);
+  Serial.begin(SERIAL_BAUD);
   delay(1000);
   Serial.println("\n\nIniciando dispositivo...");
 
@@ -281,6 +1116,7 @@ void setup() {
   
   pinMode(RESET_PIN_1, INPUT_PULLUP);
   pinMode(RESET_PIN_2, OUTPUT);
+  pinMode(CAPTURE_PIN, INPUT_PULLUP);
   digitalWrite(RESET_PIN_2, LOW);
 
   if (digitalRead(RESET_PIN_1) == LOW) {
@@ -290,59 +1126,87 @@ void setup() {
 
   preferences.begin("sensor-config", false);
   String ssid = preferences.getString("ssid", "");
+  adaptiveRate.setLimits(preferences.getUInt("rate_min", RATE_MIN_PERIOD_MS),
+                         preferences.getUInt("rate_max", RATE_MAX_PERIOD_MS));
+  publishRaw = preferences.getUChar("raw", PUBLISH_RAW_DEFAULT) != 0;
+  batchSize = min(preferences.getUChar("batch", BATCH_SIZE_DEFAULT), (uint8_t)BATCH_SIZE_MAX);
+  uplink.setWindow(preferences.getUChar("inflight", MQTT_INFLIGHT_WINDOW));
+  loadFilterParams();
+#if UPLINK_TRANSPORT == UPLINK_TRANSPORT_MQTT
+  uplink.select(preferences.getUChar("transport", UPLINK_TRANSPORT_DEFAULT) == UPLINK_MQTTSN);
+  loadBrokers();
+  mqttUplink.setBrokers(&brokers);
+#if MQTT_TLS && defined(MQTT_TLS_CA)
+  mqttSocket.setCACert(MQTT_TLS_CA);
+#endif
+#endif
 
-  if (ssid == "") {
-    startConfigurationPortal(); // Bloqueia a execução aqui até que o dispositivo seja configurado
-  } else {
-    Serial.println("Configuracao encontrada. Tentando conectar a rede...");
-    String password = preferences.getString("password", "");
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid.c_str(), password.c_str());
-
-    snprintf(commandTopic, sizeof(commandTopic), "sensors/%s/command", uniqueId.c_str());
-
-    int retries = 0;
-    while (WiFi.status() != WL_CONNECTED) {
-      delay(500);
-      Serial.print(".");
-      retries++;
-      if (retries > 40) {
-        Serial.println("\nFalha ao conectar. Credenciais podem estar erradas.");
-        clearConfigAndRestart();
-      }
-    }
-    Serial.print("\nWiFi conectado! IP: ");
-    Serial.println(WiFi.localIP());
+  uint32_t bootEpoch = nextBootEpoch();
+  readingSeq.begin(bootEpoch);
+  alarmSeq.begin(bootEpoch);
+  summarySeq.begin(bootEpoch);
+  metricsSeq.begin(bootEpoch);
+  Serial.print("Epoca de boot: ");
+  Serial.println(bootEpoch);
+  loadSealKey(bootEpoch);
 
-    Serial.println("Sincronizando relogio com servidor NTP...");
-    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+  snprintf(commandTopic, sizeof(commandTopic), "sensors/%s/command", uniqueId.c_str());
+  snprintf(alarmTopic, sizeof(alarmTopic), "sensors/%s/alarm", uniqueId.c_str());
+  snprintf(metricsTopic, sizeof(metricsTopic), "sensors/%s/metrics", uniqueId.c_str());
+  snprintf(summaryTopic, sizeof(summaryTopic), "sensors/%s/summary", uniqueId.c_str());
+  snprintf(batchTopic, sizeof(batchTopic), "sensors/%s/batch", uniqueId.c_str());
+  snprintf(historyTopic, sizeof(historyTopic), "sensors/%s/history", uniqueId.c_str());
+  snprintf(timeTopic, sizeof(timeTopic), "sensors/%s/time", uniqueId.c_str());
+  setWallClockSource(syncedClockMillis);
+  if (!history.begin()) Serial.println("Particao de historico nao encontrada; historico desligado.");
+  startScheduler();
 
-    mqtt.setServer(MQTT_HOST, MQTT_PORT);
-    mqtt.setCallback(mqttCallback);
+  if (ssid == "") {
+    enterProvisioning();
+    reportBootTime(BOOT_IMAGE_NAME);
+    return;
   }
+
+  // Não espera a rede: o wifiTask() inicia os serviços de rede quando a estação conectar
+  // e, se não conectar, tenta de novo sem apagar as credenciais
+  Serial.println("Configuracao encontrada. Tentando conectar a rede...");
+  String password = preferences.getString("password", "");
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(ssid.c_str(), password.c_str());
+  wifiWaiting = true;
+  wifiLostAt = millis();
+  wifiBackoffMs = WIFI_RETRY_MS;
+  wifiRetryAt = wifiLostAt + wifiBackoffMs;
+  reportBootTime(BOOT_IMAGE_NAME);
 }
 
 void loop() {
-  if (digitalRead(RESET_PIN_1) == LOW) {
-    Serial.println("Reset fisico detectado durante a operacao!");
-    clearConfigAndRestart();
+  uint64_t waitUs = scheduler.runDue();
+  if (captureRateHz != 0) {
+    runAdcCapture();
+    return;
   }
 
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("Conexao WiFi perdida. Reiniciando para tentar reconectar...");
-    delay(1000);
-    ESP.restart();
+#ifndef AGROFLOW_SENSING_IMAGE
+  if (portalActive) {
+    if (servicePortal() && !uplinkStarted) {
+      startNetworkServices();
+    }
+    delay(1);
+    return;
   }
+#endif
 
-  if (!mqtt.connected()) {
-    reconnectMQTT();
+  uplink.loop();
+  if (resetRequested) clearConfigAndRestart();
+  if (restartRequested) {
+    delay(1000);
+    ESP.restart();
   }
-  mqtt.loop();
 
-  long now = millis();
-  if (now - lastMsg > 5000) { // Envia dados a cada 5 segundos
-    lastMsg = now;
-    // --- MODIFICADO: Chama a função que lê e publica os dados do sensor ---
-    publishSensorData();
-  }
-}
\ No newline at end of file
+  // Dorme até o próximo prazo em vez de girar em vazio (limitado para atender o MQTT); a fração
+  // de milissegundo arredonda para cima, senão o loop() gira até o prazo
+  uint64_t waitMs = (waitUs + 999) / 1000;
+  uint32_t idleMs = waitMs < LOOP_IDLE_MAX_MS ? (uint32_t)waitMs : LOOP_IDLE_MAX_MS;
+  if (idleMs > 0) delay(idleMs);
+}
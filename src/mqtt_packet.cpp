@@ -0,0 +1,227 @@
+#include "mqtt_packet.h"
+
+#include <string.h>
+
+static size_t writeString(uint8_t* out, const char* s) {
+  size_t length = strlen(s);
+  out[0] = (uint8_t)(length >> 8);
+  out[1] = (uint8_t)length;
+  memcpy(out + 2, s, length);
+  return length + 2;
+}
+
+static size_t remainingLengthSize(uint32_t length) {
+  return length < 128 ? 1 : length < 16384 ? 2 : length < 2097152 ? 3 : 4;
+}
+
+static uint16_t readU16(const uint8_t* in) { return (uint16_t)(in[0] << 8 | in[1]); }
+
+static uint32_t readU32(const uint8_t* in) {
+  return (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 8 | in[3];
+}
+
+static size_t writeU16(uint8_t* out, uint16_t value) {
+  out[0] = (uint8_t)(value >> 8);
+  out[1] = (uint8_t)value;
+  return 2;
+}
+
+static size_t writeU32(uint8_t* out, uint32_t value) {
+  writeU16(out, (uint16_t)(value >> 16));
+  writeU16(out + 2, (uint16_t)value);
+  return 4;
+}
+
+size_t mqttWriteRemainingLength(uint8_t* out, uint32_t length) {
+  size_t n = 0;
+  do {
+    uint8_t byte = length & 0x7F;
+    length >>= 7;
+    out[n++] = length ? (byte | 0x80) : byte;
+  } while (length && n < 4);
+  return n;
+}
+
+int mqttReadVarInt(const uint8_t* in, size_t available, uint32_t& value) {
+  value = 0;
+  for (size_t i = 0; i < 4; i++) {
+    if (i >= available) return 0;
+    value |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+    if ((in[i] & 0x80) == 0) return (int)i + 1;
+  }
+  return -1;
+}
+
+int mqttReadFixedHeader(const uint8_t* in, size_t available, uint8_t& first, uint32_t& remaining) {
+  if (available < 2) return 0;
+  first = in[0];
+  int n = mqttReadVarInt(in + 1, available - 1, remaining);
+  return n > 0 ? n + 1 : n;
+}
+
+// Cabeçalho fixo no início de out; retorna o tamanho ou 0 se o pacote não couber
+static size_t writeFixedHeader(uint8_t* out, size_t capacity, uint8_t first, uint32_t remaining) {
+  size_t header = 1 + remainingLengthSize(remaining);
+  if (header + remaining > capacity) return 0;
+  out[0] = first;
+  mqttWriteRemainingLength(out + 1, remaining);
+  return header;
+}
+
+size_t mqttWriteConnect(uint8_t* out, size_t capacity, const MqttConnectOptions& options) {
+  bool v5 = options.version == MQTT_V5;
+  uint32_t properties = 0;
+  if (v5 && options.sessionExpiryS) properties += 5;
+  if (v5 && options.receiveMaximum) properties += 3;
+  uint32_t remaining = 10 + 2 + strlen(options.clientId);
+  if (v5) remaining += remainingLengthSize(properties) + properties + 1;  // + propriedades do will (vazias)
+  if (options.username) remaining += 2 + strlen(options.username);
+  if (options.password) remaining += 2 + strlen(options.password);
+  size_t n = writeFixedHeader(out, capacity, MQTT_CONNECT << 4, remaining);
+  if (n == 0) return 0;
+
+  n += writeString(out + n, "MQTT");
+  out[n++] = options.version;
+  uint8_t flags = options.cleanSession ? 0x02 : 0;
+  if (options.username) flags |= 0x80;
+  if (options.password) flags |= 0x40;
+  out[n++] = flags;
+  n += writeU16(out + n, options.keepAliveS);
+  if (v5) {
+    n += mqttWriteRemainingLength(out + n, properties);
+    if (options.sessionExpiryS) {
+      out[n++] = MQTT_PROP_SESSION_EXPIRY;
+      n += writeU32(out + n, options.sessionExpiryS);
+    }
+    if (options.receiveMaximum) {
+      out[n++] = MQTT_PROP_RECEIVE_MAXIMUM;
+      n += writeU16(out + n, options.receiveMaximum);
+    }
+  }
+  n += writeString(out + n, options.clientId);
+  if (v5) out[n++] = 0;  // Sem will: o bloco de propriedades do will continua presente, vazio
+  if (options.username) n += writeString(out + n, options.username);
+  if (options.password) n += writeString(out + n, options.password);
+  return n;
+}
+
+// Tamanho do valor de cada propriedade, para pular as que o cliente não usa; -1 se desconhecida
+static int propertySize(uint8_t id, const uint8_t* value, size_t available) {
+  switch (id) {
+    case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+      return 1;
+    case 0x13: case 0x21: case 0x22: case 0x23:
+      return 2;
+    case 0x02: case 0x11: case 0x18: case 0x27:
+      return 4;
+    case 0x0B: {
+      uint32_t ignored;
+      return mqttReadVarInt(value, available, ignored);
+    }
+    case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F:
+      return available < 2 ? -1 : 2 + readU16(value);
+    case 0x26:  // Par de strings
+      if (available < 2 || available < 4 + (size_t)readU16(value)) return -1;
+      return 4 + readU16(value) + readU16(value + 2 + readU16(value));
+    default:
+      return -1;
+  }
+}
+
+bool mqttParseConnack(const uint8_t* body, size_t length, uint8_t version, MqttConnack& out) {
+  out.sessionPresent = false;
+  out.reason = 0;
+  out.receiveMaximum = 65535;
+  out.topicAliasMaximum = 0;
+  out.maximumPacketSize = 0;
+  out.sessionExpiryS = 0;
+  out.sessionExpiryGiven = false;
+  if (length < 2) return false;
+  out.sessionPresent = body[0] & 0x01;
+  out.reason = body[1];
+  // Broker 3.1.1 respondendo a um CONNECT 5: CONNACK curto, sem propriedades
+  if (version != MQTT_V5 || length == 2) return true;
+
+  uint32_t properties;
+  int n = mqttReadVarInt(body + 2, length - 2, properties);
+  if (n <= 0 || 2 + n + properties > length) return false;
+  const uint8_t* p = body + 2 + n;
+  const uint8_t* end = p + properties;
+  while (p < end) {
+    uint8_t id = *p++;
+    int size = propertySize(id, p, end - p);
+    if (size < 0 || p + size > end) return false;
+    switch (id) {
+      case MQTT_PROP_RECEIVE_MAXIMUM: out.receiveMaximum = readU16(p); break;
+      case MQTT_PROP_TOPIC_ALIAS_MAXIMUM: out.topicAliasMaximum = readU16(p); break;
+      case MQTT_PROP_MAXIMUM_PACKET_SIZE: out.maximumPacketSize = readU32(p); break;
+      case MQTT_PROP_SESSION_EXPIRY:
+        out.sessionExpiryS = readU32(p);
+        out.sessionExpiryGiven = true;
+        break;
+      default: break;
+    }
+    p += size;
+  }
+  return true;
+}
+
+static uint32_t publishRemaining(uint8_t version, const char* topic, size_t payloadLength, uint8_t qos,
+                                 uint16_t topicAlias) {
+  uint32_t remaining = 2 + strlen(topic) + (qos ? 2 : 0) + payloadLength;
+  if (version == MQTT_V5) remaining += topicAlias ? 4 : 1;  // Comprimento das propriedades + alias
+  return remaining;
+}
+
+size_t mqttPublishSize(uint8_t version, const char* topic, size_t payloadLength, uint8_t qos, uint16_t topicAlias) {
+  uint32_t remaining = publishRemaining(version, topic, payloadLength, qos, topicAlias);
+  return 1 + remainingLengthSize(remaining) + remaining;
+}
+
+size_t mqttWritePublishHeader(uint8_t* out, size_t capacity, uint8_t version, const char* topic,
+                              size_t payloadLength, uint8_t qos, bool retain, uint16_t packetId,
+                              uint16_t topicAlias) {
+  uint32_t remaining = publishRemaining(version, topic, payloadLength, qos, topicAlias);
+  uint8_t first = (MQTT_PUBLISH << 4) | (qos << 1) | (retain ? 1 : 0);
+  // Só o cabeçalho precisa caber aqui: o payload é escrito à parte
+  size_t header = 1 + remainingLengthSize(remaining);
+  if (header + remaining - payloadLength > capacity) return 0;
+  size_t n = writeFixedHeader(out, header + remaining, first, remaining);
+  n += writeString(out + n, topic);
+  if (qos) n += writeU16(out + n, packetId);
+  if (version == MQTT_V5) {
+    if (topicAlias) {
+      out[n++] = 3;
+      out[n++] = MQTT_PROP_TOPIC_ALIAS;
+      n += writeU16(out + n, topicAlias);
+    } else {
+      out[n++] = 0;
+    }
+  }
+  return n;
+}
+
+size_t mqttWriteSubscribe(uint8_t* out, size_t capacity, uint8_t version, uint16_t packetId, const char* topic,
+                          uint8_t qos) {
+  uint32_t remaining = 2 + 2 + strlen(topic) + 1 + (version == MQTT_V5 ? 1 : 0);
+  size_t n = writeFixedHeader(out, capacity, (MQTT_SUBSCRIBE << 4) | 0x02, remaining);
+  if (n == 0) return 0;
+  n += writeU16(out + n, packetId);
+  if (version == MQTT_V5) out[n++] = 0;  // Sem propriedades
+  n += writeString(out + n, topic);
+  out[n++] = qos;  // No MQTT 5 o mesmo byte leva as opções da inscrição (só o QoS aqui)
+  return n;
+}
+
+size_t mqttWriteAck(uint8_t* out, MqttPacketType type, uint16_t packetId) {
+  out[0] = type << 4;
+  out[1] = 2;
+  writeU16(out + 2, packetId);
+  return 4;
+}
+
+size_t mqttWriteEmpty(uint8_t* out, MqttPacketType type) {
+  out[0] = type << 4;
+  out[1] = 0;
+  return 2;
+}
@@ -0,0 +1,119 @@
+#include "mqttsn_packet.h"
+
+#include <string.h>
+
+static size_t writeU16(uint8_t* out, uint16_t value) {
+  out[0] = (uint8_t)(value >> 8);
+  out[1] = (uint8_t)value;
+  return 2;
+}
+
+// Cabeçalho (comprimento + tipo) no início de out; retorna o tamanho ou 0 se não couber
+static size_t writeHeader(uint8_t* out, size_t capacity, size_t bodyLength, MqttSnMsgType type) {
+  size_t total = 2 + bodyLength;
+  if (total >= 256) total += 2;
+  if (total > capacity || total > 0xFFFF) return 0;
+  if (total < 256) {
+    out[0] = (uint8_t)total;
+    out[1] = type;
+    return 2;
+  }
+  out[0] = 0x01;
+  writeU16(out + 1, (uint16_t)total);
+  out[3] = type;
+  return 4;
+}
+
+uint8_t mqttSnQosFlags(int8_t qos) {
+  return qos < 0 ? 0x60 : (qos > 0 ? 0x20 : 0x00);
+}
+
+int8_t mqttSnQos(uint8_t flags) {
+  switch (flags & 0x60) {
+    case 0x60: return -1;
+    case 0x20: return 1;
+    case 0x40: return 2;
+    default: return 0;
+  }
+}
+
+size_t mqttSnReadHeader(const uint8_t* in, size_t available, uint16_t& length, uint8_t& type) {
+  if (available < 2) return 0;
+  size_t header = 2;
+  length = in[0];
+  if (in[0] == 0x01) {
+    if (available < 4) return 0;
+    length = (uint16_t)(in[1] << 8 | in[2]);
+    header = 4;
+  }
+  if (length < header || length > available) return 0;
+  type = in[header - 1];
+  return header;
+}
+
+size_t mqttSnWriteConnect(uint8_t* out, size_t capacity, const char* clientId, uint16_t keepAliveS,
+                          bool cleanSession) {
+  size_t idLength = strlen(clientId);
+  size_t n = writeHeader(out, capacity, 4 + idLength, MQTTSN_CONNECT);
+  if (n == 0) return 0;
+  out[n++] = cleanSession ? MQTTSN_FLAG_CLEAN_SESSION : 0;
+  out[n++] = 0x01;  // Protocol id
+  n += writeU16(out + n, keepAliveS);
+  memcpy(out + n, clientId, idLength);
+  return n + idLength;
+}
+
+size_t mqttSnWriteRegister(uint8_t* out, size_t capacity, uint16_t msgId, const char* topic) {
+  size_t topicLength = strlen(topic);
+  size_t n = writeHeader(out, capacity, 4 + topicLength, MQTTSN_REGISTER);
+  if (n == 0) return 0;
+  n += writeU16(out + n, 0);  // Topic id: atribuído pelo gateway no REGACK
+  n += writeU16(out + n, msgId);
+  memcpy(out + n, topic, topicLength);
+  return n + topicLength;
+}
+
+size_t mqttSnWritePublishHeader(uint8_t* out, size_t capacity, uint8_t flags, uint16_t topicId, uint16_t msgId,
+                                size_t payloadLength) {
+  // Só o cabeçalho precisa caber aqui: o payload é escrito à parte
+  size_t n = writeHeader(out, 0xFFFF, 5 + payloadLength, MQTTSN_PUBLISH);
+  if (n == 0 || n + 5 > capacity) return 0;
+  out[n++] = flags;
+  n += writeU16(out + n, topicId);
+  n += writeU16(out + n, msgId);
+  return n;
+}
+
+size_t mqttSnWriteSubscribe(uint8_t* out, size_t capacity, uint8_t flags, uint16_t msgId, const char* topic) {
+  size_t topicLength = strlen(topic);
+  size_t n = writeHeader(out, capacity, 3 + topicLength, MQTTSN_SUBSCRIBE);
+  if (n == 0) return 0;
+  out[n++] = flags;  // Tipo de tópico normal: o nome vai por extenso
+  n += writeU16(out + n, msgId);
+  memcpy(out + n, topic, topicLength);
+  return n + topicLength;
+}
+
+size_t mqttSnWriteAck(uint8_t* out, MqttSnMsgType type, uint16_t topicId, uint16_t msgId, uint8_t returnCode) {
+  out[0] = 7;
+  out[1] = type;
+  writeU16(out + 2, topicId);
+  writeU16(out + 4, msgId);
+  out[6] = returnCode;
+  return 7;
+}
+
+size_t mqttSnWritePingreq(uint8_t* out, size_t capacity, const char* clientId) {
+  size_t idLength = clientId ? strlen(clientId) : 0;
+  size_t n = writeHeader(out, capacity, idLength, MQTTSN_PINGREQ);
+  if (n == 0) return 0;
+  if (idLength) memcpy(out + n, clientId, idLength);
+  return n + idLength;
+}
+
+size_t mqttSnWriteDisconnect(uint8_t* out, uint16_t durationS) {
+  out[0] = durationS ? 4 : 2;
+  out[1] = MQTTSN_DISCONNECT;
+  if (durationS) writeU16(out + 2, durationS);
+  return out[0];
+}
@@ -0,0 +1,193 @@
+#include "payload.h"
+
+// Serializa o documento se ele couber inteiro no buffer
+template <typename Doc>
+static size_t serializeIfFits(const Doc& doc, char* out, size_t capacity) {
+  if (measureJson(doc) >= capacity) return 0;
+  return serializeJson(doc, out, capacity);
+}
+
+size_t serializeReading(char* out, size_t capacity, const char* id, SeqNo seq, float humidity,
+                        unsigned long long timestamp, uint32_t periodMs) {
+  StaticJsonDocument<256> doc;
+  doc["id"] = id;
+  doc["epoch"] = seq.epoch;
+  doc["seq"] = seq.seq;
+  doc["humidity"] = humidity;
+  doc["timestamp"] = timestamp;
+  doc["period_ms"] = periodMs;
+  return serializeIfFits(doc, out, capacity);
+}
+
+size_t serializeAlarm(char* out, size_t capacity, const char* id, SeqNo seq, const AlarmEvent& event,
+                      unsigned long long timestamp) {
+  StaticJsonDocument<320> doc;
+  doc["id"] = id;
+  doc["epoch"] = seq.epoch;
+  doc["seq"] = seq.seq;
+  doc["alarm"] = alarmName(event.type);
+  doc["state"] = event.active ? "raised" : "cleared";
+  doc["humidity"] = event.humidity;
+  doc["raw"] = event.raw;
+  doc["timestamp"] = timestamp;
+  return serializeIfFits(doc, out, capacity);
+}
+
+size_t serializeSummary(char* out, size_t capacity, const char* id, SeqNo seq,
+                        const WindowSummary& summary, unsigned long long startTimestamp) {
+  static const char* const quantileKeys[AGG_QUANTILES] = { "p05", "p50", "p95" };
+  StaticJsonDocument<448> doc;
+  doc["id"] = id;
+  doc["epoch"] = seq.epoch;
+  doc["seq"] = seq.seq;
+  doc["window_s"] = summary.windowMs / 1000;
+  doc["start"] = startTimestamp;
+  doc["count"] = summary.count;
+  doc["min"] = summary.min;
+  doc["max"] = summary.max;
+  doc["mean"] = summary.mean;
+  doc["stddev"] = summary.stddev;
+  for (int i = 0; i < AGG_QUANTILES; i++) doc[quantileKeys[i]] = summary.quantiles[i];
+  return serializeIfFits(doc, out, capacity);
+}
+
+void writeLaneMetrics(JsonObject parent, const char* name, const LaneStats& stats, size_t depth) {
+  JsonObject lane = parent.createNestedObject(name);
+  lane["depth"] = depth;
+  lane["enqueued"] = stats.enqueued;
+  lane["sent"] = stats.sent;
+  lane["dropped"] = stats.dropped;
+  lane["lat_last_ms"] = stats.lastLatencyMs;
+  lane["lat_mean_ms"] = stats.meanLatencyMs();
+  lane["lat_max_ms"] = stats.maxLatencyMs;
+}
+
+void writeJobMetrics(JsonObject parent, const char* name, const JobStats& stats, uint32_t periodMs) {
+  JsonObject job = parent.createNestedObject(name);
+  job["period_ms"] = periodMs;
+  job["runs"] = stats.runs;
+  job["overruns"] = stats.overruns;
+  job["missed"] = stats.missed;
+  job["jitter_last_us"] = stats.lastJitterUs;
+  job["jitter_mean_us"] = stats.meanJitterUs();
+  job["jitter_max_us"] = stats.maxJitterUs;
+  job["dur_max_us"] = stats.maxDurationUs;
+}
+
+void writeStoreMetrics(JsonObject parent, const char* name, const TsStoreStats& stats,
+                       unsigned long long oldestTimestamp) {
+  JsonObject store = parent.createNestedObject(name);
+  store["pages"] = stats.pages;
+  store["used_pages"] = stats.usedPages;
+  store["appended"] = stats.appended;
+  store["erases"] = stats.erases;
+  store["crc_errors"] = stats.crcErrors;
+  store["write_errors"] = stats.writeErrors;
+  store["oldest"] = oldestTimestamp;
+}
+
+void writeUplinkMetrics(JsonObject parent, const char* name, const MqttStats& stats, const char* protocol,
+                        size_t inflight, uint8_t window) {
+  JsonObject uplink = parent.createNestedObject(name);
+  uplink["protocol"] = protocol;
+  uplink["inflight"] = inflight;
+  uplink["window"] = window;
+  uplink["published"] = stats.published;
+  uplink["acked"] = stats.acked;
+  uplink["retransmitted"] = stats.retransmitted;
+  uplink["rejected"] = stats.rejected;
+  uplink["refused"] = stats.refused;
+  uplink["qos0"] = stats.qos0;
+  uplink["connects"] = stats.connects;
+  uplink["fallbacks"] = stats.fallbacks;
+  uplink["aliased"] = stats.aliased;
+  uplink["alias_bytes_saved"] = stats.aliasBytesSaved;
+  uplink["ack_last_ms"] = stats.lastAckMs;
+  uplink["ack_mean_ms"] = stats.meanAckMs();
+  uplink["ack_max_ms"] = stats.maxAckMs;
+}
+
+void writeBrokerMetrics(JsonArray parent, const BrokerEntry& entry, bool current, bool healthy) {
+  JsonObject broker = parent.createNestedObject();
+  broker["host"] = entry.host;
+  broker["port"] = entry.port;
+  broker["address"] = entry.address;
+  broker["current"] = current;
+  broker["healthy"] = healthy;
+  broker["rtt_ms"] = entry.stats.rttMs;
+  broker["rtt_last_ms"] = entry.stats.lastRttMs;
+  broker["probes"] = entry.stats.probes;
+  broker["probe_failures"] = entry.stats.probeFailures;
+  broker["connects"] = entry.stats.connects;
+  broker["failures"] = entry.stats.failures;
+  broker["resolves"] = entry.stats.resolves;
+  broker["dns_failures"] = entry.stats.dnsFailures;
+  broker["dns_stale"] = entry.stats.dnsStale;
+}
+
+void writeTlsMetrics(JsonObject parent, const char* name, const TlsStats& stats, const char* suite,
+                     size_t cachedSessions) {
+  JsonObject tls = parent.createNestedObject(name);
+  tls["suite"] = suite;
+  tls["cached"] = cachedSessions;
+  tls["restored"] = stats.restoredSessions;
+  tls["full"] = stats.fullHandshakes;
+  tls["resumed"] = stats.resumedHandshakes;
+  tls["rejected"] = stats.rejectedSessions;
+  tls["failures"] = stats.failures;
+  tls["oversized"] = stats.oversizedSessions;
+  tls["last_ms"] = stats.lastMs;
+  tls["last_bytes"] = stats.lastBytes;
+  tls["last_resumed"] = stats.lastResumed;
+  tls["full_ms_avg"] = stats.meanFullMs();
+  tls["resumed_ms_avg"] = stats.meanResumedMs();
+  tls["full_bytes_avg"] = stats.meanFullBytes();
+  tls["resumed_bytes_avg"] = stats.meanResumedBytes();
+  // mW x ms = uJ
+  tls["full_mj_avg"] = stats.meanFullMs() * TLS_ACTIVE_MW / 1000.0f;
+  tls["resumed_mj_avg"] = stats.meanResumedMs() * TLS_ACTIVE_MW / 1000.0f;
+}
+
+void writeSealMetrics(JsonObject parent, const char* name, const SealStats& stats, uint8_t keyId,
+                      uint32_t cpuMhz) {
+  JsonObject seal = parent.createNestedObject(name);
+  seal["key_id"] = keyId;
+  seal["sealed"] = stats.sealed;
+  seal["failures"] = stats.failures;
+  seal["bytes"] = stats.bytes;
+  seal["cycles_per_byte"] = stats.cyclesPerByte();
+  // bytes por ciclo x ciclos por microssegundo = bytes por microssegundo = MB/s
+  seal["mb_per_s"] = stats.cycles ? (float)stats.bytes * cpuMhz / stats.cycles : 0;
+  seal["last_bytes"] = stats.lastBytes;
+  seal["last_cycles"] = stats.lastCycles;
+}
+
+void writeTimeSyncMetrics(JsonObject parent, const char* name, const TimeSyncStats& stats, bool synced) {
+  JsonObject sync = parent.createNestedObject(name);
+  sync["synced"] = synced;
+  sync["err_us"] = lroundf(stats.errorUs);
+  sync["bound_us"] = stats.minDelayUs / 2;
+  sync["skew_ppm"] = stats.skewPpm;
+  sync["correction_us"] = stats.lastCorrectionUs;
+  sync["rtt_us"] = stats.lastDelayUs;
+  sync["rtt_min_us"] = stats.minDelayUs;
+  sync["fit"] = stats.fitSamples;
+  sync["filtered"] = stats.filtered;
+  sync["requests"] = stats.requests;
+  sync["responses"] = stats.responses;
+  sync["stale"] = stats.stale;
+  sync["steps"] = stats.steps;
+}
+
+void writeFilterMetrics(JsonObject parent, const char* name, const char* policy, const FilterStats& stats,
+                        float p1, float p2) {
+  JsonObject filter = parent.createNestedObject(name);
+  filter["policy"] = policy;
+  filter["p1"] = p1;
+  filter["p2"] = p2;
+  filter["samples"] = stats.samples;
+  filter["rejected"] = stats.rejected;
+  filter["input"] = stats.input;
+  filter["estimate"] = (float)stats.estimateQ / FILTER_ONE;
+  filter["spread"] = (float)stats.spreadQ / FILTER_ONE;
+}
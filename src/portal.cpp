@@ -0,0 +1,209 @@
+/*
+ * Portal de configuração: Access Point + portal cativo para informar a rede Wi-Fi.
+ * Não faz parte da imagem de sensoriamento (AGROFLOW_SENSING_IMAGE), apenas da imagem
+ * híbrida e da imagem de fábrica (provisionamento).
+ */
+#include "portal.h"
+
+#include <WiFi.h>
+#include <WebServer.h>
+#include <DNSServer.h>
+#include <Preferences.h>
+#include "portal_assets.h"
+#include "json_stream.h"
+#include "scan_json.h"
+#include "seal.h"
+
+#define STA_CONNECT_TIMEOUT_MS 20000  // Tempo máximo para conectar à rede informada no portal
+#define PORTAL_CLOSE_DELAY_MS 5000    // Mantém o portal aberto para a página mostrar o resultado
+
+extern Preferences preferences;
+
+WebServer server(80);
+DNSServer dnsServer;
+
+// --- Estado do Portal de Configuração ---
+bool portalActive = false;
+enum StaState { STA_IDLE, STA_CONNECTING, STA_CONNECTED, STA_FAILED };
+StaState staState = STA_IDLE;
+unsigned long staAttemptStartedAt = 0;
+unsigned long staConnectedAt = 0;
+String pendingSsid = "";
+String pendingPassword = "";
+uint8_t pendingSealKey[SEAL_KEY_SIZE];
+bool pendingSealKeySet = false;  // Campo vazio mantém a chave já gravada
+
+// PÁGINA HTML DE CONFIGURAÇÃO: fonte em web/index.html, comprimida com gzip em tempo de
+// build (scripts/embed_portal.py) e embutida na memória flash via portal_assets.h
+const char* portalHeaderKeys[] = { "If-None-Match" };
+
+// URLs usadas pelos sistemas operacionais para detectar portais cativos. Respondemos com um
+// redirecionamento vazio em vez da página inteira, o que faz o celular abrir o portal sem
+// transferir o HTML a cada sondagem.
+const char* const captiveProbeUrls[] = {
+  "/generate_204", "/gen_204",                          // Android / ChromeOS
+  "/hotspot-detect.html", "/library/test/success.html", // Apple
+  "/connecttest.txt", "/ncsi.txt", "/redirect",         // Windows
+  "/canonical.html", "/success.txt"                     // Firefox
+};
+
+
+// ====== FUNÇÕES DO PORTAL DE CONFIGURAÇÃO ======
+// A página não tem nome com hash: com max-age o navegador do portal cativo mostraria a
+// versão antiga depois de uma atualização. "no-cache" guarda a cópia, mas revalida a cada
+// abertura pelo ETag (304 sem corpo enquanto o firmware não muda).
+void handleRoot() {
+  server.sendHeader("ETag", INDEX_HTML_GZ_ETAG);
+  server.sendHeader("Cache-Control", "no-cache");
+  // Cache do navegador ainda válido: responde só com o cabeçalho
+  if (server.header("If-None-Match") == INDEX_HTML_GZ_ETAG) {
+    server.send(304);
+    return;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, "text/html", (const char*)index_html_gz, index_html_gz_len);
+}
+void redirectToPortal() {
+  server.sendHeader("Location", String("http://") + WiFi.softAPIP().toString() + "/", true);
+  server.send(302, "text/plain", "");
+}
+void handleNoContent() { server.send(204); }
+// Envia a lista de redes em partes (chunked), lendo os registros do scan direto do driver.
+// Nenhuma String é montada: o uso de heap não cresce com a quantidade de redes visíveis.
+void handleScan() {
+  int n = WiFi.scanNetworks();
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+
+  auto sink = [](const char* data, size_t len) { server.sendContent(data, len); };
+  JsonStreamWriter<decltype(sink)> out(sink);
+  writeScanJson(out, n, [](int i, ScanEntry& entry) {
+    const wifi_ap_record_t* ap = (const wifi_ap_record_t*)WiFi.getScanInfoByIndex(i);
+    if (ap == nullptr) return false;
+    entry.ssid = (const char*)ap->ssid;
+    entry.ssidMaxLen = sizeof(ap->ssid);
+    entry.rssi = ap->rssi;
+    return true;
+  });
+  server.sendContent("");  // Encerra a resposta chunked
+  WiFi.scanDelete();
+}
+// Chave de cifra em hex (32 dígitos); false se o campo não tem exatamente uma chave
+bool parseSealKey(const String& hex, uint8_t key[SEAL_KEY_SIZE]) {
+  if (hex.length() != SEAL_KEY_SIZE * 2) return false;
+  for (size_t i = 0; i < SEAL_KEY_SIZE * 2; i++) {
+    char c = hex[i];
+    uint8_t nibble;
+    if (c >= '0' && c <= '9') nibble = c - '0';
+    else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+    else return false;
+    key[i / 2] = (i % 2) ? (key[i / 2] | nibble) : (nibble << 4);
+  }
+  return true;
+}
+
+// Aplica as credenciais com uma tentativa de conexão ao vivo (modo AP+STA), sem reiniciar.
+// O resultado é acompanhado pela página através de /status e tratado em servicePortal().
+void handleSave() {
+  pendingSsid = server.arg("ssid");
+  pendingPassword = server.arg("password");
+  pendingSealKeySet = parseSealKey(server.arg("seal_key"), pendingSealKey);
+  Serial.print("Tentando conectar a rede informada: ");
+  Serial.println(pendingSsid);
+  WiFi.begin(pendingSsid.c_str(), pendingPassword.c_str());
+  staState = STA_CONNECTING;
+  staAttemptStartedAt = millis();
+
+  String responsePage = "<html><body style='font-family: sans-serif; text-align: center; margin-top: 50px;'>";
+  responsePage += "<h2>Configuracoes recebidas!</h2>";
+  responsePage += "<p id='s'>Conectando a rede...</p>";
+  responsePage += "<script>function p(){fetch('/status').then(r=>r.json()).then(j=>{";
+  responsePage += "if(j.state=='connected'){document.getElementById('s').textContent='Conectado! IP: '+j.ip;}";
+  responsePage += "else if(j.state=='failed'){document.getElementById('s').innerHTML='Falha ao conectar. <a href=\"/\">Tentar novamente</a>';}";
+  responsePage += "else{setTimeout(p,1000);}}).catch(()=>setTimeout(p,1000));}p();</script>";
+  responsePage += "</body></html>";
+  server.send(200, "text/html", responsePage);
+}
+void handleStatus() {
+  const char* state = "idle";
+  if (staState == STA_CONNECTING) state = "connecting";
+  else if (staState == STA_CONNECTED) state = "connected";
+  else if (staState == STA_FAILED) state = "failed";
+  String json = String("{\"state\":\"") + state + "\",\"ip\":\"" + WiFi.localIP().toString() + "\"}";
+  server.send(200, "application/json", json);
+}
+void startConfigurationPortal() {
+  byte mac[6];
+  WiFi.macAddress(mac);
+  String apName = "AgroFlowSensor-" + String(mac[3], HEX) + String(mac[4], HEX) + String(mac[5], HEX);
+  apName.toUpperCase();
+  WiFi.mode(WIFI_AP_STA);
+  WiFi.softAP(apName.c_str());
+  IPAddress ip = WiFi.softAPIP();
+  Serial.println("\n--- MODO DE CONFIGURACAO VIA PORTAL WEB ---");
+  Serial.print("Conecte-se a rede: ");
+  Serial.println(apName);
+  Serial.print("Acesse o IP: http://");
+  Serial.println(ip);
+  dnsServer.start(53, "*", ip);
+  server.on("/", HTTP_GET, handleRoot);
+  server.on("/scan", HTTP_GET, handleScan);
+  server.on("/save", HTTP_POST, handleSave);
+  server.on("/status", HTTP_GET, handleStatus);
+  for (const char* url : captiveProbeUrls) {
+    server.on(url, HTTP_GET, redirectToPortal);
+  }
+  server.on("/favicon.ico", HTTP_GET, handleNoContent);
+  server.onNotFound(redirectToPortal);
+  server.collectHeaders(portalHeaderKeys, 1);
+  server.begin();
+  portalActive = true;
+  staState = STA_IDLE;
+  Serial.println("Servidor web iniciado. Aguardando configuracao...");
+}
+void stopConfigurationPortal() {
+  server.stop();
+  dnsServer.stop();
+  WiFi.softAPdisconnect(true);
+  WiFi.mode(WIFI_STA);
+  portalActive = false;
+  Serial.println("Portal de configuracao encerrado.");
+}
+
+bool portalConnecting() { return portalActive && (staState == STA_CONNECTING || staState == STA_CONNECTED); }
+
+// Atende o portal e acompanha a tentativa de conexão iniciada em handleSave().
+// Retorna true quando a rede foi validada e o portal acabou de ser encerrado.
+bool servicePortal() {
+  dnsServer.processNextRequest();
+  server.handleClient();
+
+  if (staState == STA_CONNECTING) {
+    if (WiFi.status() == WL_CONNECTED) {
+      preferences.putString("ssid", pendingSsid);
+      preferences.putString("password", pendingPassword);
+      if (pendingSealKeySet) {
+        // Nova chave, novo id: o backend sabe com qual chave abrir cada envelope. Só é
+        // carregada no próximo boot, com uma época nova: trocar a chave no meio do boot
+        // recomeçaria o contador do nonce
+        preferences.putBytes("seal_key", pendingSealKey, SEAL_KEY_SIZE);
+        preferences.putUChar("seal_kid", preferences.getUChar("seal_kid", 0) + 1);
+        memset(pendingSealKey, 0, sizeof(pendingSealKey));
+        pendingSealKeySet = false;
+        Serial.println("Chave de cifra salva; vale a partir do proximo boot.");
+      }
+      staState = STA_CONNECTED;
+      staConnectedAt = millis();
+      Serial.println("Credenciais validadas e salvas.");
+    } else if (millis() - staAttemptStartedAt > STA_CONNECT_TIMEOUT_MS) {
+      Serial.println("Falha ao conectar. Credenciais podem estar erradas.");
+      WiFi.disconnect();
+      staState = STA_FAILED;
+    }
+  } else if (staState == STA_CONNECTED && millis() - staConnectedAt > PORTAL_CLOSE_DELAY_MS) {
+    stopConfigurationPortal();
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,123 @@
+#include "scheduler.h"
+
+int Scheduler::add(const char* name, uint32_t periodMs, JobFn fn, CatchUpPolicy policy,
+                   bool alignToWall, uint8_t maxBurst) {
+  if (_count == SCHEDULER_MAX_JOBS) return -1;
+  Job& job = _jobs[_count];
+  job.name = name;
+  job.periodUs = (uint64_t)periodMs * 1000;
+  job.nextUs = _clock();
+  job.fn = fn;
+  job.policy = policy;
+  job.alignToWall = alignToWall;
+  job.maxBurst = maxBurst ? maxBurst : 1;
+  job.moved = false;
+  job.stats = JobStats();
+  return (int)_count++;
+}
+
+void Scheduler::runJob(Job& job, uint64_t deadline) {
+  uint64_t start = _clock();
+  job.moved = false;
+  _running = (int)(&job - _jobs);
+  job.fn();
+  _running = -1;
+  uint64_t end = _clock();
+
+  uint32_t jitter = (uint32_t)(start > deadline ? start - deadline : 0);
+  uint32_t duration = (uint32_t)(end - start);
+  JobStats& s = job.stats;
+  s.runs++;
+  s.lastJitterUs = jitter;
+  s.totalJitterUs += jitter;
+  if (jitter > s.maxJitterUs) s.maxJitterUs = jitter;
+  s.lastDurationUs = duration;
+  if (duration > s.maxDurationUs) s.maxDurationUs = duration;
+  if (duration > job.periodUs) s.overruns++;
+}
+
+uint64_t Scheduler::runDue() {
+  for (size_t i = 0; i < _count; i++) {
+    Job& job = _jobs[i];
+    uint64_t now = _clock();
+    if (now < job.nextUs) continue;
+
+    if (job.policy == CATCHUP_BURST) {
+      // Uma execução por prazo vencido; o que passar do limite da rajada é descartado
+      uint8_t runs = 0;
+      while (job.nextUs <= now && runs < job.maxBurst) {
+        runJob(job, job.nextUs);
+        if (job.moved) break;
+        job.nextUs += job.periodUs;
+        runs++;
+      }
+      now = _clock();
+      if (!job.moved && job.nextUs <= now) {
+        uint64_t behind = (now - job.nextUs) / job.periodUs + 1;
+        job.stats.missed += (uint32_t)behind;
+        job.nextUs += behind * job.periodUs;
+      }
+    } else {
+      uint64_t deadline = job.nextUs;
+      runJob(job, deadline);
+      if (job.moved) continue;
+      job.nextUs = deadline + job.periodUs;
+      now = _clock();
+      if (job.nextUs <= now) {
+        uint64_t behind = (now - job.nextUs) / job.periodUs + 1;
+        job.stats.missed += (uint32_t)behind;
+        job.nextUs += behind * job.periodUs;
+      }
+    }
+  }
+
+  uint64_t now = _clock();
+  uint64_t wait = UINT64_MAX;
+  for (size_t i = 0; i < _count; i++) {
+    uint64_t next = _jobs[i].nextUs;
+    uint64_t remaining = next > now ? next - now : 0;
+    if (remaining < wait) wait = remaining;
+  }
+  return wait;
+}
+
+void Scheduler::runNow(int id) {
+  if (id < 0 || (size_t)id >= _count) return;
+  uint64_t now = _clock();
+  if (id == _running) {
+    _jobs[id].nextUs = now;
+    _jobs[id].moved = true;
+  } else if (_jobs[id].nextUs > now) {
+    _jobs[id].nextUs = now;
+  }
+}
+
+void Scheduler::runIn(int id, uint32_t delayMs) {
+  if (id < 0 || (size_t)id >= _count) return;
+  _jobs[id].nextUs = _clock() + (uint64_t)delayMs * 1000;
+  if (id == _running) _jobs[id].moved = true;
+}
+
+void Scheduler::setPeriod(int id, uint32_t periodMs) {
+  if (id < 0 || (size_t)id >= _count || periodMs == 0) return;
+  Job& job = _jobs[id];
+  uint64_t newPeriod = (uint64_t)periodMs * 1000;
+  if (newPeriod == job.periodUs) return;
+  // Um período menor vale já a partir do próximo prazo; um maior, só depois dele
+  uint64_t now = _clock();
+  uint64_t last = job.nextUs > job.periodUs ? job.nextUs - job.periodUs : 0;
+  if (newPeriod < job.periodUs && last + newPeriod < job.nextUs) {
+    job.nextUs = last + newPeriod > now ? last + newPeriod : now;
+  }
+  job.periodUs = newPeriod;
+}
+
+void Scheduler::alignToWallClock(unsigned long long epochMs) {
+  uint64_t now = _clock();
+  uint64_t epochUs = (uint64_t)epochMs * 1000;
+  for (size_t i = 0; i < _count; i++) {
+    Job& job = _jobs[i];
+    if (!job.alignToWall) continue;
+    job.nextUs = now + (job.periodUs - epochUs % job.periodUs);
+  }
+}
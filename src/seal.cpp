@@ -0,0 +1,328 @@
+#include "seal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <mbedtls/gcm.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static const uint8_t sealMagic[2] = {'A', 'S'};
+
+static uint32_t readCycles() {
+#ifdef ARDUINO
+  return ESP.getCycleCount();
+#elif defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__rdtsc();
+#else
+  return 0;
+#endif
+}
+
+#ifdef ARDUINO
+// ====== GCM DO ESP-IDF (acelerador AES) ======
+struct SealContext {
+  mbedtls_gcm_context gcm;
+};
+
+static bool gcmInit(SealContext& context, const uint8_t key[SEAL_KEY_SIZE]) {
+  mbedtls_gcm_init(&context.gcm);
+  return mbedtls_gcm_setkey(&context.gcm, MBEDTLS_CIPHER_ID_AES, key, SEAL_KEY_SIZE * 8) == 0;
+}
+
+static void gcmFree(SealContext& context) { mbedtls_gcm_free(&context.gcm); }
+
+static void gcmEncrypt(SealContext& context, const uint8_t* nonce, const uint8_t* aad, size_t aadLength,
+                       uint8_t* data, size_t length, uint8_t* tag) {
+  mbedtls_gcm_crypt_and_tag(&context.gcm, MBEDTLS_GCM_ENCRYPT, length, nonce, 12, aad, aadLength, data, data,
+                            SEAL_TAG_SIZE, tag);
+}
+
+static bool gcmDecrypt(SealContext& context, const uint8_t* nonce, const uint8_t* aad, size_t aadLength,
+                       uint8_t* data, size_t length, const uint8_t* tag) {
+  return mbedtls_gcm_auth_decrypt(&context.gcm, length, nonce, 12, aad, aadLength, tag, SEAL_TAG_SIZE, data,
+                                  data) == 0;
+}
+#else
+// ====== GCM EM SOFTWARE (host) ======
+// AES-128 com tabela T (FIPS 197) e GHASH com tabelas de 4 bits (Shoup), como o mbedtls
+// sem aceleração. Não é de tempo constante: serve aos testes e ao benchmark no host.
+static const uint8_t sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
+
+static uint32_t te0[256];  // S[x].{02,01,01,03}; as outras três colunas são rotações
+
+static void buildTables() {
+  if (te0[0] != 0) return;
+  for (int x = 0; x < 256; x++) {
+    uint32_t s = sbox[x];
+    uint32_t s2 = ((s << 1) ^ ((s & 0x80) ? 0x1b : 0)) & 0xff;
+    te0[x] = (s2 << 24) | (s << 16) | (s << 8) | (s2 ^ s);
+  }
+}
+
+static inline uint32_t ror(uint32_t x, int bits) { return (x >> bits) | (x << (32 - bits)); }
+static inline uint32_t load32(const uint8_t* p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+static inline void store32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+static inline uint64_t load64(const uint8_t* p) { return ((uint64_t)load32(p) << 32) | load32(p + 4); }
+static inline void store64(uint8_t* p, uint64_t v) {
+  store32(p, (uint32_t)(v >> 32));
+  store32(p + 4, (uint32_t)v);
+}
+
+struct SealContext {
+  uint32_t roundKeys[44];
+  uint64_t hl[16];  // Múltiplos de H para o GHASH, metades baixa e alta
+  uint64_t hh[16];
+};
+
+static void aesEncrypt(const SealContext& context, const uint8_t in[16], uint8_t out[16]) {
+  const uint32_t* rk = context.roundKeys;
+  uint32_t s0 = load32(in) ^ rk[0], s1 = load32(in + 4) ^ rk[1];
+  uint32_t s2 = load32(in + 8) ^ rk[2], s3 = load32(in + 12) ^ rk[3];
+  for (int round = 1; round < 10; round++) {
+    rk += 4;
+    uint32_t t0 = te0[s0 >> 24] ^ ror(te0[(s1 >> 16) & 0xff], 8) ^ ror(te0[(s2 >> 8) & 0xff], 16) ^
+                  ror(te0[s3 & 0xff], 24) ^ rk[0];
+    uint32_t t1 = te0[s1 >> 24] ^ ror(te0[(s2 >> 16) & 0xff], 8) ^ ror(te0[(s3 >> 8) & 0xff], 16) ^
+                  ror(te0[s0 & 0xff], 24) ^ rk[1];
+    uint32_t t2 = te0[s2 >> 24] ^ ror(te0[(s3 >> 16) & 0xff], 8) ^ ror(te0[(s0 >> 8) & 0xff], 16) ^
+                  ror(te0[s1 & 0xff], 24) ^ rk[2];
+    uint32_t t3 = te0[s3 >> 24] ^ ror(te0[(s0 >> 16) & 0xff], 8) ^ ror(te0[(s1 >> 8) & 0xff], 16) ^
+                  ror(te0[s2 & 0xff], 24) ^ rk[3];
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
+  }
+  rk += 4;
+  uint32_t state[4] = {s0, s1, s2, s3};
+  for (int i = 0; i < 4; i++) {
+    uint32_t word = ((uint32_t)sbox[state[i] >> 24] << 24) | ((uint32_t)sbox[(state[(i + 1) & 3] >> 16) & 0xff] << 16) |
+                    ((uint32_t)sbox[(state[(i + 2) & 3] >> 8) & 0xff] << 8) | sbox[state[(i + 3) & 3] & 0xff];
+    store32(out + 4 * i, word ^ rk[i]);
+  }
+}
+
+static bool gcmInit(SealContext& context, const uint8_t key[SEAL_KEY_SIZE]) {
+  static const uint8_t rcon[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+  buildTables();
+  uint32_t* rk = context.roundKeys;
+  for (int i = 0; i < 4; i++) rk[i] = load32(key + 4 * i);
+  for (int i = 4; i < 44; i++) {
+    uint32_t t = rk[i - 1];
+    if (i % 4 == 0) {
+      t = ((uint32_t)sbox[(t >> 16) & 0xff] << 24) | ((uint32_t)sbox[(t >> 8) & 0xff] << 16) |
+          ((uint32_t)sbox[t & 0xff] << 8) | sbox[t >> 24];
+      t ^= (uint32_t)rcon[i / 4 - 1] << 24;
+    }
+    rk[i] = rk[i - 4] ^ t;
+  }
+
+  // H = E(0); tabelas com H·x para os 16 valores de 4 bits (SP 800-38D, ordem de bits do GCM)
+  uint8_t h[16] = {0};
+  aesEncrypt(context, h, h);
+  uint64_t vh = load64(h);
+  uint64_t vl = load64(h + 8);
+  context.hl[8] = vl;
+  context.hh[8] = vh;
+  context.hl[0] = 0;
+  context.hh[0] = 0;
+  for (int i = 4; i > 0; i >>= 1) {
+    uint32_t t = (uint32_t)(vl & 1) * 0xe1000000u;
+    vl = (vh << 63) | (vl >> 1);
+    vh = (vh >> 1) ^ ((uint64_t)t << 32);
+    context.hl[i] = vl;
+    context.hh[i] = vh;
+  }
+  for (int i = 2; i <= 8; i *= 2) {
+    for (int j = 1; j < i; j++) {
+      context.hh[i + j] = context.hh[i] ^ context.hh[j];
+      context.hl[i + j] = context.hl[i] ^ context.hl[j];
+    }
+  }
+  return true;
+}
+
+static void gcmFree(SealContext&) {}
+
+// x = x·H
+static void ghashMultiply(const SealContext& context, uint8_t x[16]) {
+  static const uint64_t last4[16] = {0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+                                     0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0};
+  uint8_t low = x[15] & 0xf;
+  uint64_t zh = context.hh[low];
+  uint64_t zl = context.hl[low];
+  for (int i = 15; i >= 0; i--) {
+    low = x[i] & 0xf;
+    uint8_t high = x[i] >> 4;
+    if (i != 15) {
+      uint8_t rem = (uint8_t)zl & 0xf;
+      zl = (zh << 60) | (zl >> 4);
+      zh = (zh >> 4) ^ (last4[rem] << 48) ^ context.hh[low];
+      zl ^= context.hl[low];
+    }
+    uint8_t rem = (uint8_t)zl & 0xf;
+    zl = (zh << 60) | (zl >> 4);
+    zh = (zh >> 4) ^ (last4[rem] << 48) ^ context.hh[high];
+    zl ^= context.hl[high];
+  }
+  store64(x, zh);
+  store64(x + 8, zl);
+}
+
+// Acumula data em y; o último bloco incompleto é completado com zeros
+static void ghashUpdate(const SealContext& context, uint8_t y[16], const uint8_t* data, size_t length) {
+  while (length > 0) {
+    size_t n = length < 16 ? length : 16;
+    for (size_t i = 0; i < n; i++) y[i] ^= data[i];
+    ghashMultiply(context, y);
+    data += n;
+    length -= n;
+  }
+}
+
+// CTR a partir de J0 + 1 sobre data (no lugar); S = GHASH(A, C, tamanhos) e tag = E(J0) ^ S
+static void gcmCrypt(const SealContext& context, const uint8_t* nonce, const uint8_t* aad, size_t aadLength,
+                     uint8_t* data, size_t length, bool encrypt, uint8_t tag[16]) {
+  uint8_t counter[16];
+  memcpy(counter, nonce, 12);
+  store32(counter + 12, 1);
+  uint8_t y[16] = {0};
+  ghashUpdate(context, y, aad, aadLength);
+  uint32_t block = 1;
+  for (size_t pos = 0; pos < length; pos += 16) {
+    size_t n = length - pos < 16 ? length - pos : 16;
+    if (!encrypt) ghashUpdate(context, y, data + pos, n);
+    uint8_t stream[16];
+    store32(counter + 12, ++block);
+    aesEncrypt(context, counter, stream);
+    for (size_t i = 0; i < n; i++) data[pos + i] ^= stream[i];
+    if (encrypt) ghashUpdate(context, y, data + pos, n);
+  }
+  uint8_t lengths[16];
+  store64(lengths, (uint64_t)aadLength * 8);
+  store64(lengths + 8, (uint64_t)length * 8);
+  ghashUpdate(context, y, lengths, 16);
+  store32(counter + 12, 1);
+  aesEncrypt(context, counter, tag);
+  for (int i = 0; i < 16; i++) tag[i] ^= y[i];
+}
+
+static void gcmEncrypt(SealContext& context, const uint8_t* nonce, const uint8_t* aad, size_t aadLength,
+                       uint8_t* data, size_t length, uint8_t* tag) {
+  gcmCrypt(context, nonce, aad, aadLength, data, length, true, tag);
+}
+
+static bool gcmDecrypt(SealContext& context, const uint8_t* nonce, const uint8_t* aad, size_t aadLength,
+                       uint8_t* data, size_t length, const uint8_t* tag) {
+  uint8_t expected[16];
+  gcmCrypt(context, nonce, aad, aadLength, data, length, false, expected);
+  uint8_t diff = 0;
+  for (int i = 0; i < 16; i++) diff |= expected[i] ^ tag[i];
+  return diff == 0;
+}
+#endif
+
+// ====== ENVELOPE ======
+// Cabeçalho seguido do tópico; retorna o tamanho ou 0 se o tópico não cabe
+static size_t associatedData(uint8_t* aad, const uint8_t* header, const char* topic) {
+  size_t topicLength = strlen(topic);
+  if (topicLength > SEAL_TOPIC_MAX) return 0;
+  memcpy(aad, header, SEAL_HEADER_SIZE);
+  memcpy(aad + SEAL_HEADER_SIZE, topic, topicLength);
+  return SEAL_HEADER_SIZE + topicLength;
+}
+
+bool PayloadSealer::begin(const uint8_t key[SEAL_KEY_SIZE], uint8_t keyId, uint32_t epoch) {
+  end();
+  if (epoch == 0) return false;
+  _context = (SealContext*)calloc(1, sizeof(SealContext));
+  if (_context == nullptr) return false;
+  if (!gcmInit(*_context, key)) {
+    end();
+    return false;
+  }
+  _keyId = keyId;
+  _epoch = epoch;
+  _counter = 0;
+  return true;
+}
+
+void PayloadSealer::end() {
+  if (_context == nullptr) return;
+  gcmFree(*_context);
+  memset(_context, 0, sizeof(SealContext));  // Não deixa a chave expandida no heap
+  free(_context);
+  _context = nullptr;
+}
+
+size_t PayloadSealer::seal(const char* topic, uint8_t* buffer, size_t length) {
+  if (_context == nullptr) return 0;
+  uint32_t start = readCycles();
+  uint8_t* header = buffer;
+  header[0] = sealMagic[0];
+  header[1] = sealMagic[1];
+  header[2] = SEAL_VERSION;
+  header[3] = _keyId;
+  uint64_t counter = _counter++;
+  for (int i = 0; i < 4; i++) header[4 + i] = (uint8_t)(_epoch >> (8 * i));
+  for (int i = 0; i < 8; i++) header[8 + i] = (uint8_t)(counter >> (8 * i));
+  uint8_t aad[SEAL_HEADER_SIZE + SEAL_TOPIC_MAX];
+  size_t aadLength = associatedData(aad, header, topic);
+  if (aadLength == 0) {
+    _stats.failures++;
+    return 0;
+  }
+  gcmEncrypt(*_context, header + 4, aad, aadLength, buffer + SEAL_HEADER_SIZE, length,
+             buffer + SEAL_HEADER_SIZE + length);
+  uint32_t cycles = readCycles() - start;
+  _stats.sealed++;
+  _stats.bytes += length;
+  _stats.cycles += cycles;
+  _stats.lastBytes = (uint32_t)length;
+  _stats.lastCycles = cycles;
+  return length + SEAL_OVERHEAD;
+}
+
+int sealOpen(const uint8_t key[SEAL_KEY_SIZE], const char* topic, uint8_t* envelope, size_t length) {
+  if (length < SEAL_OVERHEAD || envelope[0] != sealMagic[0] || envelope[1] != sealMagic[1] ||
+      envelope[2] != SEAL_VERSION) {
+    return -1;
+  }
+  uint8_t aad[SEAL_HEADER_SIZE + SEAL_TOPIC_MAX];
+  size_t aadLength = associatedData(aad, envelope, topic);
+  if (aadLength == 0) return -1;
+  SealContext context;
+  if (!gcmInit(context, key)) return -1;
+  size_t payloadLength = length - SEAL_OVERHEAD;
+  bool ok = gcmDecrypt(context, envelope + 4, aad, aadLength, envelope + SEAL_HEADER_SIZE, payloadLength,
+                       envelope + SEAL_HEADER_SIZE + payloadLength);
+  gcmFree(context);
+  return ok ? (int)payloadLength : -1;
+}
@@ -0,0 +1,421 @@
+#include "tls_client.h"
+
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+#include "crc.h"
+
+#define TLS_SESSION_MAGIC 0x31534C54u  // "TLS1"
+
+// ====== SESSÕES NA RTC ======
+// RTC_NOINIT: não é zerada no boot, então vale depois do deep sleep e de um reinício por
+// software; depois de uma falta de energia o CRC de cada posição não confere.
+struct TlsSessionSlot {
+  uint32_t crc;                 // De port até o fim da sessão
+  uint32_t lastUse;             // Para escolher a posição a substituir
+  uint16_t port;
+  uint16_t length;              // 0 = posição vazia
+  char server[BROKER_HOST_MAX];
+  uint8_t data[TLS_SESSION_MAX];
+};
+
+struct TlsSessionStore {
+  uint32_t magic;
+  uint32_t uses;
+  TlsSessionSlot slots[TLS_SESSION_SLOTS];
+};
+
+static RTC_NOINIT_ATTR TlsSessionStore sessionStore;
+
+static uint32_t slotCrc(const TlsSessionSlot& slot) {
+  return crc32(&slot.port, offsetof(TlsSessionSlot, data) - offsetof(TlsSessionSlot, port) + slot.length);
+}
+
+static bool slotValid(const TlsSessionSlot& slot) {
+  return slot.length > 0 && slot.length <= TLS_SESSION_MAX && slotCrc(slot) == slot.crc;
+}
+
+// ====== CONTEXTO mbedtls ======
+struct TlsContext {
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context rng;
+  mbedtls_x509_crt ca;
+  mbedtls_ssl_config conf;
+  mbedtls_ssl_context ssl;
+  mbedtls_net_context net;
+  bool verify;                  // Com CA: certificado fora da cadeia derruba o handshake
+  bool open;
+  bool certificateSeen;         // O servidor mandou certificado: handshake completo
+  int peek;                     // Byte lido por available() (-1 = nenhum)
+  uint32_t bytes;               // Bytes no socket desde o início do handshake
+};
+
+// ECDSA primeiro; AES-128-GCM tem aceleração no ESP32. Suítes que a build do mbedtls
+// não tem são ignoradas no ClientHello.
+static const int ciphersuites[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256,
+    0};
+
+static const mbedtls_ecp_group_id curves[] = {
+    MBEDTLS_ECP_DP_SECP256R1,
+    MBEDTLS_ECP_DP_CURVE25519,
+    MBEDTLS_ECP_DP_SECP384R1,
+    MBEDTLS_ECP_DP_NONE};
+
+// Chamada para cada certificado da cadeia recebida, o que só acontece no handshake completo
+static int verifyCertificate(void* context, mbedtls_x509_crt*, int, uint32_t* flags) {
+  TlsContext* tls = (TlsContext*)context;
+  tls->certificateSeen = true;
+  if (!tls->verify) *flags = 0;
+  return 0;
+}
+
+static int sendCounted(void* context, const unsigned char* data, size_t length) {
+  TlsContext* tls = (TlsContext*)context;
+  int n = mbedtls_net_send(&tls->net, data, length);
+  if (n > 0) tls->bytes += n;
+  return n;
+}
+
+static int receiveCounted(void* context, unsigned char* buffer, size_t length) {
+  TlsContext* tls = (TlsContext*)context;
+  int n = mbedtls_net_recv(&tls->net, buffer, length);
+  if (n > 0) tls->bytes += n;
+  return n;
+}
+
+static bool isAddress(const char* host) {
+  for (const char* p = host; *p; p++) {
+    if ((*p < '0' || *p > '9') && *p != '.') return false;
+  }
+  return true;
+}
+
+// Conexão TCP sem bloqueio com prazo; o socket continua sem bloqueio para o mbedtls
+static int openSocket(const char* host, uint16_t port, int32_t timeoutMs) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char service[6];
+  snprintf(service, sizeof(service), "%u", port);
+  struct addrinfo* address = nullptr;
+  if (getaddrinfo(host, service, &hints, &address) != 0 || address == nullptr) return -1;
+  int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+  if (fd < 0) {
+    freeaddrinfo(address);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  int ret = ::connect(fd, address->ai_addr, address->ai_addrlen);
+  freeaddrinfo(address);
+  if (ret != 0) {
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(fd, &writable);
+    struct timeval timeout = {(time_t)(timeoutMs / 1000), (suseconds_t)((timeoutMs % 1000) * 1000)};
+    int error = 0;
+    socklen_t errorLength = sizeof(error);
+    if (errno != EINPROGRESS || select(fd + 1, nullptr, &writable, nullptr, &timeout) <= 0 ||
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLength) != 0 || error != 0) {
+      close(fd);
+      return -1;
+    }
+  }
+  // Cada pacote MQTT é um registro TLS: sem Nagle ele sai na hora
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+// ====== CLIENTE ======
+TlsClient::TlsClient() {
+  if (sessionStore.magic != TLS_SESSION_MAGIC) {
+    memset(&sessionStore, 0, sizeof(sessionStore));
+    sessionStore.magic = TLS_SESSION_MAGIC;
+    return;
+  }
+  for (size_t i = 0; i < TLS_SESSION_SLOTS; i++) {
+    if (slotValid(sessionStore.slots[i])) {
+      _stats.restoredSessions++;
+    } else {
+      sessionStore.slots[i].length = 0;
+    }
+  }
+}
+
+TlsClient::~TlsClient() {
+  if (_tls == nullptr) return;
+  stop();
+  mbedtls_ssl_free(&_tls->ssl);
+  mbedtls_ssl_config_free(&_tls->conf);
+  mbedtls_x509_crt_free(&_tls->ca);
+  mbedtls_ctr_drbg_free(&_tls->rng);
+  mbedtls_entropy_free(&_tls->entropy);
+  free(_tls);
+}
+
+void TlsClient::setServerName(const char* name) {
+  strncpy(_serverName, name, sizeof(_serverName) - 1);
+  _serverName[sizeof(_serverName) - 1] = '\0';
+}
+
+// Configuração feita uma vez e mantida entre conexões (gerador, CA, suítes)
+bool TlsClient::setup() {
+  if (_tls != nullptr) return true;
+  _tls = (TlsContext*)calloc(1, sizeof(TlsContext));
+  if (_tls == nullptr) return false;
+  mbedtls_entropy_init(&_tls->entropy);
+  mbedtls_ctr_drbg_init(&_tls->rng);
+  mbedtls_x509_crt_init(&_tls->ca);
+  mbedtls_ssl_config_init(&_tls->conf);
+  mbedtls_ssl_init(&_tls->ssl);
+  mbedtls_net_init(&_tls->net);
+  _tls->peek = -1;
+
+  static const char personalization[] = "agroflow-tls";
+  mbedtls_ssl_config* conf = &_tls->conf;
+  if (mbedtls_ctr_drbg_seed(&_tls->rng, mbedtls_entropy_func, &_tls->entropy, (const unsigned char*)personalization,
+                            sizeof(personalization) - 1) != 0 ||
+      mbedtls_ssl_config_defaults(conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                  MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+    Serial.println("TLS: falha ao iniciar o mbedtls.");
+    return false;
+  }
+  mbedtls_ssl_conf_rng(conf, mbedtls_ctr_drbg_random, &_tls->rng);
+  mbedtls_ssl_conf_min_version(conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+  mbedtls_ssl_conf_max_version(conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+  mbedtls_ssl_conf_ciphersuites(conf, ciphersuites);
+  mbedtls_ssl_conf_curves(conf, curves);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+  // OPTIONAL mesmo sem CA: é o que faz o mbedtls chamar verifyCertificate
+  _tls->verify = _caCert != nullptr &&
+                 mbedtls_x509_crt_parse(&_tls->ca, (const unsigned char*)_caCert, strlen(_caCert) + 1) == 0;
+  if (_tls->verify) {
+    mbedtls_ssl_conf_ca_chain(conf, &_tls->ca, nullptr);
+  } else {
+    Serial.println("TLS: sem CA, certificado do servidor nao verificado.");
+  }
+  mbedtls_ssl_conf_authmode(conf, _tls->verify ? MBEDTLS_SSL_VERIFY_REQUIRED : MBEDTLS_SSL_VERIFY_OPTIONAL);
+  mbedtls_ssl_conf_verify(conf, verifyCertificate, _tls);
+  return true;
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+  stop();
+  if (!setup()) return 0;
+  const char* name = _serverName[0] ? _serverName : host;
+  int fd = openSocket(host, port, timeoutMs);
+  if (fd < 0) return 0;
+  _tls->net.fd = fd;
+  mbedtls_ssl_context* ssl = &_tls->ssl;
+  if (mbedtls_ssl_setup(ssl, &_tls->conf) != 0 || (!isAddress(name) && mbedtls_ssl_set_hostname(ssl, name) != 0)) {
+    _stats.failures++;
+    stop();
+    return 0;
+  }
+  mbedtls_ssl_set_bio(ssl, _tls, sendCounted, receiveCounted, nullptr);
+  int slot = findSession(name, port);
+  bool offered = slot >= 0 && offerSession(slot);
+
+  _tls->certificateSeen = false;
+  _tls->bytes = 0;
+  unsigned long start = millis();
+  int ret;
+  while ((ret = mbedtls_ssl_handshake(ssl)) != 0) {
+    if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+        millis() - start > TLS_HANDSHAKE_TIMEOUT_MS) {
+      Serial.printf("TLS: handshake com %s falhou (-0x%04x).\n", name, (unsigned)-ret);
+      _stats.failures++;
+      // Uma sessão que o servidor não aceita nem recusa direito não é oferecida de novo
+      if (offered) sessionStore.slots[slot].length = 0;
+      stop();
+      return 0;
+    }
+    delay(1);
+  }
+
+  uint32_t elapsed = millis() - start;
+  bool resumed = offered && !_tls->certificateSeen;
+  _stats.lastMs = elapsed;
+  _stats.lastBytes = _tls->bytes;
+  _stats.lastResumed = resumed;
+  if (resumed) {
+    _stats.resumedHandshakes++;
+    _stats.resumedMsTotal += elapsed;
+    _stats.resumedBytesTotal += _tls->bytes;
+  } else {
+    _stats.fullHandshakes++;
+    _stats.fullMsTotal += elapsed;
+    _stats.fullBytesTotal += _tls->bytes;
+    if (offered) _stats.rejectedSessions++;
+  }
+  // Mesmo retomada, a sessão pode ter vindo com um ticket novo
+  saveSession(name, port);
+  _tls->open = true;
+  return 1;
+}
+
+uint8_t TlsClient::connected() {
+  return available() > 0 || (_tls != nullptr && _tls->open);
+}
+
+size_t TlsClient::write(const uint8_t* data, size_t length) {
+  if (_tls == nullptr || !_tls->open) return 0;
+  size_t sent = 0;
+  unsigned long start = millis();
+  while (sent < length) {
+    int n = mbedtls_ssl_write(&_tls->ssl, data + sent, length - sent);
+    if (n > 0) {
+      sent += n;
+      continue;
+    }
+    if ((n != MBEDTLS_ERR_SSL_WANT_READ && n != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+        millis() - start > TLS_WRITE_TIMEOUT_MS) {
+      lose();
+      break;
+    }
+    delay(1);
+  }
+  return sent;
+}
+
+// O mbedtls só decifra ao ler: um byte é lido para saber se chegou um registro, e o
+// resto do registro fica no buffer dele
+int TlsClient::available() {
+  if (_tls == nullptr) return 0;
+  size_t pending = mbedtls_ssl_get_bytes_avail(&_tls->ssl);
+  if (_tls->peek < 0 && pending == 0 && _tls->open) {
+    unsigned char byte;
+    int n = mbedtls_ssl_read(&_tls->ssl, &byte, 1);
+    if (n == 1) {
+      _tls->peek = byte;
+    } else if (n != MBEDTLS_ERR_SSL_WANT_READ && n != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      lose();  // 0 ou close_notify: o servidor fechou
+    }
+    pending = mbedtls_ssl_get_bytes_avail(&_tls->ssl);
+  }
+  return (_tls->peek >= 0 ? 1 : 0) + (int)pending;
+}
+
+int TlsClient::read() {
+  uint8_t byte;
+  return read(&byte, 1) == 1 ? byte : -1;
+}
+
+int TlsClient::read(uint8_t* buffer, size_t length) {
+  if (_tls == nullptr || length == 0) return -1;
+  size_t n = 0;
+  if (_tls->peek >= 0) {
+    buffer[n++] = (uint8_t)_tls->peek;
+    _tls->peek = -1;
+  }
+  if (n < length && _tls->open) {
+    int ret = mbedtls_ssl_read(&_tls->ssl, buffer + n, length - n);
+    if (ret > 0) {
+      n += ret;
+    } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      lose();
+    }
+  }
+  return n > 0 ? (int)n : -1;
+}
+
+void TlsClient::stop() {
+  if (_tls == nullptr) return;
+  // close_notify: o servidor encerra sem invalidar a sessão
+  if (_tls->open) mbedtls_ssl_close_notify(&_tls->ssl);
+  mbedtls_ssl_free(&_tls->ssl);
+  mbedtls_ssl_init(&_tls->ssl);
+  mbedtls_net_free(&_tls->net);
+  _tls->open = false;
+  _tls->peek = -1;
+}
+
+void TlsClient::lose() { _tls->open = false; }
+
+const char* TlsClient::suite() const {
+  return _tls != nullptr && _tls->open ? mbedtls_ssl_get_ciphersuite(&_tls->ssl) : "";
+}
+
+size_t TlsClient::cachedSessions() const {
+  size_t n = 0;
+  for (size_t i = 0; i < TLS_SESSION_SLOTS; i++) {
+    if (sessionStore.slots[i].length > 0) n++;
+  }
+  return n;
+}
+
+int TlsClient::findSession(const char* name, uint16_t port) const {
+  for (size_t i = 0; i < TLS_SESSION_SLOTS; i++) {
+    const TlsSessionSlot& slot = sessionStore.slots[i];
+    if (slot.length > 0 && slot.port == port && strcmp(slot.server, name) == 0) return (int)i;
+  }
+  return -1;
+}
+
+bool TlsClient::offerSession(int slot) {
+  TlsSessionSlot& stored = sessionStore.slots[slot];
+  if (!slotValid(stored)) {
+    stored.length = 0;
+    return false;
+  }
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  bool ok = mbedtls_ssl_session_load(&session, stored.data, stored.length) == 0 &&
+            mbedtls_ssl_set_session(&_tls->ssl, &session) == 0;
+  mbedtls_ssl_session_free(&session);
+  if (!ok) stored.length = 0;
+  stored.lastUse = ++sessionStore.uses;
+  return ok;
+}
+
+// Grava na posição do servidor, numa vazia ou na usada há mais tempo
+void TlsClient::saveSession(const char* name, uint16_t port) {
+  int index = findSession(name, port);
+  for (size_t i = 0; index < 0 && i < TLS_SESSION_SLOTS; i++) {
+    if (sessionStore.slots[i].length == 0) index = (int)i;
+  }
+  if (index < 0) {
+    index = 0;
+    for (size_t i = 1; i < TLS_SESSION_SLOTS; i++) {
+      if (sessionStore.slots[i].lastUse < sessionStore.slots[index].lastUse) index = (int)i;
+    }
+  }
+  TlsSessionSlot& slot = sessionStore.slots[index];
+  slot.length = 0;
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  size_t length = 0;
+  int ret = mbedtls_ssl_get_session(&_tls->ssl, &session);
+  if (ret == 0) ret = mbedtls_ssl_session_save(&session, slot.data, sizeof(slot.data), &length);
+  mbedtls_ssl_session_free(&session);
+  if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) _stats.oversizedSessions++;
+  if (ret != 0 || length == 0) return;
+  slot.port = port;
+  strncpy(slot.server, name, sizeof(slot.server) - 1);
+  slot.server[sizeof(slot.server) - 1] = '\0';
+  slot.length = (uint16_t)length;
+  slot.lastUse = ++sessionStore.uses;
+  slot.crc = slotCrc(slot);
+}
@@ -0,0 +1,186 @@
+#include "ts_codec.h"
+
+#include <string.h>
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t z) { return (int32_t)(z >> 1) ^ -(int32_t)(z & 1); }
+
+static inline uint8_t bitWidth(uint32_t v) {
+  uint8_t n = 0;
+  while (v) {
+    n++;
+    v >>= 1;
+  }
+  return n;
+}
+
+static void putLe(uint8_t* p, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t getLe(const uint8_t* p, int bytes) {
+  uint64_t v = 0;
+  for (int i = 0; i < bytes; i++) v |= (uint64_t)p[i] << (8 * i);
+  return v;
+}
+
+// ====== CODIFICADOR ======
+TsBlockEncoder::TsBlockEncoder(uint8_t* out, size_t capacity, uint8_t scale)
+    : _out(out), _capacity(capacity), _scale(scale) {
+  if (_capacity > TS_BLOCK_HEADER_SIZE) {
+    memset(_out + TS_BLOCK_HEADER_SIZE, 0, _capacity - TS_BLOCK_HEADER_SIZE);
+  }
+}
+
+void TsBlockEncoder::setSequence(uint32_t epoch, uint32_t firstSeq, uint16_t stride) {
+  _epoch = epoch;
+  _firstSeq = firstSeq;
+  _stride = stride;
+}
+
+void TsBlockEncoder::writeBits(uint32_t value, uint8_t bits) {
+  uint8_t* stream = _out + TS_BLOCK_HEADER_SIZE;
+  while (bits > 0) {
+    size_t byte = _bitPos >> 3;
+    uint8_t free = 8 - (_bitPos & 7);
+    uint8_t take = bits < free ? bits : free;
+    uint8_t chunk = (uint8_t)((value >> (bits - take)) & ((1u << take) - 1));
+    stream[byte] |= (uint8_t)(chunk << (free - take));
+    _bitPos += take;
+    bits -= take;
+  }
+}
+
+bool TsBlockEncoder::add(uint64_t timestampMs, int32_t value) {
+  if (_capacity < TS_BLOCK_HEADER_SIZE || _count == UINT16_MAX) return false;
+
+  if (_count == 0) {
+    putLe(_out + 6, timestampMs, 8);
+    putLe(_out + 14, (uint32_t)value, 4);
+  } else {
+    size_t capacityBits = (_capacity - TS_BLOCK_HEADER_SIZE) * 8;
+    if (_bitPos + TS_SAMPLE_MAX_BITS > capacityBits) return false;
+
+    int64_t delta = (int64_t)(timestampMs - _lastTimestamp);
+    int64_t dod = delta - _lastDelta;
+    if (dod < INT32_MIN || dod > INT32_MAX) return false;  // Salto maior que o campo de 32 bits (~24,8 dias)
+    if (dod == 0) {
+      writeBits(0, 1);
+    } else if (dod >= -64 && dod <= 63) {
+      writeBits(0x2, 2);
+      writeBits((uint32_t)dod & 0x7F, 7);
+    } else if (dod >= -256 && dod <= 255) {
+      writeBits(0x6, 3);
+      writeBits((uint32_t)dod & 0x1FF, 9);
+    } else if (dod >= -2048 && dod <= 2047) {
+      writeBits(0xE, 4);
+      writeBits((uint32_t)dod & 0xFFF, 12);
+    } else {
+      writeBits(0xF, 4);
+      writeBits((uint32_t)dod, 32);
+    }
+    _lastDelta = delta;
+
+    uint32_t z = zigzag(value - _lastValue);
+    if (z == 0) {
+      writeBits(0, 1);
+    } else {
+      uint8_t width = bitWidth(z);
+      writeBits(1, 1);
+      writeBits(width - 1, 5);
+      writeBits(z, width);
+    }
+  }
+
+  _lastTimestamp = timestampMs;
+  _lastValue = value;
+  _count++;
+  return true;
+}
+
+size_t TsBlockEncoder::finish() {
+  if (_capacity < TS_BLOCK_HEADER_SIZE) return 0;
+  if (_count == 0) memset(_out, 0, TS_BLOCK_HEADER_SIZE);
+  _out[0] = 'A';
+  _out[1] = 'F';
+  _out[2] = TS_BLOCK_VERSION;
+  _out[3] = _scale;
+  putLe(_out + 4, _count, 2);
+  putLe(_out + 18, _epoch, 4);
+  putLe(_out + 22, _firstSeq, 4);
+  putLe(_out + 26, _stride, 2);
+  return TS_BLOCK_HEADER_SIZE + (_bitPos + 7) / 8;
+}
+
+// ====== DECODIFICADOR ======
+bool TsBlockDecoder::begin(const uint8_t* block, size_t length) {
+  if (length < TS_BLOCK_HEADER_SIZE || block[0] != 'A' || block[1] != 'F' ||
+      block[2] != TS_BLOCK_VERSION) {
+    return false;
+  }
+  _scale = block[3];
+  _count = (uint16_t)getLe(block + 4, 2);
+  _lastTimestamp = getLe(block + 6, 8);
+  _lastValue = (int32_t)(uint32_t)getLe(block + 14, 4);
+  _epoch = (uint32_t)getLe(block + 18, 4);
+  _firstSeq = (uint32_t)getLe(block + 22, 4);
+  _stride = (uint16_t)getLe(block + 26, 2);
+  _lastDelta = 0;
+  _bits = block + TS_BLOCK_HEADER_SIZE;
+  _bitLength = (length - TS_BLOCK_HEADER_SIZE) * 8;
+  _bitPos = 0;
+  _read = 0;
+  return true;
+}
+
+bool TsBlockDecoder::readBits(uint8_t bits, uint32_t& value) {
+  if (_bitPos + bits > _bitLength) return false;
+  value = 0;
+  for (uint8_t i = 0; i < bits; i++) {
+    uint8_t bit = (_bits[_bitPos >> 3] >> (7 - (_bitPos & 7))) & 1;
+    value = (value << 1) | bit;
+    _bitPos++;
+  }
+  return true;
+}
+
+// Estende o sinal de um campo de n bits
+static inline int64_t signExtend(uint32_t v, uint8_t bits) {
+  if (bits == 32) return (int32_t)v;
+  uint32_t sign = 1u << (bits - 1);
+  return (int64_t)(int32_t)((v ^ sign) - sign);
+}
+
+bool TsBlockDecoder::next(uint64_t& timestampMs, int32_t& value) {
+  if (_read >= _count) return false;
+  if (_read > 0) {
+    // Prefixo: número de '1' antes do '0' (até 4) seleciona o tamanho do delta-of-delta
+    static const uint8_t dodBits[] = { 0, 7, 9, 12, 32 };
+    uint8_t ones = 0;
+    uint32_t bit;
+    while (ones < 4) {
+      if (!readBits(1, bit)) return false;
+      if (bit == 0) break;
+      ones++;
+    }
+    int64_t dod = 0;
+    if (ones > 0) {
+      uint32_t raw;
+      if (!readBits(dodBits[ones], raw)) return false;
+      dod = signExtend(raw, dodBits[ones]);
+    }
+    _lastDelta += dod;
+    _lastTimestamp += _lastDelta;
+
+    if (!readBits(1, bit)) return false;
+    if (bit) {
+      uint32_t width, z;
+      if (!readBits(5, width) || !readBits((uint8_t)(width + 1), z)) return false;
+      _lastValue += unzigzag(z);
+    }
+  }
+  timestampMs = _lastTimestamp;
+  value = _lastValue;
+  _read++;
+  return true;
+}
@@ -0,0 +1,284 @@
+#include "ts_store.h"
+
+#include <stddef.h>
+#include <string.h>
+#include "crc.h"
+
+#define TS_STORE_MAGIC 0x324C5354u  // "TSL2" (a versão sem sequência usava "TSLG")
+
+// ====== ACESSO À FLASH ======
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_partition.h>
+
+static const esp_partition_t* partition = nullptr;
+static spi_flash_mmap_handle_t mapHandle;
+
+static bool flashOpen(const uint8_t*& base, uint32_t& size) {
+  partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, TS_STORE_PARTITION_LABEL);
+#ifdef TS_STORE_FALLBACK_LABEL
+  if (partition == nullptr) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, TS_STORE_FALLBACK_LABEL);
+    if (partition != nullptr) {
+      Serial.println("Sem particao " TS_STORE_PARTITION_LABEL ": historico na particao " TS_STORE_FALLBACK_LABEL
+                     " (conteudo anterior apagado).");
+    }
+  }
+#endif
+  if (partition == nullptr) return false;
+  const void* ptr;
+  if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &ptr, &mapHandle) != ESP_OK) {
+    return false;
+  }
+  base = (const uint8_t*)ptr;
+  size = partition->size;
+  return true;
+}
+
+// A escrita pela API invalida o cache das regiões mapeadas: o ponteiro já enxerga o dado novo
+static bool flashWrite(uint32_t offset, const void* data, size_t length) {
+  return esp_partition_write(partition, offset, data, length) == ESP_OK;
+}
+
+static bool flashErase(uint32_t offset) {
+  return esp_partition_erase_range(partition, offset, TS_STORE_PAGE_SIZE) == ESP_OK;
+}
+
+#else
+// Flash NOR simulada em RAM para o host
+static uint8_t hostFlash[TS_STORE_HOST_PAGES * TS_STORE_PAGE_SIZE] __attribute__((aligned(8)));
+static bool hostFlashInitialized = false;
+
+static bool flashOpen(const uint8_t*& base, uint32_t& size) {
+  if (!hostFlashInitialized) {
+    memset(hostFlash, 0xFF, sizeof(hostFlash));
+    hostFlashInitialized = true;
+  }
+  base = hostFlash;
+  size = sizeof(hostFlash);
+  return true;
+}
+
+static bool flashWrite(uint32_t offset, const void* data, size_t length) {
+  if (offset + length > sizeof(hostFlash)) return false;
+  const uint8_t* src = (const uint8_t*)data;
+  for (size_t i = 0; i < length; i++) hostFlash[offset + i] &= src[i];
+  return true;
+}
+
+static bool flashErase(uint32_t offset) {
+  if (offset + TS_STORE_PAGE_SIZE > sizeof(hostFlash)) return false;
+  memset(hostFlash + offset, 0xFF, TS_STORE_PAGE_SIZE);
+  return true;
+}
+#endif
+
+static bool isErased(const void* data, size_t length) {
+  const uint8_t* p = (const uint8_t*)data;
+  for (size_t i = 0; i < length; i++) {
+    if (p[i] != 0xFF) return false;
+  }
+  return true;
+}
+
+// ====== LOG CIRCULAR ======
+const TsStore::PageHeader* TsStore::header(uint32_t physical) const {
+  return (const PageHeader*)(_base + (size_t)physical * TS_STORE_PAGE_SIZE);
+}
+
+const TsStore::Record* TsStore::record(uint32_t physical, uint16_t slot) const {
+  return (const Record*)(_base + (size_t)physical * TS_STORE_PAGE_SIZE + sizeof(PageHeader)) + slot;
+}
+
+bool TsStore::headerValid(uint32_t physical) const {
+  const PageHeader* h = header(physical);
+  return h->magic == TS_STORE_MAGIC && h->crc == crc32(h, offsetof(PageHeader, crc));
+}
+
+bool TsStore::begin() {
+  uint32_t size;
+  if (!flashOpen(_base, size) || size < 2 * TS_STORE_PAGE_SIZE) {
+    _base = nullptr;
+    return false;
+  }
+  _stats.pages = size / TS_STORE_PAGE_SIZE;
+
+  // A página em escrita é a de maior sequência (comparação com volta do contador)
+  bool found = false;
+  for (uint32_t p = 0; p < _stats.pages; p++) {
+    if (!headerValid(p)) {
+      if (!isErased(header(p), sizeof(PageHeader))) _stats.crcErrors++;
+      continue;
+    }
+    if (!found || (int32_t)(header(p)->pageSeq - _headPageSeq) > 0) {
+      _head = p;
+      _headPageSeq = header(p)->pageSeq;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    // Log vazio: a primeira gravação abre a página 0
+    _head = _stats.pages - 1;
+    _headSlot = recordsPerPage();
+    _oldest = 0;
+    _stats.usedPages = 0;
+    return true;
+  }
+
+  // A mais antiga é a primeira página válida depois da cabeça (0 se o log ainda não deu a volta)
+  _oldest = _head;
+  for (uint32_t i = 1; i < _stats.pages; i++) {
+    uint32_t p = (_head + i) % _stats.pages;
+    if (headerValid(p)) {
+      _oldest = p;
+      break;
+    }
+  }
+  _stats.usedPages = (_head + _stats.pages - _oldest) % _stats.pages + 1;
+  _headBase = header(_head)->baseTimestamp;
+  _headFirst = SeqNo{ header(_head)->epoch, header(_head)->firstSeq };
+  _lastTimestamp = _headBase;
+
+  // Primeiro registro livre da página em escrita; um registro incompleto (queda de energia
+  // durante a gravação) fica para trás e é ignorado na leitura pelo CRC
+  _headSlot = 0;
+  while (_headSlot < recordsPerPage() && !isErased(record(_head, _headSlot), sizeof(Record))) {
+    const Record* r = record(_head, _headSlot);
+    if (r->crc == crc16(r, offsetof(Record, crc))) _lastTimestamp = _headBase + r->offsetMs;
+    _headSlot++;
+  }
+  return true;
+}
+
+// Apaga a próxima página (descartando a mais antiga se o log está cheio) e grava o cabeçalho
+bool TsStore::openPage(uint64_t timestampMs, SeqNo seq) {
+  uint32_t next = (_head + 1) % _stats.pages;
+  if (_stats.usedPages == _stats.pages) {
+    _oldest = (_oldest + 1) % _stats.pages;
+    _stats.usedPages--;
+  }
+  if (!flashErase(next * TS_STORE_PAGE_SIZE)) {
+    _stats.writeErrors++;
+    return false;
+  }
+  _stats.erases++;
+
+  PageHeader h;
+  h.magic = TS_STORE_MAGIC;
+  h.pageSeq = _headPageSeq + 1;
+  h.baseTimestamp = timestampMs;
+  h.epoch = seq.epoch;
+  h.firstSeq = seq.seq;
+  h.reserved = 0xFFFFFFFF;
+  h.crc = crc32(&h, offsetof(PageHeader, crc));
+  if (!flashWrite(next * TS_STORE_PAGE_SIZE, &h, sizeof(h))) {
+    _stats.writeErrors++;
+    return false;
+  }
+
+  _head = next;
+  _headPageSeq = h.pageSeq;
+  _headBase = timestampMs;
+  _headFirst = seq;
+  _headSlot = 0;
+  if (_stats.usedPages == 0) _oldest = _head;
+  _stats.usedPages++;
+  return true;
+}
+
+bool TsStore::append(uint64_t timestampMs, int32_t value, SeqNo seq) {
+  if (!ready()) return false;
+  if (timestampMs < _lastTimestamp) timestampMs = _lastTimestamp;
+
+  // Página nova quando a atual enche, a sequência não continua a da página ou o offset não
+  // cabe em 32 bits (~49 dias sem gravar)
+  if (_stats.usedPages == 0 || _headSlot >= recordsPerPage() || !seqFollows(_headFirst, seq, _headSlot) ||
+      timestampMs - _headBase >= UINT32_MAX) {
+    if (!openPage(timestampMs, seq)) return false;
+  }
+
+  Record r;
+  r.offsetMs = (uint32_t)(timestampMs - _headBase);
+  r.value = (int16_t)(value < INT16_MIN ? INT16_MIN : (value > INT16_MAX ? INT16_MAX : value));
+  r.crc = crc16(&r, offsetof(Record, crc));
+  uint32_t offset = _head * TS_STORE_PAGE_SIZE + sizeof(PageHeader) + _headSlot * sizeof(Record);
+  if (!flashWrite(offset, &r, sizeof(r))) {
+    _stats.writeErrors++;
+    return false;
+  }
+  _headSlot++;
+  _lastTimestamp = timestampMs;
+  _stats.appended++;
+  return true;
+}
+
+TsCursor TsStore::seek(uint64_t timestampMs) const {
+  TsCursor cursor = { _headPageSeq + 1, 0 };  // Log vazio: a primeira página que for aberta
+  if (!ready() || _stats.usedPages == 0) return cursor;
+  cursor.pageSeq = oldestPageSeq();
+  if (header(physicalPage(0))->baseTimestamp >= timestampMs) return cursor;
+
+  // Última página que começa em ou antes de timestampMs
+  uint32_t lo = 0, hi = _stats.usedPages - 1;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi + 1) / 2;
+    if (header(physicalPage(mid))->baseTimestamp <= timestampMs) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  uint32_t physical = physicalPage(lo);
+  uint64_t base = header(physical)->baseTimestamp;
+  uint16_t slots = lo == _stats.usedPages - 1 ? _headSlot : recordsPerPage();
+  for (uint16_t slot = 0; slot < slots; slot++) {
+    const Record* r = record(physical, slot);
+    if (!isErased(r, sizeof(Record)) && base + r->offsetMs >= timestampMs) {
+      cursor.pageSeq += lo;
+      cursor.slot = slot;
+      return cursor;
+    }
+  }
+  cursor.pageSeq += lo + 1;
+  return cursor;
+}
+
+bool TsStore::read(TsCursor& cursor, TsRecord& out) {
+  if (!ready() || _stats.usedPages == 0) return false;
+  // Página do cursor descartada pela volta do log: os registros dela se perderam
+  if ((int32_t)(cursor.pageSeq - oldestPageSeq()) < 0) {
+    cursor.pageSeq = oldestPageSeq();
+    cursor.slot = 0;
+  }
+  while ((int32_t)(_headPageSeq - cursor.pageSeq) >= 0) {
+    uint32_t physical = physicalOfSeq(cursor.pageSeq);
+    uint16_t slots = cursor.pageSeq == _headPageSeq ? _headSlot : recordsPerPage();
+    if (cursor.slot >= slots || !headerValid(physical) || header(physical)->pageSeq != cursor.pageSeq) {
+      cursor.pageSeq++;
+      cursor.slot = 0;
+      continue;
+    }
+    const Record* r = record(physical, cursor.slot++);
+    if (isErased(r, sizeof(Record))) {
+      cursor.slot = slots;  // Página fechada antes de encher
+      continue;
+    }
+    if (r->crc != crc16(r, offsetof(Record, crc))) {
+      _stats.crcErrors++;
+      continue;
+    }
+    const PageHeader* h = header(physical);
+    out.timestampMs = h->baseTimestamp + r->offsetMs;
+    out.value = r->value;
+    out.seq = SeqNo{ h->epoch, h->firstSeq + (uint32_t)(cursor.slot - 1) };
+    return true;
+  }
+  return false;
+}
+
+uint64_t TsStore::oldestTimestamp() const {
+  if (!ready() || _stats.usedPages == 0) return 0;
+  return header(physicalPage(0))->baseTimestamp;
+}
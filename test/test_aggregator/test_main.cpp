@@ -0,0 +1,104 @@
+// Primeiros resumos de janela depois do boot (aggregator.h + scheduler.h), com o mesmo
+// agendamento do startScheduler(): a janela é adicionada antes da amostragem e o primeiro
+// fechamento fica um período depois do boot. Relógio falso, sem esperar de verdade.
+//   pio test -e test_native -f test_aggregator
+#include <unity.h>
+#include "aggregator.h"
+#include "scheduler.h"
+
+#define WINDOW_MS 60000
+#define SAMPLE_MS 100
+#define BOOT_MS 1000  // setup() termina depois do delay(1000)
+#define WALL_MINUTE_MS 1699999980000ULL  // Horário Unix múltiplo de 1 min
+#define SUMMARIES_MAX 4
+
+static uint64_t clockUs = 0;
+static uint64_t fakeClock() { return clockUs; }
+static unsigned long fakeMillis() { return (unsigned long)(clockUs / 1000); }
+
+static WindowAggregator window(WINDOW_MS);
+static WindowSummary summaries[SUMMARIES_MAX];
+static size_t summaryCount = 0;
+static float nextValue = 0;
+
+static void sampleJob() { window.add(nextValue++); }
+
+static void closeJob() {
+  WindowSummary summary;
+  if (window.close(fakeMillis(), summary) && summaryCount < SUMMARIES_MAX) summaries[summaryCount++] = summary;
+}
+
+void setUp(void) {
+  clockUs = (uint64_t)BOOT_MS * 1000;
+  summaryCount = 0;
+  nextValue = 0;
+}
+void tearDown(void) {}
+
+static void advance(Scheduler& scheduler, unsigned long untilMs) {
+  while (fakeMillis() <= untilMs) {
+    scheduler.runDue();
+    clockUs += 1000;
+  }
+}
+
+static void test_first_window_is_full(void) {
+  Scheduler scheduler(fakeClock);
+  int closeId = scheduler.add("agg", WINDOW_MS, closeJob, CATCHUP_SKIP, true);
+  window.restart(fakeMillis());
+  scheduler.runIn(closeId, WINDOW_MS);
+  scheduler.add("adc", SAMPLE_MS, sampleJob);
+
+  advance(scheduler, BOOT_MS + WINDOW_MS - 1);
+  TEST_ASSERT_EQUAL_MESSAGE(0, summaryCount, "nenhum resumo antes do fim da primeira janela");
+
+  advance(scheduler, BOOT_MS + 2 * WINDOW_MS);
+  TEST_ASSERT_EQUAL(2, summaryCount);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(BOOT_MS, summaries[0].startedAt, "início da primeira janela");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(WINDOW_MS / SAMPLE_MS, summaries[0].count, "amostras da primeira janela");
+  TEST_ASSERT_EQUAL_FLOAT(0, summaries[0].min);
+  TEST_ASSERT_EQUAL_FLOAT(WINDOW_MS / SAMPLE_MS - 1, summaries[0].max);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(BOOT_MS + WINDOW_MS, summaries[1].startedAt, "início da segunda janela");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(WINDOW_MS / SAMPLE_MS, summaries[1].count, "amostras da segunda janela");
+  TEST_ASSERT_EQUAL_FLOAT(WINDOW_MS / SAMPLE_MS, summaries[1].min);
+}
+
+// Alinhamento ao horário no meio da primeira janela: ela fecha na fronteira do minuto, com
+// as amostras desde o boot, e a seguinte já é um minuto cheio
+static void test_aligned_first_window(void) {
+  Scheduler scheduler(fakeClock);
+  int closeId = scheduler.add("agg", WINDOW_MS, closeJob, CATCHUP_SKIP, true);
+  window.restart(fakeMillis());
+  scheduler.runIn(closeId, WINDOW_MS);
+  scheduler.add("adc", SAMPLE_MS, sampleJob);
+
+  advance(scheduler, BOOT_MS + 10000 - 1);
+  // Faltam 20 s para o próximo minuto
+  scheduler.alignToWallClock(WALL_MINUTE_MS + 40000);
+  advance(scheduler, BOOT_MS + 10000 + 20000 + WINDOW_MS);
+
+  TEST_ASSERT_EQUAL(2, summaryCount);
+  TEST_ASSERT_EQUAL_UINT32(BOOT_MS, summaries[0].startedAt);
+  TEST_ASSERT_EQUAL_UINT32((10000 + 20000) / SAMPLE_MS, summaries[0].count);
+  TEST_ASSERT_EQUAL_UINT32(BOOT_MS + 30000, summaries[1].startedAt);
+  TEST_ASSERT_EQUAL_UINT32(WINDOW_MS / SAMPLE_MS, summaries[1].count);
+}
+
+// Janela sem amostras não gera resumo
+static void test_empty_window_is_skipped(void) {
+  WindowSummary summary;
+  window.restart(0);
+  TEST_ASSERT_FALSE(window.close(WINDOW_MS, summary));
+  window.add(1);
+  TEST_ASSERT_TRUE(window.close(2 * WINDOW_MS, summary));
+  TEST_ASSERT_EQUAL_UINT32(WINDOW_MS, summary.startedAt);
+  TEST_ASSERT_EQUAL_UINT32(1, summary.count);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_window_is_full);
+  RUN_TEST(test_aligned_first_window);
+  RUN_TEST(test_empty_window_is_skipped);
+  return UNITY_END();
+}
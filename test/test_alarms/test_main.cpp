@@ -0,0 +1,108 @@
+// Alarmes por amostra (alarms.h): o debounce de fio solto e fundo de escala e a suspensão de
+// seco/encharcado enquanto o filtro ainda carrega o pico, sem alarme de umidade falso na
+// volta do sensor.
+//   pio test -e test_native -f test_alarms
+#include <unity.h>
+#include "alarms.h"
+
+#define NORMAL_RAW 2320
+#define NORMAL_HUMIDITY 35.0f
+
+static const AlarmThresholds thresholds = { 20.0f, 90.0f, 3.0f, 100, 4000, 3, 100 };
+
+#define EVENTS_MAX 16
+static AlarmEvent events[EVENTS_MAX];
+static size_t eventCount = 0;
+
+static void record(const AlarmEvent& event) {
+  if (eventCount < EVENTS_MAX) events[eventCount] = event;
+  eventCount++;
+}
+
+// Umidade da calibração do firmware (DRY_VALUE 2850, WET_VALUE 1350), limitada a 0..100
+static float humidityOf(int raw) {
+  float h = (2850 - raw) * 100.0f / (2850 - 1350);
+  return h < 0 ? 0 : (h > 100 ? 100 : h);
+}
+
+static void feed(AlarmMonitor& monitor, int pin, int filtered, int samples = 1) {
+  for (int i = 0; i < samples; i++) monitor.update(pin, filtered, humidityOf(filtered), record);
+}
+
+void setUp(void) { eventCount = 0; }
+void tearDown(void) {}
+
+static void checkEvent(size_t i, AlarmType type, bool active) {
+  TEST_ASSERT_TRUE(i < eventCount);
+  TEST_ASSERT_EQUAL_MESSAGE(type, events[i].type, "tipo do alarme");
+  TEST_ASSERT_EQUAL_MESSAGE(active, events[i].active, "estado do alarme");
+}
+
+// Picos mais curtos que o debounce não disparam; um valor oscilando no limite também não
+static void test_short_spikes_are_debounced(void) {
+  AlarmMonitor monitor(thresholds);
+  feed(monitor, NORMAL_RAW, NORMAL_RAW, 10);
+  feed(monitor, 4095, NORMAL_RAW, 2);
+  feed(monitor, NORMAL_RAW, NORMAL_RAW, 5);
+  feed(monitor, 0, NORMAL_RAW, 2);
+  feed(monitor, NORMAL_RAW, NORMAL_RAW, 5);
+  for (int i = 0; i < 50; i++) feed(monitor, i % 2 ? 4001 : 3999, NORMAL_RAW);
+  TEST_ASSERT_EQUAL(0, eventCount);
+}
+
+// Fundo de escala por 5 s (a 10 Hz) com a mediana do Hampel atrasada: o filtro fica no
+// fundo de escala por 4 amostras depois da volta do pino. Só o adc_rail dispara e normaliza.
+static void test_rail_episode_has_no_humidity_alarm(void) {
+  AlarmMonitor monitor(thresholds);
+  feed(monitor, NORMAL_RAW, NORMAL_RAW, 10);
+  feed(monitor, 4095, NORMAL_RAW, 4);
+  feed(monitor, 4095, 4095, 46);
+  feed(monitor, NORMAL_RAW, 4095, 4);
+  feed(monitor, NORMAL_RAW, 3000, 3);  // O filtro ainda volta (umidade abaixo do limite de seco)
+  feed(monitor, NORMAL_RAW, NORMAL_RAW, 200);
+  TEST_ASSERT_EQUAL(2, eventCount);
+  checkEvent(0, ALARM_ADC_RAIL, true);
+  checkEvent(1, ALARM_ADC_RAIL, false);
+  TEST_ASSERT_EQUAL(4095, events[0].raw);
+  TEST_ASSERT_FALSE(monitor.active(ALARM_DRY));
+}
+
+// Sensor desconectado (0 V vira 100%): sem encharcado falso na volta
+static void test_disconnect_episode_has_no_humidity_alarm(void) {
+  AlarmMonitor monitor(thresholds);
+  feed(monitor, NORMAL_RAW, NORMAL_RAW, 10);
+  feed(monitor, 0, NORMAL_RAW, 4);
+  feed(monitor, 0, 0, 6000);
+  feed(monitor, NORMAL_RAW, 0, 4);
+  feed(monitor, NORMAL_RAW, 1200, 5);
+  feed(monitor, NORMAL_RAW, NORMAL_RAW, 200);
+  TEST_ASSERT_EQUAL(2, eventCount);
+  checkEvent(0, ALARM_DISCONNECTED, true);
+  checkEvent(1, ALARM_DISCONNECTED, false);
+  TEST_ASSERT_FALSE(monitor.active(ALARM_SATURATED));
+}
+
+// Seco de verdade continua disparando, depois da espera do filtro, e normaliza com histerese
+static void test_dry_after_settle(void) {
+  AlarmMonitor monitor(thresholds);
+  int dryRaw = 2600;  // ~16,7%
+  feed(monitor, dryRaw, dryRaw, thresholds.settleSamples - 1);
+  TEST_ASSERT_EQUAL_MESSAGE(0, eventCount, "suspenso durante a espera do boot");
+  feed(monitor, dryRaw, dryRaw, 2);
+  TEST_ASSERT_EQUAL(1, eventCount);
+  checkEvent(0, ALARM_DRY, true);
+  feed(monitor, 2540, 2540, 10);  // ~20,7%: dentro da histerese
+  TEST_ASSERT_EQUAL(1, eventCount);
+  feed(monitor, 2450, 2450);      // ~26,7%
+  TEST_ASSERT_EQUAL(2, eventCount);
+  checkEvent(1, ALARM_DRY, false);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_short_spikes_are_debounced);
+  RUN_TEST(test_rail_episode_has_no_humidity_alarm);
+  RUN_TEST(test_disconnect_episode_has_no_humidity_alarm);
+  RUN_TEST(test_dry_after_settle);
+  return UNITY_END();
+}
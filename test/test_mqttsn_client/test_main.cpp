@@ -0,0 +1,177 @@
+// Pedidos do MQTT-SN sem esperar (mqttsn_client.h): o CONNECT, o SUBSCRIBE e o REGISTER saem
+// uma vez por chamada e a resposta é conferida no loop() seguinte, com os reenvios no
+// relógio; a mensagem QoS 1 de um tópico novo espera o REGACK na janela.
+//   pio test -e test_native -f test_mqttsn_client
+#include <unity.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "mqttsn_client.h"
+
+static unsigned long clockMs = 0;
+static unsigned long fakeMillis() { return clockMs; }
+
+// UDP falso: guarda os datagramas enviados e entrega os da fila de entrada
+class FakeUdp {
+ public:
+  std::vector<std::string> sent;
+  std::deque<std::string> inbox;
+
+  uint8_t begin(uint16_t) { return 1; }
+  int beginPacket(const char*, uint16_t) {
+    _packet.clear();
+    return 1;
+  }
+  size_t write(const uint8_t* data, size_t length) {
+    _packet.append((const char*)data, length);
+    return length;
+  }
+  int endPacket() {
+    sent.push_back(_packet);
+    return 1;
+  }
+  int parsePacket() {
+    if (inbox.empty()) return 0;
+    _received = inbox.front();
+    inbox.pop_front();
+    return (int)_received.size();
+  }
+  int read(uint8_t* buffer, size_t length) {
+    size_t n = _received.size() < length ? _received.size() : length;
+    memcpy(buffer, _received.data(), n);
+    return (int)n;
+  }
+
+  // Tipo do i-ésimo datagrama enviado (cabeçalho curto)
+  uint8_t sentType(size_t i) const { return (uint8_t)sent[i][1]; }
+  uint16_t sentMsgId(size_t i) const {  // REGISTER e SUBSCRIBE
+    size_t at = sentType(i) == MQTTSN_REGISTER ? 4 : 3;
+    return (uint16_t)((uint8_t)sent[i][at] << 8 | (uint8_t)sent[i][at + 1]);
+  }
+  size_t count(uint8_t type) const {
+    size_t n = 0;
+    for (size_t i = 0; i < sent.size(); i++) n += sentType(i) == type;
+    return n;
+  }
+
+ private:
+  std::string _packet;
+  std::string _received;
+};
+
+static FakeUdp udp;
+
+static void reply(const uint8_t* data, size_t length) { udp.inbox.push_back(std::string((const char*)data, length)); }
+
+static void replyConnack(uint8_t returnCode) {
+  uint8_t packet[3] = { 3, MQTTSN_CONNACK, returnCode };
+  reply(packet, sizeof(packet));
+}
+
+static void replyAck(MqttSnMsgType type, uint16_t topicId, uint16_t msgId) {
+  if (type == MQTTSN_SUBACK) {  // flags, topic id, msg id, código
+    uint8_t suback[8] = { 8, MQTTSN_SUBACK, 0x20, (uint8_t)(topicId >> 8), (uint8_t)topicId,
+                          (uint8_t)(msgId >> 8), (uint8_t)msgId, MQTTSN_RC_ACCEPTED };
+    reply(suback, sizeof(suback));
+    return;
+  }
+  uint8_t packet[7];
+  reply(packet, mqttSnWriteAck(packet, type, topicId, msgId, MQTTSN_RC_ACCEPTED));
+}
+
+void setUp(void) {
+  clockMs = 1000;
+  udp.sent.clear();
+  udp.inbox.clear();
+}
+void tearDown(void) {}
+
+static void connectClient(MqttSnClient<FakeUdp>& client) {
+  client.setGateway("gateway", 10000);
+  TEST_ASSERT_TRUE(client.beginConnect("node", false));
+  replyConnack(MQTTSN_RC_ACCEPTED);
+  client.loop();
+  TEST_ASSERT_TRUE(client.connected());
+  udp.sent.clear();
+}
+
+// Sem CONNACK: um CONNECT por Tretry, cada loop() volta na hora, e a tentativa termina
+// depois de Nretry reenvios
+static void test_connect_does_not_wait(void) {
+  MqttSnClient<FakeUdp> client(udp, fakeMillis);
+  client.setGateway("gateway", 10000);
+  TEST_ASSERT_TRUE(client.beginConnect("node", false));
+  TEST_ASSERT_TRUE(client.connecting());
+  TEST_ASSERT_EQUAL(1, udp.count(MQTTSN_CONNECT));
+  for (int i = 0; i < 100; i++) {
+    clockMs += 10;
+    TEST_ASSERT_FALSE(client.loop());
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(1, udp.count(MQTTSN_CONNECT), "sem reenvio antes de Tretry");
+  for (int i = 0; i < MQTTSN_RETRY_MAX + 1; i++) {
+    clockMs += MQTTSN_RETRY_MS;
+    client.loop();
+  }
+  TEST_ASSERT_EQUAL(MQTTSN_RETRY_MAX + 1, udp.count(MQTTSN_CONNECT));
+  TEST_ASSERT_FALSE(client.connecting());
+  TEST_ASSERT_EQUAL(MQTT_STATE_CONNECTION_TIMEOUT, client.state());
+
+  TEST_ASSERT_TRUE(client.beginConnect("node", false));
+  clockMs += 50;
+  replyConnack(MQTTSN_RC_ACCEPTED);
+  TEST_ASSERT_TRUE(client.loop());
+  TEST_ASSERT_TRUE(client.connected());
+}
+
+// Tópico novo: a mensagem QoS 1 entra na janela, o REGISTER sai depois do SUBSCRIBE em
+// andamento (um pedido por vez) e o PUBLISH sai com o REGACK
+static void test_register_does_not_wait(void) {
+  MqttSnClient<FakeUdp> client(udp, fakeMillis);
+  connectClient(client);
+  TEST_ASSERT_TRUE(client.subscribe("cmd", 1));
+  TEST_ASSERT_EQUAL(1, udp.sent.size());
+  TEST_ASSERT_EQUAL(MQTTSN_SUBSCRIBE, udp.sentType(0));
+
+  const uint8_t payload[3] = { 1, 2, 3 };
+  TEST_ASSERT_TRUE(client.publish("data", payload, sizeof(payload), 1));
+  TEST_ASSERT_EQUAL(1, client.inflight());
+  TEST_ASSERT_EQUAL_MESSAGE(1, udp.sent.size(), "REGISTER espera o SUBACK");
+
+  replyAck(MQTTSN_SUBACK, 3, udp.sentMsgId(0));
+  client.loop();
+  TEST_ASSERT_EQUAL(2, udp.sent.size());
+  TEST_ASSERT_EQUAL(MQTTSN_REGISTER, udp.sentType(1));
+  TEST_ASSERT_EQUAL(0, udp.count(MQTTSN_PUBLISH));
+
+  replyAck(MQTTSN_REGACK, 7, udp.sentMsgId(1));
+  client.loop();
+  TEST_ASSERT_EQUAL(3, udp.sent.size());
+  TEST_ASSERT_EQUAL(MQTTSN_PUBLISH, udp.sentType(2));
+  TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, (uint8_t)udp.sent[2][2] & MQTTSN_FLAG_DUP, "primeiro envio, sem DUP");
+  TEST_ASSERT_EQUAL_UINT8(7, (uint8_t)udp.sent[2][4]);
+}
+
+// Gateway mudo no REGISTER: reenvios no relógio e, depois de Nretry, a conexão é dada como
+// perdida; a mensagem continua na janela para a reconexão
+static void test_register_timeout_loses_connection(void) {
+  MqttSnClient<FakeUdp> client(udp, fakeMillis);
+  connectClient(client);
+  const uint8_t payload[1] = { 9 };
+  TEST_ASSERT_TRUE(client.publish("data", payload, sizeof(payload), 1));
+  TEST_ASSERT_EQUAL(1, udp.count(MQTTSN_REGISTER));
+  for (int i = 0; i < MQTTSN_RETRY_MAX + 1 && client.connected(); i++) {
+    clockMs += MQTTSN_RETRY_MS;
+    client.loop();
+  }
+  TEST_ASSERT_EQUAL(MQTTSN_RETRY_MAX + 1, udp.count(MQTTSN_REGISTER));
+  TEST_ASSERT_EQUAL(MQTT_STATE_CONNECTION_LOST, client.state());
+  TEST_ASSERT_EQUAL(1, client.inflight());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_connect_does_not_wait);
+  RUN_TEST(test_register_does_not_wait);
+  RUN_TEST(test_register_timeout_loses_connection);
+  return UNITY_END();
+}
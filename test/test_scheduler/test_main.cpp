@@ -0,0 +1,87 @@
+// Prazos pedidos pelo próprio job (scheduler.h): runNow()/runIn() chamados durante a
+// execução valem no lugar do prazo da grade, como no publishTask esvaziando a fila e no
+// connectTask esperando o CONNACK. Relógio falso, sem esperar de verdade.
+//   pio test -e test_native -f test_scheduler
+#include <unity.h>
+#include "scheduler.h"
+
+#define PERIOD_MS 1000
+
+static uint64_t clockUs = 0;
+static uint64_t fakeClock() { return clockUs; }
+
+static Scheduler* current = nullptr;
+static int jobId = -1;
+static int runs = 0;
+static int againRuns = 0;      // Quantas execuções pedem outra logo em seguida
+static uint32_t againInMs = 0;  // 0: runNow(); senão runIn()
+
+static void selfJob() {
+  runs++;
+  if (againRuns <= 0) return;
+  againRuns--;
+  if (againInMs == 0) {
+    current->runNow(jobId);
+  } else {
+    current->runIn(jobId, againInMs);
+  }
+}
+
+void setUp(void) {
+  clockUs = 0;
+  runs = 0;
+  againRuns = 0;
+  againInMs = 0;
+}
+void tearDown(void) {}
+
+static void advance(Scheduler& scheduler, uint64_t untilUs) {
+  while (clockUs <= untilUs) {
+    scheduler.runDue();
+    clockUs += 1000;
+  }
+}
+
+// runNow() do próprio job: roda de novo na volta seguinte, depois volta para a grade
+static void test_run_now_from_job(void) {
+  Scheduler scheduler(fakeClock);
+  current = &scheduler;
+  jobId = scheduler.add("self", PERIOD_MS, selfJob);
+  againRuns = 3;
+  scheduler.runDue();
+  scheduler.runDue();
+  scheduler.runDue();
+  TEST_ASSERT_EQUAL_MESSAGE(3, runs, "uma execução por volta enquanto pede");
+  scheduler.runDue();
+  TEST_ASSERT_EQUAL_MESSAGE(4, runs, "a última pedida");
+  scheduler.runDue();
+  TEST_ASSERT_EQUAL_MESSAGE(4, runs, "sem pedido, espera o período");
+  advance(scheduler, PERIOD_MS * 1000);
+  TEST_ASSERT_EQUAL(5, runs);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, scheduler.stats(jobId).missed, "prazo pedido não é prazo perdido");
+}
+
+// runIn() do próprio job: o prazo pedido vale mesmo sendo menor que o período
+static void test_run_in_from_job(void) {
+  Scheduler scheduler(fakeClock);
+  current = &scheduler;
+  jobId = scheduler.add("self", PERIOD_MS, selfJob);
+  againRuns = 1;
+  againInMs = 20;
+  scheduler.runDue();
+  advance(scheduler, 19000);
+  TEST_ASSERT_EQUAL(1, runs);
+  advance(scheduler, 20000);
+  TEST_ASSERT_EQUAL(2, runs);
+  advance(scheduler, 20000 + PERIOD_MS * 1000 - 1000);
+  TEST_ASSERT_EQUAL_MESSAGE(2, runs, "a grade recomeça do prazo pedido");
+  advance(scheduler, 20000 + PERIOD_MS * 1000);
+  TEST_ASSERT_EQUAL(3, runs);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_run_now_from_job);
+  RUN_TEST(test_run_in_from_job);
+  return UNITY_END();
+}
@@ -0,0 +1,114 @@
+// Ida e volta do bloco comprimido (ts_codec.h) nas bordas de cada faixa do delta-of-delta:
+// o valor de borda cabe no campo com sinal e o vizinho de fora passa para a faixa seguinte.
+//   pio test -e test_native -f test_ts_codec
+#include <unity.h>
+#include "ts_codec.h"
+
+#define BASE_TIMESTAMP 1700000000000ULL
+#define BASE_PERIOD_MS 5000
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Três amostras: a 2ª fixa o delta em BASE_PERIOD_MS e a 3ª tem o dod pedido. Confere a
+// volta e os bits gastos pelo timestamp da 3ª (o valor repetido custa 1 bit).
+static void checkDod(int64_t dod, size_t timestampBits) {
+  uint8_t block[TS_BLOCK_HEADER_SIZE + 3 * TS_SAMPLE_MAX_BITS / 8 + 1];
+  uint64_t timestamps[3] = { BASE_TIMESTAMP, BASE_TIMESTAMP + BASE_PERIOD_MS,
+                             BASE_TIMESTAMP + 2 * BASE_PERIOD_MS + dod };
+  TsBlockEncoder encoder(block, sizeof(block), 2);
+  TEST_ASSERT_TRUE(encoder.add(timestamps[0], 4500));
+  TEST_ASSERT_TRUE(encoder.add(timestamps[1], 4500));
+  size_t before = encoder.bitsUsed();
+  TEST_ASSERT_TRUE(encoder.add(timestamps[2], 4500));
+  TEST_ASSERT_EQUAL_MESSAGE(timestampBits + 1, encoder.bitsUsed() - before, "faixa do dod");
+  size_t length = encoder.finish();
+
+  TsBlockDecoder decoder;
+  TEST_ASSERT_TRUE(decoder.begin(block, length));
+  TEST_ASSERT_EQUAL_UINT16(3, decoder.count());
+  for (int i = 0; i < 3; i++) {
+    uint64_t timestamp;
+    int32_t value;
+    TEST_ASSERT_TRUE(decoder.next(timestamp, value));
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(timestamps[i], timestamp, "timestamp");
+    TEST_ASSERT_EQUAL_INT32_MESSAGE(4500, value, "valor");
+  }
+}
+
+static void test_dod_zero(void) { checkDod(0, 1); }
+
+static void test_dod_7_bits(void) {
+  checkDod(1, 9);
+  checkDod(-1, 9);
+  checkDod(63, 9);
+  checkDod(-64, 9);
+}
+
+static void test_dod_9_bits(void) {
+  checkDod(64, 12);
+  checkDod(-65, 12);
+  checkDod(255, 12);
+  checkDod(-256, 12);
+}
+
+static void test_dod_12_bits(void) {
+  checkDod(256, 16);
+  checkDod(-257, 16);
+  checkDod(2047, 16);
+  checkDod(-2048, 16);
+}
+
+static void test_dod_32_bits(void) {
+  checkDod(2048, 36);
+  checkDod(-2049, 36);
+  checkDod(3600000, 36);
+  checkDod(-BASE_PERIOD_MS, 36);
+}
+
+static void test_dod_32_bits_limits(void) {
+  checkDod(INT32_MAX, 36);
+  checkDod(INT32_MIN, 36);
+}
+
+// dod fora de int32 (intervalo de mais de ~24,8 dias): add() recusa, o bloco continua
+// válido com as amostras anteriores e a recusada abre um bloco novo
+static void checkDodRejected(int64_t dod) {
+  uint8_t block[TS_BLOCK_HEADER_SIZE + 3 * TS_SAMPLE_MAX_BITS / 8 + 1];
+  uint64_t third = BASE_TIMESTAMP + 2 * BASE_PERIOD_MS + dod;
+  TsBlockEncoder encoder(block, sizeof(block), 2);
+  TEST_ASSERT_TRUE(encoder.add(BASE_TIMESTAMP, 4500));
+  TEST_ASSERT_TRUE(encoder.add(BASE_TIMESTAMP + BASE_PERIOD_MS, 4501));
+  size_t before = encoder.bitsUsed();
+  TEST_ASSERT_FALSE_MESSAGE(encoder.add(third, 4502), "dod fora de int32");
+  TEST_ASSERT_EQUAL(before, encoder.bitsUsed());
+  TEST_ASSERT_EQUAL_UINT16(2, encoder.count());
+
+  TsBlockDecoder decoder;
+  TEST_ASSERT_TRUE(decoder.begin(block, encoder.finish()));
+  TEST_ASSERT_EQUAL_UINT16(2, decoder.count());
+  uint64_t timestamp;
+  int32_t value;
+  TEST_ASSERT_TRUE(decoder.next(timestamp, value));
+  TEST_ASSERT_TRUE(decoder.next(timestamp, value));
+  TEST_ASSERT_EQUAL_UINT64(BASE_TIMESTAMP + BASE_PERIOD_MS, timestamp);
+  TEST_ASSERT_EQUAL_INT32(4501, value);
+}
+
+static void test_dod_out_of_range(void) {
+  checkDodRejected((int64_t)INT32_MAX + 1);
+  checkDodRejected(30LL * 24 * 3600 * 1000);  // 30 dias desligado
+  checkDodRejected((int64_t)INT32_MIN - 1);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_dod_zero);
+  RUN_TEST(test_dod_7_bits);
+  RUN_TEST(test_dod_9_bits);
+  RUN_TEST(test_dod_12_bits);
+  RUN_TEST(test_dod_32_bits);
+  RUN_TEST(test_dod_32_bits_limits);
+  RUN_TEST(test_dod_out_of_range);
+  return UNITY_END();
+}
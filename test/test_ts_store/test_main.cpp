@@ -0,0 +1,80 @@
+// Consulta ao histórico (ts_store.h) enquanto o log dá a volta: o cursor continua de onde
+// parou, sem pular nem repetir página, e recomeça da mais antiga se a dele foi apagada.
+//   pio test -e test_native -f test_ts_store
+#include <unity.h>
+#include "ts_store.h"
+
+#define PERIOD_MS 5000
+#define EPOCH 7
+
+static TsStore store;
+static uint32_t nextSeq = 0;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static uint64_t timestampOf(uint32_t seq) { return 1700000000000ULL + (uint64_t)seq * PERIOD_MS; }
+
+static void appendReadings(uint32_t count) {
+  for (uint32_t i = 0; i < count; i++, nextSeq++) {
+    TEST_ASSERT_TRUE(store.append(timestampOf(nextSeq), (int32_t)(nextSeq % 10000), SeqNo{ EPOCH, nextSeq }));
+  }
+}
+
+// Lê até o fim conferindo que cada registro é o seguinte ao anterior; retorna quantos leu
+static uint32_t readConsecutive(TsCursor& cursor, uint32_t& expected) {
+  TsRecord record;
+  uint32_t n = 0;
+  while (store.read(cursor, record)) {
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected, record.seq.seq, "seq");
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(timestampOf(expected), record.timestampMs, "timestamp");
+    expected++;
+    n++;
+  }
+  return n;
+}
+
+// Log cheio; o cursor está na 3ª página mais antiga quando a mais antiga é apagada
+static void test_cursor_survives_rollover(void) {
+  const uint32_t perPage = TsStore::recordsPerPage();
+  TEST_ASSERT_TRUE(store.begin());
+  appendReadings(TS_STORE_HOST_PAGES * perPage);
+  TEST_ASSERT_EQUAL_UINT32(TS_STORE_HOST_PAGES, store.stats().usedPages);
+
+  uint32_t expected = 2 * perPage + 5;
+  TsCursor cursor = store.seek(timestampOf(expected));
+  TsRecord record;
+  for (int i = 0; i < 10; i++) {
+    TEST_ASSERT_TRUE(store.read(cursor, record));
+    TEST_ASSERT_EQUAL_UINT32(expected++, record.seq.seq);
+  }
+
+  appendReadings(perPage);  // Reaproveita a página mais antiga
+  TEST_ASSERT_EQUAL_UINT32(timestampOf(perPage), store.oldestTimestamp());
+  uint32_t read = readConsecutive(cursor, expected);
+  TEST_ASSERT_EQUAL_UINT32(nextSeq, expected);
+  TEST_ASSERT_EQUAL_UINT32(nextSeq - (2 * perPage + 15), read);
+}
+
+// O cursor estava na página apagada: segue da primeira leitura que sobrou
+static void test_cursor_on_dropped_page(void) {
+  const uint32_t perPage = TsStore::recordsPerPage();
+  uint64_t oldest = store.oldestTimestamp();
+  uint32_t expected = (uint32_t)((oldest - timestampOf(0)) / PERIOD_MS) + 3;
+  TsCursor cursor = store.seek(timestampOf(expected));
+  TsRecord record;
+  TEST_ASSERT_TRUE(store.read(cursor, record));
+  TEST_ASSERT_EQUAL_UINT32(expected, record.seq.seq);
+
+  appendReadings(perPage);
+  expected = (uint32_t)((store.oldestTimestamp() - timestampOf(0)) / PERIOD_MS);
+  readConsecutive(cursor, expected);
+  TEST_ASSERT_EQUAL_UINT32(nextSeq, expected);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_cursor_survives_rollover);
+  RUN_TEST(test_cursor_on_dropped_page);
+  return UNITY_END();
+}